@@ -0,0 +1,561 @@
+// Component benchmarks for the decoder core, run against the stand-in REX
+// backend and a mock AIMP host. See the "Benchmarks" section of README.md.
+
+#include "Rx2BenchAimp.h"
+#include "Rx2BenchReport.h"
+#include "Rx2BenchRex.h"
+
+#include "Rx2Decoder.h"
+#include "Rx2PcmStore.h"
+#include "Rx2RtAudit.h"
+#include "Rx2Settings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ---------------- options ----------------
+
+struct BenchOptions
+{
+    Rx2BenchLoop loop;
+    int          reps;
+    double       threshold;   // regression threshold, percent
+    std::string  outPath;
+    std::string  baselinePath;
+    std::string  only;        // comma-separated groups; empty = all
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: rx2_bench [options]\n"
+            "  --seconds S      loop length in seconds at 120 BPM (default 8)\n"
+            "  --rate HZ        sample rate (default 44100)\n"
+            "  --channels N     1 or 2 (default 2)\n"
+            "  --slices N       slice count (default 16)\n"
+            "  --bits N         source bit depth reported by the file (default 16)\n"
+            "  --reps N         repetitions per measurement; the median is kept (default 5)\n"
+            "  --only GROUPS    comma-separated subset of: open, read, store\n"
+            "  --out FILE       write the JSON report to FILE instead of stdout\n"
+            "  --baseline FILE  compare against an earlier report; exit 1 on regressions\n"
+            "  --threshold PCT  allowed slowdown before a result is flagged (default 10)\n");
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions* opt)
+{
+    opt->loop.channels   = 2;
+    opt->loop.sampleRate = 44100;
+    opt->loop.slices     = 16;
+    opt->loop.bitDepth   = 16;
+    opt->loop.seconds    = 8.0;
+    opt->loop.muted      = false;
+    opt->loop.hangMs     = 0;
+    opt->reps            = 5;
+    opt->threshold       = 10.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg   = argv[i];
+        const char*       value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (!value)
+        {
+            fprintf(stderr, "rx2_bench: missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if      (arg == "--seconds")   opt->loop.seconds    = atof(value);
+        else if (arg == "--rate")      opt->loop.sampleRate = atoi(value);
+        else if (arg == "--channels")  opt->loop.channels   = atoi(value);
+        else if (arg == "--slices")    opt->loop.slices     = atoi(value);
+        else if (arg == "--bits")      opt->loop.bitDepth   = atoi(value);
+        else if (arg == "--reps")      opt->reps            = atoi(value);
+        else if (arg == "--only")      opt->only            = value;
+        else if (arg == "--out")       opt->outPath         = value;
+        else if (arg == "--baseline")  opt->baselinePath    = value;
+        else if (arg == "--threshold") opt->threshold       = atof(value);
+        else
+        {
+            fprintf(stderr, "rx2_bench: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if ((opt->loop.channels != 1 && opt->loop.channels != 2) || opt->loop.sampleRate <= 0
+        || opt->loop.slices <= 0 || opt->loop.seconds <= 0.0 || opt->reps <= 0
+        || (opt->loop.bitDepth != 16 && opt->loop.bitDepth != 24 && opt->loop.bitDepth != 32))
+    {
+        fprintf(stderr, "rx2_bench: invalid loop parameters\n");
+        return false;
+    }
+    return true;
+}
+
+// ---------------- helpers ----------------
+
+// Opens a decoder the way AIMP does; null (with a message) on failure.
+static Rx2Decoder* OpenDecoder(Rx2BenchCore& core, const std::vector<std::uint8_t>& file,
+                               Rx2BenchStream** streamOut)
+{
+    Rx2BenchStream* stream  = new Rx2BenchStream(file);
+    Rx2Decoder*     decoder = new Rx2Decoder(&core, stream);
+
+    if (!decoder->IsValid())
+    {
+        fprintf(stderr, "rx2_bench: decoder failed to open (REX error %d)\n",
+                static_cast<int>(decoder->GetLastError()));
+        decoder->Release();
+        stream->Release();
+        return nullptr;
+    }
+
+    if (streamOut)
+        *streamOut = stream;
+    else
+        stream->Release();
+    return decoder;
+}
+
+// ---------------- benchmarks ----------------
+
+// Constructor cost split into its stages, per storage configuration.
+// Ingest, preflight and REXCreate do not depend on the storage format and
+// are reported once; "render" runs from REXStartPreview to the end of the
+// constructor, and its overhead excludes the stand-in's own synthesis.
+static bool BenchOpen(Rx2BenchReport& report, Rx2BenchCore& core, const BenchOptions& opt,
+                      const std::vector<std::uint8_t>& file)
+{
+    if (!report.Wants("open"))
+        return true;
+
+    const std::int64_t frames = Rx2BenchLoopFrames(opt.loop);
+
+    for (const Rx2BenchStorageConfig& config : kRx2BenchStorageConfigs)
+    {
+        const std::string prefix = std::string("open_") + config.name;
+
+        Rx2BenchApplyStorageConfig(core, config);
+
+        std::vector<double> total, ingest, preflight, create, render, overhead;
+        for (int rep = 0; rep < opt.reps; ++rep)
+        {
+            Rx2BenchRexResetStats();
+
+            Rx2BenchStream*    stream = nullptr;
+            const std::int64_t t0     = Rx2BenchNowNs();
+            Rx2Decoder*        dec    = OpenDecoder(core, file, &stream);
+            const std::int64_t t1     = Rx2BenchNowNs();
+            if (!dec)
+                return false;
+
+            const Rx2BenchRexStats stats = Rx2BenchRexGetStats();
+            const std::int64_t     wall  = t1 - stats.previewStartNs;
+
+            total.push_back(Rx2BenchNsToMs(t1 - t0));
+            ingest.push_back(Rx2BenchNsToMs(stream->ReadNs()));
+            preflight.push_back(Rx2BenchNsToMs(stats.preflightNs));
+            create.push_back(Rx2BenchNsToMs(stats.createNs));
+            render.push_back(frames / (wall / 1e9) / 1e6);
+            overhead.push_back(static_cast<double>(wall - stats.renderNs) / frames);
+
+            dec->Release();
+            stream->Release();
+        }
+
+        if (&config == &kRx2BenchStorageConfigs[0])
+        {
+            report.Add("open_ingest_ms",    Rx2BenchMedian(ingest),    "ms", false);
+            report.Add("open_preflight_ms", Rx2BenchMedian(preflight), "ms", false);
+            report.Add("open_rex_create_ms", Rx2BenchMedian(create),   "ms", false);
+        }
+
+        report.Add(prefix + "_total_ms",         Rx2BenchMedian(total),    "ms",        false);
+        report.Add(prefix + "_render_mframes_s", Rx2BenchMedian(render),   "Mframes/s", true);
+        report.Add(prefix + "_render_ns_frame",  Rx2BenchMedian(overhead), "ns/frame",  false);
+    }
+    return true;
+}
+
+// Read() throughput at AIMP-like buffer sizes, with seeks back to the start
+// when the loop ends, in each storage configuration.
+static bool BenchRead(Rx2BenchReport& report, Rx2BenchCore& core, const BenchOptions& opt,
+                      const std::vector<std::uint8_t>& file)
+{
+    static const int kBufferBytes[] = { 512, 4096, 16384, 65536 };
+
+    if (!report.Wants("read"))
+        return true;
+
+    const std::int64_t frames = Rx2BenchLoopFrames(opt.loop);
+    const std::int64_t target = std::max<std::int64_t>(frames * 2, 4 * 1024 * 1024);
+
+    std::vector<std::uint8_t> buffer(kBufferBytes[_countof(kBufferBytes) - 1]);
+
+    for (const Rx2BenchStorageConfig& config : kRx2BenchStorageConfigs)
+    {
+        const std::string prefix = std::string("read_") + config.name;
+
+        Rx2BenchApplyStorageConfig(core, config);
+
+        Rx2Decoder* dec = OpenDecoder(core, file, nullptr);
+        if (!dec)
+            return false;
+
+        int sampleRate = 0, channels = 0, sampleFormat = 0;
+        dec->GetStreamInfo(&sampleRate, &channels, &sampleFormat);
+        const int frameBytes = channels * (sampleFormat == AIMP_DECODER_SAMPLEFORMAT_16BIT ? 2 :
+                                           sampleFormat == AIMP_DECODER_SAMPLEFORMAT_24BIT ? 3 : 4);
+
+        for (int bytes : kBufferBytes)
+        {
+            std::vector<double> rates;
+            for (int rep = 0; rep < opt.reps; ++rep)
+            {
+                dec->SetPosition(0);
+
+                std::int64_t       served = 0;
+                const std::int64_t t0     = Rx2BenchNowNs();
+                while (served < target * frameBytes)
+                {
+                    const int n = dec->Read(buffer.data(), bytes);
+                    if (n <= 0)
+                    {
+                        dec->SetPosition(0);
+                        continue;
+                    }
+                    served += n;
+                }
+                const std::int64_t t1 = Rx2BenchNowNs();
+
+                rates.push_back(static_cast<double>(served / frameBytes) / ((t1 - t0) / 1e9) / 1e6);
+            }
+
+            report.Add(prefix + "_" + std::to_string(bytes) + "B", Rx2BenchMedian(rates), "Mframes/s", true);
+        }
+
+        dec->Release();
+    }
+    return true;
+}
+
+// Round trip through the store, checked sample by sample: every storage
+// format (16/24-bit and compressed included) reads back what was appended,
+// within the quantization error for integer formats and exactly for float;
+// compressed blocks decode to exactly the bytes of the uncompressed store;
+// silent and dual-mono blocks become Silent and DualMono extents; and reads
+// at random positions straddling block boundaries match the sequential
+// read. Prints the first mismatch and returns false.
+static bool VerifyStoreRoundTrip(int channels, const std::vector<float>& left, const std::vector<float>& right)
+{
+    struct RoundTripFormat
+    {
+        const char*     name;
+        Rx2SampleFormat format;
+        bool            compress;
+        float           scale;   // 1 LSB = 1 / scale; 0 = float
+    };
+    static const RoundTripFormat kFormats[] =
+    {
+        { "f32",  Rx2SampleFormat::Float32, false, 0.0f       },
+        { "i16",  Rx2SampleFormat::Int16,   false, 32768.0f   },
+        { "i16c", Rx2SampleFormat::Int16,   true,  32768.0f   },
+        { "i24",  Rx2SampleFormat::Int24,   false, 8388608.0f },
+        { "i24c", Rx2SampleFormat::Int24,   true,  8388608.0f },
+    };
+
+    const int          B      = Rx2PcmStore::kBlockFrames;
+    const std::int64_t frames = static_cast<std::int64_t>(left.size());
+    const size_t       n      = left.size();
+
+    // Signals, as (left, right, extent kind every block must have or -1).
+    struct Signal
+    {
+        const char*        name;
+        std::vector<float> l, r;
+        int                kind;
+    };
+    std::vector<Signal> signals;
+    signals.push_back({ "loop",          left,                     right,                    -1 });
+    signals.push_back({ "silent",        std::vector<float>(n, 0.0f), std::vector<float>(n, 0.0f),
+                        static_cast<int>(Rx2PcmExtentKind::Silent) });
+    signals.push_back({ "negative_zero", std::vector<float>(n, -0.0f), std::vector<float>(n, -0.0f),
+                        static_cast<int>(Rx2PcmExtentKind::Silent) });
+    if (channels == 2)
+        signals.push_back({ "dual_mono", left, left, static_cast<int>(Rx2PcmExtentKind::DualMono) });
+
+    // Blocks cycling through signal, silence and dual mono, so extents of
+    // every kind meet at block boundaries.
+    Signal mixed = { "mixed", left, right, -1 };
+    for (size_t i = 0; i < n; ++i)
+    {
+        const size_t block = i / B;
+        if (block % 3 == 1)
+            mixed.l[i] = mixed.r[i] = 0.0f;
+        else if (block % 3 == 2)
+            mixed.r[i] = mixed.l[i];
+    }
+    signals.push_back(mixed);
+
+    std::uint32_t rng = 12345;
+    auto random = [&rng](std::uint32_t range)
+    {
+        rng = rng * 1664525u + 1013904223u;
+        return static_cast<std::int64_t>((rng >> 8) % range);
+    };
+
+    for (const Signal& sig : signals)
+    {
+        std::vector<std::uint8_t> uncompressed;   // native bytes of the last uncompressed store
+
+        for (const RoundTripFormat& fmt : kFormats)
+        {
+            const std::string what = std::string("store round trip ") + fmt.name + " " + sig.name;
+
+            Rx2PcmStore store;
+            bool ok = store.Reset(channels, frames, fmt.format, fmt.compress, false);
+            for (std::int64_t pos = 0; ok && pos < frames; pos += B)
+            {
+                const int count = static_cast<int>(std::min<std::int64_t>(B, frames - pos));
+                ok = store.Append(sig.l.data() + pos, channels > 1 ? sig.r.data() + pos : nullptr, count);
+            }
+            if (!ok || !store.Finish() || store.Frames() != frames)
+            {
+                fprintf(stderr, "rx2_bench: %s: append failed\n", what.c_str());
+                return false;
+            }
+
+            // Blocks the loop leaves silent are Silent whatever the signal.
+            for (const Rx2PcmExtent& extent : store.Extents())
+            {
+                if (sig.kind >= 0 && static_cast<int>(extent.kind) != sig.kind
+                    && extent.kind != Rx2PcmExtentKind::Silent)
+                {
+                    fprintf(stderr, "rx2_bench: %s: frames %lld+%lld stored as extent kind %d, expected %d\n",
+                            what.c_str(), static_cast<long long>(extent.firstFrame),
+                            static_cast<long long>(extent.frames), static_cast<int>(extent.kind), sig.kind);
+                    return false;
+                }
+            }
+
+            // Sequential reads, as float and in the storage format.
+            const int bps = Rx2BytesPerSample(fmt.format);
+            std::vector<float>        asFloat(n * channels);
+            std::vector<std::uint8_t> native(n * channels * bps);
+            for (std::int64_t pos = 0; pos < frames; pos += B)
+            {
+                const int count = static_cast<int>(std::min<std::int64_t>(B, frames - pos));
+                store.Read(pos, count, asFloat.data() + pos * channels, Rx2SampleFormat::Float32);
+                store.Read(pos, count, native.data() + pos * channels * bps, fmt.format);
+            }
+
+            // Dither is +/-1 LSB and rounding half an LSB; clipping at the
+            // positive rail can add one more.
+            const float tolerance = fmt.scale > 0.0f ? 2.5f / fmt.scale : 0.0f;
+            for (size_t i = 0; i < n; ++i)
+            {
+                for (int c = 0; c < channels; ++c)
+                {
+                    float in = (c == 0) ? sig.l[i] : sig.r[i];
+                    in = std::max(-1.0f, std::min(1.0f, in));
+                    const float got = asFloat[i * channels + c];
+                    if (!(std::fabs(got - in) <= tolerance))
+                    {
+                        fprintf(stderr, "rx2_bench: %s: frame %zu channel %d reads %.9g, appended %.9g\n",
+                                what.c_str(), i, c, got, in);
+                        return false;
+                    }
+                }
+            }
+
+            // The codec is lossless: same bytes as the uncompressed store
+            // (which consumed the same dither sequence).
+            if (fmt.compress && native != uncompressed)
+            {
+                fprintf(stderr, "rx2_bench: %s: compressed blocks do not decode to the uncompressed samples\n",
+                        what.c_str());
+                return false;
+            }
+            if (!fmt.compress)
+                uncompressed = native;
+
+            // Random access across block boundaries.
+            std::vector<std::uint8_t> part(static_cast<size_t>(2 * B) * channels * bps);
+            for (int probe = 0; probe < 64; ++probe)
+            {
+                const std::int64_t boundary = B * (1 + random(static_cast<std::uint32_t>(frames / B + 1)));
+                std::int64_t first = boundary - 1 - random(B);
+                first = std::max<std::int64_t>(0, std::min<std::int64_t>(first, frames - 1));
+                const int count = static_cast<int>(std::min<std::int64_t>(1 + random(2 * B), frames - first));
+
+                store.Read(first, count, part.data(), fmt.format);
+                if (memcmp(part.data(), native.data() + first * channels * bps,
+                           static_cast<size_t>(count) * channels * bps) != 0)
+                {
+                    fprintf(stderr, "rx2_bench: %s: reading frames %lld+%d differs from the sequential read\n",
+                            what.c_str(), static_cast<long long>(first), count);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// The store on its own: append (clamp, quantize, dither, silence and
+// dual-mono detection, compression) and interleaving reads as float, for a
+// rendered loop and for digital silence. The silence
+// rows are the cost of the silent-block path on both sides. Returns false
+// when the round trip check fails.
+static bool BenchStore(Rx2BenchReport& report, const BenchOptions& opt,
+                       const std::vector<std::uint8_t>& file)
+{
+    struct StoreFormat
+    {
+        const char*     name;
+        Rx2SampleFormat format;
+        bool            compress;
+    };
+    static const StoreFormat kFormats[] =
+    {
+        { "f32",  Rx2SampleFormat::Float32, false },
+        { "i16",  Rx2SampleFormat::Int16,   false },
+        { "i24",  Rx2SampleFormat::Int24,   false },
+        { "i16c", Rx2SampleFormat::Int16,   true  },
+    };
+
+    if (!report.Wants("store"))
+        return true;
+
+    // Render the loop once through the stand-in.
+    const int          channels = opt.loop.channels;
+    const std::int64_t frames   = Rx2BenchLoopFrames(opt.loop);
+
+    std::vector<float> left(static_cast<size_t>(frames));
+    std::vector<float> right(static_cast<size_t>(frames));
+    {
+        REX::REXHandle handle = nullptr;
+        REX::REXCreate(&handle, reinterpret_cast<const char*>(file.data()),
+                       static_cast<REX::REX_int32_t>(file.size()), nullptr, nullptr);
+        REX::REXStartPreview(handle);
+        for (std::int64_t pos = 0; pos < frames; pos += 64)
+        {
+            float* out[2] = { left.data() + pos, right.data() + pos };
+            const int n = static_cast<int>(std::min<std::int64_t>(64, frames - pos));
+            REX::REXRenderPreviewBatch(handle, n, out);
+        }
+        REX::REXStopPreview(handle);
+        REX::REXDelete(&handle);
+    }
+    if (!VerifyStoreRoundTrip(channels, left, right))
+        return false;
+
+    const std::vector<float> silence(static_cast<size_t>(frames), 0.0f);
+
+    // Short loops are repeated so each measurement covers a few million frames.
+    const int passes = static_cast<int>(std::max<std::int64_t>(1, (4 * 1024 * 1024) / frames));
+
+    std::vector<std::uint8_t> out(static_cast<size_t>(Rx2PcmStore::kBlockFrames) * channels * sizeof(float));
+
+    for (const StoreFormat& format : kFormats)
+    {
+        for (int silent = 0; silent < 2; ++silent)
+        {
+            const std::string prefix = std::string("store_") + format.name + (silent ? "_silence" : "_signal");
+            const float* l = silent ? silence.data() : left.data();
+            const float* r = silent ? silence.data() : right.data();
+
+            std::vector<double> append, convert;
+            for (int rep = 0; rep < opt.reps; ++rep)
+            {
+                Rx2PcmStore store;
+
+                const std::int64_t t0 = Rx2BenchNowNs();
+                for (int pass = 0; pass < passes; ++pass)
+                {
+                    store.Reset(channels, frames, format.format, format.compress, false);
+                    for (std::int64_t pos = 0; pos < frames; pos += Rx2PcmStore::kBlockFrames)
+                    {
+                        const int n = static_cast<int>(std::min<std::int64_t>(Rx2PcmStore::kBlockFrames, frames - pos));
+                        store.Append(l + pos, channels > 1 ? r + pos : nullptr, n);
+                    }
+                    store.Finish();
+                }
+                const std::int64_t t1 = Rx2BenchNowNs();
+
+                append.push_back(static_cast<double>(frames) * passes / ((t1 - t0) / 1e9) / 1e6);
+
+                // Integer storage widens to float; float storage, having
+                // no other output format, is the straight copy.
+                const Rx2SampleFormat outFormat = Rx2SampleFormat::Float32;
+                const std::int64_t t2 = Rx2BenchNowNs();
+                for (int pass = 0; pass < passes; ++pass)
+                {
+                    for (std::int64_t pos = 0; pos < frames; pos += Rx2PcmStore::kBlockFrames)
+                    {
+                        const int n = static_cast<int>(std::min<std::int64_t>(Rx2PcmStore::kBlockFrames, frames - pos));
+                        store.Read(pos, n, out.data(), outFormat);
+                    }
+                }
+                const std::int64_t t3 = Rx2BenchNowNs();
+
+                convert.push_back(static_cast<double>(frames) * passes / ((t3 - t2) / 1e9) / 1e6);
+
+                if (store.HasSignalAbove(1e-7f) == (silent != 0))
+                    fprintf(stderr, "rx2_bench: %s: unexpected silence detection result\n", prefix.c_str());
+            }
+
+            report.Add(prefix + "_append_mframes_s",  Rx2BenchMedian(append),  "Mframes/s", true);
+            report.Add(prefix + "_convert_mframes_s", Rx2BenchMedian(convert), "Mframes/s", true);
+        }
+    }
+    return true;
+}
+
+// ---------------- main ----------------
+
+int main(int argc, char** argv)
+{
+    BenchOptions opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    const std::vector<std::uint8_t> file = Rx2BenchMakeRexFile(opt.loop);
+
+    fprintf(stderr, "rx2_bench: %.2f s loop, %d Hz, %d ch, %d slices, %d frames, %zu byte file\n",
+            opt.loop.seconds, opt.loop.sampleRate, opt.loop.channels, opt.loop.slices,
+            static_cast<int>(Rx2BenchLoopFrames(opt.loop)), file.size());
+
+    Rx2BenchCore   core;
+    Rx2BenchReport report(opt.only);
+
+    // Unlimited, so no decoder's PCM is dropped between measurements.
+    core.SetConfig(L"RX2Decoder\\MemoryBudgetMB", 0);
+
+    if (!BenchOpen(report, core, opt, file) || !BenchRead(report, core, opt, file)
+        || !BenchStore(report, opt, file))
+        return 2;
+
+    Rx2RtAuditReport();
+
+    std::ostringstream config;
+    config << "\"seconds\": " << opt.loop.seconds
+           << ", \"rate\": " << opt.loop.sampleRate
+           << ", \"channels\": " << opt.loop.channels
+           << ", \"slices\": " << opt.loop.slices
+           << ", \"bits\": " << opt.loop.bitDepth
+           << ", \"reps\": " << opt.reps;
+
+    return Rx2BenchFinish("rx2_bench", config.str(), report, opt.outPath, opt.baselinePath, opt.threshold);
+}
@@ -0,0 +1,629 @@
+#include "Rx2BenchAimp.h"
+#include "Rx2BenchRex.h"
+
+#include "Rx2Settings.h"
+
+#include <cstring>
+#include <functional>
+#include <new>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ---------------- Rx2BenchString ----------------
+
+Rx2BenchString::Rx2BenchString()
+    : m_refCount(1)
+{
+}
+
+HRESULT WINAPI Rx2BenchString::QueryInterface(REFIID riid, void** ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IAIMPString)
+    {
+        *ppv = static_cast<IAIMPString*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2BenchString::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2BenchString::Release()
+{
+    const LONG count = InterlockedDecrement(&m_refCount);
+    if (count == 0)
+        delete this;
+    return count;
+}
+
+HRESULT WINAPI Rx2BenchString::GetChar(int Index, WCHAR* Char)
+{
+    if (!Char || Index < 0 || Index >= static_cast<int>(m_data.size()))
+        return E_INVALIDARG;
+    *Char = m_data[Index];
+    return S_OK;
+}
+
+WCHAR* WINAPI Rx2BenchString::GetData()
+{
+    return &m_data[0];
+}
+
+int WINAPI Rx2BenchString::GetLength()
+{
+    return static_cast<int>(m_data.size());
+}
+
+int WINAPI Rx2BenchString::GetHashCode()
+{
+    return static_cast<int>(std::hash<std::wstring>()(m_data));
+}
+
+HRESULT WINAPI Rx2BenchString::SetChar(int Index, WCHAR Char)
+{
+    if (Index < 0 || Index >= static_cast<int>(m_data.size()))
+        return E_INVALIDARG;
+    m_data[Index] = Char;
+    return S_OK;
+}
+
+HRESULT WINAPI Rx2BenchString::SetData(WCHAR* Chars, int CharsCount)
+{
+    if (!Chars || CharsCount < 0)
+        return E_INVALIDARG;
+    m_data.assign(Chars, CharsCount);
+    return S_OK;
+}
+
+// ---------------- Rx2BenchStream ----------------
+
+Rx2BenchStream::Rx2BenchStream(const std::vector<std::uint8_t>& data)
+    : m_refCount(1)
+    , m_data(data)
+    , m_position(0)
+    , m_readNs(0)
+{
+}
+
+HRESULT WINAPI Rx2BenchStream::QueryInterface(REFIID riid, void** ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    // Not an IAIMPFileStream: the decoder sees an anonymous stream.
+    if (riid == IID_IUnknown || riid == IID_IAIMPStream)
+    {
+        *ppv = static_cast<IAIMPStream*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2BenchStream::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2BenchStream::Release()
+{
+    const LONG count = InterlockedDecrement(&m_refCount);
+    if (count == 0)
+        delete this;
+    return count;
+}
+
+INT64 WINAPI Rx2BenchStream::GetSize()
+{
+    return static_cast<INT64>(m_data.size());
+}
+
+HRESULT WINAPI Rx2BenchStream::SetSize(const INT64 /*Value*/)
+{
+    return E_NOTIMPL;
+}
+
+INT64 WINAPI Rx2BenchStream::GetPosition()
+{
+    return m_position;
+}
+
+HRESULT WINAPI Rx2BenchStream::Seek(const INT64 Offset, int Mode)
+{
+    INT64 base = 0;
+    switch (Mode)
+    {
+    case AIMP_STREAM_SEEKMODE_FROM_BEGINNING: base = 0;                                  break;
+    case AIMP_STREAM_SEEKMODE_FROM_CURRENT:   base = m_position;                         break;
+    case AIMP_STREAM_SEEKMODE_FROM_END:       base = static_cast<INT64>(m_data.size());  break;
+    default:                                  return E_INVALIDARG;
+    }
+
+    const INT64 target = base + Offset;
+    if (target < 0 || target > static_cast<INT64>(m_data.size()))
+        return E_INVALIDARG;
+
+    m_position = target;
+    return S_OK;
+}
+
+int WINAPI Rx2BenchStream::Read(unsigned char* Buffer, unsigned int Count)
+{
+    const std::int64_t t0 = Rx2BenchNowNs();
+
+    INT64 available = static_cast<INT64>(m_data.size()) - m_position;
+    if (available > Count)
+        available = Count;
+
+    if (available > 0)
+    {
+        memcpy(Buffer, m_data.data() + m_position, static_cast<size_t>(available));
+        m_position += available;
+    }
+
+    m_readNs += Rx2BenchNowNs() - t0;
+    return available > 0 ? static_cast<int>(available) : 0;
+}
+
+HRESULT WINAPI Rx2BenchStream::Write(unsigned char* /*Buffer*/, unsigned int /*Count*/, unsigned int* /*Written*/)
+{
+    return E_NOTIMPL;
+}
+
+// ---------------- Rx2BenchFileStream ----------------
+
+Rx2BenchFileStream::Rx2BenchFileStream(const std::string& path)
+    : m_refCount(1)
+    , m_fd(open(path.c_str(), O_RDONLY | O_CLOEXEC))
+    , m_size(0)
+    , m_position(0)
+{
+    struct stat st;
+    if (m_fd >= 0 && fstat(m_fd, &st) == 0)
+        m_size = static_cast<INT64>(st.st_size);
+
+    m_path.resize(path.size());
+    const int n = MultiByteToWideChar(CP_UTF8, 0, path.data(), static_cast<int>(path.size()),
+                                      &m_path[0], static_cast<int>(m_path.size()));
+    m_path.resize(n > 0 ? n : 0);
+}
+
+Rx2BenchFileStream::~Rx2BenchFileStream()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+HRESULT WINAPI Rx2BenchFileStream::QueryInterface(REFIID riid, void** ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IAIMPStream || riid == IID_IAIMPFileStream)
+    {
+        *ppv = static_cast<IAIMPFileStream*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2BenchFileStream::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2BenchFileStream::Release()
+{
+    const LONG count = InterlockedDecrement(&m_refCount);
+    if (count == 0)
+        delete this;
+    return count;
+}
+
+INT64 WINAPI Rx2BenchFileStream::GetSize()
+{
+    return m_size;
+}
+
+HRESULT WINAPI Rx2BenchFileStream::SetSize(const INT64 /*Value*/)
+{
+    return E_NOTIMPL;
+}
+
+INT64 WINAPI Rx2BenchFileStream::GetPosition()
+{
+    return m_position;
+}
+
+HRESULT WINAPI Rx2BenchFileStream::Seek(const INT64 Offset, int Mode)
+{
+    INT64 base = 0;
+    switch (Mode)
+    {
+    case AIMP_STREAM_SEEKMODE_FROM_BEGINNING: base = 0;          break;
+    case AIMP_STREAM_SEEKMODE_FROM_CURRENT:   base = m_position; break;
+    case AIMP_STREAM_SEEKMODE_FROM_END:       base = m_size;     break;
+    default:                                  return E_INVALIDARG;
+    }
+
+    const INT64 target = base + Offset;
+    if (target < 0 || target > m_size)
+        return E_INVALIDARG;
+
+    m_position = target;
+    return S_OK;
+}
+
+int WINAPI Rx2BenchFileStream::Read(unsigned char* Buffer, unsigned int Count)
+{
+    const ssize_t n = pread(m_fd, Buffer, Count, static_cast<off_t>(m_position));
+    if (n <= 0)
+        return 0;
+
+    m_position += n;
+    return static_cast<int>(n);
+}
+
+HRESULT WINAPI Rx2BenchFileStream::Write(unsigned char* /*Buffer*/, unsigned int /*Count*/, unsigned int* /*Written*/)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT WINAPI Rx2BenchFileStream::GetClipping(INT64* Offset, INT64* Size)
+{
+    if (Offset)
+        *Offset = 0;
+    if (Size)
+        *Size = m_size;
+    return E_FAIL;   // not a clipped stream
+}
+
+HRESULT WINAPI Rx2BenchFileStream::GetFileName(IAIMPString** S)
+{
+    if (!S)
+        return E_POINTER;
+
+    Rx2BenchString* s = new (std::nothrow) Rx2BenchString();
+    if (!s)
+        return E_OUTOFMEMORY;
+
+    s->SetData(&m_path[0], static_cast<int>(m_path.size()));
+    *S = s;
+    return S_OK;
+}
+
+// ---------------- Rx2BenchErrorInfo ----------------
+
+Rx2BenchErrorInfo::Rx2BenchErrorInfo()
+    : m_refCount(1)
+{
+}
+
+HRESULT WINAPI Rx2BenchErrorInfo::QueryInterface(REFIID riid, void** ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IAIMPErrorInfo)
+    {
+        *ppv = static_cast<IAIMPErrorInfo*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2BenchErrorInfo::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2BenchErrorInfo::Release()
+{
+    const LONG count = InterlockedDecrement(&m_refCount);
+    if (count == 0)
+        delete this;
+    return count;
+}
+
+HRESULT WINAPI Rx2BenchErrorInfo::GetInfo(int* ErrorCode, IAIMPString** Message, IAIMPString** Details)
+{
+    if (ErrorCode)
+        *ErrorCode = 0;
+    if (Details)
+        *Details = nullptr;
+    return GetInfoFormatted(Message);
+}
+
+HRESULT WINAPI Rx2BenchErrorInfo::GetInfoFormatted(IAIMPString** S)
+{
+    if (!S)
+        return E_POINTER;
+
+    Rx2BenchString* s = new (std::nothrow) Rx2BenchString();
+    if (!s)
+        return E_OUTOFMEMORY;
+
+    s->SetData(&m_message[0], static_cast<int>(m_message.size()));
+    *S = s;
+    return S_OK;
+}
+
+void WINAPI Rx2BenchErrorInfo::SetInfo(int /*ErrorCode*/, IAIMPString* Message, IAIMPString* /*Details*/)
+{
+    if (Message)
+        m_message.assign(Message->GetData(), static_cast<size_t>(Message->GetLength()));
+    else
+        m_message.clear();
+}
+
+// ---------------- Rx2BenchFileInfo ----------------
+
+Rx2BenchFileInfo::Rx2BenchFileInfo()
+    : m_refCount(1)
+    , m_valuesSet(0)
+{
+}
+
+HRESULT WINAPI Rx2BenchFileInfo::QueryInterface(REFIID riid, void** ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IAIMPPropertyList || riid == IID_IAIMPFileInfo)
+    {
+        *ppv = static_cast<IAIMPFileInfo*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2BenchFileInfo::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2BenchFileInfo::Release()
+{
+    const LONG count = InterlockedDecrement(&m_refCount);
+    if (count == 0)
+        delete this;
+    return count;
+}
+
+HRESULT WINAPI Rx2BenchFileInfo::Reset()
+{
+    m_valuesSet = 0;
+    return S_OK;
+}
+
+HRESULT WINAPI Rx2BenchFileInfo::GetValueAsFloat(int /*PropertyID*/, double* /*Value*/)                { return E_FAIL; }
+HRESULT WINAPI Rx2BenchFileInfo::GetValueAsInt32(int /*PropertyID*/, int* /*Value*/)                   { return E_FAIL; }
+HRESULT WINAPI Rx2BenchFileInfo::GetValueAsInt64(int /*PropertyID*/, INT64* /*Value*/)                 { return E_FAIL; }
+HRESULT WINAPI Rx2BenchFileInfo::GetValueAsObject(int /*PropertyID*/, REFIID /*IID*/, void** /*Value*/) { return E_FAIL; }
+
+HRESULT WINAPI Rx2BenchFileInfo::SetValueAsFloat(int /*PropertyID*/, const double /*Value*/)   { ++m_valuesSet; return S_OK; }
+HRESULT WINAPI Rx2BenchFileInfo::SetValueAsInt32(int /*PropertyID*/, int /*Value*/)            { ++m_valuesSet; return S_OK; }
+HRESULT WINAPI Rx2BenchFileInfo::SetValueAsInt64(int /*PropertyID*/, const INT64 /*Value*/)    { ++m_valuesSet; return S_OK; }
+HRESULT WINAPI Rx2BenchFileInfo::SetValueAsObject(int /*PropertyID*/, IUnknown* /*Value*/)     { ++m_valuesSet; return S_OK; }
+
+HRESULT WINAPI Rx2BenchFileInfo::Assign(IAIMPFileInfo* /*Source*/) { return E_NOTIMPL; }
+HRESULT WINAPI Rx2BenchFileInfo::Clone(IAIMPFileInfo** /*Info*/)   { return E_NOTIMPL; }
+
+// ---------------- Rx2BenchCore ----------------
+
+Rx2BenchCore::Rx2BenchCore()
+    : m_refCount(1)
+{
+}
+
+HRESULT WINAPI Rx2BenchCore::QueryInterface(REFIID riid, void** ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown)
+    {
+        *ppv = static_cast<IAIMPCore*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    if (riid == IID_IAIMPServiceConfig)
+    {
+        *ppv = static_cast<IAIMPServiceConfig*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    if (riid == IID_IAIMPServiceFileStreaming)
+    {
+        *ppv = static_cast<IAIMPServiceFileStreaming*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+// The core lives on the bench's stack; counts are kept but never free it.
+ULONG WINAPI Rx2BenchCore::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2BenchCore::Release()
+{
+    return InterlockedDecrement(&m_refCount);
+}
+
+HRESULT WINAPI Rx2BenchCore::GetPath(int /*PathID*/, IAIMPString** Value)
+{
+    if (Value)
+        *Value = nullptr;
+    return E_NOTIMPL;
+}
+
+HRESULT WINAPI Rx2BenchCore::CreateObject(REFIID IID, void** Obj)
+{
+    if (!Obj)
+        return E_POINTER;
+
+    *Obj = nullptr;
+    if (IID != IID_IAIMPString)
+        return E_NOINTERFACE;
+
+    Rx2BenchString* s = new (std::nothrow) Rx2BenchString();
+    if (!s)
+        return E_OUTOFMEMORY;
+
+    *Obj = static_cast<IAIMPString*>(s);
+    return S_OK;
+}
+
+HRESULT WINAPI Rx2BenchCore::RegisterExtension(REFIID /*ServiceIID*/, IUnknown* /*Extension*/)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT WINAPI Rx2BenchCore::RegisterService(IUnknown* /*Service*/)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT WINAPI Rx2BenchCore::UnregisterExtension(IUnknown* /*Extension*/)
+{
+    return E_NOTIMPL;
+}
+
+HRESULT WINAPI Rx2BenchCore::FlushCache()
+{
+    return S_OK;
+}
+
+HRESULT WINAPI Rx2BenchCore::Delete(IAIMPString* KeyPath)
+{
+    if (!KeyPath)
+        return E_INVALIDARG;
+    m_config.erase(std::wstring(KeyPath->GetData(), KeyPath->GetLength()));
+    return S_OK;
+}
+
+HRESULT WINAPI Rx2BenchCore::GetValueAsFloat(IAIMPString* /*KeyPath*/, double* /*Value*/)
+{
+    return E_FAIL;
+}
+
+HRESULT WINAPI Rx2BenchCore::GetValueAsInt32(IAIMPString* KeyPath, int* Value)
+{
+    if (!KeyPath || !Value)
+        return E_INVALIDARG;
+
+    auto it = m_config.find(std::wstring(KeyPath->GetData(), KeyPath->GetLength()));
+    if (it == m_config.end())
+        return E_FAIL;
+
+    *Value = it->second;
+    return S_OK;
+}
+
+HRESULT WINAPI Rx2BenchCore::GetValueAsInt64(IAIMPString* /*KeyPath*/, INT64* /*Value*/)
+{
+    return E_FAIL;
+}
+
+HRESULT WINAPI Rx2BenchCore::GetValueAsStream(IAIMPString* /*KeyPath*/, IAIMPStream** /*Value*/)
+{
+    return E_FAIL;
+}
+
+HRESULT WINAPI Rx2BenchCore::GetValueAsString(IAIMPString* /*KeyPath*/, IAIMPString** /*Value*/)
+{
+    return E_FAIL;
+}
+
+HRESULT WINAPI Rx2BenchCore::CreateStreamForFile(IAIMPString* FileName, DWORD /*Flags*/, const INT64 /*Offset*/,
+                                                 const INT64 /*Size*/, IAIMPStream** Stream)
+{
+    if (!FileName || !Stream)
+        return E_INVALIDARG;
+
+    *Stream = nullptr;
+
+    std::string path;
+    for (int i = 0; i < FileName->GetLength(); ++i)
+        path.push_back(static_cast<char>(FileName->GetData()[i]));   // bench paths are ASCII
+
+    Rx2BenchFileStream* stream = new (std::nothrow) Rx2BenchFileStream(path);
+    if (!stream)
+        return E_OUTOFMEMORY;
+    if (!stream->IsOpen())
+    {
+        stream->Release();
+        return E_FAIL;
+    }
+
+    *Stream = stream;
+    return S_OK;
+}
+
+HRESULT WINAPI Rx2BenchCore::CreateStreamForFileURI(IAIMPString* /*FileURI*/, IAIMPVirtualFile** VirtualFile,
+                                                    IAIMPStream** Stream)
+{
+    if (VirtualFile)
+        *VirtualFile = nullptr;
+    if (Stream)
+        *Stream = nullptr;
+    return E_NOTIMPL;
+}
+
+// ---------------- storage presets ----------------
+
+const Rx2BenchStorageConfig kRx2BenchStorageConfigs[5] =
+{
+    { "f32",       32, false, false },
+    { "i16",       16, false, false },
+    { "i24",       24, false, false },
+    { "i16c",      16, true,  false },
+    { "f32_spill", 32, false, true  },
+};
+
+const Rx2BenchStorageConfig* Rx2BenchFindStorageConfig(const char* name)
+{
+    for (const Rx2BenchStorageConfig& config : kRx2BenchStorageConfigs)
+    {
+        if (strcmp(config.name, name) == 0)
+            return &config;
+    }
+    return nullptr;
+}
+
+void Rx2BenchApplyStorageConfig(Rx2BenchCore& core, const Rx2BenchStorageConfig& config)
+{
+    core.SetConfig(L"RX2Decoder\\PcmStorageBits", config.storageBits);
+    core.SetConfig(L"RX2Decoder\\PcmCompression", config.compression ? 1 : 0);
+    core.SetConfig(L"RX2Decoder\\PcmNativeOutput", 1);
+    core.SetConfig(L"RX2Decoder\\PcmSpillThresholdMB", config.spill ? 1 : 4096);
+    Rx2LoadSettings(&core);
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "apiCore.h"
+#include "apiFileManager.h"
+#include "apiObjects.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal AIMP host for the benchmarks: a core that creates strings and
+// exposes a config service backed by a key/value map and a file streaming
+// service, an in-memory stream that accounts for the time spent reading
+// it, a stream over a file on disk, an error info sink and a file info
+// sink.
+
+class Rx2BenchString : public IAIMPString
+{
+public:
+    Rx2BenchString();
+    virtual ~Rx2BenchString() {}
+
+    HRESULT WINAPI QueryInterface(REFIID riid, void** ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    HRESULT WINAPI GetChar(int Index, WCHAR* Char) override;
+    WCHAR*  WINAPI GetData() override;
+    int     WINAPI GetLength() override;
+    int     WINAPI GetHashCode() override;
+    HRESULT WINAPI SetChar(int Index, WCHAR Char) override;
+    HRESULT WINAPI SetData(WCHAR* Chars, int CharsCount) override;
+
+private:
+    LONG         m_refCount;
+    std::wstring m_data;
+};
+
+class Rx2BenchStream : public IAIMPStream
+{
+public:
+    explicit Rx2BenchStream(const std::vector<std::uint8_t>& data);
+    virtual ~Rx2BenchStream() {}
+
+    HRESULT WINAPI QueryInterface(REFIID riid, void** ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    INT64   WINAPI GetSize() override;
+    HRESULT WINAPI SetSize(const INT64 Value) override;
+    INT64   WINAPI GetPosition() override;
+    HRESULT WINAPI Seek(const INT64 Offset, int Mode) override;
+    int     WINAPI Read(unsigned char* Buffer, unsigned int Count) override;
+    HRESULT WINAPI Write(unsigned char* Buffer, unsigned int Count, unsigned int* Written) override;
+
+    // Time spent in Read() since the last reset.
+    std::int64_t ReadNs() const { return m_readNs; }
+    void         ResetReadNs()  { m_readNs = 0; }
+
+private:
+    LONG                             m_refCount;
+    const std::vector<std::uint8_t>& m_data;
+    INT64                            m_position;
+    std::int64_t                     m_readNs;
+};
+
+// Named file on disk, as AIMP hands a playlist entry to CreateDecoder.
+class Rx2BenchFileStream : public IAIMPFileStream
+{
+public:
+    explicit Rx2BenchFileStream(const std::string& path);
+    virtual ~Rx2BenchFileStream();
+
+    bool IsOpen() const { return m_fd >= 0; }
+
+    HRESULT WINAPI QueryInterface(REFIID riid, void** ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    INT64   WINAPI GetSize() override;
+    HRESULT WINAPI SetSize(const INT64 Value) override;
+    INT64   WINAPI GetPosition() override;
+    HRESULT WINAPI Seek(const INT64 Offset, int Mode) override;
+    int     WINAPI Read(unsigned char* Buffer, unsigned int Count) override;
+    HRESULT WINAPI Write(unsigned char* Buffer, unsigned int Count, unsigned int* Written) override;
+
+    HRESULT WINAPI GetClipping(INT64* Offset, INT64* Size) override;
+    HRESULT WINAPI GetFileName(IAIMPString** S) override;
+
+private:
+    LONG         m_refCount;
+    int          m_fd;
+    std::wstring m_path;
+    INT64        m_size;
+    INT64        m_position;
+};
+
+class Rx2BenchErrorInfo : public IAIMPErrorInfo
+{
+public:
+    Rx2BenchErrorInfo();
+    virtual ~Rx2BenchErrorInfo() {}
+
+    // Text of the last SetInfo(); empty if none.
+    const std::wstring& Message() const { return m_message; }
+    void                Clear()         { m_message.clear(); }
+
+    HRESULT WINAPI QueryInterface(REFIID riid, void** ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    HRESULT WINAPI GetInfo(int* ErrorCode, IAIMPString** Message, IAIMPString** Details) override;
+    HRESULT WINAPI GetInfoFormatted(IAIMPString** S) override;
+    void    WINAPI SetInfo(int ErrorCode, IAIMPString* Message, IAIMPString* Details) override;
+
+private:
+    LONG         m_refCount;
+    std::wstring m_message;
+};
+
+// Takes the properties a decoder's GetFileInfo sets and only counts them.
+class Rx2BenchFileInfo : public IAIMPFileInfo
+{
+public:
+    Rx2BenchFileInfo();
+    virtual ~Rx2BenchFileInfo() {}
+
+    int ValuesSet() const { return m_valuesSet; }
+
+    HRESULT WINAPI QueryInterface(REFIID riid, void** ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    void    WINAPI BeginUpdate() override {}
+    void    WINAPI EndUpdate() override {}
+    HRESULT WINAPI Reset() override;
+    HRESULT WINAPI GetValueAsFloat(int PropertyID, double* Value) override;
+    HRESULT WINAPI GetValueAsInt32(int PropertyID, int* Value) override;
+    HRESULT WINAPI GetValueAsInt64(int PropertyID, INT64* Value) override;
+    HRESULT WINAPI GetValueAsObject(int PropertyID, REFIID IID, void** Value) override;
+    HRESULT WINAPI SetValueAsFloat(int PropertyID, const double Value) override;
+    HRESULT WINAPI SetValueAsInt32(int PropertyID, int Value) override;
+    HRESULT WINAPI SetValueAsInt64(int PropertyID, const INT64 Value) override;
+    HRESULT WINAPI SetValueAsObject(int PropertyID, IUnknown* Value) override;
+
+    HRESULT WINAPI Assign(IAIMPFileInfo* Source) override;
+    HRESULT WINAPI Clone(IAIMPFileInfo** Info) override;
+
+private:
+    LONG m_refCount;
+    int  m_valuesSet;
+};
+
+class Rx2BenchCore : public IAIMPCore, public IAIMPServiceConfig, public IAIMPServiceFileStreaming
+{
+public:
+    Rx2BenchCore();
+
+    // Values returned for "RX2Decoder\\<key>"; absent keys fail like AIMP's.
+    void SetConfig(const std::wstring& key, int value) { m_config[key] = value; }
+    void ClearConfig()                                 { m_config.clear(); }
+
+    HRESULT WINAPI QueryInterface(REFIID riid, void** ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    // IAIMPCore
+    HRESULT WINAPI GetPath(int PathID, IAIMPString** Value) override;
+    HRESULT WINAPI CreateObject(REFIID IID, void** Obj) override;
+    HRESULT WINAPI RegisterExtension(REFIID ServiceIID, IUnknown* Extension) override;
+    HRESULT WINAPI RegisterService(IUnknown* Service) override;
+    HRESULT WINAPI UnregisterExtension(IUnknown* Extension) override;
+
+    // IAIMPServiceConfig
+    HRESULT WINAPI FlushCache() override;
+    HRESULT WINAPI Delete(IAIMPString* KeyPath) override;
+    HRESULT WINAPI GetValueAsFloat(IAIMPString* KeyPath, double* Value) override;
+    HRESULT WINAPI GetValueAsInt32(IAIMPString* KeyPath, int* Value) override;
+    HRESULT WINAPI GetValueAsInt64(IAIMPString* KeyPath, INT64* Value) override;
+    HRESULT WINAPI GetValueAsStream(IAIMPString* KeyPath, IAIMPStream** Value) override;
+    HRESULT WINAPI GetValueAsString(IAIMPString* KeyPath, IAIMPString** Value) override;
+
+    // IAIMPServiceFileStreaming
+    HRESULT WINAPI CreateStreamForFile(IAIMPString* FileName, DWORD Flags, const INT64 Offset,
+                                       const INT64 Size, IAIMPStream** Stream) override;
+    HRESULT WINAPI CreateStreamForFileURI(IAIMPString* FileURI, IAIMPVirtualFile** VirtualFile,
+                                          IAIMPStream** Stream) override;
+
+private:
+    LONG                        m_refCount;
+    std::map<std::wstring, int> m_config;
+};
+
+// Storage presets shared by the bench tools. Applying one sets the PCM
+// storage keys and reloads the plugin's settings; other keys are kept.
+struct Rx2BenchStorageConfig
+{
+    const char* name;
+    int         storageBits;
+    bool        compression;
+    bool        spill;         // force the memory-mapped store
+};
+
+extern const Rx2BenchStorageConfig kRx2BenchStorageConfigs[5];
+
+const Rx2BenchStorageConfig* Rx2BenchFindStorageConfig(const char* name);
+void                         Rx2BenchApplyStorageConfig(Rx2BenchCore& core, const Rx2BenchStorageConfig& config);
@@ -0,0 +1,141 @@
+#include "Rx2BenchCorpus.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Loop shapes cycled through for the valid files: short one-shots up to
+// long stereo phrases, at both common rates and bit depths.
+static const Rx2BenchLoop kShapes[] =
+{
+    // ch  rate   slices bits seconds muted hang
+    { 2, 44100, 16, 16,  2.0, false, 0 },
+    { 1, 44100,  8, 16,  1.0, false, 0 },
+    { 2, 48000, 32, 24,  4.0, false, 0 },
+    { 2, 44100, 16, 16,  8.0, false, 0 },
+    { 1, 48000,  4, 24,  0.5, false, 0 },
+    { 2, 44100, 64, 24, 16.0, false, 0 },
+};
+
+const char* Rx2BenchFileKindName(Rx2BenchFileKind kind)
+{
+    switch (kind)
+    {
+    case Rx2BenchFileKind::Valid:      return "valid";
+    case Rx2BenchFileKind::Corrupt:    return "corrupt";
+    case Rx2BenchFileKind::Truncated:  return "truncated";
+    case Rx2BenchFileKind::Wav:        return "wav";
+    case Rx2BenchFileKind::ZeroLength: return "zero_length";
+    case Rx2BenchFileKind::Silent:     return "silent";
+    case Rx2BenchFileKind::Empty:      return "empty";
+    case Rx2BenchFileKind::Hanging:    return "hanging";
+    }
+    return "?";
+}
+
+bool Rx2BenchFileKindHasRexError(Rx2BenchFileKind kind)
+{
+    return kind == Rx2BenchFileKind::Corrupt
+        || kind == Rx2BenchFileKind::Truncated
+        || kind == Rx2BenchFileKind::ZeroLength
+        || kind == Rx2BenchFileKind::Silent
+        || kind == Rx2BenchFileKind::Hanging;
+}
+
+Rx2BenchCorpus::Rx2BenchCorpus()
+    : m_temporary(false)
+{
+}
+
+Rx2BenchCorpus::~Rx2BenchCorpus()
+{
+    if (!m_temporary)
+        return;
+
+    for (const Rx2BenchCorpusFile& file : m_files)
+        unlink(file.path.c_str());
+    rmdir(m_dir.c_str());
+}
+
+bool Rx2BenchCorpus::WriteFile(const std::string& name, const std::vector<std::uint8_t>& data,
+                               Rx2BenchFileKind kind, const Rx2BenchLoop& loop)
+{
+    Rx2BenchCorpusFile file;
+    file.path = m_dir + "/" + name;
+    file.kind = kind;
+    file.loop = loop;
+
+    FILE* f = fopen(file.path.c_str(), "wb");
+    if (!f)
+        return false;
+    const bool ok = data.empty() || fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (fclose(f) != 0 || !ok)
+        return false;
+
+    m_files.push_back(file);
+    return true;
+}
+
+bool Rx2BenchCorpus::Create(const std::string& dir, int validFiles, int hangMs)
+{
+    if (dir.empty())
+    {
+        const char* tmp = getenv("TMPDIR");
+        std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/rx2-corpus-XXXXXX";
+        if (!mkdtemp(&pattern[0]))
+            return false;
+        m_dir       = pattern;
+        m_temporary = true;
+    }
+    else
+    {
+        m_dir = dir;
+        mkdir(m_dir.c_str(), 0755);
+    }
+
+    char name[64];
+    for (int i = 0; i < validFiles; ++i)
+    {
+        const Rx2BenchLoop& shape = kShapes[i % (sizeof(kShapes) / sizeof(kShapes[0]))];
+        snprintf(name, sizeof(name), "valid_%03d.rx2", i);
+        if (!WriteFile(name, Rx2BenchMakeRexFile(shape), Rx2BenchFileKind::Valid, shape))
+            return false;
+    }
+
+    const Rx2BenchLoop base = { 2, 44100, 16, 16, 4.0, false, 0 };
+
+    std::vector<std::uint8_t> corrupt = Rx2BenchMakeRexFile(base);
+    memcpy(corrupt.data(), "JUNK", 4);
+
+    std::vector<std::uint8_t> truncated = Rx2BenchMakeRexFile(base);
+    truncated.resize(truncated.size() * 3 / 5);
+
+    // A canonical 44-byte WAV header followed by a little silence.
+    static const std::uint8_t kWavHeader[44] =
+    {
+        'R', 'I', 'F', 'F', 0x24, 0x10, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 2, 0, 0x44, 0xAC, 0, 0,
+        0x10, 0xB1, 0x02, 0, 4, 0, 16, 0, 'd', 'a', 't', 'a', 0, 0x10, 0, 0
+    };
+    std::vector<std::uint8_t> wav(kWavHeader, kWavHeader + sizeof(kWavHeader));
+    wav.resize(wav.size() + 4096, 0);
+
+    Rx2BenchLoop zero = base;
+    zero.seconds = 0.0;
+
+    Rx2BenchLoop silent = base;
+    silent.muted = true;
+
+    Rx2BenchLoop hanging = base;
+    hanging.hangMs = hangMs;
+
+    return WriteFile("corrupt.rx2",     corrupt,                      Rx2BenchFileKind::Corrupt,    base)
+        && WriteFile("truncated.rx2",   truncated,                    Rx2BenchFileKind::Truncated,  base)
+        && WriteFile("riff.rx2",        wav,                          Rx2BenchFileKind::Wav,        base)
+        && WriteFile("zero_length.rx2", Rx2BenchMakeRexFile(zero),    Rx2BenchFileKind::ZeroLength, zero)
+        && WriteFile("silent.rx2",      Rx2BenchMakeRexFile(silent),  Rx2BenchFileKind::Silent,     silent)
+        && WriteFile("empty.rx2",       std::vector<std::uint8_t>(),  Rx2BenchFileKind::Empty,      base)
+        && WriteFile("hanging.rx2",     Rx2BenchMakeRexFile(hanging), Rx2BenchFileKind::Hanging,    hanging);
+}
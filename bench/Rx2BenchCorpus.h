@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Rx2BenchRex.h"
+
+#include <string>
+#include <vector>
+
+// A directory of stand-in REX files for the end-to-end harnesses: valid
+// loops in a spread of shapes, plus one file of each invalid kind CreateDecoder
+// has to turn away.
+enum class Rx2BenchFileKind
+{
+    Valid,
+    Corrupt,      // unknown header          -> kREXError_FileCorrupt at preflight
+    Truncated,    // payload cut short       -> kREXError_FileCorrupt at preflight
+    Wav,          // RIFF/WAVE               -> rejected before any REX call
+    ZeroLength,   // Bars/Beats not set      -> kREXError_FileHasZeroLoopLength
+    Silent,       // every slice muted       -> kRexError_NoActiveSlices after a full render
+    Empty,        // zero bytes              -> rejected before any REX call
+    Hanging       // REXCreate stalls        -> kRexError_CreateTimedOut once the sandbox times out
+};
+
+const char* Rx2BenchFileKindName(Rx2BenchFileKind kind);
+
+// Kinds whose rejection carries a REX error (and so an error message and a
+// negative-cache entry).
+bool Rx2BenchFileKindHasRexError(Rx2BenchFileKind kind);
+
+struct Rx2BenchCorpusFile
+{
+    std::string      path;
+    Rx2BenchFileKind kind;
+    Rx2BenchLoop     loop;   // shape the file was generated from
+};
+
+class Rx2BenchCorpus
+{
+public:
+    Rx2BenchCorpus();
+    ~Rx2BenchCorpus();
+
+    // Writes `validFiles` valid loops and one file per invalid kind into
+    // `dir`, or into a fresh temporary directory (removed again by the
+    // destructor) if `dir` is empty. The hanging file stalls REXCreate for
+    // `hangMs`, past the plugin's default sandbox timeout.
+    bool Create(const std::string& dir, int validFiles, int hangMs = 3000);
+
+    const std::vector<Rx2BenchCorpusFile>& Files() const { return m_files; }
+    const std::string&                     Dir() const   { return m_dir; }
+
+private:
+    bool WriteFile(const std::string& name, const std::vector<std::uint8_t>& data,
+                   Rx2BenchFileKind kind, const Rx2BenchLoop& loop);
+
+    std::string                     m_dir;
+    bool                            m_temporary;
+    std::vector<Rx2BenchCorpusFile> m_files;
+};
@@ -0,0 +1,89 @@
+#include "Rx2BenchOpen.h"
+#include "Rx2BenchAimp.h"
+#include "Rx2BenchRex.h"
+
+#include "Rx2DecoderExtension.h"
+
+#include <new>
+
+// AIMP's decode buffers are in this range.
+static const int kReadBytes = 16384;
+
+const char* Rx2BenchPhaseName(int phase)
+{
+    static const char* const kNames[kRx2BenchPhaseCount] =
+    {
+        "validate", "ingest", "create", "setup", "render", "first_read"
+    };
+    return (phase >= 0 && phase < kRx2BenchPhaseCount) ? kNames[phase] : "?";
+}
+
+static std::int64_t Span(std::int64_t from, std::int64_t to)
+{
+    return (from > 0 && to >= from) ? to - from : -1;
+}
+
+void Rx2BenchOpenFile(Rx2DecoderExtension* extension, const std::string& path,
+                      Rx2BenchOpenResult* result, IAIMPAudioDecoder** decoder)
+{
+    result->hr      = E_FAIL;
+    result->audio   = false;
+    result->error.clear();
+    result->openNs  = 0;
+    result->totalNs = 0;
+    for (std::int64_t& ns : result->phaseNs)
+        ns = -1;
+
+    if (decoder)
+        *decoder = nullptr;
+
+    Rx2BenchFileStream* stream    = new Rx2BenchFileStream(path);
+    Rx2BenchErrorInfo*  errorInfo = new Rx2BenchErrorInfo();
+    IAIMPAudioDecoder*  dec       = nullptr;
+
+    Rx2BenchRexResetMarks();
+
+    const std::int64_t t0 = Rx2BenchNowNs();
+    result->hr = extension->CreateDecoder(stream, 0, errorInfo, &dec);
+    const std::int64_t t1 = Rx2BenchNowNs();
+
+    std::int64_t t2 = t1;
+    if (SUCCEEDED(result->hr) && dec)
+    {
+        int sampleRate = 0, channels = 0, sampleFormat = 0;
+        if (dec->GetStreamInfo(&sampleRate, &channels, &sampleFormat))
+        {
+            unsigned char buffer[kReadBytes];
+            for (int attempt = 0; attempt < 64 && !result->audio; ++attempt)
+                result->audio = dec->Read(buffer, sizeof(buffer)) > 0;
+        }
+        t2 = Rx2BenchNowNs();
+    }
+
+    const Rx2BenchRexMarks marks = Rx2BenchRexGetMarks();
+
+    result->openNs  = t1 - t0;
+    result->totalNs = t2 - t0;
+    result->error   = errorInfo->Message();
+
+    if (result->audio)
+    {
+        result->phaseNs[kRx2BenchPhaseValidate]  = Span(t0,                   marks.firstInfoEndNs);
+        result->phaseNs[kRx2BenchPhaseIngest]    = Span(marks.firstInfoEndNs, marks.lastInfoEndNs);
+        result->phaseNs[kRx2BenchPhaseCreate]    = Span(marks.lastInfoEndNs,  marks.getInfoNs);
+        result->phaseNs[kRx2BenchPhaseSetup]     = Span(marks.getInfoNs,      marks.renderStartNs);
+        result->phaseNs[kRx2BenchPhaseRender]    = Span(marks.renderStartNs,  t1);
+        result->phaseNs[kRx2BenchPhaseFirstRead] = Span(t1,                   t2);
+    }
+
+    errorInfo->Release();
+    stream->Release();   // the decoder keeps its own reference
+
+    if (dec)
+    {
+        if (decoder)
+            *decoder = dec;
+        else
+            dec->Release();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "apiDecoders.h"
+
+#include <cstdint>
+#include <string>
+
+class Rx2DecoderExtension;
+
+// Stages of one open as the end-to-end harnesses split it, bounded by the
+// stand-in's per-thread marks (Rx2BenchRexMarks):
+//   validate    CreateDecoder entry .. first header parse: file key,
+//               negative cache, WAV check, library load, preflight read
+//   ingest      .. the decoder's own header parse: whole-file read
+//   create      .. REXCreate has returned: sandbox thread + "decompression"
+//   setup       .. rendering starts: REX info, store allocation
+//   render      .. CreateDecoder returns: render, analysis, cache stores
+//   first_read  .. the first Read() that returns audio
+// An open the library index vouches for parses no header, so validate,
+// ingest and create have no bounds and stay -1.
+enum Rx2BenchPhase
+{
+    kRx2BenchPhaseValidate,
+    kRx2BenchPhaseIngest,
+    kRx2BenchPhaseCreate,
+    kRx2BenchPhaseSetup,
+    kRx2BenchPhaseRender,
+    kRx2BenchPhaseFirstRead,
+    kRx2BenchPhaseCount
+};
+
+const char* Rx2BenchPhaseName(int phase);
+
+struct Rx2BenchOpenResult
+{
+    HRESULT      hr;                            // from CreateDecoder
+    bool         audio;                         // a Read() returned data
+    std::wstring error;                         // message left in the error info
+    std::int64_t openNs;                        // CreateDecoder alone
+    std::int64_t totalNs;                       // to first audio, or to the failure
+    std::int64_t phaseNs[kRx2BenchPhaseCount];  // -1 where the marks are missing
+};
+
+// Opens `path` through the extension the way AIMP does (file stream, error
+// info, CreateDecoder, GetStreamInfo, Read until data arrives). The decoder
+// is returned through `decoder` if given, otherwise released.
+void Rx2BenchOpenFile(Rx2DecoderExtension* extension, const std::string& path,
+                      Rx2BenchOpenResult* result, IAIMPAudioDecoder** decoder);
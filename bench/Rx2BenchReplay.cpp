@@ -0,0 +1,545 @@
+// Replays a call log written by the plugin's call recorder (Rx2CallLog.h)
+// against the decoder extension, headless: the same CreateDecoder calls on
+// the same files, then the same sequence of decoder calls, timing each one
+// and checking its result against the recorded one. Calls are issued from
+// one thread in the order they were recorded, as fast as possible or, with
+// --realtime, at their recorded times. See the "Benchmarks" section of
+// README.md.
+
+#include "Rx2BenchAimp.h"
+#include "Rx2BenchReport.h"
+#include "Rx2BenchRex.h"
+
+#include "Rx2CallLog.h"
+#include "Rx2DecoderExtension.h"
+#include "Rx2Metrics.h"
+#include "Rx2RexLibrary.h"
+#include "Rx2RexShim.h"
+#include "Rx2RtAudit.h"
+#include "Rx2SliceTrack.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ---------------- options ----------------
+
+struct ReplayOptions
+{
+    std::string logPath;
+    std::vector<std::pair<std::string, std::string>> maps;   // path prefix FROM -> TO
+    bool        realtime;     // pace calls by their recorded times
+    std::string config;       // storage preset
+    int         timeoutMs;    // the plugin's REXCreate timeout; 0 = its default
+    double      threshold;    // regression threshold, percent
+    std::string outPath;
+    std::string baselinePath;
+    std::string faultsPath;   // REX API fault script
+    std::string metricsPath;  // the plugin's counters, REX call timings included
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: rx2_replay [options] FILE.rx2calls\n"
+            "  --map FROM=TO    open recorded paths starting with FROM under TO instead;\n"
+            "                   repeatable, backslashes become slashes afterwards\n"
+            "  --realtime       issue calls at their recorded times (default: back to back)\n"
+            "  --config NAME    storage preset: f32, i16, i24, i16c, f32_spill (default f32)\n"
+            "  --timeout-ms N   the plugin's REXCreate timeout (default: the plugin's)\n"
+            "  --out FILE       write the JSON report to FILE instead of stdout\n"
+            "  --baseline FILE  compare against an earlier report; exit 1 on regressions\n"
+            "  --threshold PCT  allowed slowdown before a result is flagged (default 10)\n"
+            "  --rex-faults FILE\n"
+            "                   turn the REX API shim on with the faults scripted in FILE\n"
+            "                   (see Rx2RexShim.h; an empty file only times the calls)\n"
+            "  --metrics FILE   also write the plugin's counters, REX call timings included\n");
+}
+
+static bool ParseOptions(int argc, char** argv, ReplayOptions* opt)
+{
+    opt->realtime  = false;
+    opt->config    = "f32";
+    opt->timeoutMs = 0;
+    opt->threshold = 10.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (arg == "--realtime")
+        {
+            opt->realtime = true;
+            continue;
+        }
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            if (!opt->logPath.empty())
+            {
+                fprintf(stderr, "rx2_replay: more than one call log given\n");
+                return false;
+            }
+            opt->logPath = arg;
+            continue;
+        }
+
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            fprintf(stderr, "rx2_replay: missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if (arg == "--map")
+        {
+            const char* eq = strchr(value, '=');
+            if (!eq || eq == value)
+            {
+                fprintf(stderr, "rx2_replay: --map wants FROM=TO, got %s\n", value);
+                return false;
+            }
+            opt->maps.emplace_back(std::string(value, eq), std::string(eq + 1));
+        }
+        else if (arg == "--config")     opt->config       = value;
+        else if (arg == "--timeout-ms") opt->timeoutMs    = atoi(value);
+        else if (arg == "--out")        opt->outPath      = value;
+        else if (arg == "--baseline")   opt->baselinePath = value;
+        else if (arg == "--threshold")  opt->threshold    = atof(value);
+        else if (arg == "--rex-faults") opt->faultsPath   = value;
+        else if (arg == "--metrics")    opt->metricsPath  = value;
+        else
+        {
+            fprintf(stderr, "rx2_replay: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (opt->logPath.empty())
+    {
+        fprintf(stderr, "rx2_replay: no call log given\n");
+        return false;
+    }
+    if (!Rx2BenchFindStorageConfig(opt->config.c_str()))
+    {
+        fprintf(stderr, "rx2_replay: unknown storage preset %s\n", opt->config.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---------------- call log ----------------
+
+struct CallLog
+{
+    std::vector<Rx2CallRecord>             calls;    // everything but kRx2CallFile
+    std::map<std::uint32_t, std::string>   files;    // file id -> UTF-8 path
+    std::uint64_t                          dropped;
+};
+
+static void AppendUtf8(std::string& out, std::uint32_t c)
+{
+    if (c < 0x80)
+    {
+        out += static_cast<char>(c);
+    }
+    else if (c < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (c >> 6));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    }
+    else if (c < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (c >> 12));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (c >> 18));
+        out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (c & 0x3F));
+    }
+}
+
+static std::string Utf16ToUtf8(const std::uint16_t* units, size_t count)
+{
+    std::string out;
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::uint32_t c = units[i];
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < count && units[i + 1] >= 0xDC00 && units[i + 1] < 0xE000)
+            c = 0x10000 + ((c - 0xD800) << 10) + (units[++i] - 0xDC00);
+        AppendUtf8(out, c);
+    }
+    return out;
+}
+
+static bool ReadCallLog(const std::string& path, CallLog* log)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+    {
+        fprintf(stderr, "rx2_replay: cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<unsigned char> data;
+    unsigned char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        data.insert(data.end(), chunk, chunk + n);
+    fclose(f);
+
+    Rx2CallFileHeader header;
+    if (data.size() < sizeof(header))
+    {
+        fprintf(stderr, "rx2_replay: %s is not a call log\n", path.c_str());
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, kRx2CallMagic, sizeof(header.magic)) != 0
+        || header.version != kRx2CallVersion || header.recordSize != sizeof(Rx2CallRecord))
+    {
+        fprintf(stderr, "rx2_replay: %s is not a version %u call log\n",
+                path.c_str(), static_cast<unsigned>(kRx2CallVersion));
+        return false;
+    }
+
+    log->calls.clear();
+    log->files.clear();
+    log->dropped = 0;
+
+    size_t pos = sizeof(header);
+    while (pos + sizeof(Rx2CallRecord) <= data.size())
+    {
+        Rx2CallRecord record;
+        memcpy(&record, data.data() + pos, sizeof(record));
+        pos += sizeof(record);
+
+        if (record.op == kRx2CallFile)
+        {
+            const size_t bytes  = static_cast<size_t>(record.arg);
+            const size_t padded = (bytes + 7) & ~static_cast<size_t>(7);
+            if (record.arg < 0 || pos + padded > data.size())
+                break;
+
+            std::vector<std::uint16_t> units(bytes / sizeof(std::uint16_t));
+            if (!units.empty())
+                memcpy(units.data(), data.data() + pos, units.size() * sizeof(std::uint16_t));
+            log->files[record.decoder] = Utf16ToUtf8(units.data(), units.size());
+            pos += padded;
+        }
+        else if (record.op == kRx2CallDropped)
+        {
+            log->dropped += static_cast<std::uint64_t>(record.arg);
+        }
+        else if (record.op > kRx2CallFile && record.op < kRx2CallOpCount)
+        {
+            log->calls.push_back(record);
+        }
+    }
+
+    // The writer flushes four times a second; a log cut short by a crash
+    // just ends early.
+    if (pos != data.size())
+        fprintf(stderr, "rx2_replay: %s: ignoring %zu trailing bytes\n", path.c_str(), data.size() - pos);
+    return true;
+}
+
+static bool ReadTextFile(const std::string& path, std::string* text)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f)
+        return false;
+
+    char   chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        text->append(chunk, n);
+    fclose(f);
+    return true;
+}
+
+static std::string MapPath(const std::string& recorded, const ReplayOptions& opt)
+{
+    std::string path = recorded;
+    for (const auto& map : opt.maps)
+    {
+        if (path.compare(0, map.first.size(), map.first) == 0)
+        {
+            path = map.second + path.substr(map.first.size());
+            break;
+        }
+    }
+    for (char& c : path)
+    {
+        if (c == '\\')
+            c = '/';
+    }
+    return path;
+}
+
+// ---------------- replay ----------------
+
+struct ReplayStats
+{
+    std::vector<double> us[kRx2CallOpCount];   // latency of each call, by op
+    size_t              calls      = 0;
+    size_t              skipped    = 0;        // the decoder was not created here
+    size_t              mismatches = 0;        // result differs from the recording
+};
+
+static void Mismatch(ReplayStats* stats, const Rx2CallRecord& record, std::int64_t result)
+{
+    if (stats->mismatches++ < 10)
+    {
+        fprintf(stderr, "rx2_replay: %s on decoder %u returned %lld, recorded %lld\n",
+                Rx2CallOpName(record.op), static_cast<unsigned>(record.decoder),
+                static_cast<long long>(result), static_cast<long long>(record.result));
+    }
+}
+
+static IAIMPAudioDecoder* ReplayCreate(Rx2DecoderExtension* extension, const CallLog& log,
+                                       const Rx2CallRecord& record, const ReplayOptions& opt,
+                                       std::int64_t* result)
+{
+    const std::uint32_t fileId = static_cast<std::uint32_t>(record.arg & 0xFFFFFFFF);
+    const int           slice  = static_cast<int>((record.arg >> 32) & 0xFFFF) - 1;
+    const LongWord      flags  = static_cast<LongWord>((record.arg >> 48) & 0xFFFF);
+
+    auto file = log.files.find(fileId);
+    if (file == log.files.end())
+    {
+        *result = E_FAIL;
+        return nullptr;
+    }
+
+    IAIMPStream* stream = new Rx2BenchFileStream(MapPath(file->second, opt));
+    if (slice >= 0)
+    {
+        IAIMPStream* sliceStream = new Rx2SliceStream(stream, slice);
+        stream->Release();
+        stream = sliceStream;
+    }
+
+    Rx2BenchErrorInfo* errorInfo = new Rx2BenchErrorInfo();
+    IAIMPAudioDecoder* decoder   = nullptr;
+    *result = extension->CreateDecoder(stream, flags, errorInfo, &decoder);
+    errorInfo->Release();
+    stream->Release();   // the decoder keeps its own reference
+
+    if (FAILED(*result) && decoder)
+    {
+        decoder->Release();
+        decoder = nullptr;
+    }
+    return decoder;
+}
+
+// One decoder call; returns its result in the recording's terms.
+static std::int64_t ReplayDecoderCall(IAIMPAudioDecoder* decoder, const Rx2CallRecord& record,
+                                      std::vector<unsigned char>& buffer)
+{
+    switch (record.op)
+    {
+    case kRx2CallGetFileInfo:
+    {
+        Rx2BenchFileInfo* info = new Rx2BenchFileInfo();
+        const BOOL ok = decoder->GetFileInfo(info);
+        info->Release();
+        return ok;
+    }
+    case kRx2CallGetStreamInfo:
+    {
+        int sampleRate = 0, channels = 0, sampleFormat = 0;
+        return decoder->GetStreamInfo(&sampleRate, &channels, &sampleFormat);
+    }
+    case kRx2CallIsSeekable:       return decoder->IsSeekable();
+    case kRx2CallIsRealTimeStream: return decoder->IsRealTimeStream();
+    case kRx2CallGetAvailableData: return decoder->GetAvailableData();
+    case kRx2CallGetSize:          return decoder->GetSize();
+    case kRx2CallGetPosition:      return decoder->GetPosition();
+    case kRx2CallSetPosition:      return decoder->SetPosition(record.arg);
+    case kRx2CallRead:
+    {
+        const int count = record.arg > 0 ? static_cast<int>(record.arg) : 0;
+        if (buffer.size() < static_cast<size_t>(count))
+            buffer.resize(static_cast<size_t>(count));
+        return decoder->Read(buffer.data(), count);
+    }
+    default:
+        return 0;
+    }
+}
+
+static void Replay(Rx2DecoderExtension* extension, const CallLog& log, const ReplayOptions& opt,
+                   ReplayStats* stats)
+{
+    std::map<std::uint32_t, IAIMPAudioDecoder*> decoders;   // recorded id -> ours
+    std::vector<unsigned char>                  buffer(16384);
+
+    const std::int64_t start = Rx2BenchNowNs();
+    for (const Rx2CallRecord& record : log.calls)
+    {
+        if (opt.realtime)
+        {
+            const std::int64_t due = start + record.timeUs * 1000;
+            const std::int64_t now = Rx2BenchNowNs();
+            if (due > now)
+                Sleep(static_cast<DWORD>((due - now) / 1000000));
+        }
+
+        std::int64_t result = 0;
+        std::int64_t t0     = 0;
+
+        if (record.op == kRx2CallCreateDecoder)
+        {
+            t0 = Rx2BenchNowNs();
+            IAIMPAudioDecoder* decoder = ReplayCreate(extension, log, record, opt, &result);
+            stats->us[record.op].push_back((Rx2BenchNowNs() - t0) / 1e3);
+            ++stats->calls;
+
+            // HRESULTs of failures differ between the real library and the
+            // stand-in; only success has to match.
+            if (SUCCEEDED(result) != SUCCEEDED(record.result))
+                Mismatch(stats, record, result);
+            if (decoder && record.decoder)
+                decoders[record.decoder] = decoder;
+            else if (decoder)
+                decoder->Release();
+            continue;
+        }
+
+        auto it = decoders.find(record.decoder);
+        if (it == decoders.end())
+        {
+            // A decoder that failed inside CreateDecoder is destroyed there
+            // without ever being handed out.
+            if (record.op != kRx2CallDestroy)
+                ++stats->skipped;
+            continue;
+        }
+
+        if (record.op == kRx2CallDestroy)
+        {
+            t0 = Rx2BenchNowNs();
+            it->second->Release();
+            stats->us[record.op].push_back((Rx2BenchNowNs() - t0) / 1e3);
+            ++stats->calls;
+            decoders.erase(it);
+            continue;
+        }
+
+        t0 = Rx2BenchNowNs();
+        result = ReplayDecoderCall(it->second, record, buffer);
+        stats->us[record.op].push_back((Rx2BenchNowNs() - t0) / 1e3);
+        ++stats->calls;
+
+        if (result != record.result)
+            Mismatch(stats, record, result);
+    }
+
+    // Decoders still open when recording stopped.
+    for (auto& entry : decoders)
+        entry.second->Release();
+}
+
+// ---------------- main ----------------
+
+int main(int argc, char** argv)
+{
+    ReplayOptions opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    CallLog log;
+    if (!ReadCallLog(opt.logPath, &log))
+        return 2;
+
+    fprintf(stderr, "rx2_replay: %zu calls on %zu files from %s, %s storage%s\n",
+            log.calls.size(), log.files.size(), opt.logPath.c_str(), opt.config.c_str(),
+            opt.realtime ? ", real time" : "");
+    if (log.dropped)
+        fprintf(stderr, "rx2_replay: the recording lost %llu calls to a full ring\n",
+                static_cast<unsigned long long>(log.dropped));
+
+    Rx2BenchCore core;
+    if (opt.timeoutMs > 0)
+        core.SetConfig(L"RX2Decoder\\RexCreateTimeoutMs", opt.timeoutMs);
+    Rx2BenchApplyStorageConfig(core, *Rx2BenchFindStorageConfig(opt.config.c_str()));
+
+    if (!opt.faultsPath.empty())
+    {
+        std::string script, error;
+        if (!ReadTextFile(opt.faultsPath, &script))
+        {
+            fprintf(stderr, "rx2_replay: cannot read %s\n", opt.faultsPath.c_str());
+            return 2;
+        }
+        if (!Rx2RexShimEnable(script, &error))
+        {
+            fprintf(stderr, "rx2_replay: %s: %s\n", opt.faultsPath.c_str(), error.c_str());
+            return 2;
+        }
+    }
+
+    Rx2DecoderExtension* extension = new Rx2DecoderExtension(&core);
+
+    ReplayStats stats;
+    const std::int64_t t0 = Rx2BenchNowNs();
+    Replay(extension, log, opt, &stats);
+    const std::int64_t t1 = Rx2BenchNowNs();
+
+    // Release REXCreate calls hung by the script, and let their abandoned
+    // workers finish before the library goes away.
+    Rx2RexShimStop();
+    for (int i = 0; i < 100 && Rx2AbandonedRexCreates() > 0; ++i)
+        Sleep(10);
+
+    extension->Release();
+
+    Rx2BenchReport report("");
+    for (int op = kRx2CallCreateDecoder; op < kRx2CallOpCount; ++op)
+    {
+        if (stats.us[op].empty())
+            continue;
+        const std::string prefix = std::string("replay_") + Rx2CallOpName(op);
+        report.Add(prefix + "_p50_us", Rx2BenchPercentile(stats.us[op], 50), "us", false);
+        report.Add(prefix + "_p95_us", Rx2BenchPercentile(stats.us[op], 95), "us", false);
+    }
+    report.Add("replay_total_ms",   Rx2BenchNsToMs(t1 - t0),                 "ms",    false);
+    report.Add("replay_skipped",    static_cast<double>(stats.skipped),     "calls", false);
+    report.Add("replay_mismatches", static_cast<double>(stats.mismatches),  "calls", false);
+
+    Rx2RtAuditReport();
+
+    if (!opt.metricsPath.empty()
+        && !Rx2MetricsWriteJson(std::wstring(opt.metricsPath.begin(), opt.metricsPath.end()).c_str()))
+    {
+        fprintf(stderr, "rx2_replay: cannot write %s\n", opt.metricsPath.c_str());
+        return 2;
+    }
+
+    std::ostringstream config;
+    config << "\"log\": \"" << opt.logPath << "\""
+           << ", \"calls\": " << stats.calls
+           << ", \"storage\": \"" << opt.config << "\""
+           << ", \"timeout_ms\": " << opt.timeoutMs
+           << ", \"realtime\": " << (opt.realtime ? "true" : "false")
+           << ", \"rex_faults\": \"" << opt.faultsPath << "\"";
+
+    return Rx2BenchFinish("rx2_replay", config.str(), report, opt.outPath, opt.baselinePath,
+                          opt.threshold);
+}
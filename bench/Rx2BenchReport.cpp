@@ -0,0 +1,177 @@
+#include "Rx2BenchReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+// ---------------- results ----------------
+
+void Rx2BenchReport::Add(const std::string& name, double value, const char* unit, bool higherIsBetter)
+{
+    m_results.push_back(Rx2BenchResult{ name, value, unit, higherIsBetter });
+    fprintf(stderr, "  %-36s %12.3f %s\n", name.c_str(), value, unit);
+}
+
+double Rx2BenchMedian(std::vector<double> values)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+    const size_t n = values.size();
+    return (n % 2) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+double Rx2BenchPercentile(std::vector<double> values, double pct)
+{
+    if (values.empty())
+        return 0.0;
+    std::sort(values.begin(), values.end());
+
+    size_t rank = static_cast<size_t>(std::ceil(pct / 100.0 * values.size()));
+    if (rank < 1)
+        rank = 1;
+    if (rank > values.size())
+        rank = values.size();
+    return values[rank - 1];
+}
+
+// ---------------- JSON ----------------
+
+static std::string JsonEscape(const std::string& s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out.push_back('\\');
+        out.push_back(c);
+    }
+    return out;
+}
+
+// One result per line, so reports diff cleanly and the baseline reader can
+// stay a line scanner.
+std::string Rx2BenchWriteJson(const std::string& config, const Rx2BenchReport& report)
+{
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"schema\": 1,\n";
+    json << "  \"config\": {" << config << "},\n";
+    json << "  \"results\": [\n";
+
+    const std::vector<Rx2BenchResult>& results = report.Results();
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Rx2BenchResult& r = results[i];
+        char value[64];
+        snprintf(value, sizeof(value), "%.6g", r.value);
+
+        json << "    {\"name\": \"" << JsonEscape(r.name) << "\""
+             << ", \"value\": " << value
+             << ", \"unit\": \"" << JsonEscape(r.unit) << "\""
+             << ", \"better\": \"" << (r.higherIsBetter ? "higher" : "lower") << "\"}"
+             << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    json << "  ]\n";
+    json << "}\n";
+    return json.str();
+}
+
+bool Rx2BenchReadBaseline(const std::string& path, std::map<std::string, double>* values)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const std::string nameKey  = "\"name\": \"";
+        const std::string valueKey = "\"value\": ";
+
+        const size_t n = line.find(nameKey);
+        const size_t v = line.find(valueKey);
+        if (n == std::string::npos || v == std::string::npos)
+            continue;
+
+        const size_t nameStart = n + nameKey.size();
+        const size_t nameEnd   = line.find('"', nameStart);
+        if (nameEnd == std::string::npos)
+            continue;
+
+        (*values)[line.substr(nameStart, nameEnd - nameStart)] = strtod(line.c_str() + v + valueKey.size(), nullptr);
+    }
+    return true;
+}
+
+int Rx2BenchCompareToBaseline(const Rx2BenchReport& report, const std::map<std::string, double>& baseline,
+                              double thresholdPct)
+{
+    int regressions = 0;
+
+    fprintf(stderr, "\n%-36s %12s %12s %8s\n", "result", "baseline", "current", "change");
+    for (const Rx2BenchResult& r : report.Results())
+    {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second == 0.0)
+        {
+            fprintf(stderr, "%-36s %12s %12.3f %8s\n", r.name.c_str(), "-", r.value, "new");
+            continue;
+        }
+
+        // Positive change = better, whichever direction that is.
+        const double base   = it->second;
+        double       change = (r.value - base) / base * 100.0;
+        if (!r.higherIsBetter)
+            change = -change;
+
+        const bool regressed = change < -thresholdPct;
+        if (regressed)
+            ++regressions;
+
+        fprintf(stderr, "%-36s %12.3f %12.3f %+7.1f%%%s\n",
+                r.name.c_str(), base, r.value, change, regressed ? "  REGRESSION" : "");
+    }
+
+    fprintf(stderr, "%d regression(s) beyond %.1f%%\n", regressions, thresholdPct);
+    return regressions;
+}
+
+int Rx2BenchFinish(const char* tool, const std::string& config, const Rx2BenchReport& report,
+                   const std::string& outPath, const std::string& baselinePath,
+                   double thresholdPct)
+{
+    const std::string json = Rx2BenchWriteJson(config, report);
+    if (outPath.empty())
+    {
+        fputs(json.c_str(), stdout);
+    }
+    else
+    {
+        std::ofstream out(outPath);
+        out << json;
+        if (!out)
+        {
+            fprintf(stderr, "%s: cannot write %s\n", tool, outPath.c_str());
+            return 2;
+        }
+    }
+
+    if (!baselinePath.empty())
+    {
+        std::map<std::string, double> baseline;
+        if (!Rx2BenchReadBaseline(baselinePath, &baseline))
+        {
+            fprintf(stderr, "%s: cannot read baseline %s\n", tool, baselinePath.c_str());
+            return 2;
+        }
+        if (Rx2BenchCompareToBaseline(report, baseline, thresholdPct) > 0)
+            return 1;
+    }
+
+    return 0;
+}
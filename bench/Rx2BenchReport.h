@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Results shared by the bench tools: a flat list of named numbers written
+// as JSON (one result per line) and compared against an earlier report.
+
+struct Rx2BenchResult
+{
+    std::string name;
+    double      value;
+    std::string unit;
+    bool        higherIsBetter;
+};
+
+class Rx2BenchReport
+{
+public:
+    // `only` is a comma-separated list of groups to run; empty = all.
+    explicit Rx2BenchReport(const std::string& only) : m_only("," + only + ",") {}
+
+    bool Wants(const char* group) const
+    {
+        return m_only == ",," || m_only.find(std::string(",") + group + ",") != std::string::npos;
+    }
+
+    // Also echoes the result to stderr.
+    void Add(const std::string& name, double value, const char* unit, bool higherIsBetter);
+
+    const std::vector<Rx2BenchResult>& Results() const { return m_results; }
+
+private:
+    std::string                 m_only;
+    std::vector<Rx2BenchResult> m_results;
+};
+
+double Rx2BenchMedian(std::vector<double> values);
+
+// Nearest-rank percentile (pct in 0..100) of an unsorted sample.
+double Rx2BenchPercentile(std::vector<double> values, double pct);
+
+inline double Rx2BenchNsToMs(std::int64_t ns)
+{
+    return ns / 1e6;
+}
+
+// `config` is the body of the report's "config" object, e.g. "\"reps\": 5".
+std::string Rx2BenchWriteJson(const std::string& config, const Rx2BenchReport& report);
+
+// Pulls name -> value out of a report written by Rx2BenchWriteJson().
+bool Rx2BenchReadBaseline(const std::string& path, std::map<std::string, double>* values);
+
+// Prints a comparison table to stderr; returns the number of results that
+// got worse by more than thresholdPct.
+int Rx2BenchCompareToBaseline(const Rx2BenchReport& report,
+                              const std::map<std::string, double>& baseline,
+                              double thresholdPct);
+
+// Writes the report to outPath (stdout if empty) and, if baselinePath is
+// set, compares against it. Returns the process exit code: 0, 1 on
+// regressions, 2 on I/O errors.
+int Rx2BenchFinish(const char* tool, const std::string& config, const Rx2BenchReport& report,
+                   const std::string& outPath, const std::string& baselinePath,
+                   double thresholdPct);
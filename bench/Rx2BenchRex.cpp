@@ -0,0 +1,529 @@
+#include "Rx2BenchRex.h"
+
+#include "RexSdk.h"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <thread>
+
+// ---------------- file image ----------------
+
+static const std::uint32_t kFileMagic   = 0x53425852u;   // "RXBS"
+static const std::uint32_t kFileVersion = 3;
+static const std::uint32_t kFlagMuted   = 1;
+static const int           kPpqPerBeat  = 15360;
+static const int           kTempo       = 120000;        // 120 BPM
+
+struct FileHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::int32_t  channels;
+    std::int32_t  sampleRate;
+    std::int32_t  slices;
+    std::int32_t  bitDepth;
+    std::int32_t  tempo;
+    std::int32_t  ppqLength;
+    std::uint32_t payloadBytes;
+    std::uint32_t flags;
+    std::uint32_t hangMs;
+};
+
+static std::int32_t LoopPpq(const Rx2BenchLoop& loop)
+{
+    const double beats = loop.seconds * kTempo / 60000.0;
+    return static_cast<std::int32_t>(std::lround(beats * kPpqPerBeat));
+}
+
+// Same arithmetic as Rx2Decoder's constructor, so lengths agree exactly.
+static std::int64_t FramesForPpq(int sampleRate, std::int32_t ppq)
+{
+    double tmp = static_cast<double>(sampleRate) * 1000.0 * ppq;
+    tmp /= static_cast<double>(kTempo) * 256.0;
+    return static_cast<std::int64_t>(tmp);
+}
+
+static bool ParseHeader(const char* buffer, std::int64_t size, FileHeader* header)
+{
+    if (!buffer || size < static_cast<std::int64_t>(sizeof(FileHeader)))
+        return false;
+
+    memcpy(header, buffer, sizeof(FileHeader));
+    return header->magic == kFileMagic
+        && header->version == kFileVersion
+        && (header->channels == 1 || header->channels == 2)
+        && header->sampleRate > 0
+        && header->slices > 0
+        && header->ppqLength >= 0
+        && static_cast<std::int64_t>(sizeof(FileHeader)) + header->payloadBytes <= size;
+}
+
+static void FillInfo(const FileHeader& header, REX::REXInfo* info)
+{
+    info->fChannels      = header.channels;
+    info->fSampleRate    = header.sampleRate;
+    info->fSliceCount    = header.slices;
+    info->fTempo         = header.tempo;
+    info->fOriginalTempo = header.tempo;
+    info->fPPQLength     = header.ppqLength;
+    info->fTimeSignNom   = 4;
+    info->fTimeSignDenom = 4;
+    info->fBitDepth      = header.bitDepth;
+}
+
+std::vector<std::uint8_t> Rx2BenchMakeRexFile(const Rx2BenchLoop& loop)
+{
+    FileHeader header{};
+    header.magic      = kFileMagic;
+    header.version    = kFileVersion;
+    header.channels   = loop.channels;
+    header.sampleRate = loop.sampleRate;
+    header.slices     = loop.slices;
+    header.bitDepth   = loop.bitDepth;
+    header.tempo      = kTempo;
+    header.ppqLength  = LoopPpq(loop);
+    header.flags      = loop.muted ? kFlagMuted : 0;
+    header.hangMs     = static_cast<std::uint32_t>(loop.hangMs > 0 ? loop.hangMs : 0);
+
+    // REX2 stores roughly half of the raw PCM size.
+    const std::int64_t frames = FramesForPpq(loop.sampleRate, header.ppqLength);
+    header.payloadBytes = static_cast<std::uint32_t>(frames * loop.channels * (loop.bitDepth / 8) / 2);
+
+    std::vector<std::uint8_t> file(sizeof(FileHeader) + header.payloadBytes);
+    memcpy(file.data(), &header, sizeof(FileHeader));
+
+    std::uint32_t state = 0x12345678u;
+    for (std::size_t i = sizeof(FileHeader); i < file.size(); ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        file[i] = static_cast<std::uint8_t>(state >> 24);
+    }
+    return file;
+}
+
+std::int64_t Rx2BenchLoopFrames(const Rx2BenchLoop& loop)
+{
+    return FramesForPpq(loop.sampleRate, LoopPpq(loop));
+}
+
+// ---------------- stats ----------------
+
+static std::atomic<std::int64_t> g_preflightNs(0);
+static std::atomic<std::int64_t> g_createNs(0);
+static std::atomic<std::int64_t> g_renderNs(0);
+static std::atomic<std::int64_t> g_previewStartNs(0);
+static std::atomic<std::int64_t> g_lockWaitNs(0);
+
+static thread_local Rx2BenchRexMarks t_marks = {};
+
+std::int64_t Rx2BenchNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Rx2BenchRexResetStats()
+{
+    g_preflightNs    = 0;
+    g_createNs       = 0;
+    g_renderNs       = 0;
+    g_previewStartNs = 0;
+    g_lockWaitNs     = 0;
+}
+
+Rx2BenchRexStats Rx2BenchRexGetStats()
+{
+    Rx2BenchRexStats stats;
+    stats.preflightNs    = g_preflightNs;
+    stats.createNs       = g_createNs;
+    stats.renderNs       = g_renderNs;
+    stats.previewStartNs = g_previewStartNs;
+    stats.lockWaitNs     = g_lockWaitNs;
+    return stats;
+}
+
+void Rx2BenchRexResetMarks()
+{
+    t_marks = Rx2BenchRexMarks{};
+}
+
+Rx2BenchRexMarks Rx2BenchRexGetMarks()
+{
+    return t_marks;
+}
+
+static void MarkRenderStart(std::int64_t now)
+{
+    if (!t_marks.renderStartNs)
+        t_marks.renderStartNs = now;
+}
+
+// ---------------- library lock ----------------
+
+static std::atomic<bool> g_serialized(false);
+static std::mutex        g_libraryLock;
+
+void Rx2BenchRexSetSerialized(bool serialized)
+{
+    g_serialized = serialized;
+}
+
+// Held for the duration of a call in serialized mode; the wait for it is
+// accounted separately so it does not show up as create or render time.
+class LibraryLock
+{
+public:
+    LibraryLock() : m_locked(g_serialized)
+    {
+        if (!m_locked)
+            return;
+        if (g_libraryLock.try_lock())
+            return;
+        const std::int64_t t0 = Rx2BenchNowNs();
+        g_libraryLock.lock();
+        g_lockWaitNs += Rx2BenchNowNs() - t0;
+    }
+
+    ~LibraryLock()
+    {
+        if (m_locked)
+            g_libraryLock.unlock();
+    }
+
+    LibraryLock(const LibraryLock&) = delete;
+    LibraryLock& operator=(const LibraryLock&) = delete;
+
+private:
+    bool m_locked;
+};
+
+// ---------------- synthesis ----------------
+
+// One tone burst per slice; the right channel is detuned so stereo loops
+// never collapse to dual mono.
+struct Voice
+{
+    double re[2];
+    double im[2];
+    double stepRe[2];
+    double stepIm[2];
+    double decay;
+};
+
+static void StartVoice(Voice& v, int slice, int sampleRate, bool muted)
+{
+    const double kTwoPi = 6.283185307179586;
+    const double freq   = 110.0 * std::pow(2.0, (slice * 5 % 24) / 12.0);
+
+    for (int c = 0; c < 2; ++c)
+    {
+        const double w = kTwoPi * freq * (c == 0 ? 1.0 : 1.003) / sampleRate;
+        v.re[c]     = 0.0;
+        v.im[c]     = muted ? 0.0 : 0.5;
+        v.stepRe[c] = std::cos(w);
+        v.stepIm[c] = std::sin(w);
+    }
+    v.decay = std::exp(-1.0 / (0.08 * sampleRate));
+}
+
+static void RenderVoice(Voice& v, int channels, int frames, float* left, float* right)
+{
+    for (int i = 0; i < frames; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            const double re = v.re[c] * v.stepRe[c] - v.im[c] * v.stepIm[c];
+            const double im = v.re[c] * v.stepIm[c] + v.im[c] * v.stepRe[c];
+            v.re[c] = re * v.decay;
+            v.im[c] = im * v.decay;
+        }
+
+        left[i] = static_cast<float>(v.im[0]);
+        if (right)
+            right[i] = static_cast<float>(channels > 1 ? v.im[1] : v.im[0]);
+    }
+}
+
+// ---------------- handle ----------------
+
+namespace REX {
+
+struct REXOpaqueHandle
+{
+    FileHeader    header;
+    std::int64_t  frames;
+    std::int64_t  sliceFrames;
+    std::uint32_t payloadHash;   // keeps the "decode" walk observable
+    bool          previewing;
+    std::int64_t  position;
+    Voice         voice;
+};
+
+} // namespace REX
+
+using namespace REX;
+
+static bool Muted(const REXOpaqueHandle* h)
+{
+    return (h->header.flags & kFlagMuted) != 0;
+}
+
+static std::int64_t SliceStart(const REXOpaqueHandle* h, int slice)
+{
+    return h->sliceFrames * slice;
+}
+
+static std::int64_t SliceLength(const REXOpaqueHandle* h, int slice)
+{
+    if (slice == h->header.slices - 1)
+        return h->frames - SliceStart(h, slice);
+    return h->sliceFrames;
+}
+
+// ---------------- REX API ----------------
+
+namespace REX {
+
+REXError REXInitializeDLL_DirPath(const wchar_t* /*dirPath*/)
+{
+    return kREXError_NoError;
+}
+
+void REXUninitializeDLL()
+{
+}
+
+REXError REXGetInfoFromBuffer(REX_int32_t bufferSize, const char buffer[],
+                              REX_int32_t infoSize, REXInfo* info)
+{
+    const std::int64_t t0 = Rx2BenchNowNs();
+
+    REXError err = kREXError_NoError;
+    FileHeader header{};
+    if (!info || infoSize < static_cast<REX_int32_t>(sizeof(REXInfo)))
+        err = kREXImplError_InvalidSize;
+    else if (!ParseHeader(buffer, bufferSize, &header))
+        err = kREXError_FileCorrupt;
+    else
+        FillInfo(header, info);
+
+    const std::int64_t t1 = Rx2BenchNowNs();
+    if (!t_marks.firstInfoEndNs)
+        t_marks.firstInfoEndNs = t1;
+    t_marks.lastInfoEndNs = t1;
+
+    g_preflightNs += t1 - t0;
+    return err;
+}
+
+REXError REXCreate(REXHandle* handle, const char buffer[], REX_int32_t size,
+                   REXCreateCallback callback, void* userData)
+{
+    LibraryLock lock;
+    const std::int64_t t0 = Rx2BenchNowNs();
+
+    *handle = nullptr;
+
+    FileHeader header{};
+    if (!ParseHeader(buffer, size, &header))
+    {
+        g_createNs += Rx2BenchNowNs() - t0;
+        return kREXError_FileCorrupt;
+    }
+
+    if (header.ppqLength == 0)
+    {
+        g_createNs += Rx2BenchNowNs() - t0;
+        return kREXError_FileHasZeroLoopLength;
+    }
+
+    if (header.hangMs)
+        std::this_thread::sleep_for(std::chrono::milliseconds(header.hangMs));
+
+    REXOpaqueHandle* h = new (std::nothrow) REXOpaqueHandle();
+    if (!h)
+    {
+        g_createNs += Rx2BenchNowNs() - t0;
+        return kREXError_OutOfMemory;
+    }
+
+    h->header      = header;
+    h->frames      = FramesForPpq(header.sampleRate, header.ppqLength);
+    h->sliceFrames = h->frames / header.slices;
+    h->previewing  = false;
+    h->position    = 0;
+
+    // Stand-in for decompression: touch every payload byte once.
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(buffer) + sizeof(FileHeader);
+    std::uint32_t hash = 2166136261u;
+    for (std::uint32_t i = 0; i < header.payloadBytes; ++i)
+        hash = (hash ^ p[i]) * 16777619u;
+    h->payloadHash = hash;
+
+    if (callback)
+        callback(100, userData);
+
+    *handle = h;
+    g_createNs += Rx2BenchNowNs() - t0;
+    return kREXError_NoError;
+}
+
+void REXDelete(REXHandle* handle)
+{
+    if (!handle)
+        return;
+    delete *handle;
+    *handle = nullptr;
+}
+
+REXError REXGetInfo(REXHandle handle, REX_int32_t infoSize, REXInfo* info)
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+    if (!info || infoSize < static_cast<REX_int32_t>(sizeof(REXInfo)))
+        return kREXImplError_InvalidSize;
+
+    if (!t_marks.getInfoNs)
+        t_marks.getInfoNs = Rx2BenchNowNs();
+
+    FillInfo(handle->header, info);
+    return kREXError_NoError;
+}
+
+REXError REXGetCreatorInfo(REXHandle handle, REX_int32_t /*creatorInfoSize*/, REXCreatorInfo* /*info*/)
+{
+    return handle ? kREXError_NoCreatorInfoAvailable : kREXImplError_InvalidHandle;
+}
+
+REXError REXGetSliceInfo(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t sliceInfoSize,
+                         REXSliceInfo* info)
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+    if (!info || sliceInfoSize < static_cast<REX_int32_t>(sizeof(REXSliceInfo)))
+        return kREXImplError_InvalidSize;
+    if (sliceIndex < 0 || sliceIndex >= handle->header.slices)
+        return kREXImplError_InvalidSlice;
+
+    info->fPPQPos       = static_cast<REX_int32_t>(
+        static_cast<std::int64_t>(handle->header.ppqLength) * sliceIndex / handle->header.slices);
+    info->fSampleLength = static_cast<REX_int32_t>(SliceLength(handle, sliceIndex));
+    return kREXError_NoError;
+}
+
+REXError REXSetOutputSampleRate(REXHandle handle, REX_int32_t outputSampleRate)
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+    if (outputSampleRate != handle->header.sampleRate)
+        return kREXImplError_InvalidSampleRate;   // the stand-in does not resample
+    return kREXError_NoError;
+}
+
+REXError REXRenderSlice(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t bufferFrameLength,
+                        float* outputBuffers[2])
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+    if (sliceIndex < 0 || sliceIndex >= handle->header.slices)
+        return kREXImplError_InvalidSlice;
+    if (bufferFrameLength < SliceLength(handle, sliceIndex))
+        return kREXImplError_BufferTooSmall;
+
+    LibraryLock lock;
+    const std::int64_t t0 = Rx2BenchNowNs();
+    MarkRenderStart(t0);
+
+    Voice voice;
+    StartVoice(voice, sliceIndex, handle->header.sampleRate, Muted(handle));
+    RenderVoice(voice, handle->header.channels, static_cast<int>(SliceLength(handle, sliceIndex)),
+                outputBuffers[0], handle->header.channels > 1 ? outputBuffers[1] : nullptr);
+
+    g_renderNs += Rx2BenchNowNs() - t0;
+    return kREXError_NoError;
+}
+
+REXError REXStartPreview(REXHandle handle)
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+
+    handle->previewing = true;
+    handle->position   = 0;
+    StartVoice(handle->voice, 0, handle->header.sampleRate, Muted(handle));
+
+    g_previewStartNs = Rx2BenchNowNs();
+    MarkRenderStart(g_previewStartNs);
+    return kREXError_NoError;
+}
+
+REXError REXStopPreview(REXHandle handle)
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+    handle->previewing = false;
+    return kREXError_NoError;
+}
+
+REXError REXRenderPreviewBatch(REXHandle handle, REX_int32_t framesToRender, float* outputBuffers[2])
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+    if (framesToRender <= 0 || framesToRender > 64)
+        return kREXImplError_InvalidArgument;
+
+    float* left  = outputBuffers[0];
+    float* right = handle->header.channels > 1 ? outputBuffers[1] : nullptr;
+
+    if (!handle->previewing)
+    {
+        memset(left, 0, sizeof(float) * framesToRender);
+        if (right)
+            memset(right, 0, sizeof(float) * framesToRender);
+        return kREXError_NoError;
+    }
+
+    LibraryLock lock;
+    const std::int64_t t0 = Rx2BenchNowNs();
+
+    int done = 0;
+    while (done < framesToRender)
+    {
+        const std::int64_t pos   = handle->position % handle->frames;
+        int                slice = static_cast<int>(pos / handle->sliceFrames);
+        if (slice >= handle->header.slices)
+            slice = handle->header.slices - 1;
+
+        if (pos == SliceStart(handle, slice))
+            StartVoice(handle->voice, slice, handle->header.sampleRate, Muted(handle));
+
+        const std::int64_t sliceLeft = SliceStart(handle, slice) + SliceLength(handle, slice) - pos;
+        int n = framesToRender - done;
+        if (n > sliceLeft)
+            n = static_cast<int>(sliceLeft);
+
+        RenderVoice(handle->voice, handle->header.channels, n,
+                    left + done, right ? right + done : nullptr);
+
+        done             += n;
+        handle->position += n;
+    }
+
+    g_renderNs += Rx2BenchNowNs() - t0;
+    return kREXError_NoError;
+}
+
+REXError REXSetPreviewTempo(REXHandle handle, REX_int32_t tempo)
+{
+    if (!handle)
+        return kREXImplError_InvalidHandle;
+    if (tempo != handle->header.tempo)
+        return kREXImplError_InvalidTempo;   // nor time-stretch
+    return kREXError_NoError;
+}
+
+} // namespace REX
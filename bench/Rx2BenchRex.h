@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Deterministic software stand-in for the REX Shared Library.
+//
+// Rx2BenchMakeRexFile() writes a small header describing a synthetic loop
+// followed by a pseudo-random "compressed" payload of roughly the size a
+// real REX2 file would have. REXCreate() walks the whole payload (standing
+// in for decompression), and preview/slice rendering synthesizes one
+// decaying tone burst per slice, so every run renders the same samples.
+struct Rx2BenchLoop
+{
+    int    channels;     // 1 or 2
+    int    sampleRate;
+    int    slices;
+    int    bitDepth;     // reported as REXInfo::fBitDepth
+    double seconds;      // loop length at 120 BPM, 4/4; 0 = Bars/Beats not set
+    bool   muted;        // every slice renders silence
+    int    hangMs;       // REXCreate stalls this long first, like a damaged file
+};
+
+std::vector<std::uint8_t> Rx2BenchMakeRexFile(const Rx2BenchLoop& loop);
+
+// Exact loop length the decoder will derive from the file's header.
+std::int64_t Rx2BenchLoopFrames(const Rx2BenchLoop& loop);
+
+// Time spent inside the stand-in, accumulated since the last reset, plus
+// when the most recent preview started, so the bench can split a decoder
+// constructor into its stages.
+struct Rx2BenchRexStats
+{
+    std::int64_t preflightNs;      // REXGetInfoFromBuffer
+    std::int64_t createNs;         // REXCreate
+    std::int64_t renderNs;         // REXRenderPreviewBatch / REXRenderSlice
+    std::int64_t previewStartNs;   // Rx2BenchNowNs() of the last REXStartPreview
+    std::int64_t lockWaitNs;       // waiting for the library lock (serialized mode)
+};
+
+void             Rx2BenchRexResetStats();
+Rx2BenchRexStats Rx2BenchRexGetStats();
+
+// Per-thread timestamps (Rx2BenchNowNs) of the stand-in calls that bound
+// the stages of one open, so a harness can split CreateDecoder without
+// instrumenting the plugin. Zero until the call happens on this thread.
+struct Rx2BenchRexMarks
+{
+    std::int64_t firstInfoEndNs;   // end of the first REXGetInfoFromBuffer
+    std::int64_t lastInfoEndNs;    // end of the latest REXGetInfoFromBuffer
+    std::int64_t getInfoNs;        // first REXGetInfo, i.e. REXCreate has returned
+    std::int64_t renderStartNs;    // REXStartPreview or the first REXRenderSlice
+};
+
+void             Rx2BenchRexResetMarks();
+Rx2BenchRexMarks Rx2BenchRexGetMarks();
+
+// Serialized mode: REXCreate and the render calls take one library-wide
+// lock, as a DLL with global state would. Off by default, so the stand-in
+// is fully reentrant and only the plugin's own synchronization shows.
+void Rx2BenchRexSetSerialized(bool serialized);
+
+// Monotonic clock shared by the bench and its mocks, in nanoseconds.
+std::int64_t Rx2BenchNowNs();
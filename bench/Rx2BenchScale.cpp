@@ -0,0 +1,303 @@
+// Concurrency scaling: the same opens (CreateDecoder to first audio) issued
+// from 1, 2, 4, ... threads at once, as AIMP's playlist scanner and the
+// playback thread do, with the time spent waiting at each of the plugin's
+// synchronization points (Rx2Contention.h). See the "Benchmarks" section of
+// README.md.
+
+#include "Rx2BenchAimp.h"
+#include "Rx2BenchCorpus.h"
+#include "Rx2BenchOpen.h"
+#include "Rx2BenchReport.h"
+#include "Rx2BenchRex.h"
+
+#include "Rx2Contention.h"
+#include "Rx2DecoderExtension.h"
+#include "Rx2RtAudit.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// ---------------- options ----------------
+
+struct ScaleOptions
+{
+    std::vector<int> threads;     // thread counts, in the order they are run
+    int              opens;       // opens per thread count
+    int              files;       // valid files in the corpus
+    std::string      config;      // storage preset
+    bool             serialized;  // stand-in takes a library-wide lock
+    std::string      dir;         // corpus directory; empty = temporary
+    double           threshold;   // regression threshold, percent
+    std::string      outPath;
+    std::string      baselinePath;
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: rx2_scale [options]\n"
+            "  --threads LIST    comma-separated thread counts (default 1,2,4,8)\n"
+            "  --opens N         opens per thread count, shared by its threads (default 96)\n"
+            "  --files N         valid loops in the corpus (default 24)\n"
+            "  --config NAME     storage preset: f32, i16, i24, i16c, f32_spill (default f32)\n"
+            "  --rex-serialized  make the stand-in REX library take one global lock\n"
+            "  --dir DIR         write the corpus to DIR and keep it (default: temporary)\n"
+            "  --out FILE        write the JSON report to FILE instead of stdout\n"
+            "  --baseline FILE   compare against an earlier report; exit 1 on regressions\n"
+            "  --threshold PCT   allowed slowdown before a result is flagged (default 10)\n");
+}
+
+static bool ParseThreadList(const std::string& list, std::vector<int>* threads)
+{
+    threads->clear();
+
+    std::stringstream in(list);
+    std::string       item;
+    while (std::getline(in, item, ','))
+    {
+        const int n = atoi(item.c_str());
+        if (n <= 0 || n > 256)
+            return false;
+        threads->push_back(n);
+    }
+    return !threads->empty();
+}
+
+static bool ParseOptions(int argc, char** argv, ScaleOptions* opt)
+{
+    opt->threads    = { 1, 2, 4, 8 };
+    opt->opens      = 96;
+    opt->files      = 24;
+    opt->config     = "f32";
+    opt->serialized = false;
+    opt->threshold  = 10.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (arg == "--rex-serialized")
+        {
+            opt->serialized = true;
+            continue;
+        }
+
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            fprintf(stderr, "rx2_scale: missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if (arg == "--threads")
+        {
+            if (!ParseThreadList(value, &opt->threads))
+            {
+                fprintf(stderr, "rx2_scale: bad thread list %s\n", value);
+                return false;
+            }
+        }
+        else if (arg == "--opens")     opt->opens        = atoi(value);
+        else if (arg == "--files")     opt->files        = atoi(value);
+        else if (arg == "--config")    opt->config       = value;
+        else if (arg == "--dir")       opt->dir          = value;
+        else if (arg == "--out")       opt->outPath      = value;
+        else if (arg == "--baseline")  opt->baselinePath = value;
+        else if (arg == "--threshold") opt->threshold    = atof(value);
+        else
+        {
+            fprintf(stderr, "rx2_scale: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (opt->opens <= 0 || opt->files <= 0)
+    {
+        fprintf(stderr, "rx2_scale: --opens and --files must be positive\n");
+        return false;
+    }
+    if (!Rx2BenchFindStorageConfig(opt->config.c_str()))
+    {
+        fprintf(stderr, "rx2_scale: unknown storage preset %s\n", opt->config.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---------------- run ----------------
+
+struct ScaleRun
+{
+    double              wallMs;
+    std::vector<double> latencyMs;   // per open, to first audio
+    bool                ok;
+};
+
+// `opens` opens of the valid files, round robin, pulled from a shared
+// counter by `threads` threads that start together.
+static ScaleRun RunConcurrent(Rx2DecoderExtension* extension, const std::vector<std::string>& paths,
+                              int threads, int opens)
+{
+    ScaleRun run;
+    run.ok = true;
+
+    std::atomic<int>  next(0);
+    std::atomic<int>  ready(0);
+    std::atomic<bool> go(false);
+    std::mutex        lock;
+
+    auto worker = [&]()
+    {
+        std::vector<double> local;
+
+        ready.fetch_add(1);
+        while (!go.load())
+            std::this_thread::yield();
+
+        for (int i = next.fetch_add(1); i < opens; i = next.fetch_add(1))
+        {
+            const std::string& path = paths[i % paths.size()];
+
+            Rx2BenchOpenResult r;
+            Rx2BenchOpenFile(extension, path, &r, nullptr);
+            if (FAILED(r.hr) || !r.audio)
+            {
+                fprintf(stderr, "rx2_scale: %s: no audio (hr 0x%08x, %ls)\n",
+                        path.c_str(), static_cast<unsigned>(r.hr), r.error.c_str());
+                std::lock_guard<std::mutex> guard(lock);
+                run.ok = false;
+                break;
+            }
+            local.push_back(Rx2BenchNsToMs(r.totalNs));
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        run.latencyMs.insert(run.latencyMs.end(), local.begin(), local.end());
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back(worker);
+
+    while (ready.load() < threads)
+        std::this_thread::yield();
+
+    const std::int64_t t0 = Rx2BenchNowNs();
+    go = true;
+    for (std::thread& t : pool)
+        t.join();
+    run.wallMs = Rx2BenchNsToMs(Rx2BenchNowNs() - t0);
+
+    return run;
+}
+
+// ---------------- main ----------------
+
+int main(int argc, char** argv)
+{
+    ScaleOptions opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    Rx2BenchCorpus corpus;
+    if (!corpus.Create(opt.dir, opt.files))
+    {
+        fprintf(stderr, "rx2_scale: cannot write the corpus to %s\n", corpus.Dir().c_str());
+        return 2;
+    }
+
+    std::vector<std::string> paths;
+    for (const Rx2BenchCorpusFile& file : corpus.Files())
+    {
+        if (file.kind == Rx2BenchFileKind::Valid)
+            paths.push_back(file.path);
+    }
+
+    const unsigned cpus = std::thread::hardware_concurrency();
+    fprintf(stderr, "rx2_scale: %zu files in %s, %d opens per step, %s storage, %u CPUs%s\n",
+            paths.size(), corpus.Dir().c_str(), opt.opens, opt.config.c_str(), cpus,
+            opt.serialized ? ", serialized REX" : "");
+
+    Rx2BenchCore core;
+    Rx2BenchApplyStorageConfig(core, *Rx2BenchFindStorageConfig(opt.config.c_str()));
+    Rx2BenchRexSetSerialized(opt.serialized);
+
+    Rx2DecoderExtension* extension = new Rx2DecoderExtension(&core);
+
+    // The first open of a session also loads the REX library; keep it out
+    // of every step.
+    {
+        Rx2BenchOpenResult warmup;
+        Rx2BenchOpenFile(extension, paths.front(), &warmup, nullptr);
+    }
+
+    Rx2BenchReport report("");
+
+    double baseRate = 0.0;   // opens/s per thread at the first step
+    bool   ok       = true;
+    for (int threads : opt.threads)
+    {
+        Rx2SyncResetStats();
+        Rx2BenchRexResetStats();
+
+        const ScaleRun run = RunConcurrent(extension, paths, threads, opt.opens);
+        if (!(ok = run.ok))
+            break;
+
+        const std::string prefix = "scale_t" + std::to_string(threads);
+        const double      rate   = run.latencyMs.size() / (run.wallMs / 1000.0);
+        if (baseRate == 0.0)
+            baseRate = rate / opt.threads.front();
+
+        report.Add(prefix + "_opens_s",    rate,                                      "opens/s", true);
+        report.Add(prefix + "_p50_ms",     Rx2BenchPercentile(run.latencyMs, 50),     "ms",      false);
+        report.Add(prefix + "_p95_ms",     Rx2BenchPercentile(run.latencyMs, 95),     "ms",      false);
+        report.Add(prefix + "_efficiency", rate / (baseRate * threads),               "ratio",   true);
+
+        // Waits per open, for the sites this step actually went through.
+        const double opens = static_cast<double>(run.latencyMs.size());
+        const std::string waitPrefix = "wait_t" + std::to_string(threads) + "_";
+        for (int s = 0; s < static_cast<int>(Rx2SyncSite::Count); ++s)
+        {
+            const Rx2SyncSite  site  = static_cast<Rx2SyncSite>(s);
+            const Rx2SyncStats stats = Rx2SyncGetStats(site);
+            if (!stats.acquisitions)
+                continue;
+            report.Add(waitPrefix + Rx2SyncSiteName(site) + "_us_per_open",
+                       stats.waitNs / 1e3 / opens, "us", false);
+        }
+        if (opt.serialized)
+        {
+            report.Add(waitPrefix + "rex_library_lock_us_per_open",
+                       Rx2BenchRexGetStats().lockWaitNs / 1e3 / opens, "us", false);
+        }
+    }
+
+    extension->Release();
+    Rx2BenchRexSetSerialized(false);
+    if (!ok)
+        return 2;
+
+    Rx2RtAuditReport();
+
+    std::ostringstream config;
+    config << "\"opens\": " << opt.opens
+           << ", \"files\": " << opt.files
+           << ", \"storage\": \"" << opt.config << "\""
+           << ", \"rex_serialized\": " << (opt.serialized ? "true" : "false")
+           << ", \"cpus\": " << cpus;
+
+    return Rx2BenchFinish("rx2_scale", config.str(), report, opt.outPath, opt.baselinePath, opt.threshold);
+}
@@ -0,0 +1,570 @@
+// Soak test: open, read, seek and release decoders in a loop against valid,
+// corrupt and hanging stand-in files, starting and stopping the prefetcher
+// after each pass, for as long as asked, sampling resident memory, handle,
+// descriptor and thread counts and open latency, and failing when any of
+// them keeps growing. See the "Benchmarks" section of README.md.
+
+#include "Rx2BenchAimp.h"
+#include "Rx2BenchCorpus.h"
+#include "Rx2BenchOpen.h"
+#include "Rx2BenchReport.h"
+#include "Rx2BenchRex.h"
+
+#include "Rx2CallLog.h"
+#include "Rx2Decoder.h"
+#include "Rx2DecoderExtension.h"
+#include "Rx2NegativeCache.h"
+#include "Rx2Prefetcher.h"
+#include "Rx2RexLibrary.h"
+#include "Rx2RtAudit.h"
+#include "Rx2Waveform.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+// ---------------- options ----------------
+
+struct SoakOptions
+{
+    double      minutes;      // run length
+    int         sampleSec;    // seconds between samples
+    int         files;        // valid files in the corpus
+    std::string config;       // storage preset
+    int         timeoutMs;    // plugin's REXCreate timeout (RexCreateTimeoutMs)
+    int         hangMs;       // how long the hanging file stalls REXCreate
+    double      driftPct;     // allowed growth of memory and latency
+    std::string dir;          // corpus directory; empty = temporary
+    double      threshold;    // regression threshold, percent
+    std::string outPath;
+    std::string baselinePath;
+    std::string recordPath;   // call log of the whole run, for rx2_replay
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: rx2_soak [options]\n"
+            "  --minutes N      run length (default 5)\n"
+            "  --sample SEC     seconds between samples (default 10)\n"
+            "  --files N        valid loops in the corpus (default 8)\n"
+            "  --config NAME    storage preset: f32, i16, i24, i16c, f32_spill (default f32)\n"
+            "  --timeout-ms N   the plugin's REXCreate timeout (default 250)\n"
+            "  --hang-ms N      how long the hanging file stalls REXCreate (default 400)\n"
+            "  --drift PCT      allowed growth of memory and open latency (default 20)\n"
+            "  --dir DIR        write the corpus to DIR and keep it (default: temporary)\n"
+            "  --out FILE       write the JSON report to FILE instead of stdout\n"
+            "  --baseline FILE  compare against an earlier report; exit 1 on regressions\n"
+            "  --threshold PCT  allowed slowdown before a result is flagged (default 10)\n"
+            "  --record FILE    record the decoder calls of the run to FILE (see rx2_replay)\n");
+}
+
+static bool ParseOptions(int argc, char** argv, SoakOptions* opt)
+{
+    opt->minutes   = 5.0;
+    opt->sampleSec = 10;
+    opt->files     = 8;
+    opt->config    = "f32";
+    opt->timeoutMs = 250;
+    opt->hangMs    = 400;
+    opt->driftPct  = 20.0;
+    opt->threshold = 10.0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg   = argv[i];
+        const char*       value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (!value)
+        {
+            fprintf(stderr, "rx2_soak: missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if      (arg == "--minutes")    opt->minutes      = atof(value);
+        else if (arg == "--sample")     opt->sampleSec    = atoi(value);
+        else if (arg == "--files")      opt->files        = atoi(value);
+        else if (arg == "--config")     opt->config       = value;
+        else if (arg == "--timeout-ms") opt->timeoutMs    = atoi(value);
+        else if (arg == "--hang-ms")    opt->hangMs       = atoi(value);
+        else if (arg == "--drift")      opt->driftPct     = atof(value);
+        else if (arg == "--dir")        opt->dir          = value;
+        else if (arg == "--out")        opt->outPath      = value;
+        else if (arg == "--baseline")   opt->baselinePath = value;
+        else if (arg == "--threshold")  opt->threshold    = atof(value);
+        else if (arg == "--record")     opt->recordPath   = value;
+        else
+        {
+            fprintf(stderr, "rx2_soak: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (opt->files <= 0 || opt->sampleSec <= 0 || opt->minutes <= 0.0)
+    {
+        fprintf(stderr, "rx2_soak: --minutes, --sample and --files must be positive\n");
+        return false;
+    }
+    if (opt->minutes * 60.0 / opt->sampleSec < 10.0)
+    {
+        fprintf(stderr, "rx2_soak: need at least 10 samples to judge trends; lengthen --minutes or shorten --sample\n");
+        return false;
+    }
+    if (opt->timeoutMs < 100 || opt->hangMs <= opt->timeoutMs)
+    {
+        fprintf(stderr, "rx2_soak: --timeout-ms must be at least 100 and --hang-ms longer than it\n");
+        return false;
+    }
+    if (!Rx2BenchFindStorageConfig(opt->config.c_str()))
+    {
+        fprintf(stderr, "rx2_soak: unknown storage preset %s\n", opt->config.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---------------- process probes ----------------
+
+static double ResidentMB()
+{
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0.0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(f);
+    return resident * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+static int ThreadCount()
+{
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f)
+        return 0;
+
+    int  threads = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strncmp(line, "Threads:", 8) == 0)
+        {
+            threads = atoi(line + 8);
+            break;
+        }
+    }
+    fclose(f);
+    return threads;
+}
+
+static int DescriptorCount()
+{
+    DIR* dir = opendir("/proc/self/fd");
+    if (!dir)
+        return 0;
+
+    int count = 0;
+    while (dirent* entry = readdir(dir))
+    {
+        if (entry->d_name[0] != '.')
+            ++count;
+    }
+    closedir(dir);
+    return count - 1;   // the descriptor reading the directory
+}
+
+static int HandleCount()
+{
+    DWORD count = 0;
+    return GetProcessHandleCount(GetCurrentProcess(), &count) ? static_cast<int>(count) : 0;
+}
+
+// ---------------- workload ----------------
+
+// Pause and resume. The paused decoder is the one read last, so the memory
+// budget must leave it alone and the next Read() carries on at once. Once
+// another file has played, it can be evicted: then Read() must not wait,
+// serving silence without advancing while a pool thread restores the PCM,
+// and carry on with the same audio from the same position afterwards.
+// `decoder` is positioned where playback paused.
+static bool PauseResume(Rx2DecoderExtension* extension, const Rx2BenchCorpusFile& file,
+                        IAIMPAudioDecoder* decoder)
+{
+    static char before[16384], after[16384];
+    Rx2Decoder* rx2 = static_cast<Rx2Decoder*>(decoder);
+
+    const INT64 position = decoder->GetPosition();
+    const int   expected = decoder->Read(before, sizeof(before));
+    if (expected <= 0 || !decoder->SetPosition(position))
+        return true;   // at the end; nothing left to resume
+
+    if (rx2->EvictMemory() != 0)
+        return false;
+    int got = decoder->Read(after, sizeof(after));
+    if (got != expected || memcmp(before, after, static_cast<size_t>(got)) != 0
+        || !decoder->SetPosition(position))
+        return false;
+
+    // Another track plays meanwhile (reading it makes it the playing one).
+    IAIMPAudioDecoder* other = nullptr;
+    Rx2BenchOpenResult r;
+    Rx2BenchOpenFile(extension, file.path, &r, &other);
+    if (other)
+        other->Release();
+    if (!r.audio || rx2->EvictMemory() == 0)
+        return false;
+
+    got = decoder->Read(after, sizeof(after));
+    if (got != expected || decoder->GetPosition() != position
+        || after[0] != 0 || memcmp(after, after + 1, static_cast<size_t>(got) - 1) != 0)
+        return false;
+
+    for (int i = 0; i < 5000 && rx2->ResidentBytes() == 0; ++i)
+        Sleep(1);
+
+    got = decoder->Read(after, sizeof(after));
+    return got == expected
+        && decoder->GetPosition() == position + got
+        && memcmp(before, after, static_cast<size_t>(got)) == 0;
+}
+
+// A seekbar drawing the open file: the peaks the decoder offers must match
+// what the waveform service serves for the same file without it.
+static bool SameWaveform(IRx2ServiceWaveform* service, IAIMPAudioDecoder* decoder, const std::string& path)
+{
+    const int kBuckets = 64;
+
+    IRx2Waveform* own = nullptr;
+    if (FAILED(decoder->QueryInterface(IID_IRx2Waveform, (void**)&own)) || !own)
+        return false;
+
+    Rx2BenchString* name = new Rx2BenchString();
+    std::wstring    wide(path.begin(), path.end());
+    name->SetData(&wide[0], static_cast<int>(wide.size()));
+
+    IRx2Waveform* served = nullptr;
+    const bool    found  = SUCCEEDED(service->GetWaveform(name, &served)) && served;
+    name->Release();
+
+    bool same = found
+             && own->GetChannels() == served->GetChannels()
+             && own->GetFrames() == served->GetFrames();
+    if (same)
+    {
+        std::vector<Rx2Peak> a(kBuckets * own->GetChannels()), b(a.size());
+        const int n = own->GetPeaks(0, own->GetFrames(), kBuckets, a.data());
+        same = n > 0
+            && served->GetPeaks(0, served->GetFrames(), kBuckets, b.data()) == n
+            && memcmp(a.data(), b.data(), n * own->GetChannels() * sizeof(Rx2Peak)) == 0;
+    }
+
+    if (served)
+        served->Release();
+    own->Release();
+    return same;
+}
+
+// One valid file the way playback uses it: open to first audio, play a
+// little, seek around, draw its waveform, play again, pause, resume, close.
+static bool PlayValid(Rx2DecoderExtension* extension, IRx2ServiceWaveform* waveforms,
+                      const Rx2BenchCorpusFile& file, double* openMs)
+{
+    IAIMPAudioDecoder* decoder = nullptr;
+    Rx2BenchOpenResult r;
+    Rx2BenchOpenFile(extension, file.path, &r, &decoder);
+    if (FAILED(r.hr) || !r.audio || !decoder)
+    {
+        fprintf(stderr, "rx2_soak: %s: no audio (hr 0x%08x, %ls)\n",
+                file.path.c_str(), static_cast<unsigned>(r.hr), r.error.c_str());
+        if (decoder)
+            decoder->Release();
+        return false;
+    }
+    *openMs = Rx2BenchNsToMs(r.totalNs);
+
+    static char buffer[16384];
+    const INT64 size = decoder->GetSize();
+    const INT64 seeks[] = { size / 3, (size * 4) / 5, 0, size / 2 };
+
+    bool ok = true;
+    for (INT64 position : seeks)
+    {
+        for (int i = 0; i < 4 && ok; ++i)
+            ok = decoder->Read(buffer, sizeof(buffer)) >= 0;
+        ok = ok && decoder->SetPosition(position - position % 16);
+    }
+    if (!ok)
+    {
+        decoder->Release();
+        fprintf(stderr, "rx2_soak: %s: read or seek failed\n", file.path.c_str());
+        return false;
+    }
+
+    if (!SameWaveform(waveforms, decoder, file.path))
+    {
+        decoder->Release();
+        fprintf(stderr, "rx2_soak: %s: the waveform service and the decoder disagree\n", file.path.c_str());
+        return false;
+    }
+
+    ok = PauseResume(extension, file, decoder);
+    decoder->Release();
+    if (!ok)
+        fprintf(stderr, "rx2_soak: %s: resuming after eviction did not continue the audio\n", file.path.c_str());
+    return ok;
+}
+
+// An invalid file as a first attempt, so every open takes the whole
+// rejection path. The hanging file needs no clearing: a sandbox timeout is
+// never cached, so each of its opens waits out the timeout again.
+static bool RejectInvalid(Rx2DecoderExtension* extension, const Rx2BenchCorpusFile& file)
+{
+    Rx2NegativeCacheClear();
+
+    Rx2BenchOpenResult r;
+    Rx2BenchOpenFile(extension, file.path, &r, nullptr);
+    if (SUCCEEDED(r.hr))
+    {
+        fprintf(stderr, "rx2_soak: %s: %s file was accepted\n",
+                file.path.c_str(), Rx2BenchFileKindName(file.kind));
+        return false;
+    }
+    return true;
+}
+
+// ---------------- trends ----------------
+
+struct SoakSample
+{
+    double minutes;
+    double rssMB;
+    double handles;
+    double descriptors;
+    double threads;
+    double openP50Ms;
+};
+
+struct SoakMetric
+{
+    const char* name;
+    const char* unit;
+    double SoakSample::* field;
+    bool        count;     // integer resource: any lasting rise is a leak
+};
+
+static const SoakMetric kMetrics[] =
+{
+    { "rss",         "MB", &SoakSample::rssMB,       false },
+    { "handles",     "",   &SoakSample::handles,     true  },
+    { "descriptors", "",   &SoakSample::descriptors, true  },
+    { "threads",     "",   &SoakSample::threads,     true  },
+    { "open_p50",    "ms", &SoakSample::openP50Ms,   false },
+};
+
+// Least-squares slope of the metric over time, per hour.
+static double SlopePerHour(const std::vector<SoakSample>& samples, double SoakSample::* field)
+{
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (const SoakSample& s : samples)
+    {
+        sx  += s.minutes;
+        sy  += s.*field;
+        sxx += s.minutes * s.minutes;
+        sxy += s.minutes * (s.*field);
+    }
+    const double n     = static_cast<double>(samples.size());
+    const double denom = n * sxx - sx * sx;
+    return denom > 0.0 ? (n * sxy - sx * sy) / denom * 60.0 : 0.0;
+}
+
+// Compares the first and last third of the samples after warm-up. Counts
+// fail when the last third never drops back to the first third's peak;
+// memory and latency when the last third's median grew past the drift.
+static bool Trends(const std::vector<SoakSample>& samples, const SoakMetric& metric,
+                   double driftPct, double* growth)
+{
+    const size_t third = samples.size() / 3;
+    std::vector<double> first, last;
+    for (size_t i = 0; i < third; ++i)
+    {
+        first.push_back(samples[i].*metric.field);
+        last.push_back(samples[samples.size() - third + i].*metric.field);
+    }
+
+    if (metric.count)
+    {
+        const double firstMax = *std::max_element(first.begin(), first.end());
+        const double lastMin  = *std::min_element(last.begin(), last.end());
+        *growth = lastMin - firstMax;
+        return lastMin > firstMax;
+    }
+
+    const double before = Rx2BenchMedian(first);
+    const double after  = Rx2BenchMedian(last);
+    *growth = before > 0.0 ? (after - before) / before * 100.0 : 0.0;
+    return *growth > driftPct;
+}
+
+// ---------------- main ----------------
+
+int main(int argc, char** argv)
+{
+    SoakOptions opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    Rx2BenchCorpus corpus;
+    if (!corpus.Create(opt.dir, opt.files, opt.hangMs))
+    {
+        fprintf(stderr, "rx2_soak: cannot write the corpus to %s\n", corpus.Dir().c_str());
+        return 2;
+    }
+
+    std::vector<const Rx2BenchCorpusFile*> valid, invalid;
+    for (const Rx2BenchCorpusFile& file : corpus.Files())
+    {
+        if (file.kind == Rx2BenchFileKind::Valid)
+            valid.push_back(&file);
+        else if (file.kind == Rx2BenchFileKind::Corrupt || file.kind == Rx2BenchFileKind::Truncated
+                 || file.kind == Rx2BenchFileKind::Hanging)
+            invalid.push_back(&file);
+    }
+
+    fprintf(stderr, "rx2_soak: %zu valid and %zu invalid files in %s, %.1f minutes, %s storage\n",
+            valid.size(), invalid.size(), corpus.Dir().c_str(), opt.minutes, opt.config.c_str());
+
+    Rx2BenchCore core;
+    core.SetConfig(L"RX2Decoder\\RexCreateTimeoutMs", opt.timeoutMs);
+    Rx2BenchApplyStorageConfig(core, *Rx2BenchFindStorageConfig(opt.config.c_str()));
+
+    if (!opt.recordPath.empty()
+        && !Rx2CallLogOpen(std::wstring(opt.recordPath.begin(), opt.recordPath.end()).c_str()))
+    {
+        fprintf(stderr, "rx2_soak: cannot record calls to %s\n", opt.recordPath.c_str());
+        return 2;
+    }
+
+    Rx2DecoderExtension* extension = new Rx2DecoderExtension(&core);
+    Rx2WaveformService*  waveforms = new Rx2WaveformService(&core, extension);
+
+    const std::int64_t start      = Rx2BenchNowNs();
+    const std::int64_t end        = start + static_cast<std::int64_t>(opt.minutes * 60e9);
+    const std::int64_t sampleNs   = static_cast<std::int64_t>(opt.sampleSec) * 1000000000;
+    std::int64_t       nextSample = start + sampleNs;
+
+    std::vector<SoakSample> samples;
+    std::vector<double>     window, all;
+    long                    maxAbandoned = 0;
+    size_t                  cycles = 0;
+    bool                    ok = true;
+
+    while (ok && Rx2BenchNowNs() < end)
+    {
+        // One cycle: every valid file, then one invalid file in turn.
+        for (const Rx2BenchCorpusFile* file : valid)
+        {
+            double openMs = 0.0;
+            if (!(ok = PlayValid(extension, waveforms, *file, &openMs)))
+                break;
+            window.push_back(openMs);
+            all.push_back(openMs);
+        }
+        ok = ok && RejectInvalid(extension, *invalid[cycles % invalid.size()]);
+
+        // The prefetcher's worker and empty slot, as a plugin load and
+        // unload leave them.
+        Rx2PrefetchStart(&core);
+        Rx2PrefetchStop();
+        ++cycles;
+
+        maxAbandoned = std::max(maxAbandoned, Rx2AbandonedRexCreates());
+
+        const std::int64_t now = Rx2BenchNowNs();
+        if (now < nextSample)
+            continue;
+        nextSample += sampleNs;
+
+        SoakSample s;
+        s.minutes     = (now - start) / 60e9;
+        s.rssMB       = ResidentMB();
+        s.handles     = HandleCount();
+        s.descriptors = DescriptorCount();
+        s.threads     = ThreadCount();
+        s.openP50Ms   = Rx2BenchPercentile(window, 50);
+        samples.push_back(s);
+        window.clear();
+
+        fprintf(stderr, "rx2_soak: %6.1f min  rss %7.1f MB  handles %4.0f  fds %4.0f  threads %3.0f  open p50 %7.3f ms\n",
+                s.minutes, s.rssMB, s.handles, s.descriptors, s.threads, s.openP50Ms);
+    }
+
+    // Let abandoned REXCreate workers finish before the library goes away.
+    for (int i = 0; i < 100 && Rx2AbandonedRexCreates() > 0; ++i)
+        Sleep(opt.hangMs / 10 + 1);
+
+    waveforms->Release();
+    extension->Release();
+    Rx2CallLogStop();
+    if (!ok)
+        return 2;
+
+    // The first fifth is warm-up: caches, allocator arenas and the worker
+    // pool settle there.
+    samples.erase(samples.begin(), samples.begin() + samples.size() / 5);
+    if (samples.size() < 6)
+    {
+        fprintf(stderr, "rx2_soak: only %zu samples after warm-up\n", samples.size());
+        return 2;
+    }
+
+    Rx2BenchReport report("");
+    report.Add("soak_opens_per_min", all.size() / opt.minutes,             "opens/min", true);
+    report.Add("soak_open_p50_ms",   Rx2BenchPercentile(all, 50),          "ms",        false);
+    report.Add("soak_open_p95_ms",   Rx2BenchPercentile(all, 95),          "ms",        false);
+    report.Add("soak_rss_mb",        samples.back().rssMB,                 "MB",        false);
+    report.Add("soak_abandoned_max", static_cast<double>(maxAbandoned),    "workers",   false);
+
+    int trends = 0;
+    for (const SoakMetric& metric : kMetrics)
+    {
+        const std::string prefix = std::string("soak_") + metric.name;
+        report.Add(prefix + "_slope_per_hour", SlopePerHour(samples, metric.field),
+                   metric.unit[0] ? metric.unit : "count", false);
+
+        double growth = 0.0;
+        if (Trends(samples, metric, opt.driftPct, &growth))
+        {
+            fprintf(stderr, metric.count
+                            ? "rx2_soak: %s trends upward: the last third stays %.0f above the first third's peak\n"
+                            : "rx2_soak: %s trends upward: %+.1f%% between the first and last third\n",
+                    metric.name, growth);
+            ++trends;
+        }
+    }
+
+    Rx2RtAuditReport();
+
+    std::ostringstream config;
+    config << "\"minutes\": " << opt.minutes
+           << ", \"files\": " << opt.files
+           << ", \"storage\": \"" << opt.config << "\""
+           << ", \"timeout_ms\": " << opt.timeoutMs
+           << ", \"hang_ms\": " << opt.hangMs
+           << ", \"cycles\": " << cycles;
+
+    const int result = Rx2BenchFinish("rx2_soak", config.str(), report, opt.outPath, opt.baselinePath,
+                                      opt.threshold);
+    return (result == 0 && trends > 0) ? 1 : result;
+}
@@ -0,0 +1,359 @@
+// End-to-end time to first audio: Rx2DecoderExtension::CreateDecoder up to
+// the first Read() that returns data, over a corpus of stand-in files, with
+// the latency of turning invalid files away. See the "Benchmarks" section
+// of README.md.
+
+#include "Rx2BenchAimp.h"
+#include "Rx2BenchCorpus.h"
+#include "Rx2BenchOpen.h"
+#include "Rx2BenchReport.h"
+
+#include "Rx2DecoderExtension.h"
+#include "Rx2IndexFormat.h"
+#include "Rx2LibraryIndex.h"
+#include "Rx2Metrics.h"
+#include "Rx2NegativeCache.h"
+#include "Rx2RexShim.h"
+#include "Rx2RtAudit.h"
+#include "Rx2Trace.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// ---------------- options ----------------
+
+struct TtfaOptions
+{
+    int         files;       // valid files in the corpus
+    int         rounds;      // passes over the corpus
+    std::string config;      // storage preset
+    std::string dir;         // corpus directory; empty = temporary
+    double      threshold;   // regression threshold, percent
+    std::string outPath;
+    std::string baselinePath;
+    std::string metricsPath;  // the plugin's own counters, as Stats.json
+    std::string tracePath;    // Chrome trace of every open
+    bool        rexShim;      // time every REX call into the metrics
+    bool        index;        // open through a library index of the corpus
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: rx2_ttfa [options]\n"
+            "  --files N        valid loops in the corpus (default 24)\n"
+            "  --rounds N       passes over the corpus (default 5)\n"
+            "  --config NAME    storage preset: f32, i16, i24, i16c, f32_spill (default f32)\n"
+            "  --dir DIR        write the corpus to DIR and keep it (default: temporary)\n"
+            "  --out FILE       write the JSON report to FILE instead of stdout\n"
+            "  --baseline FILE  compare against an earlier report; exit 1 on regressions\n"
+            "  --threshold PCT  allowed slowdown before a result is flagged (default 10)\n"
+            "  --metrics FILE   also write the plugin's counters and histograms to FILE\n"
+            "  --trace FILE     record the plugin's lifecycle trace and write it to FILE\n"
+            "  --rex-shim       time every REX library call; see rex_api in --metrics\n"
+            "  --index          index the corpus first and open through the library index\n");
+}
+
+static bool ParseOptions(int argc, char** argv, TtfaOptions* opt)
+{
+    opt->files     = 24;
+    opt->rounds    = 5;
+    opt->config    = "f32";
+    opt->threshold = 10.0;
+    opt->rexShim   = false;
+    opt->index     = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg   = argv[i];
+        const char*       value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (arg == "--rex-shim")
+        {
+            opt->rexShim = true;
+            continue;
+        }
+        if (arg == "--index")
+        {
+            opt->index = true;
+            continue;
+        }
+        if (!value)
+        {
+            fprintf(stderr, "rx2_ttfa: missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if      (arg == "--files")     opt->files        = atoi(value);
+        else if (arg == "--rounds")    opt->rounds       = atoi(value);
+        else if (arg == "--config")    opt->config       = value;
+        else if (arg == "--dir")       opt->dir          = value;
+        else if (arg == "--out")       opt->outPath      = value;
+        else if (arg == "--baseline")  opt->baselinePath = value;
+        else if (arg == "--threshold") opt->threshold    = atof(value);
+        else if (arg == "--metrics")   opt->metricsPath  = value;
+        else if (arg == "--trace")     opt->tracePath    = value;
+        else
+        {
+            fprintf(stderr, "rx2_ttfa: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (opt->files <= 0 || opt->rounds <= 0)
+    {
+        fprintf(stderr, "rx2_ttfa: --files and --rounds must be positive\n");
+        return false;
+    }
+    if (!Rx2BenchFindStorageConfig(opt->config.c_str()))
+    {
+        fprintf(stderr, "rx2_ttfa: unknown storage preset %s\n", opt->config.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---------------- checks ----------------
+
+// An open answered by the library index parses no header, so the
+// stand-in marks that bound validate, ingest and create never appear.
+static bool PhaseExpected(int phase, bool indexed)
+{
+    return !indexed || phase >= kRx2BenchPhaseSetup;
+}
+
+// Every open must end the way its file kind dictates, or the timings are
+// of the wrong path.
+static bool CheckOutcome(const Rx2BenchCorpusFile& file, const Rx2BenchOpenResult& r, bool indexed)
+{
+    const char* kind = Rx2BenchFileKindName(file.kind);
+
+    if (file.kind == Rx2BenchFileKind::Valid)
+    {
+        if (FAILED(r.hr) || !r.audio)
+        {
+            fprintf(stderr, "rx2_ttfa: %s: no audio (hr 0x%08x, %ls)\n",
+                    file.path.c_str(), static_cast<unsigned>(r.hr), r.error.c_str());
+            return false;
+        }
+        for (int phase = 0; phase < kRx2BenchPhaseCount; ++phase)
+        {
+            if (r.phaseNs[phase] < 0 && PhaseExpected(phase, indexed))
+            {
+                fprintf(stderr, "rx2_ttfa: %s: phase %s was not observed\n",
+                        file.path.c_str(), Rx2BenchPhaseName(phase));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (SUCCEEDED(r.hr))
+    {
+        fprintf(stderr, "rx2_ttfa: %s: %s file was accepted\n", file.path.c_str(), kind);
+        return false;
+    }
+    if (Rx2BenchFileKindHasRexError(file.kind) == r.error.empty())
+    {
+        fprintf(stderr, "rx2_ttfa: %s: unexpected error text for a %s file: \"%ls\"\n",
+                file.path.c_str(), kind, r.error.c_str());
+        return false;
+    }
+    return true;
+}
+
+// ---------------- library index ----------------
+
+// Indexes the corpus as rx2_index would, under the names the bench
+// streams report, and maps the index for the decoder extension.
+static bool BuildLibraryIndex(const Rx2BenchCorpus& corpus, const std::string& path)
+{
+    std::vector<Rx2IndexRecord> records;
+    for (const Rx2BenchCorpusFile& file : corpus.Files())
+    {
+        Rx2IndexRecord record;
+        REX::REXError  err;
+        if (!Rx2IndexScanFile(file.path, &record, &err))
+            continue;
+        record.path.assign(file.path.begin(), file.path.end());
+        records.push_back(std::move(record));
+    }
+
+    return Rx2IndexWrite(path, records)
+        && Rx2LibraryIndexOpen(std::wstring(path.begin(), path.end()).c_str());
+}
+
+// ---------------- main ----------------
+
+static const Rx2BenchFileKind kInvalidKinds[] =
+{
+    Rx2BenchFileKind::Corrupt,
+    Rx2BenchFileKind::Truncated,
+    Rx2BenchFileKind::Wav,
+    Rx2BenchFileKind::ZeroLength,
+    Rx2BenchFileKind::Silent,
+    Rx2BenchFileKind::Empty,
+};
+
+int main(int argc, char** argv)
+{
+    TtfaOptions opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    Rx2BenchCorpus corpus;
+    if (!corpus.Create(opt.dir, opt.files))
+    {
+        fprintf(stderr, "rx2_ttfa: cannot write the corpus to %s\n", corpus.Dir().c_str());
+        return 2;
+    }
+
+    fprintf(stderr, "rx2_ttfa: %zu files in %s, %d rounds, %s storage\n",
+            corpus.Files().size(), corpus.Dir().c_str(), opt.rounds, opt.config.c_str());
+
+    Rx2BenchCore core;
+    Rx2BenchApplyStorageConfig(core, *Rx2BenchFindStorageConfig(opt.config.c_str()));
+    if (!opt.tracePath.empty())
+        Rx2TraceEnable();
+    if (opt.rexShim)
+        Rx2RexShimEnable(std::string(), nullptr);
+
+    Rx2DecoderExtension* extension = new Rx2DecoderExtension(&core);
+
+    // The first open of a session also loads the REX library; keep it out
+    // of the percentiles.
+    {
+        Rx2BenchOpenResult warmup;
+        Rx2BenchOpenFile(extension, corpus.Files().front().path, &warmup, nullptr);
+    }
+
+    // Beside the corpus directory, which a temporary corpus removes.
+    const std::string indexPath = corpus.Dir() + ".rx2index";
+    if (opt.index && !BuildLibraryIndex(corpus, indexPath))
+    {
+        fprintf(stderr, "rx2_ttfa: cannot build the library index %s\n", indexPath.c_str());
+        extension->Release();
+        return 2;
+    }
+
+    std::vector<double> total;
+    std::vector<double> phases[kRx2BenchPhaseCount];
+    std::vector<double> failCold[_countof(kInvalidKinds)];
+    std::vector<double> failCached[_countof(kInvalidKinds)];
+    std::vector<double> failAll;
+
+    bool ok = true;
+    for (int round = 0; round < opt.rounds && ok; ++round)
+    {
+        for (const Rx2BenchCorpusFile& file : corpus.Files())
+        {
+            if (file.kind != Rx2BenchFileKind::Valid)
+                continue;
+
+            Rx2BenchOpenResult r;
+            Rx2BenchOpenFile(extension, file.path, &r, nullptr);
+            if (!(ok = CheckOutcome(file, r, opt.index)))
+                break;
+
+            total.push_back(Rx2BenchNsToMs(r.totalNs));
+            for (int phase = 0; phase < kRx2BenchPhaseCount; ++phase)
+            {
+                if (r.phaseNs[phase] >= 0)
+                    phases[phase].push_back(Rx2BenchNsToMs(r.phaseNs[phase]));
+            }
+        }
+
+        // Each invalid file twice: once as if AIMP had never seen it, once
+        // more as a playlist refresh would, answered by the negative cache.
+        for (size_t k = 0; k < _countof(kInvalidKinds) && ok; ++k)
+        {
+            for (const Rx2BenchCorpusFile& file : corpus.Files())
+            {
+                if (file.kind != kInvalidKinds[k])
+                    continue;
+
+                Rx2NegativeCacheClear();
+
+                Rx2BenchOpenResult cold, cached;
+                Rx2BenchOpenFile(extension, file.path, &cold, nullptr);
+                Rx2BenchOpenFile(extension, file.path, &cached, nullptr);
+                if (!(ok = CheckOutcome(file, cold, opt.index) && CheckOutcome(file, cached, opt.index)))
+                    break;
+
+                failCold[k].push_back(Rx2BenchNsToMs(cold.totalNs));
+                failCached[k].push_back(Rx2BenchNsToMs(cached.totalNs));
+                failAll.push_back(Rx2BenchNsToMs(cold.totalNs));
+            }
+        }
+    }
+
+    extension->Release();
+    if (opt.index)
+    {
+        Rx2LibraryIndexStop();
+        remove(indexPath.c_str());
+    }
+    if (!ok)
+        return 2;
+
+    Rx2BenchReport report("");
+
+    report.Add("ttfa_p50_ms", Rx2BenchPercentile(total, 50), "ms", false);
+    report.Add("ttfa_p95_ms", Rx2BenchPercentile(total, 95), "ms", false);
+    report.Add("ttfa_p99_ms", Rx2BenchPercentile(total, 99), "ms", false);
+
+    for (int phase = 0; phase < kRx2BenchPhaseCount; ++phase)
+    {
+        if (phases[phase].empty())
+            continue;
+        const std::string prefix = std::string("phase_") + Rx2BenchPhaseName(phase);
+        report.Add(prefix + "_p50_ms", Rx2BenchPercentile(phases[phase], 50), "ms", false);
+        report.Add(prefix + "_p95_ms", Rx2BenchPercentile(phases[phase], 95), "ms", false);
+    }
+
+    report.Add("fail_p50_ms", Rx2BenchPercentile(failAll, 50), "ms", false);
+    report.Add("fail_p95_ms", Rx2BenchPercentile(failAll, 95), "ms", false);
+    report.Add("fail_p99_ms", Rx2BenchPercentile(failAll, 99), "ms", false);
+
+    for (size_t k = 0; k < _countof(kInvalidKinds); ++k)
+    {
+        const std::string prefix = std::string("fail_") + Rx2BenchFileKindName(kInvalidKinds[k]);
+        report.Add(prefix + "_p50_ms",        Rx2BenchPercentile(failCold[k], 50),   "ms", false);
+        report.Add(prefix + "_p95_ms",        Rx2BenchPercentile(failCold[k], 95),   "ms", false);
+        report.Add(prefix + "_cached_p50_ms", Rx2BenchPercentile(failCached[k], 50), "ms", false);
+    }
+
+    Rx2RtAuditReport();
+
+    if (!opt.metricsPath.empty()
+        && !Rx2MetricsWriteJson(std::wstring(opt.metricsPath.begin(), opt.metricsPath.end()).c_str()))
+    {
+        fprintf(stderr, "rx2_ttfa: cannot write %s\n", opt.metricsPath.c_str());
+        return 2;
+    }
+    if (!opt.tracePath.empty()
+        && !Rx2TraceWriteJson(std::wstring(opt.tracePath.begin(), opt.tracePath.end()).c_str()))
+    {
+        fprintf(stderr, "rx2_ttfa: cannot write %s\n", opt.tracePath.c_str());
+        return 2;
+    }
+    Rx2TraceDisable();
+
+    std::ostringstream config;
+    config << "\"files\": " << opt.files
+           << ", \"rounds\": " << opt.rounds
+           << ", \"storage\": \"" << opt.config << "\""
+           << ", \"rex_shim\": " << (opt.rexShim ? "true" : "false")
+           << ", \"index\": " << (opt.index ? "true" : "false");
+
+    return Rx2BenchFinish("rx2_ttfa", config.str(), report, opt.outPath, opt.baselinePath, opt.threshold);
+}
@@ -0,0 +1,686 @@
+// POSIX implementations behind bench/include/windows.h and shlwapi.h.
+
+#include <windows.h>
+#include <shlwapi.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ---------------- waitable objects ----------------
+
+namespace {
+
+enum class ObjectKind
+{
+    Event,
+    Semaphore,
+    Thread,
+    File
+};
+
+struct WaitObject
+{
+    ObjectKind              kind;
+    std::mutex              mutex;
+    std::condition_variable cv;
+    bool                    manualReset = true;
+    bool                    signaled    = false;   // event / finished thread
+    LONG                    count       = 0;       // semaphore
+    LONG                    maximum     = 0;
+    std::thread             thread;
+    int                     fd          = -1;      // file
+
+    explicit WaitObject(ObjectKind k) : kind(k) {}
+
+    // Called with `mutex` held.
+    bool IsSignaled() const
+    {
+        return kind == ObjectKind::Semaphore ? count > 0 : signaled;
+    }
+
+    // Called with `mutex` held, after IsSignaled().
+    void Consume()
+    {
+        if (kind == ObjectKind::Semaphore)
+            --count;
+        else if (kind == ObjectKind::Event && !manualReset)
+            signaled = false;
+    }
+};
+
+// HANDLE points at a heap-held reference, so a detached thread can outlive
+// its handle.
+typedef std::shared_ptr<WaitObject> ObjectRef;
+
+WaitObject* ToObject(HANDLE handle)
+{
+    if (!handle || handle == INVALID_HANDLE_VALUE)
+        return nullptr;
+    return static_cast<ObjectRef*>(handle)->get();
+}
+
+std::atomic<long> g_liveHandles(0);
+
+HANDLE NewHandle(const ObjectRef& object)
+{
+    HANDLE handle = new (std::nothrow) ObjectRef(object);
+    if (handle)
+        ++g_liveHandles;
+    return handle;
+}
+
+} // namespace
+
+HANDLE CreateEventW(void* /*attrs*/, BOOL manualReset, BOOL initialState, LPCWSTR /*name*/)
+{
+    ObjectRef event = std::make_shared<WaitObject>(ObjectKind::Event);
+    event->manualReset = manualReset != FALSE;
+    event->signaled    = initialState != FALSE;
+    return NewHandle(event);
+}
+
+BOOL SetEvent(HANDLE handle)
+{
+    WaitObject* event = ToObject(handle);
+    if (!event)
+        return FALSE;
+
+    std::lock_guard<std::mutex> lock(event->mutex);
+    event->signaled = true;
+    event->cv.notify_all();
+    return TRUE;
+}
+
+BOOL ResetEvent(HANDLE handle)
+{
+    WaitObject* event = ToObject(handle);
+    if (!event)
+        return FALSE;
+
+    std::lock_guard<std::mutex> lock(event->mutex);
+    event->signaled = false;
+    return TRUE;
+}
+
+HANDLE CreateSemaphoreW(void* /*attrs*/, LONG initialCount, LONG maximumCount, LPCWSTR /*name*/)
+{
+    ObjectRef semaphore = std::make_shared<WaitObject>(ObjectKind::Semaphore);
+    semaphore->count   = initialCount;
+    semaphore->maximum = maximumCount;
+    return NewHandle(semaphore);
+}
+
+BOOL ReleaseSemaphore(HANDLE handle, LONG releaseCount, LONG* previousCount)
+{
+    WaitObject* semaphore = ToObject(handle);
+    if (!semaphore || releaseCount <= 0)
+        return FALSE;
+
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->count + releaseCount > semaphore->maximum)
+        return FALSE;
+
+    if (previousCount)
+        *previousCount = semaphore->count;
+    semaphore->count += releaseCount;
+    semaphore->cv.notify_all();
+    return TRUE;
+}
+
+HANDLE CreateThread(void* /*attrs*/, SIZE_T /*stackSize*/, LPTHREAD_START_ROUTINE proc, LPVOID param,
+                    DWORD /*flags*/, DWORD* threadId)
+{
+    ObjectRef thread = std::make_shared<WaitObject>(ObjectKind::Thread);
+
+    try
+    {
+        thread->thread = std::thread([thread, proc, param]()
+        {
+            proc(param);
+
+            std::lock_guard<std::mutex> lock(thread->mutex);
+            thread->signaled = true;
+            thread->cv.notify_all();
+        });
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+
+    if (threadId)
+        *threadId = 0;
+    return NewHandle(thread);
+}
+
+BOOL TerminateThread(HANDLE /*thread*/, DWORD /*exitCode*/)
+{
+    return FALSE;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+    if (!handle || handle == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    ObjectRef* ref = static_cast<ObjectRef*>(handle);
+    WaitObject* object = ref->get();
+
+    if (object->kind == ObjectKind::Thread && object->thread.joinable())
+    {
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(object->mutex);
+            finished = object->signaled;
+        }
+
+        if (finished)
+            object->thread.join();
+        else
+            object->thread.detach();
+    }
+
+    if (object->kind == ObjectKind::File && object->fd >= 0)
+    {
+        close(object->fd);
+        object->fd = -1;
+    }
+
+    delete ref;
+    --g_liveHandles;
+    return TRUE;
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+    WaitObject* object = ToObject(handle);
+    if (!object)
+        return WAIT_FAILED;
+
+    std::unique_lock<std::mutex> lock(object->mutex);
+
+    if (milliseconds == INFINITE)
+        object->cv.wait(lock, [object]() { return object->IsSignaled(); });
+    else if (!object->cv.wait_for(lock, std::chrono::milliseconds(milliseconds),
+                                  [object]() { return object->IsSignaled(); }))
+        return WAIT_TIMEOUT;
+
+    object->Consume();
+    return WAIT_OBJECT_0;
+}
+
+// Wait-any only, by polling; used by the memory budget's watcher, which the
+// bench never starts.
+DWORD WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL /*waitAll*/, DWORD milliseconds)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(milliseconds);
+
+    for (;;)
+    {
+        for (DWORD i = 0; i < count; ++i)
+        {
+            WaitObject* object = ToObject(handles[i]);
+            if (!object)
+                return WAIT_FAILED;
+
+            std::lock_guard<std::mutex> lock(object->mutex);
+            if (object->IsSignaled())
+            {
+                object->Consume();
+                return WAIT_OBJECT_0 + i;
+            }
+        }
+
+        if (milliseconds != INFINITE && std::chrono::steady_clock::now() >= deadline)
+            return WAIT_TIMEOUT;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+BOOL QueueUserWorkItem(LPTHREAD_START_ROUTINE proc, PVOID context, ULONG /*flags*/)
+{
+    try
+    {
+        std::thread(proc, context).detach();
+    }
+    catch (...)
+    {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+namespace {
+
+struct WaitRegistration
+{
+    std::atomic<bool> stop{ false };
+    std::thread       thread;
+};
+
+} // namespace
+
+BOOL RegisterWaitForSingleObject(HANDLE* newWait, HANDLE object, WAITORTIMERCALLBACK callback,
+                                 PVOID context, DWORD milliseconds, ULONG flags)
+{
+    if (!newWait || !ToObject(object) || !callback || milliseconds != INFINITE)
+        return FALSE;
+
+    WaitRegistration* wait = new (std::nothrow) WaitRegistration();
+    if (!wait)
+        return FALSE;
+
+    try
+    {
+        wait->thread = std::thread([wait, object, callback, context, flags]()
+        {
+            while (!wait->stop)
+            {
+                if (WaitForSingleObject(object, 50) != WAIT_OBJECT_0 || wait->stop)
+                    continue;
+                callback(context, FALSE);
+                if (flags & WT_EXECUTEONLYONCE)
+                    break;
+            }
+        });
+    }
+    catch (...)
+    {
+        delete wait;
+        return FALSE;
+    }
+
+    *newWait = wait;
+    return TRUE;
+}
+
+BOOL UnregisterWaitEx(HANDLE waitHandle, HANDLE /*completionEvent*/)
+{
+    WaitRegistration* wait = static_cast<WaitRegistration*>(waitHandle);
+    if (!wait)
+        return FALSE;
+
+    wait->stop = true;
+    wait->thread.join();
+    delete wait;
+    return TRUE;
+}
+
+HANDLE GetCurrentThread()
+{
+    return reinterpret_cast<HANDLE>(static_cast<LONG_PTR>(-2));
+}
+
+HANDLE GetCurrentProcess()
+{
+    return reinterpret_cast<HANDLE>(static_cast<LONG_PTR>(-1));
+}
+
+BOOL GetProcessHandleCount(HANDLE process, DWORD* count)
+{
+    if (process != GetCurrentProcess() || !count)
+        return FALSE;
+    *count = static_cast<DWORD>(g_liveHandles.load());
+    return TRUE;
+}
+
+DWORD GetCurrentThreadId()
+{
+    return static_cast<DWORD>(syscall(SYS_gettid));
+}
+
+DWORD GetCurrentProcessId()
+{
+    return static_cast<DWORD>(getpid());
+}
+
+BOOL SetThreadPriority(HANDLE /*thread*/, int /*priority*/)
+{
+    return TRUE;
+}
+
+HANDLE CreateMemoryResourceNotification(MEMORY_RESOURCE_NOTIFICATION_TYPE /*type*/)
+{
+    return nullptr;
+}
+
+BOOL QueryMemoryResourceNotification(HANDLE /*handle*/, BOOL* state)
+{
+    if (state)
+        *state = FALSE;
+    return FALSE;
+}
+
+void Sleep(DWORD ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// ---------------- files ----------------
+
+static std::string NarrowPath(LPCWSTR path)
+{
+    std::string out;
+    for (; path && *path; ++path)
+    {
+        const std::uint32_t cp = static_cast<std::uint32_t>(*path);
+        if (cp < 0x80)
+        {
+            out.push_back(static_cast<char>(cp));
+        }
+        else if (cp < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+    return out;
+}
+
+static int ToFd(HANDLE handle)
+{
+    WaitObject* object = ToObject(handle);
+    return (object && object->kind == ObjectKind::File) ? object->fd : -1;
+}
+
+HANDLE CreateFileW(LPCWSTR path, DWORD access, DWORD /*shareMode*/, void* /*attrs*/, DWORD disposition,
+                   DWORD /*flags*/, HANDLE /*templateFile*/)
+{
+    int mode = (access & GENERIC_WRITE) ? ((access & GENERIC_READ) ? O_RDWR : O_WRONLY) : O_RDONLY;
+    if (disposition == CREATE_ALWAYS)
+        mode |= O_CREAT | O_TRUNC;
+
+    const int fd = open(NarrowPath(path).c_str(), mode | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return INVALID_HANDLE_VALUE;
+
+    ObjectRef file = std::make_shared<WaitObject>(ObjectKind::File);
+    file->fd = fd;
+
+    HANDLE handle = NewHandle(file);
+    if (!handle)
+    {
+        close(fd);
+        return INVALID_HANDLE_VALUE;
+    }
+    return handle;
+}
+
+BOOL ReadFile(HANDLE file, LPVOID buffer, DWORD bytes, DWORD* read, void* /*overlapped*/)
+{
+    const ssize_t n = ::read(ToFd(file), buffer, bytes);
+    if (read)
+        *read = n > 0 ? static_cast<DWORD>(n) : 0;
+    return n >= 0;
+}
+
+BOOL WriteFile(HANDLE file, const void* buffer, DWORD bytes, DWORD* written, void* /*overlapped*/)
+{
+    const ssize_t n = ::write(ToFd(file), buffer, bytes);
+    if (written)
+        *written = n > 0 ? static_cast<DWORD>(n) : 0;
+    return n >= 0;
+}
+
+DWORD GetFileAttributesW(LPCWSTR path)
+{
+    struct stat st;
+    if (stat(NarrowPath(path).c_str(), &st) != 0)
+        return INVALID_FILE_ATTRIBUTES;
+    return S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+}
+
+BOOL GetFileAttributesExW(LPCWSTR path, GET_FILEEX_INFO_LEVELS /*level*/, LPVOID info)
+{
+    struct stat st;
+    if (!info || stat(NarrowPath(path).c_str(), &st) != 0)
+        return FALSE;
+
+    // FILETIME counts 100 ns intervals from 1601-01-01.
+    const std::uint64_t kEpochDelta = 116444736000000000ull;
+    const std::uint64_t written = kEpochDelta
+                                + static_cast<std::uint64_t>(st.st_mtim.tv_sec) * 10000000u
+                                + static_cast<std::uint64_t>(st.st_mtim.tv_nsec) / 100u;
+    const std::uint64_t size = static_cast<std::uint64_t>(st.st_size);
+
+    WIN32_FILE_ATTRIBUTE_DATA* data = static_cast<WIN32_FILE_ATTRIBUTE_DATA*>(info);
+    memset(data, 0, sizeof(*data));
+    data->dwFileAttributes               = S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY : FILE_ATTRIBUTE_NORMAL;
+    data->ftLastWriteTime.dwLowDateTime  = static_cast<DWORD>(written);
+    data->ftLastWriteTime.dwHighDateTime = static_cast<DWORD>(written >> 32);
+    data->nFileSizeLow                   = static_cast<DWORD>(size);
+    data->nFileSizeHigh                  = static_cast<DWORD>(size >> 32);
+    return TRUE;
+}
+
+BOOL CreateDirectoryW(LPCWSTR path, void* /*attrs*/)
+{
+    return mkdir(NarrowPath(path).c_str(), 0755) == 0;
+}
+
+BOOL DeleteFileW(LPCWSTR path)
+{
+    return unlink(NarrowPath(path).c_str()) == 0;
+}
+
+BOOL MoveFileExW(LPCWSTR from, LPCWSTR to, DWORD /*flags*/)
+{
+    return rename(NarrowPath(from).c_str(), NarrowPath(to).c_str()) == 0;
+}
+
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size)
+{
+    struct stat st;
+    if (!size || fstat(ToFd(file), &st) != 0)
+        return FALSE;
+    size->QuadPart = static_cast<std::int64_t>(st.st_size);
+    return TRUE;
+}
+
+// A mapping is another handle on the file; views remember their length
+// for munmap.
+static std::mutex                         g_viewsMutex;
+static std::map<const void*, std::size_t> g_views;
+
+HANDLE CreateFileMappingW(HANDLE file, void* /*attrs*/, DWORD protect, DWORD /*sizeHigh*/, DWORD /*sizeLow*/,
+                          LPCWSTR /*name*/)
+{
+    const int fd = ToFd(file);
+    if (fd < 0 || protect != PAGE_READONLY)
+        return nullptr;
+
+    ObjectRef mapping = std::make_shared<WaitObject>(ObjectKind::File);
+    mapping->fd = dup(fd);
+    if (mapping->fd < 0)
+        return nullptr;
+
+    HANDLE handle = NewHandle(mapping);
+    if (!handle)
+        close(mapping->fd);
+    return handle;
+}
+
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, std::size_t bytes)
+{
+    struct stat st;
+    const int fd = ToFd(mapping);
+    if (fd < 0 || access != FILE_MAP_READ || offsetHigh != 0 || offsetLow != 0 || fstat(fd, &st) != 0)
+        return nullptr;
+
+    if (bytes == 0)
+        bytes = static_cast<std::size_t>(st.st_size);
+    if (bytes == 0)
+        return nullptr;
+
+    void* view = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(g_viewsMutex);
+    g_views[view] = bytes;
+    return view;
+}
+
+BOOL UnmapViewOfFile(const void* view)
+{
+    std::size_t bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(g_viewsMutex);
+        auto it = g_views.find(view);
+        if (it == g_views.end())
+            return FALSE;
+        bytes = it->second;
+        g_views.erase(it);
+    }
+    return munmap(const_cast<void*>(view), bytes) == 0;
+}
+
+// ---------------- init once ----------------
+
+static std::mutex g_initOnceMutex;
+
+BOOL InitOnceExecuteOnce(PINIT_ONCE initOnce, PINIT_ONCE_FN fn, PVOID param, LPVOID* context)
+{
+    std::lock_guard<std::mutex> lock(g_initOnceMutex);
+    if (initOnce->Ptr)
+        return TRUE;
+
+    if (!fn(initOnce, param, context))
+        return FALSE;
+
+    initOnce->Ptr = initOnce;
+    return TRUE;
+}
+
+// ---------------- modules / strings / misc ----------------
+
+BOOL GetModuleHandleExW(DWORD /*flags*/, LPCWSTR /*moduleName*/, HMODULE* module)
+{
+    // Everything is linked into the executable.
+    if (module)
+        *module = nullptr;
+    return TRUE;
+}
+
+DWORD GetModuleFileNameW(HMODULE /*module*/, LPWSTR fileName, DWORD size)
+{
+    char path[4096];
+    const ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (len <= 0 || size == 0)
+        return 0;
+    path[len] = '\0';
+
+    const std::size_t n = mbstowcs(fileName, path, size);
+    if (n == static_cast<std::size_t>(-1) || n >= size)
+        return 0;
+    return static_cast<DWORD>(n);
+}
+
+BOOL PathRemoveFileSpecW(LPWSTR path)
+{
+    wchar_t* slash = wcsrchr(path, L'/');
+    if (!slash)
+        return FALSE;
+    *slash = L'\0';
+    return TRUE;
+}
+
+DWORD GetLastError()
+{
+    return static_cast<DWORD>(errno);
+}
+
+int MultiByteToWideChar(UINT /*codePage*/, DWORD /*flags*/, const char* src, int srcLength,
+                        wchar_t* dst, int dstLength)
+{
+    const unsigned char* p   = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = p + srcLength;
+
+    int written = 0;
+    while (p < end)
+    {
+        std::uint32_t cp   = *p++;
+        int           more = 0;
+        if      (cp >= 0xF0) { cp &= 0x07; more = 3; }
+        else if (cp >= 0xE0) { cp &= 0x0F; more = 2; }
+        else if (cp >= 0xC0) { cp &= 0x1F; more = 1; }
+
+        while (more-- > 0 && p < end)
+            cp = (cp << 6) | (*p++ & 0x3F);
+
+        if (dst)
+        {
+            if (written >= dstLength)
+                return 0;
+            dst[written] = static_cast<wchar_t>(cp);
+        }
+        ++written;
+    }
+    return written;
+}
+
+void OutputDebugStringW(LPCWSTR text)
+{
+    if (text)
+        fprintf(stderr, "%ls", text);
+}
+
+int _snwprintf_s(wchar_t* buffer, std::size_t size, std::size_t /*count*/, const wchar_t* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int n = vswprintf(buffer, size, format, args);
+    va_end(args);
+
+    // Truncate like _TRUNCATE instead of leaving the buffer unterminated.
+    if (n < 0 && size > 0)
+        buffer[size - 1] = L'\0';
+    return n;
+}
+
+int _wcsicmp(const wchar_t* a, const wchar_t* b)
+{
+    return wcscasecmp(a, b);
+}
+
+void* _aligned_malloc(std::size_t size, std::size_t alignment)
+{
+    void* p = nullptr;
+    if (alignment < sizeof(void*))
+        alignment = sizeof(void*);
+    return posix_memalign(&p, alignment, size) == 0 ? p : nullptr;
+}
+
+void _aligned_free(void* p)
+{
+    free(p);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Subset of the AIMP SDK's apiCore.h needed by the benchmarked sources.
+
+#include "apiObjects.h"
+
+static const GUID IID_IAIMPServiceConfig = { 0x41494D50, 0x5372, 0x7643, { 0x6F, 0x6E, 0x66, 0x69, 0x67, 0x00, 0x00, 0x00 } };
+
+#define AIMP_CORE_PATH_PROFILE 1
+
+class IAIMPCore : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI GetPath(int PathID, IAIMPString** Value) = 0;
+    virtual HRESULT WINAPI CreateObject(REFIID IID, void** Obj) = 0;
+    virtual HRESULT WINAPI RegisterExtension(REFIID ServiceIID, IUnknown* Extension) = 0;
+    virtual HRESULT WINAPI RegisterService(IUnknown* Service) = 0;
+    virtual HRESULT WINAPI UnregisterExtension(IUnknown* Extension) = 0;
+};
+
+class IAIMPServiceConfig : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI FlushCache() = 0;
+    virtual HRESULT WINAPI Delete(IAIMPString* KeyPath) = 0;
+    virtual HRESULT WINAPI GetValueAsFloat(IAIMPString* KeyPath, double* Value) = 0;
+    virtual HRESULT WINAPI GetValueAsInt32(IAIMPString* KeyPath, int* Value) = 0;
+    virtual HRESULT WINAPI GetValueAsInt64(IAIMPString* KeyPath, INT64* Value) = 0;
+    virtual HRESULT WINAPI GetValueAsStream(IAIMPString* KeyPath, IAIMPStream** Value) = 0;
+    virtual HRESULT WINAPI GetValueAsString(IAIMPString* KeyPath, IAIMPString** Value) = 0;
+};
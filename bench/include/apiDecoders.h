@@ -0,0 +1,36 @@
+#pragma once
+
+// Subset of the AIMP SDK's apiDecoders.h needed by the benchmarked sources.
+
+#include "apiFileManager.h"
+#include "apiObjects.h"
+
+static const GUID IID_IAIMPAudioDecoder           = { 0x41494D50, 0x4175, 0x6469, { 0x6F, 0x44, 0x65, 0x63, 0x00, 0x00, 0x00, 0x00 } };
+static const GUID IID_IAIMPExtensionAudioDecoder = { 0x41494D50, 0x4578, 0x7441, { 0x75, 0x64, 0x69, 0x6F, 0x44, 0x65, 0x63, 0x00 } };
+
+#define AIMP_DECODER_SAMPLEFORMAT_08BIT      1
+#define AIMP_DECODER_SAMPLEFORMAT_16BIT      2
+#define AIMP_DECODER_SAMPLEFORMAT_24BIT      3
+#define AIMP_DECODER_SAMPLEFORMAT_32BIT      4
+#define AIMP_DECODER_SAMPLEFORMAT_32BITFLOAT 5
+
+class IAIMPAudioDecoder : public IUnknown
+{
+public:
+    virtual BOOL  WINAPI GetFileInfo(IAIMPFileInfo* FileInfo) = 0;
+    virtual BOOL  WINAPI GetStreamInfo(int* SampleRate, int* Channels, int* SampleFormat) = 0;
+    virtual BOOL  WINAPI IsSeekable() = 0;
+    virtual BOOL  WINAPI IsRealTimeStream() = 0;
+    virtual INT64 WINAPI GetAvailableData() = 0;
+    virtual INT64 WINAPI GetSize() = 0;
+    virtual INT64 WINAPI GetPosition() = 0;
+    virtual BOOL  WINAPI SetPosition(const INT64 Value) = 0;
+    virtual int   WINAPI Read(void* Buffer, int Count) = 0;
+};
+
+class IAIMPExtensionAudioDecoder : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI CreateDecoder(IAIMPStream* Stream, LongWord Flags,
+                                         IAIMPErrorInfo* ErrorInfo, IAIMPAudioDecoder** Decoder) = 0;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+// Subset of the AIMP SDK's apiFileManager.h needed by the benchmarked sources.
+
+#include "apiObjects.h"
+
+static const GUID IID_IAIMPFileInfo           = { 0x41494D50, 0x4669, 0x6C65, { 0x49, 0x6E, 0x66, 0x6F, 0x00, 0x00, 0x00, 0x00 } };
+static const GUID IID_IAIMPFileStream           = { 0x41494D50, 0x4669, 0x6C65, { 0x53, 0x74, 0x72, 0x65, 0x61, 0x6D, 0x00, 0x00 } };
+static const GUID IID_IAIMPServiceFileStreaming = { 0x41494D50, 0x5372, 0x7646, { 0x69, 0x6C, 0x65, 0x53, 0x74, 0x72, 0x6D, 0x00 } };
+static const GUID IID_IAIMPVirtualFile          = { 0x41494D50, 0x5669, 0x7274, { 0x46, 0x69, 0x6C, 0x65, 0x00, 0x00, 0x00, 0x00 } };
+
+#define AIMP_SERVICE_FILESTREAMING_FLAG_CREATENEW   1
+#define AIMP_SERVICE_FILESTREAMING_FLAG_READ        2
+#define AIMP_SERVICE_FILESTREAMING_FLAG_READWRITE   4
+#define AIMP_SERVICE_FILESTREAMING_FLAG_MAPTOMEMORY 8
+
+enum
+{
+    AIMP_VIRTUALFILE_PROPID_FILEURI = 0,
+    AIMP_VIRTUALFILE_PROPID_AUDIOSOURCEFILE,
+    AIMP_VIRTUALFILE_PROPID_CLIPSTART,
+    AIMP_VIRTUALFILE_PROPID_CLIPFINISH,
+    AIMP_VIRTUALFILE_PROPID_INDEXINCUESHEET,
+    AIMP_VIRTUALFILE_PROPID_FILEFORMAT
+};
+
+enum
+{
+    AIMP_FILEINFO_PROPID_CUSTOM = 0,
+    AIMP_FILEINFO_PROPID_ALBUM,
+    AIMP_FILEINFO_PROPID_ALBUMART,
+    AIMP_FILEINFO_PROPID_ALBUMARTIST,
+    AIMP_FILEINFO_PROPID_ALBUMGAIN,
+    AIMP_FILEINFO_PROPID_ALBUMPEAK,
+    AIMP_FILEINFO_PROPID_ARTIST,
+    AIMP_FILEINFO_PROPID_BITRATE,
+    AIMP_FILEINFO_PROPID_BPM,
+    AIMP_FILEINFO_PROPID_CHANNELS,
+    AIMP_FILEINFO_PROPID_COMMENT,
+    AIMP_FILEINFO_PROPID_COMPOSER,
+    AIMP_FILEINFO_PROPID_COPYRIGHT,
+    AIMP_FILEINFO_PROPID_CUESHEET,
+    AIMP_FILEINFO_PROPID_DATE,
+    AIMP_FILEINFO_PROPID_DISKNUMBER,
+    AIMP_FILEINFO_PROPID_DISKTOTAL,
+    AIMP_FILEINFO_PROPID_DURATION,
+    AIMP_FILEINFO_PROPID_FILENAME,
+    AIMP_FILEINFO_PROPID_FILESIZE,
+    AIMP_FILEINFO_PROPID_GENRE,
+    AIMP_FILEINFO_PROPID_LYRICS,
+    AIMP_FILEINFO_PROPID_MARK,
+    AIMP_FILEINFO_PROPID_PUBLISHER,
+    AIMP_FILEINFO_PROPID_SAMPLERATE,
+    AIMP_FILEINFO_PROPID_TITLE,
+    AIMP_FILEINFO_PROPID_TRACKGAIN,
+    AIMP_FILEINFO_PROPID_TRACKNUMBER,
+    AIMP_FILEINFO_PROPID_TRACKPEAK,
+    AIMP_FILEINFO_PROPID_TRACKTOTAL,
+    AIMP_FILEINFO_PROPID_URL
+};
+
+class IAIMPFileInfo : public IAIMPPropertyList
+{
+public:
+    virtual HRESULT WINAPI Assign(IAIMPFileInfo* Source) = 0;
+    virtual HRESULT WINAPI Clone(IAIMPFileInfo** Info) = 0;
+};
+
+class IAIMPFileStream : public IAIMPStream
+{
+public:
+    virtual HRESULT WINAPI GetClipping(INT64* Offset, INT64* Size) = 0;
+    virtual HRESULT WINAPI GetFileName(IAIMPString** S) = 0;
+};
+
+class IAIMPVirtualFile : public IAIMPPropertyList
+{
+public:
+    virtual HRESULT WINAPI CreateStream(IAIMPStream** Stream) = 0;
+    virtual HRESULT WINAPI GetFileInfo(IAIMPFileInfo* Info) = 0;
+    virtual BOOL    WINAPI IsExists() = 0;
+    virtual HRESULT WINAPI IsInSameStream(IAIMPVirtualFile* VirtualFile) = 0;
+    virtual HRESULT WINAPI Synchronize() = 0;
+};
+
+class IAIMPServiceFileStreaming : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI CreateStreamForFile(IAIMPString* FileName, DWORD Flags,
+                                               const INT64 Offset, const INT64 Size,
+                                               IAIMPStream** Stream) = 0;
+    virtual HRESULT WINAPI CreateStreamForFileURI(IAIMPString* FileURI, IAIMPVirtualFile** VirtualFile,
+                                                  IAIMPStream** Stream) = 0;
+};
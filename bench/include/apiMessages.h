@@ -0,0 +1,24 @@
+#pragma once
+
+// Subset of the AIMP SDK's apiMessages.h needed by the benchmarked sources.
+
+#include "apiObjects.h"
+
+static const GUID IID_IAIMPServiceMessageDispatcher = { 0x41494D50, 0x5372, 0x764D, { 0x73, 0x67, 0x44, 0x73, 0x70, 0x00, 0x00, 0x00 } };
+
+#define AIMP_MSG_EVENT_STREAM_START 0x40
+
+class IAIMPMessageHook : public IUnknown
+{
+public:
+    virtual void WINAPI CoreMessage(DWORD AMessage, int AParam1, void* AParam2, HRESULT* AResult) = 0;
+};
+
+class IAIMPServiceMessageDispatcher : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI Send(DWORD Message, int Param1, void* Param2) = 0;
+    virtual DWORD   WINAPI Register(WCHAR* Key) = 0;
+    virtual HRESULT WINAPI Hook(IAIMPMessageHook* Hook) = 0;
+    virtual HRESULT WINAPI Unhook(IAIMPMessageHook* Hook) = 0;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+// Subset of the AIMP SDK's apiObjects.h needed by the benchmarked sources.
+// Interface layouts follow the SDK; only the bench's mocks implement them.
+
+#include <windows.h>
+
+typedef DWORD LongWord;
+
+static const GUID IID_IAIMPErrorInfo    = { 0x41494D50, 0x4572, 0x7249, { 0x6E, 0x66, 0x6F, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+static const GUID IID_IAIMPPropertyList = { 0x41494D50, 0x5072, 0x704C, { 0x69, 0x73, 0x74, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+static const GUID IID_IAIMPString       = { 0x41494D50, 0x5374, 0x7269, { 0x6E, 0x67, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+static const GUID IID_IAIMPStream       = { 0x41494D50, 0x5374, 0x7265, { 0x61, 0x6D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+
+#define AIMP_STREAM_SEEKMODE_FROM_BEGINNING 0
+#define AIMP_STREAM_SEEKMODE_FROM_CURRENT   1
+#define AIMP_STREAM_SEEKMODE_FROM_END       2
+
+class IAIMPString : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI GetChar(int Index, WCHAR* Char) = 0;
+    virtual WCHAR*  WINAPI GetData() = 0;
+    virtual int     WINAPI GetLength() = 0;
+    virtual int     WINAPI GetHashCode() = 0;
+    virtual HRESULT WINAPI SetChar(int Index, WCHAR Char) = 0;
+    virtual HRESULT WINAPI SetData(WCHAR* Chars, int CharsCount) = 0;
+};
+
+class IAIMPStream : public IUnknown
+{
+public:
+    virtual INT64   WINAPI GetSize() = 0;
+    virtual HRESULT WINAPI SetSize(const INT64 Value) = 0;
+    virtual INT64   WINAPI GetPosition() = 0;
+    virtual HRESULT WINAPI Seek(const INT64 Offset, int Mode) = 0;
+    virtual int     WINAPI Read(unsigned char* Buffer, unsigned int Count) = 0;
+    virtual HRESULT WINAPI Write(unsigned char* Buffer, unsigned int Count, unsigned int* Written) = 0;
+};
+
+class IAIMPErrorInfo : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI GetInfo(int* ErrorCode, IAIMPString** Message, IAIMPString** Details) = 0;
+    virtual HRESULT WINAPI GetInfoFormatted(IAIMPString** S) = 0;
+    virtual void    WINAPI SetInfo(int ErrorCode, IAIMPString* Message, IAIMPString* Details) = 0;
+};
+
+class IAIMPPropertyList : public IUnknown
+{
+public:
+    virtual void    WINAPI BeginUpdate() = 0;
+    virtual void    WINAPI EndUpdate() = 0;
+    virtual HRESULT WINAPI Reset() = 0;
+    virtual HRESULT WINAPI GetValueAsFloat(int PropertyID, double* Value) = 0;
+    virtual HRESULT WINAPI GetValueAsInt32(int PropertyID, int* Value) = 0;
+    virtual HRESULT WINAPI GetValueAsInt64(int PropertyID, INT64* Value) = 0;
+    virtual HRESULT WINAPI GetValueAsObject(int PropertyID, REFIID IID, void** Value) = 0;
+    virtual HRESULT WINAPI SetValueAsFloat(int PropertyID, const double Value) = 0;
+    virtual HRESULT WINAPI SetValueAsInt32(int PropertyID, int Value) = 0;
+    virtual HRESULT WINAPI SetValueAsInt64(int PropertyID, const INT64 Value) = 0;
+    virtual HRESULT WINAPI SetValueAsObject(int PropertyID, IUnknown* Value) = 0;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+// Subset of the AIMP SDK's apiPlayer.h needed by the benchmarked sources.
+
+#include "apiObjects.h"
+
+static const GUID IID_IAIMPServicePlaybackQueue = { 0x41494D50, 0x5372, 0x7650, { 0x6C, 0x62, 0x61, 0x63, 0x6B, 0x51, 0x75, 0x65 } };
+
+enum
+{
+    AIMP_PLAYBACKQUEUEITEM_PROPID_CUSTOM = 0,
+    AIMP_PLAYBACKQUEUEITEM_PROPID_PLAYLISTITEM,
+    AIMP_PLAYBACKQUEUEITEM_PROPID_OFFSET
+};
+
+class IAIMPPlaybackQueueItem : public IAIMPPropertyList
+{
+};
+
+class IAIMPServicePlaybackQueue : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI GetNextTrack(IAIMPPlaybackQueueItem** Item) = 0;
+    virtual HRESULT WINAPI GetPrevTrack(IAIMPPlaybackQueueItem** Item) = 0;
+};
@@ -0,0 +1,21 @@
+#pragma once
+
+// Subset of the AIMP SDK's apiPlaylists.h needed by the benchmarked sources.
+
+#include "apiObjects.h"
+
+static const GUID IID_IAIMPPlaylistItem = { 0x41494D50, 0x506C, 0x7349, { 0x74, 0x65, 0x6D, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+
+enum
+{
+    AIMP_PLAYLISTITEM_PROPID_CUSTOM = 0,
+    AIMP_PLAYLISTITEM_PROPID_DISPLAYTEXT,
+    AIMP_PLAYLISTITEM_PROPID_FILEINFO,
+    AIMP_PLAYLISTITEM_PROPID_FILENAME
+};
+
+class IAIMPPlaylistItem : public IAIMPPropertyList
+{
+public:
+    virtual HRESULT WINAPI ReloadInfo() = 0;
+};
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <windows.h>
+
+BOOL PathRemoveFileSpecW(LPWSTR path);
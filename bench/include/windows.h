@@ -0,0 +1,327 @@
+#pragma once
+
+// POSIX stand-in for the slice of the Win32 API used by the decoder core,
+// so the benchmark can build the real sources on Linux. Only the calls the
+// benchmarked sources make are provided; semantics follow Win32 where the
+// decoder depends on them (SRW try-lock, manual/auto-reset events,
+// semaphores, thread handles that become signaled on exit).
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <time.h>
+
+#define WINAPI
+#define CALLBACK
+
+typedef std::int32_t   HRESULT;
+typedef int            BOOL;
+typedef unsigned char  BOOLEAN;
+typedef std::int32_t   LONG;
+typedef std::uint32_t  ULONG;
+typedef std::uint32_t  DWORD;
+typedef std::uint32_t  UINT;
+typedef unsigned char  BYTE;
+typedef std::uint16_t  WORD;
+typedef std::int64_t   INT64;
+typedef std::uint64_t  UINT64;
+typedef std::int64_t   LONGLONG;
+typedef std::uint64_t  ULONGLONG;
+typedef wchar_t        WCHAR;
+typedef const wchar_t* LPCWSTR;
+typedef wchar_t*       LPWSTR;
+typedef const char*    LPCSTR;
+typedef void*          HANDLE;
+typedef void*          HMODULE;
+typedef void*          LPVOID;
+typedef void*          PVOID;
+typedef std::size_t    SIZE_T;
+typedef std::uintptr_t ULONG_PTR;
+typedef std::intptr_t  LONG_PTR;
+
+typedef DWORD (WINAPI *LPTHREAD_START_ROUTINE)(LPVOID);
+
+#define TRUE  1
+#define FALSE 0
+
+#define S_OK          ((HRESULT)0)
+#define S_FALSE       ((HRESULT)1)
+#define E_NOTIMPL     ((HRESULT)0x80004001u)
+#define E_NOINTERFACE ((HRESULT)0x80004002u)
+#define E_POINTER     ((HRESULT)0x80004003u)
+#define E_FAIL        ((HRESULT)0x80004005u)
+#define E_UNEXPECTED  ((HRESULT)0x8000FFFFu)
+#define E_INVALIDARG  ((HRESULT)0x80070057u)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000Eu)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr)    (((HRESULT)(hr)) < 0)
+
+#define MAX_PATH      260
+#define INFINITE      0xFFFFFFFFu
+#define WAIT_OBJECT_0 0u
+#define WAIT_TIMEOUT  258u
+#define WAIT_FAILED   0xFFFFFFFFu
+#define CP_UTF8       65001
+#define _TRUNCATE     ((std::size_t)-1)
+#define _countof(a)   (sizeof(a) / sizeof((a)[0]))
+
+#define INVALID_HANDLE_VALUE ((HANDLE)(LONG_PTR)-1)
+
+#define GET_MODULE_HANDLE_EX_FLAG_PIN                0x1
+#define GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT 0x2
+#define GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS       0x4
+
+#define WT_EXECUTEDEFAULT      0x00
+#define WT_EXECUTEONLYONCE     0x08
+#define WT_EXECUTELONGFUNCTION 0x10
+
+#define THREAD_MODE_BACKGROUND_BEGIN 0x00010000
+#define THREAD_MODE_BACKGROUND_END   0x00020000
+
+#define GENERIC_READ              0x80000000u
+#define GENERIC_WRITE             0x40000000u
+#define FILE_SHARE_READ           0x1
+#define CREATE_ALWAYS             2
+#define OPEN_EXISTING             3
+#define FILE_ATTRIBUTE_DIRECTORY  0x10
+#define FILE_ATTRIBUTE_NORMAL     0x80
+#define FILE_FLAG_SEQUENTIAL_SCAN 0x08000000
+#define INVALID_FILE_ATTRIBUTES   ((DWORD)-1)
+#define MOVEFILE_REPLACE_EXISTING 0x1
+#define PAGE_READONLY             0x02
+#define FILE_MAP_READ             0x0004
+
+// ---------------- COM basics ----------------
+
+struct GUID
+{
+    std::uint32_t Data1;
+    std::uint16_t Data2;
+    std::uint16_t Data3;
+    std::uint8_t  Data4[8];
+};
+
+typedef GUID        IID;
+typedef const GUID& REFIID;
+typedef const GUID& REFGUID;
+
+inline bool operator==(const GUID& a, const GUID& b) { return memcmp(&a, &b, sizeof(GUID)) == 0; }
+inline bool operator!=(const GUID& a, const GUID& b) { return !(a == b); }
+
+static const GUID IID_IUnknown = { 0x00000000, 0x0000, 0x0000, { 0xC0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x46 } };
+
+struct IUnknown
+{
+    virtual HRESULT WINAPI QueryInterface(REFIID riid, void** ppv) = 0;
+    virtual ULONG   WINAPI AddRef()  = 0;
+    virtual ULONG   WINAPI Release() = 0;
+};
+
+// ---------------- interlocked ----------------
+
+inline LONG InterlockedIncrement(LONG volatile* v) { return __atomic_add_fetch(v, 1, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedDecrement(LONG volatile* v) { return __atomic_sub_fetch(v, 1, __ATOMIC_SEQ_CST); }
+inline LONG InterlockedExchange(LONG volatile* v, LONG x) { return __atomic_exchange_n(v, x, __ATOMIC_SEQ_CST); }
+
+inline LONG InterlockedCompareExchange(LONG volatile* v, LONG x, LONG cmp)
+{
+    __atomic_compare_exchange_n(v, &cmp, x, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return cmp;
+}
+
+// ---------------- SRW locks / init once ----------------
+
+struct SRWLOCK
+{
+    pthread_rwlock_t lock;
+};
+
+#define SRWLOCK_INIT { PTHREAD_RWLOCK_INITIALIZER }
+
+inline void    InitializeSRWLock(SRWLOCK* l)          { pthread_rwlock_init(&l->lock, nullptr); }
+inline void    AcquireSRWLockExclusive(SRWLOCK* l)    { pthread_rwlock_wrlock(&l->lock); }
+inline void    ReleaseSRWLockExclusive(SRWLOCK* l)    { pthread_rwlock_unlock(&l->lock); }
+inline BOOLEAN TryAcquireSRWLockExclusive(SRWLOCK* l) { return pthread_rwlock_trywrlock(&l->lock) == 0; }
+inline void    AcquireSRWLockShared(SRWLOCK* l)       { pthread_rwlock_rdlock(&l->lock); }
+inline BOOLEAN TryAcquireSRWLockShared(SRWLOCK* l)    { return pthread_rwlock_tryrdlock(&l->lock) == 0; }
+inline void    ReleaseSRWLockShared(SRWLOCK* l)       { pthread_rwlock_unlock(&l->lock); }
+
+union INIT_ONCE
+{
+    void* Ptr;
+};
+typedef INIT_ONCE* PINIT_ONCE;
+
+#define INIT_ONCE_STATIC_INIT { nullptr }
+
+typedef BOOL (WINAPI *PINIT_ONCE_FN)(PINIT_ONCE, PVOID, PVOID*);
+
+BOOL InitOnceExecuteOnce(PINIT_ONCE initOnce, PINIT_ONCE_FN fn, PVOID param, LPVOID* context);
+
+// ---------------- time ----------------
+
+union LARGE_INTEGER
+{
+    struct
+    {
+        DWORD LowPart;
+        LONG  HighPart;
+    };
+    LONGLONG QuadPart;
+};
+
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* f)
+{
+    f->QuadPart = 1000000000LL;
+    return TRUE;
+}
+
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* c)
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    c->QuadPart = static_cast<LONGLONG>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    return TRUE;
+}
+
+inline ULONGLONG GetTickCount64()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<ULONGLONG>(ts.tv_sec) * 1000u + ts.tv_nsec / 1000000;
+}
+
+void Sleep(DWORD ms);
+
+// ---------------- kernel objects ----------------
+//
+// Events, semaphores and threads share one waitable handle type; a thread
+// handle is signaled once its procedure returns. TerminateThread cannot be
+// emulated and fails; closing a running thread's handle detaches it.
+
+HANDLE CreateEventW(void* attrs, BOOL manualReset, BOOL initialState, LPCWSTR name);
+inline HANDLE CreateEvent(void* attrs, BOOL manualReset, BOOL initialState, LPCWSTR name)
+{
+    return CreateEventW(attrs, manualReset, initialState, name);
+}
+BOOL   SetEvent(HANDLE event);
+BOOL   ResetEvent(HANDLE event);
+HANDLE CreateSemaphoreW(void* attrs, LONG initialCount, LONG maximumCount, LPCWSTR name);
+BOOL   ReleaseSemaphore(HANDLE semaphore, LONG releaseCount, LONG* previousCount);
+HANDLE CreateThread(void* attrs, SIZE_T stackSize, LPTHREAD_START_ROUTINE proc, LPVOID param,
+                    DWORD flags, DWORD* threadId);
+BOOL   TerminateThread(HANDLE thread, DWORD exitCode);
+BOOL   CloseHandle(HANDLE handle);
+DWORD  WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+DWORD  WaitForMultipleObjects(DWORD count, const HANDLE* handles, BOOL waitAll, DWORD milliseconds);
+BOOL   QueueUserWorkItem(LPTHREAD_START_ROUTINE proc, PVOID context, ULONG flags);
+
+// Thread-pool waits run on a thread of their own that polls the object, and
+// only INFINITE waits are supported. The wait handle is not a kernel object:
+// release it with UnregisterWaitEx, which always waits for a running callback.
+typedef void (CALLBACK *WAITORTIMERCALLBACK)(PVOID context, BOOLEAN timedOut);
+BOOL   RegisterWaitForSingleObject(HANDLE* newWait, HANDLE object, WAITORTIMERCALLBACK callback,
+                                   PVOID context, DWORD milliseconds, ULONG flags);
+BOOL   UnregisterWaitEx(HANDLE waitHandle, HANDLE completionEvent);
+
+// Priorities are accepted and ignored; the pseudo handle only identifies
+// the calling thread to SetThreadPriority.
+HANDLE GetCurrentThread();
+DWORD  GetCurrentThreadId();
+DWORD  GetCurrentProcessId();
+BOOL   SetThreadPriority(HANDLE thread, int priority);
+
+// The handle count covers the objects created through this shim: events,
+// semaphores, threads and files not yet closed.
+HANDLE GetCurrentProcess();
+BOOL   GetProcessHandleCount(HANDLE process, DWORD* count);
+
+enum MEMORY_RESOURCE_NOTIFICATION_TYPE
+{
+    LowMemoryResourceNotification,
+    HighMemoryResourceNotification
+};
+
+// Unsupported: returns null, which the memory budget treats as "no watcher".
+HANDLE CreateMemoryResourceNotification(MEMORY_RESOURCE_NOTIFICATION_TYPE type);
+BOOL   QueryMemoryResourceNotification(HANDLE handle, BOOL* state);
+
+// ---------------- files ----------------
+//
+// Paths are converted to UTF-8 and used as-is, so only '/'-separated paths
+// name real locations. File handles share CloseHandle with the objects above.
+
+struct FILETIME
+{
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+};
+
+struct WIN32_FILE_ATTRIBUTE_DATA
+{
+    DWORD    dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD    nFileSizeHigh;
+    DWORD    nFileSizeLow;
+};
+
+enum GET_FILEEX_INFO_LEVELS
+{
+    GetFileExInfoStandard
+};
+
+HANDLE CreateFileW(LPCWSTR path, DWORD access, DWORD shareMode, void* attrs, DWORD disposition,
+                   DWORD flags, HANDLE templateFile);
+BOOL   ReadFile(HANDLE file, LPVOID buffer, DWORD bytes, DWORD* read, void* overlapped);
+BOOL   WriteFile(HANDLE file, const void* buffer, DWORD bytes, DWORD* written, void* overlapped);
+DWORD  GetFileAttributesW(LPCWSTR path);
+BOOL   GetFileAttributesExW(LPCWSTR path, GET_FILEEX_INFO_LEVELS level, LPVOID info);
+BOOL   CreateDirectoryW(LPCWSTR path, void* attrs);
+BOOL   DeleteFileW(LPCWSTR path);
+BOOL   MoveFileExW(LPCWSTR from, LPCWSTR to, DWORD flags);
+BOOL   GetFileSizeEx(HANDLE file, LARGE_INTEGER* size);
+
+// Read-only mappings of a whole file (PAGE_READONLY / FILE_MAP_READ, offset 0).
+HANDLE CreateFileMappingW(HANDLE file, void* attrs, DWORD protect, DWORD sizeHigh, DWORD sizeLow,
+                          LPCWSTR name);
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offsetHigh, DWORD offsetLow, std::size_t bytes);
+BOOL   UnmapViewOfFile(const void* view);
+
+// ---------------- modules / strings / misc ----------------
+
+BOOL  GetModuleHandleExW(DWORD flags, LPCWSTR moduleName, HMODULE* module);
+DWORD GetModuleFileNameW(HMODULE module, LPWSTR fileName, DWORD size);
+DWORD GetLastError();
+
+// UTF-8 only (the sole code page the decoder passes).
+int MultiByteToWideChar(UINT codePage, DWORD flags, const char* src, int srcLength,
+                        wchar_t* dst, int dstLength);
+
+// Debug output goes to stderr, keeping stdout free for the JSON report.
+void OutputDebugStringW(LPCWSTR text);
+
+int _snwprintf_s(wchar_t* buffer, std::size_t size, std::size_t count, const wchar_t* format, ...);
+int _wcsicmp(const wchar_t* a, const wchar_t* b);
+
+// CRT aligned heap; the audit build's aligned operator new uses it.
+void* _aligned_malloc(std::size_t size, std::size_t alignment);
+void  _aligned_free(void* p);
+
+// Array form only, with _TRUNCATE semantics for any count.
+template <std::size_t N>
+inline int wcsncpy_s(wchar_t (&dst)[N], const wchar_t* src, std::size_t count)
+{
+    std::size_t n = wcslen(src);
+    if (n > count)
+        n = count;
+    if (n > N - 1)
+        n = N - 1;
+    wmemcpy(dst, src, n);
+    dst[n] = L'\0';
+    return 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// Declarations of the REX Shared Library API as used by the decoder, for the
+// benchmark's deterministic stand-in (bench/Rx2BenchRex.cpp). Names, error
+// values and struct layouts follow the Reason REX SDK; nothing here talks
+// to the real library. Kept apart from the Win32 and AIMP shims in
+// include/ so the standalone core (rx2_core) builds without them.
+
+#define REXCALL
+
+namespace REX {
+
+typedef int REX_int32_t;
+
+enum REXError
+{
+    kREXError_NoError                 = 1,
+    kREXError_OperationAbortedByUser  = 2,
+    kREXError_NoCreatorInfoAvailable  = 3,
+
+    kREXError_NotEnoughMemoryForDLL   = 100,
+    kREXError_UnableToLoadDLL         = 101,
+    kREXError_DLLTooOld               = 102,
+    kREXError_DLLNotFound             = 103,
+    kREXError_APITooOld               = 104,
+    kREXError_OutOfMemory             = 105,
+    kREXError_FileCorrupt             = 106,
+    kREXError_REX2FileTooNew          = 107,
+    kREXError_FileHasZeroLoopLength   = 108,
+    kREXError_OSVersionNotSupported   = 109,
+
+    kREXImplError_DLLNotInitialized    = 200,
+    kREXImplError_DLLAlreadyInitialized = 201,
+    kREXImplError_InvalidHandle        = 202,
+    kREXImplError_InvalidSize          = 203,
+    kREXImplError_InvalidArgument      = 204,
+    kREXImplError_InvalidSlice         = 205,
+    kREXImplError_InvalidSampleRate    = 206,
+    kREXImplError_BufferTooSmall       = 207,
+    kREXImplError_IsBeingPreviewed     = 208,
+    kREXImplError_NotBeingPreviewed    = 209,
+    kREXImplError_InvalidTempo         = 210,
+
+    kREXError_Undefined                = 666
+};
+
+struct REXOpaqueHandle;
+typedef REXOpaqueHandle* REXHandle;
+
+struct REXInfo
+{
+    REX_int32_t fChannels;
+    REX_int32_t fSampleRate;
+    REX_int32_t fSliceCount;
+    REX_int32_t fTempo;            // 1/1000 BPM
+    REX_int32_t fOriginalTempo;
+    REX_int32_t fPPQLength;        // 15360 per quarter note
+    REX_int32_t fTimeSignNom;
+    REX_int32_t fTimeSignDenom;
+    REX_int32_t fBitDepth;
+};
+
+struct REXSliceInfo
+{
+    REX_int32_t fPPQPos;
+    REX_int32_t fSampleLength;
+};
+
+struct REXCreatorInfo
+{
+    char fName[256];
+    char fCopyright[256];
+    char fURL[256];
+    char fEmail[256];
+    char fFreeText[256];
+};
+
+enum REXCallbackResult
+{
+    kREXCallback_Abort    = 1,
+    kREXCallback_Continue = 2
+};
+
+typedef REXCallbackResult (REXCALL *REXCreateCallback)(REX_int32_t percentFinished, void* userData);
+
+REXError REXInitializeDLL_DirPath(const wchar_t* dirPath);
+void     REXUninitializeDLL();
+
+REXError REXCreate(REXHandle* handle, const char buffer[], REX_int32_t size,
+                   REXCreateCallback callback, void* userData);
+void     REXDelete(REXHandle* handle);
+
+REXError REXGetInfo(REXHandle handle, REX_int32_t infoSize, REXInfo* info);
+REXError REXGetInfoFromBuffer(REX_int32_t bufferSize, const char buffer[],
+                              REX_int32_t infoSize, REXInfo* info);
+REXError REXGetCreatorInfo(REXHandle handle, REX_int32_t creatorInfoSize, REXCreatorInfo* info);
+REXError REXGetSliceInfo(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t sliceInfoSize,
+                         REXSliceInfo* info);
+
+REXError REXSetOutputSampleRate(REXHandle handle, REX_int32_t outputSampleRate);
+REXError REXRenderSlice(REXHandle handle, REX_int32_t sliceIndex, REX_int32_t bufferFrameLength,
+                        float* outputBuffers[2]);
+
+REXError REXStartPreview(REXHandle handle);
+REXError REXStopPreview(REXHandle handle);
+REXError REXRenderPreviewBatch(REXHandle handle, REX_int32_t framesToRender, float* outputBuffers[2]);
+REXError REXSetPreviewTempo(REXHandle handle, REX_int32_t tempo);
+
+} // namespace REX
@@ -0,0 +1,259 @@
+#include "Rx2AnalysisCache.h"
+#include "Rx2Contention.h"
+#include "Rx2Loudness.h"
+#include "Rx2Metrics.h"
+#include "Rx2PeakIndex.h"
+#include "Rx2Settings.h"
+
+#include <cstring>
+#include <cwctype>
+#include <string>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+struct AnalysisHeader
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::int64_t  size;
+    std::uint64_t mtime;
+    std::uint32_t headerHash;
+    std::uint32_t reserved;
+    std::uint64_t payloadBytes;
+};
+
+static const std::uint32_t kAnalysisMagic   = 0x41325852u;   // "RX2A"
+static const std::uint32_t kAnalysisVersion = 1;
+
+static SRWLOCK      g_lock = SRWLOCK_INIT;
+static std::wstring g_dir;                  // empty = cache disabled
+
+// ---------------- helpers ----------------
+
+static bool CreateDirectoryChain(const std::wstring& dir)
+{
+    for (size_t pos = dir.find(L'\\', 3); pos != std::wstring::npos; pos = dir.find(L'\\', pos + 1))
+        CreateDirectoryW(dir.substr(0, pos).c_str(), nullptr);
+
+    const DWORD attr = GetFileAttributesW(dir.c_str());
+    return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// <dir><16 hex digits of FNV-1a 64 over the lower-cased path>.<kind>
+static std::wstring RecordPath(const std::wstring& dir, const Rx2FileKey& key, const wchar_t* kind)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (wchar_t ch : key.path)
+    {
+        const std::uint32_t c = static_cast<std::uint32_t>(towlower(ch));
+        hash ^= c & 0xFF;
+        hash *= 1099511628211ull;
+        hash ^= c >> 8;
+        hash *= 1099511628211ull;
+    }
+
+    wchar_t name[40];
+    _snwprintf_s(name, _countof(name), _TRUNCATE, L"%016llx.", static_cast<unsigned long long>(hash));
+    return dir + name + kind;
+}
+
+static std::wstring CacheDirectory()
+{
+    Rx2LockShared(&g_lock, Rx2SyncSite::AnalysisCache);
+    std::wstring dir = g_dir;
+    ReleaseSRWLockShared(&g_lock);
+    return dir;
+}
+
+// ---------------- public API ----------------
+
+void Rx2AnalysisCacheStart(IAIMPCore* core)
+{
+    if (!core || !Rx2GetSettings().analysisCache)
+        return;
+
+    std::wstring dir = Rx2ProfileDir(core);
+    if (dir.empty())
+        return;
+    dir.append(L"Analysis\\");
+
+    if (!CreateDirectoryChain(dir))
+        return;
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::AnalysisCache);
+    g_dir = dir;
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+void Rx2AnalysisCacheStop()
+{
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::AnalysisCache);
+    g_dir.clear();
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+// Opens the record and reads its header; returns the handle positioned at
+// the payload, or INVALID_HANDLE_VALUE when there is no current record for
+// this exact file.
+static HANDLE OpenRecord(const std::wstring& dir, const Rx2FileKey& key, const wchar_t* kind,
+                         DWORD flags, AnalysisHeader* header)
+{
+    HANDLE file = CreateFileW(RecordPath(dir, key, kind).c_str(),
+                              GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return file;
+
+    DWORD got = 0;
+    if (ReadFile(file, header, sizeof(*header), &got, nullptr) && got == sizeof(*header)
+        && header->magic == kAnalysisMagic && header->version == kAnalysisVersion
+        && header->size == key.size && header->mtime == key.mtime
+        && header->headerHash == key.headerHash
+        && header->payloadBytes <= 256u * 1024 * 1024)
+        return file;
+
+    CloseHandle(file);
+    return INVALID_HANDLE_VALUE;
+}
+
+bool Rx2AnalysisCacheHas(const Rx2FileKey& key, const wchar_t* kind)
+{
+    const std::wstring dir = CacheDirectory();
+    if (dir.empty())
+        return false;
+
+    AnalysisHeader header{};
+    HANDLE file = OpenRecord(dir, key, kind, FILE_ATTRIBUTE_NORMAL, &header);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    CloseHandle(file);
+    return true;
+}
+
+bool Rx2AnalysisCacheRead(const Rx2FileKey& key, const wchar_t* kind,
+                          std::vector<std::uint8_t>& data)
+{
+    const std::wstring dir = CacheDirectory();
+    if (dir.empty())
+        return false;
+
+    AnalysisHeader header{};
+    HANDLE file = OpenRecord(dir, key, kind, FILE_FLAG_SEQUENTIAL_SCAN, &header);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool  ok  = false;
+    DWORD got = 0;
+    try
+    {
+        data.resize(static_cast<size_t>(header.payloadBytes));
+        ok = data.empty()
+          || (ReadFile(file, data.data(), static_cast<DWORD>(data.size()), &got, nullptr)
+              && got == data.size());
+    }
+    catch (...)
+    {
+        ok = false;
+    }
+
+    CloseHandle(file);
+    if (!ok)
+        data.clear();
+    return ok;
+}
+
+bool Rx2AnalysisCacheWrite(const Rx2FileKey& key, const wchar_t* kind,
+                           const std::vector<std::uint8_t>& data)
+{
+    const std::wstring dir = CacheDirectory();
+    if (dir.empty())
+        return false;
+
+    const std::wstring path = RecordPath(dir, key, kind);
+
+    // Write beside the record and rename, so readers never see a torn file.
+    wchar_t suffix[24];
+    _snwprintf_s(suffix, _countof(suffix), _TRUNCATE, L".%lu.tmp", GetCurrentThreadId());
+    const std::wstring temp = path + suffix;
+
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    AnalysisHeader header{};
+    header.magic        = kAnalysisMagic;
+    header.version      = kAnalysisVersion;
+    header.size         = key.size;
+    header.mtime        = key.mtime;
+    header.headerHash   = key.headerHash;
+    header.payloadBytes = data.size();
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, &header, sizeof(header), &written, nullptr) && written == sizeof(header);
+    if (ok && !data.empty())
+        ok = WriteFile(file, data.data(), static_cast<DWORD>(data.size()), &written, nullptr)
+          && written == data.size();
+
+    CloseHandle(file);
+
+    if (ok)
+        ok = MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+    if (!ok)
+        DeleteFileW(temp.c_str());
+    return ok;
+}
+
+// Hit/miss counts for lookups made while the on-disk cache is enabled.
+static bool CountLookup(bool hit)
+{
+    if (!CacheDirectory().empty())
+        Rx2MetricAdd(hit ? Rx2Counter::AnalysisCacheHits : Rx2Counter::AnalysisCacheMisses);
+    return hit;
+}
+
+bool Rx2LoadCachedPeaks(const Rx2FileKey& key, Rx2PeakIndex* peaks)
+{
+    std::vector<std::uint8_t> data;
+    return CountLookup(peaks
+        && Rx2AnalysisCacheRead(key, L"peaks", data)
+        && peaks->Deserialize(data.data(), data.size()));
+}
+
+void Rx2StoreCachedPeaks(const Rx2FileKey& key, const Rx2PeakIndex& peaks)
+{
+    if (CacheDirectory().empty())
+        return;
+
+    // Already cached for this exact file: nothing to do. Only the header
+    // is read, so reopening a cached file costs one small read.
+    if (Rx2AnalysisCacheHas(key, L"peaks"))
+        return;
+
+    std::vector<std::uint8_t> data;
+    if (peaks.Serialize(data))
+        Rx2AnalysisCacheWrite(key, L"peaks", data);
+}
+
+bool Rx2LoadCachedLoudness(const Rx2FileKey& key, Rx2Loudness* loudness)
+{
+    std::vector<std::uint8_t> data;
+    return CountLookup(loudness
+        && Rx2AnalysisCacheRead(key, L"loudness", data)
+        && loudness->Deserialize(data.data(), data.size()));
+}
+
+void Rx2StoreCachedLoudness(const Rx2FileKey& key, const Rx2Loudness& loudness)
+{
+    if (CacheDirectory().empty())
+        return;
+
+    if (Rx2AnalysisCacheHas(key, L"loudness"))
+        return;
+
+    std::vector<std::uint8_t> data;
+    if (loudness.Serialize(data))
+        Rx2AnalysisCacheWrite(key, L"loudness", data);
+}
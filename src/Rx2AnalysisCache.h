@@ -0,0 +1,32 @@
+#pragma once
+
+#include "apiCore.h"
+#include "Rx2FileKey.h"
+
+#include <cstdint>
+#include <vector>
+
+class Rx2Loudness;
+class Rx2PeakIndex;
+
+// Optional on-disk cache for per-file analysis results (waveform peaks,
+// loudness), kept under <AIMP profile>\RX2Decoder\Analysis. Each record is one
+// file named after a hash of the path; its header repeats the file key so
+// a record for an edited file is treated as missing. Disabled unless
+// RX2Decoder\AnalysisCache is set.
+void Rx2AnalysisCacheStart(IAIMPCore* core);
+void Rx2AnalysisCacheStop();
+
+// True when a record of `kind` exists for this exact file; reads only its
+// header.
+bool Rx2AnalysisCacheHas(const Rx2FileKey& key, const wchar_t* kind);
+bool Rx2AnalysisCacheRead(const Rx2FileKey& key, const wchar_t* kind,
+                          std::vector<std::uint8_t>& data);
+bool Rx2AnalysisCacheWrite(const Rx2FileKey& key, const wchar_t* kind,
+                           const std::vector<std::uint8_t>& data);
+
+// Typed helpers for the analysis done during render.
+bool Rx2LoadCachedPeaks(const Rx2FileKey& key, Rx2PeakIndex* peaks);
+void Rx2StoreCachedPeaks(const Rx2FileKey& key, const Rx2PeakIndex& peaks);
+bool Rx2LoadCachedLoudness(const Rx2FileKey& key, Rx2Loudness* loudness);
+void Rx2StoreCachedLoudness(const Rx2FileKey& key, const Rx2Loudness& loudness);
@@ -0,0 +1,327 @@
+#include "Rx2CallLog.h"
+#include "Rx2Metrics.h"
+#include "Rx2Settings.h"
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <new>
+#include <utility>
+#include <vector>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+// 64 K records (2.5 MB) is about a minute of Read calls from a busy
+// playlist scan; the writer empties it four times a second.
+static const std::uint64_t kRingSlots = 65536;
+
+struct RingSlot
+{
+    std::atomic<std::uint64_t> sequence;
+    Rx2CallRecord              record;
+};
+
+static RingSlot*                  g_ring    = nullptr;
+static std::atomic<std::uint64_t> g_head(0);            // next slot to claim
+static std::uint64_t              g_tail    = 0;        // writer thread only
+static std::atomic<std::uint64_t> g_dropped(0);
+
+static std::atomic<bool>          g_enabled(false);
+static std::int64_t               g_startTicks = 0;
+
+static std::atomic<std::uint32_t> g_nextDecoder(0);
+static std::atomic<std::uint32_t> g_nextThread(0);
+
+// File ids, and the paths the writer has not written yet.
+static SRWLOCK                                             g_fileLock = SRWLOCK_INIT;
+static std::map<std::wstring, std::uint32_t>               g_fileIds;
+static std::vector<std::pair<std::uint32_t, std::wstring>> g_newFiles;
+
+static HANDLE g_file      = INVALID_HANDLE_VALUE;
+static HANDLE g_writer    = nullptr;
+static HANDLE g_stopEvent = nullptr;
+
+static thread_local std::uint16_t t_thread = 0;
+
+// ---------------- helpers ----------------
+
+static bool WriteAll(const void* data, size_t bytes)
+{
+    DWORD written = 0;
+    return WriteFile(g_file, data, static_cast<DWORD>(bytes), &written, nullptr)
+        && written == bytes;
+}
+
+// Bounded multi-producer queue (D. Vyukov): a slot is free for position p
+// when its sequence is p, and filled when it is p + 1.
+static bool RingPush(const Rx2CallRecord& record)
+{
+    std::uint64_t pos = g_head.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        RingSlot&           slot = g_ring[pos & (kRingSlots - 1)];
+        const std::uint64_t seq  = slot.sequence.load(std::memory_order_acquire);
+        const std::int64_t  diff = static_cast<std::int64_t>(seq - pos);
+
+        if (diff == 0)
+        {
+            if (g_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                slot.record = record;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0)
+        {
+            return false;   // full
+        }
+        else
+        {
+            pos = g_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+static bool RingPop(Rx2CallRecord* record)
+{
+    RingSlot& slot = g_ring[g_tail & (kRingSlots - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != g_tail + 1)
+        return false;
+
+    *record = slot.record;
+    slot.sequence.store(g_tail + kRingSlots, std::memory_order_release);
+    ++g_tail;
+    return true;
+}
+
+// Writes what the ring holds, preceded by the paths those records refer to.
+// The ring is emptied first: a path is registered before any record that
+// uses it is pushed, so it is in g_newFiles by the time it is taken.
+static void Drain(std::vector<Rx2CallRecord>& batch)
+{
+    batch.clear();
+    Rx2CallRecord record;
+    while (RingPop(&record))
+        batch.push_back(record);
+
+    std::vector<std::pair<std::uint32_t, std::wstring>> files;
+    AcquireSRWLockExclusive(&g_fileLock);
+    files.swap(g_newFiles);
+    ReleaseSRWLockExclusive(&g_fileLock);
+
+    for (const auto& file : files)
+    {
+        // wchar_t is UTF-16 on Windows; the bench build's is wider.
+        std::vector<std::uint16_t> path((file.second.size() + 3) & ~static_cast<size_t>(3), 0);
+        for (size_t i = 0; i < file.second.size(); ++i)
+            path[i] = static_cast<std::uint16_t>(file.second[i]);
+
+        Rx2CallRecord header{};
+        header.op      = kRx2CallFile;
+        header.decoder = file.first;
+        header.arg     = static_cast<std::int64_t>(file.second.size() * sizeof(std::uint16_t));
+
+        WriteAll(&header, sizeof(header));
+        if (!path.empty())
+            WriteAll(path.data(), path.size() * sizeof(std::uint16_t));
+    }
+
+    if (!batch.empty())
+        WriteAll(batch.data(), batch.size() * sizeof(Rx2CallRecord));
+}
+
+static DWORD WINAPI WriterProc(LPVOID /*param*/)
+{
+    std::vector<Rx2CallRecord> batch;
+    batch.reserve(static_cast<size_t>(kRingSlots));
+
+    for (;;)
+    {
+        const bool stopping = WaitForSingleObject(g_stopEvent, 250) == WAIT_OBJECT_0;
+        Drain(batch);
+        if (stopping)
+            break;
+    }
+    return 0;
+}
+
+// ---------------- recording ----------------
+
+const char* Rx2CallOpName(int op)
+{
+    static const char* const kNames[kRx2CallOpCount] =
+    {
+        "?", "file", "create_decoder", "destroy", "get_file_info", "get_stream_info",
+        "is_seekable", "is_real_time_stream", "get_available_data", "get_size",
+        "get_position", "set_position", "read", "dropped"
+    };
+    return (op > 0 && op < kRx2CallOpCount) ? kNames[op] : "?";
+}
+
+bool Rx2CallLogEnabled()
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+std::uint32_t Rx2CallLogNewDecoderId()
+{
+    return Rx2CallLogEnabled() ? g_nextDecoder.fetch_add(1, std::memory_order_relaxed) + 1 : 0;
+}
+
+std::uint32_t Rx2CallLogFileId(const std::wstring& path)
+{
+    if (!Rx2CallLogEnabled() || path.empty())
+        return 0;
+
+    std::uint32_t id = 0;
+    AcquireSRWLockExclusive(&g_fileLock);
+    try
+    {
+        auto it = g_fileIds.find(path);
+        if (it != g_fileIds.end())
+        {
+            id = it->second;
+        }
+        else
+        {
+            id = static_cast<std::uint32_t>(g_fileIds.size() + 1);
+            g_fileIds.emplace(path, id);
+            g_newFiles.emplace_back(id, path);
+        }
+    }
+    catch (...)
+    {
+        id = 0;
+    }
+    ReleaseSRWLockExclusive(&g_fileLock);
+    return id;
+}
+
+std::int64_t Rx2CallLogNowUs()
+{
+    if (!Rx2CallLogEnabled())
+        return 0;
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (now.QuadPart - g_startTicks) * 1000000 / Rx2TicksPerSecond();
+}
+
+void Rx2CallLogRecord(Rx2CallOp op, std::uint32_t decoder, std::int64_t arg,
+                      std::int64_t result, std::int64_t startUs)
+{
+    if (!Rx2CallLogEnabled())
+        return;
+
+    if (!t_thread)
+        t_thread = static_cast<std::uint16_t>(g_nextThread.fetch_add(1, std::memory_order_relaxed) + 1);
+
+    Rx2CallRecord record;
+    record.timeUs  = startUs;
+    record.arg     = arg;
+    record.result  = result;
+    record.decoder = decoder;
+    record.op      = op;
+    record.thread  = t_thread;
+
+    if (!RingPush(record))
+        g_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ---------------- lifetime ----------------
+
+bool Rx2CallLogOpen(const wchar_t* path)
+{
+    if (!path || !*path || g_writer)
+        return false;
+
+    if (!g_ring)
+    {
+        g_ring = new (std::nothrow) RingSlot[kRingSlots];
+        if (!g_ring)
+            return false;
+    }
+    for (std::uint64_t i = 0; i < kRingSlots; ++i)
+        g_ring[i].sequence.store(i, std::memory_order_relaxed);
+    g_head    = 0;
+    g_tail    = 0;
+    g_dropped = 0;
+
+    g_file = CreateFileW(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                         CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (g_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    Rx2CallFileHeader header{};
+    memcpy(header.magic, kRx2CallMagic, sizeof(header.magic));
+    header.version    = kRx2CallVersion;
+    header.recordSize = sizeof(Rx2CallRecord);
+
+    g_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!WriteAll(&header, sizeof(header)) || !g_stopEvent
+        || !(g_writer = CreateThread(nullptr, 0, WriterProc, nullptr, 0, nullptr)))
+    {
+        if (g_stopEvent)
+            CloseHandle(g_stopEvent);
+        CloseHandle(g_file);
+        g_stopEvent = nullptr;
+        g_file      = INVALID_HANDLE_VALUE;
+        return false;
+    }
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    g_startTicks = now.QuadPart;
+
+    g_enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+void Rx2CallLogStart(IAIMPCore* core)
+{
+    if (!core || !Rx2GetSettings().recordCalls)
+        return;
+
+    const std::wstring dir = Rx2ProfileDir(core);
+    if (dir.empty())
+        return;
+
+    if (!Rx2CallLogOpen((dir + L"Calls.rx2calls").c_str()))
+        OutputDebugStringW(L"RX2Decoder: cannot record calls to Calls.rx2calls\n");
+}
+
+void Rx2CallLogStop()
+{
+    if (!g_writer)
+        return;
+
+    // A call already past the enabled check may still land after the last
+    // drain; at shutdown that loses at most the final few records.
+    g_enabled.store(false, std::memory_order_release);
+
+    SetEvent(g_stopEvent);
+    WaitForSingleObject(g_writer, INFINITE);
+    CloseHandle(g_writer);
+    CloseHandle(g_stopEvent);
+    g_writer    = nullptr;
+    g_stopEvent = nullptr;
+
+    const std::uint64_t dropped = g_dropped.load(std::memory_order_relaxed);
+    if (dropped)
+    {
+        Rx2CallRecord record{};
+        record.op  = kRx2CallDropped;
+        record.arg = static_cast<std::int64_t>(dropped);
+        WriteAll(&record, sizeof(record));
+    }
+
+    CloseHandle(g_file);
+    g_file = INVALID_HANDLE_VALUE;
+
+    AcquireSRWLockExclusive(&g_fileLock);
+    g_fileIds.clear();
+    g_newFiles.clear();
+    ReleaseSRWLockExclusive(&g_fileLock);
+}
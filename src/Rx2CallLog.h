@@ -0,0 +1,122 @@
+#pragma once
+
+// Call recorder: logs what AIMP asks of the decoder extension and of the
+// decoders it returns, for replay with bench/rx2_replay.
+//
+// Each CreateDecoder and IAIMPAudioDecoder call becomes one fixed-size
+// record with its start time, arguments and result; the path of each file
+// opened is written once. Records pass through a lock-free ring to a writer
+// thread that appends them to the file every 250 ms, so recording Read on
+// the audio thread neither waits nor allocates; when the ring is full,
+// records are dropped and counted in a last kRx2CallDropped record.
+// Recording is off unless RX2Decoder\RecordCalls is set; the plugin then
+// writes <AIMP profile>\RX2Decoder\Calls.rx2calls.
+//
+// File layout, little endian:
+//   Rx2CallFileHeader
+//   Rx2CallRecord...   a kRx2CallFile record is followed by `arg` bytes of
+//                      UTF-16 path, zero-padded to a multiple of 8
+
+#include "apiCore.h"
+
+#include <cstdint>
+#include <string>
+
+static const char          kRx2CallMagic[8] = { 'R', 'X', '2', 'C', 'A', 'L', 'L', 'S' };
+static const std::uint32_t kRx2CallVersion  = 1;
+
+enum Rx2CallOp : std::uint16_t
+{
+    kRx2CallFile = 1,          // decoder = file id, arg = path bytes
+    kRx2CallCreateDecoder,     // decoder = the one returned (0 = none), arg = see
+                               // Rx2CallOpenArg, result = HRESULT
+    kRx2CallDestroy,           // the decoder's last reference went away
+    kRx2CallGetFileInfo,
+    kRx2CallGetStreamInfo,
+    kRx2CallIsSeekable,
+    kRx2CallIsRealTimeStream,
+    kRx2CallGetAvailableData,
+    kRx2CallGetSize,
+    kRx2CallGetPosition,
+    kRx2CallSetPosition,       // arg = position in bytes
+    kRx2CallRead,              // arg = bytes asked for, result = bytes returned
+    kRx2CallDropped,           // arg = records lost to a full ring
+    kRx2CallOpCount
+};
+
+struct Rx2CallFileHeader
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+};
+
+struct Rx2CallRecord
+{
+    std::int64_t  timeUs;      // since recording started
+    std::int64_t  arg;
+    std::int64_t  result;
+    std::uint32_t decoder;     // 1-based id per decoder, or the file id
+    std::uint16_t op;          // Rx2CallOp
+    std::uint16_t thread;      // 1-based id per calling thread
+};
+
+static_assert(sizeof(Rx2CallRecord) == 32, "Rx2CallRecord is part of the file format");
+
+// CreateDecoder's arg: file id in bits 0-31, slice index + 1 (0 = whole
+// loop) in bits 32-47, the Flags argument in bits 48-63.
+inline std::int64_t Rx2CallOpenArg(std::uint32_t fileId, int sliceIndex, std::uint32_t flags)
+{
+    return static_cast<std::int64_t>(fileId)
+         | static_cast<std::int64_t>(static_cast<std::uint16_t>(sliceIndex + 1)) << 32
+         | static_cast<std::int64_t>(flags & 0xFFFF) << 48;
+}
+
+const char* Rx2CallOpName(int op);
+
+// Starts recording into `path` (truncated). False if it cannot be created
+// or recording is already on.
+bool          Rx2CallLogOpen(const wchar_t* path);
+bool          Rx2CallLogEnabled();
+
+// Plugin lifetime: opens the profile's Calls.rx2calls if RX2Decoder\RecordCalls
+// is set; stop drains the ring and closes the file.
+void          Rx2CallLogStart(IAIMPCore* core);
+void          Rx2CallLogStop();
+
+// Id for a new decoder, or 0 while recording is off (its calls are then
+// never logged). File ids are handed out once per path.
+std::uint32_t Rx2CallLogNewDecoderId();
+std::uint32_t Rx2CallLogFileId(const std::wstring& path);
+
+std::int64_t  Rx2CallLogNowUs();
+void          Rx2CallLogRecord(Rx2CallOp op, std::uint32_t decoder, std::int64_t arg,
+                               std::int64_t result, std::int64_t startUs);
+
+// One decoder call: construct on entry, pass the return value through
+// Result(). Does nothing for decoders without an id.
+class Rx2LoggedCall
+{
+public:
+    Rx2LoggedCall(Rx2CallOp op, std::uint32_t decoder, std::int64_t arg = 0)
+        : m_op(op)
+        , m_decoder(decoder)
+        , m_arg(arg)
+        , m_startUs(decoder ? Rx2CallLogNowUs() : 0)
+    {
+    }
+
+    template <typename T>
+    T Result(T value)
+    {
+        if (m_decoder)
+            Rx2CallLogRecord(m_op, m_decoder, m_arg, static_cast<std::int64_t>(value), m_startUs);
+        return value;
+    }
+
+private:
+    Rx2CallOp     m_op;
+    std::uint32_t m_decoder;
+    std::int64_t  m_arg;
+    std::int64_t  m_startUs;
+};
@@ -0,0 +1,128 @@
+#include "Rx2Contention.h"
+
+const char* Rx2SyncSiteName(Rx2SyncSite site)
+{
+    switch (site)
+    {
+    case Rx2SyncSite::NegativeCache:      return "negative_cache";
+    case Rx2SyncSite::AnalysisCache:      return "analysis_cache";
+    case Rx2SyncSite::LibraryIndex:       return "library_index";
+    case Rx2SyncSite::MemoryBudget:       return "memory_budget";
+    case Rx2SyncSite::PrefetchSlot:       return "prefetch_slot";
+    case Rx2SyncSite::WaveformService:    return "waveform_service";
+    case Rx2SyncSite::DecoderPcm:         return "decoder_pcm";
+    case Rx2SyncSite::RexLibraryInit:     return "rex_library_init";
+    case Rx2SyncSite::RexCreateSandbox:   return "rex_create_sandbox";
+    case Rx2SyncSite::PipelineFreeSlot:   return "pipeline_free_slot";
+    case Rx2SyncSite::PipelineFilledSlot: return "pipeline_filled_slot";
+    case Rx2SyncSite::PipelineJoin:       return "pipeline_join";
+    default:                              return "?";
+    }
+}
+
+#if RX2_CONTENTION_PROFILE
+
+#include <atomic>
+
+// ---------------- state ----------------
+
+static const int kSites = static_cast<int>(Rx2SyncSite::Count);
+
+struct SiteCounters
+{
+    std::atomic<std::uint64_t> acquisitions;
+    std::atomic<std::uint64_t> contended;
+    std::atomic<std::int64_t>  waitTicks;
+    std::atomic<std::int64_t>  maxWaitTicks;
+};
+
+static SiteCounters g_sites[kSites];
+
+static std::int64_t TicksToNs(std::int64_t ticks)
+{
+    static const std::int64_t freq = []()
+    {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return static_cast<std::int64_t>(f.QuadPart);
+    }();
+    return static_cast<std::int64_t>(static_cast<double>(ticks) * 1e9 / freq);
+}
+
+// ---------------- public API ----------------
+
+std::int64_t Rx2SyncTicks()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+void Rx2SyncRecord(Rx2SyncSite site, bool contended, std::int64_t waitTicks)
+{
+    const int s = static_cast<int>(site);
+    if (s < 0 || s >= kSites)
+        return;
+
+    SiteCounters& c = g_sites[s];
+    c.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    if (!contended)
+        return;
+
+    c.contended.fetch_add(1, std::memory_order_relaxed);
+    c.waitTicks.fetch_add(waitTicks, std::memory_order_relaxed);
+
+    std::int64_t prev = c.maxWaitTicks.load(std::memory_order_relaxed);
+    while (waitTicks > prev
+           && !c.maxWaitTicks.compare_exchange_weak(prev, waitTicks, std::memory_order_relaxed))
+    {
+    }
+}
+
+Rx2SyncStats Rx2SyncGetStats(Rx2SyncSite site)
+{
+    Rx2SyncStats stats{};
+    const int s = static_cast<int>(site);
+    if (s < 0 || s >= kSites)
+        return stats;
+
+    const SiteCounters& c = g_sites[s];
+    stats.acquisitions = c.acquisitions.load(std::memory_order_relaxed);
+    stats.contended    = c.contended.load(std::memory_order_relaxed);
+    stats.waitNs       = TicksToNs(c.waitTicks.load(std::memory_order_relaxed));
+    stats.maxWaitNs    = TicksToNs(c.maxWaitTicks.load(std::memory_order_relaxed));
+    return stats;
+}
+
+void Rx2SyncResetStats()
+{
+    for (SiteCounters& c : g_sites)
+    {
+        c.acquisitions = 0;
+        c.contended    = 0;
+        c.waitTicks    = 0;
+        c.maxWaitTicks = 0;
+    }
+}
+
+void Rx2ContentionReport()
+{
+    for (int s = 0; s < kSites; ++s)
+    {
+        const Rx2SyncStats stats = Rx2SyncGetStats(static_cast<Rx2SyncSite>(s));
+        if (!stats.acquisitions)
+            continue;
+
+        wchar_t msg[256];
+        _snwprintf_s(msg, _countof(msg), _TRUNCATE,
+                     L"RX2Decoder: contention: %hs: %llu acquisitions, %llu waited, "
+                     L"%.3f ms total, %.3f ms max\n",
+                     Rx2SyncSiteName(static_cast<Rx2SyncSite>(s)),
+                     static_cast<unsigned long long>(stats.acquisitions),
+                     static_cast<unsigned long long>(stats.contended),
+                     stats.waitNs / 1e6, stats.maxWaitNs / 1e6);
+        OutputDebugStringW(msg);
+    }
+}
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+
+// Wait-time profile of the plugin's own synchronization points
+// (RX2_CONTENTION_PROFILE builds only).
+//
+// Each lock or wait that can block is taken through Rx2LockExclusive /
+// Rx2LockShared or wrapped in RX2_SYNC_WAIT with the site it belongs to.
+// Locks are tried first, so an acquisition only counts as contended, and
+// its wait is only timed, when another thread holds the lock; waits on
+// events, semaphores and init-once are always timed. Rx2ContentionReport()
+// logs the totals per site. Without RX2_CONTENTION_PROFILE the helpers are
+// the plain Win32 calls. Either way a lock taken through them on the audio
+// thread counts as a violation in RX2_RT_AUDIT builds.
+
+#include "Rx2RtAudit.h"
+
+#include <windows.h>
+
+#include <cstdint>
+
+enum class Rx2SyncSite
+{
+    NegativeCache,       // Rx2NegativeCache's map
+    AnalysisCache,       // Rx2AnalysisCache's directory
+    LibraryIndex,        // Rx2LibraryIndex's mapping
+    MemoryBudget,        // Rx2MemoryBudget's client list
+    PrefetchSlot,        // Rx2Prefetcher's slot and pending path
+    WaveformService,     // Rx2WaveformService's core and decoder pointers
+    DecoderPcm,          // Rx2Decoder::m_pcmLock (eviction, re-render)
+    RexLibraryInit,      // first-use load of the REX library
+    RexCreateSandbox,    // waiting for the sandboxed REXCreate thread
+    PipelineFreeSlot,    // render pipeline producer waiting for the worker
+    PipelineFilledSlot,  // render pipeline worker waiting for blocks
+    PipelineJoin,        // render pipeline producer waiting for the worker to drain
+    Count
+};
+
+struct Rx2SyncStats
+{
+    std::uint64_t acquisitions;
+    std::uint64_t contended;     // acquisitions that had to wait
+    std::int64_t  waitNs;        // total time spent waiting
+    std::int64_t  maxWaitNs;
+};
+
+const char* Rx2SyncSiteName(Rx2SyncSite site);
+
+#if RX2_CONTENTION_PROFILE
+
+void         Rx2SyncRecord(Rx2SyncSite site, bool contended, std::int64_t waitTicks);
+std::int64_t Rx2SyncTicks();
+Rx2SyncStats Rx2SyncGetStats(Rx2SyncSite site);
+void         Rx2SyncResetStats();
+void         Rx2ContentionReport();
+
+inline void Rx2LockExclusive(SRWLOCK* lock, Rx2SyncSite site)
+{
+    RX2_RT_NOTE(Rx2RtViolation::Lock, Rx2SyncSiteName(site));
+    if (TryAcquireSRWLockExclusive(lock))
+    {
+        Rx2SyncRecord(site, false, 0);
+        return;
+    }
+    const std::int64_t t0 = Rx2SyncTicks();
+    AcquireSRWLockExclusive(lock);
+    Rx2SyncRecord(site, true, Rx2SyncTicks() - t0);
+}
+
+inline void Rx2LockShared(SRWLOCK* lock, Rx2SyncSite site)
+{
+    RX2_RT_NOTE(Rx2RtViolation::Lock, Rx2SyncSiteName(site));
+    if (TryAcquireSRWLockShared(lock))
+    {
+        Rx2SyncRecord(site, false, 0);
+        return;
+    }
+    const std::int64_t t0 = Rx2SyncTicks();
+    AcquireSRWLockShared(lock);
+    Rx2SyncRecord(site, true, Rx2SyncTicks() - t0);
+}
+
+template <typename Fn>
+inline auto Rx2SyncTimed(Rx2SyncSite site, Fn fn) -> decltype(fn())
+{
+    const std::int64_t t0 = Rx2SyncTicks();
+    auto result = fn();
+    Rx2SyncRecord(site, true, Rx2SyncTicks() - t0);
+    return result;
+}
+
+#define RX2_SYNC_WAIT(site, call)  Rx2SyncTimed(site, [&]() { return call; })
+
+#else
+
+inline void Rx2ContentionReport() {}
+
+inline void Rx2LockExclusive(SRWLOCK* lock, Rx2SyncSite site)
+{
+    RX2_RT_NOTE(Rx2RtViolation::Lock, Rx2SyncSiteName(site));
+    AcquireSRWLockExclusive(lock);
+}
+
+inline void Rx2LockShared(SRWLOCK* lock, Rx2SyncSite site)
+{
+    RX2_RT_NOTE(Rx2RtViolation::Lock, Rx2SyncSiteName(site));
+    AcquireSRWLockShared(lock);
+}
+
+#define RX2_SYNC_WAIT(site, call)  (call)
+
+#endif
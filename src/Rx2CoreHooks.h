@@ -0,0 +1,20 @@
+#pragma once
+
+// Instrumentation used by the decoder core (Rx2Loop, Rx2RenderPipeline).
+// In the plugin and the bench host these are the lifecycle trace
+// (Rx2Trace.h) and the wait-time profile (Rx2Contention.h). Standalone core
+// builds (RX2_CORE_STANDALONE) have neither, and the hooks compile to the
+// bare calls.
+
+#if RX2_CORE_STANDALONE
+
+#define RX2_TRACE_SCOPE(name)       ((void)0)
+#define RX2_TRACE_CALL(name, call)  (call)
+#define RX2_SYNC_WAIT(site, call)   (call)
+
+#else
+
+#include "Rx2Contention.h"
+#include "Rx2Trace.h"
+
+#endif
@@ -1,19 +1,25 @@
 #include "Rx2Decoder.h"
-
+#include "Rx2CallLog.h"
+#include "Rx2Contention.h"
+#include "Rx2Metrics.h"
+#include "Rx2RtAudit.h"
+#include "Rx2Settings.h"
+#include "Rx2Trace.h"
+
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
-#include <string>
 #include <cstring>
+#include <string>
+#include <new>
 #include <windows.h>
 
-// ---------------- helpers ----------------
+// The decoder AIMP read from last: the track that is playing, or paused.
+// It is never evicted, so resuming it never waits for a render. Only
+// compared, never dereferenced.
+static std::atomic<const Rx2Decoder*> g_playing(nullptr);
 
-static float ClampSampleFloat(float v)
-{
-    if (v < -1.0f) return -1.0f;
-    if (v >  1.0f) return  1.0f;
-    return v;
-}
+// ---------------- helpers ----------------
 
 static INT64 BytesToFrames(INT64 bytes, int channels, int bytesPerSample)
 {
@@ -36,87 +42,87 @@ static INT64 FramesToBytes(INT64 frames, int channels, int bytesPerSample)
     return frames * frameSize;
 }
 
-static REX::REXCallbackResult RexProgressCallback(REX::REX_int32_t /*percentFinished*/, void* /*ud*/)
+// The core's share of the plugin settings.
+static Rx2LoopOptions LoopOptions(bool skipPreflight, int sliceIndex)
 {
-    return REX::kREXCallback_Continue;
+    const Rx2Settings& settings = Rx2GetSettings();
+
+    Rx2LoopOptions options;
+    options.pcmStorageBits      = settings.pcmStorageBits;
+    options.pcmMinStorageBits   = settings.pcmMinStorageBits;
+    options.pcmCompression      = settings.pcmCompression;
+    options.pcmSpillThresholdMB = settings.pcmSpillThresholdMB;
+    options.sliceIndex          = sliceIndex;
+    options.skipPreflight       = skipPreflight;
+    options.sampleRate          = 0;
+    options.tempo               = 0;
+    return options;
 }
 
-// Convert a narrow C string from the REX SDK (UTF-8 safe ASCII) into std::wstring.
-static std::wstring RexStringToWide(const char* s)
+static int AimpSampleFormat(Rx2SampleFormat format)
 {
-    if (!s || !*s)
+    switch (format)
+    {
+    case Rx2SampleFormat::Int16: return AIMP_DECODER_SAMPLEFORMAT_16BIT;
+    case Rx2SampleFormat::Int24: return AIMP_DECODER_SAMPLEFORMAT_24BIT;
+    default:                     return AIMP_DECODER_SAMPLEFORMAT_32BITFLOAT;
+    }
+}
+
+// Convert a narrow string from the REX SDK (UTF-8 safe ASCII) into std::wstring.
+static std::wstring RexStringToWide(const std::string& s)
+{
+    if (s.empty())
         return std::wstring();
 
-    int len = static_cast<int>(strlen(s));
+    int len = static_cast<int>(s.size());
     if (len <= 0)
         return std::wstring();
 
-    int needed = MultiByteToWideChar(CP_UTF8, 0, s, len, nullptr, 0);
+    int needed = MultiByteToWideChar(CP_UTF8, 0, s.data(), len, nullptr, 0);
     if (needed <= 0)
         return std::wstring();
 
     std::wstring out;
     out.resize(static_cast<size_t>(needed));
-    MultiByteToWideChar(CP_UTF8, 0, s, len, &out[0], needed);
+    MultiByteToWideChar(CP_UTF8, 0, s.data(), len, &out[0], needed);
     return out;
 }
 
-// ---------------- REXCreate sandbox ----------------
-
-// Context for running REXCreate in a worker thread
-struct REXCreateContext
-{
-    const char*      data;
-    REX::REX_int32_t size;
-    REX::REXHandle   handle;
-    REX::REXError    err;
-    HANDLE           doneEvent;
-};
-
-// Worker thread: calls REXCreate and signals when done
-static DWORD WINAPI REXCreateThreadProc(LPVOID param)
-{
-    REXCreateContext* ctx = reinterpret_cast<REXCreateContext*>(param);
-
-    ctx->err = REX::REXCreate(
-        &ctx->handle,
-        ctx->data,
-        ctx->size,
-        RexProgressCallback,
-        nullptr);
-
-    SetEvent(ctx->doneEvent);
-    return 0;
-}
-
 // ---------------- ctor / dtor ----------------
 
-Rx2Decoder::Rx2Decoder(IAIMPCore* core, IAIMPStream* stream, bool skipPreflight)
+Rx2Decoder::Rx2Decoder(IAIMPCore* core, IAIMPStream* stream, bool skipPreflight, int sliceIndex)
     : m_refCount(1)
     , m_core(core)
     , m_stream(stream)
     , m_fileData(nullptr)
     , m_fileSize(0)
+    , m_loop()
     , m_sampleRate(44100)
-    , m_sourceSampleRate(0)
     , m_channels(2)
     , m_totalSamples(0)
     , m_positionSamples(0)
-    , m_loopFrames(0)
     , m_bytesServed(0)
-    , m_previewTempo(0)
-    , m_hasTempoFromFile(false)
     , m_creatorName()
     , m_creatorCopyright()
     , m_creatorURL()
     , m_creatorEmail()
     , m_creatorFreeText()
-    , m_rexHandle(nullptr)
     , m_isValid(false)
     , m_skipPreflight(skipPreflight)
-    , m_lastError(REX::kREXError_NoError)
-    , m_hasError(false)
+    , m_sliceIndex(sliceIndex)
+    , m_callLogId(Rx2CallLogNewDecoderId())
+    , m_outputFormat(Rx2SampleFormat::Float32)
+    , m_pcmEvicted(false)
+    , m_lastUseTick(0)
+    , m_pinned(false)
+    , m_restorePending(false)
+    , m_restoreFailed(false)
 {
+    RX2_TRACE_SCOPE("Rx2Decoder::Rx2Decoder");
+
+    InitializeSRWLock(&m_pcmLock);
+
     if (m_core)
         m_core->AddRef();
     if (m_stream)
@@ -126,500 +132,191 @@ Rx2Decoder::Rx2Decoder(IAIMPCore* core, IAIMPStream* stream, bool skipPreflight)
         return;
 
     // 1) read whole file
-    m_stream->Seek(0, AIMP_STREAM_SEEKMODE_FROM_BEGINNING);
-    const INT64 totalSize = m_stream->GetSize();
-    if (totalSize <= 0)
-        return;
-
-    m_fileData = new std::uint8_t[static_cast<size_t>(totalSize)];
-    m_fileSize = 0;
-
-    while (m_fileSize < totalSize)
-    {
-        INT64 remaining = totalSize - m_fileSize;
-        int toRead = static_cast<int>(remaining > 64 * 1024 ? 64 * 1024 : remaining);
-        int r = m_stream->Read(m_fileData + m_fileSize, toRead);
-        if (r <= 0)
-            break;
-        m_fileSize += r;
-    }
-
-    if (m_fileSize <= 0)
-        return;
-
-    bool headersOk = m_skipPreflight; // assume preflight done by caller if skipped
-
-    
-    // 1.5) Preflight: skip here if already performed by caller/extension
-    if (!m_skipPreflight)
-    {
-       
-        REX::REXInfo preInfo{};
-        REX::REXError preErr = REX::REXGetInfoFromBuffer(
-            static_cast<REX::REX_int32_t>(m_fileSize),
-            reinterpret_cast<const char*>(m_fileData),
-            static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)),
-            &preInfo);
-
-        if (preErr != REX::kREXError_NoError)
-        {
-            m_lastError = preErr;
-            m_hasError  = true;
-            m_isValid   = false;
-            m_totalSamples = 0;
-            m_positionSamples = 0;
-            m_loopFrames = 0;
-            m_previewTempo = 0;
-            m_fileSize = 0;
-            m_pcmData.clear();
-
-            if (m_stream)
-            {
-                m_stream->Release();
-                m_stream = nullptr;
-            }
-            delete[] m_fileData;
-            m_fileData = nullptr;
-            return;
-        }
-    
-        // Additional cheap sanity checks on header fields
-        bool headerOk = true;
-      
-        // Explicitly detect missing loop length to show a specific error.
-        if (preInfo.fPPQLength <= 0)
-        {
-            m_lastError = REX::kREXError_FileHasZeroLoopLength;
-            m_hasError  = true;
-            m_isValid   = false;
-            headerOk = false;
-        }
-
-        // Channels must be 1 or 2 for our decoder
-        if (preInfo.fChannels <= 0 || preInfo.fChannels > 2)
-            headerOk = false;
-
-        // Sample rate must be sane
-        if (preInfo.fSampleRate <= 0 || preInfo.fSampleRate > 192000)
-            headerOk = false;
-
-        // PPQ length must be positive and not absurdly large
-        if (preInfo.fPPQLength <= 0 || preInfo.fPPQLength > 100000000)
-            headerOk = false;
-
-        // Bars/Beats not set -> both tempo fields zero.
-        if (preInfo.fTempo <= 0 && preInfo.fOriginalTempo <= 0)
-            headerOk = false;
-
-        // Time signature denominator should be common musical values
-        if (!(preInfo.fTimeSignDenom == 1 ||
-              preInfo.fTimeSignDenom == 2 ||
-              preInfo.fTimeSignDenom == 4 ||
-              preInfo.fTimeSignDenom == 8 ||
-              preInfo.fTimeSignDenom == 16))
-        {
-            headerOk = false;
-        }
-
-        if (!headerOk)
-        {
-            m_lastError = REX::kREXError_FileCorrupt;
-            m_hasError  = true;
-            m_isValid   = false;
-            return;
-        }
-
-        headersOk = true;
-    }
-
-    if (!headersOk)
-    {
-        m_lastError = REX::kREXError_FileCorrupt;
-        m_hasError  = true;
-        m_isValid   = false;
+    if (!ReadWholeStream())
         return;
-    }
-
-    
-    // 2) create REX handle, sandboxed in a worker thread with timeout
-    REX::REXError err = REX::kREXError_NoError;
 
-    
-    REXCreateContext ctx{};
-    ctx.data      = reinterpret_cast<const char*>(m_fileData);
-    ctx.size      = static_cast<REX::REX_int32_t>(m_fileSize);
-    ctx.handle    = nullptr;
-    ctx.err       = REX::kREXError_NoError;
-    ctx.doneEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
-
-    if (!ctx.doneEvent)
-    {
-        m_lastError = REX::kREXError_OutOfMemory;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
-    }
+    // 2) validate and render; the core owns the bytes from here, and they
+    // are re-read from m_stream if the PCM ever has to be rendered again
+    const bool opened = m_loop.Open(m_fileData, m_fileSize, LoopOptions(m_skipPreflight, m_sliceIndex));
+    m_fileData = nullptr;
 
-    HANDLE thread = CreateThread(
-        nullptr,
-        0,
-        REXCreateThreadProc,
-        &ctx,
-        0,
-        nullptr);
+    RecordRender();
 
-    if (!thread)
-    {
-        CloseHandle(ctx.doneEvent);
-        m_lastError = REX::kREXError_OutOfMemory;
-        m_hasError  = true;
-        m_isValid   = false;
+    if (!opened)
         return;
-    }
-
-    // Wait for completion or timeout
-    const DWORD TIMEOUT_MS = 2000; // 2 seconds
-    DWORD waitRes = WaitForSingleObject(ctx.doneEvent, TIMEOUT_MS);
-
-    if (waitRes == WAIT_OBJECT_0)
-    {
-        // Completed normally
-        CloseHandle(ctx.doneEvent);
-        CloseHandle(thread);
 
-        err         = ctx.err;
-        m_rexHandle = ctx.handle;
-    }
+    m_sampleRate   = m_loop.SampleRate();
+    m_channels     = m_loop.Channels();
+    m_totalSamples = m_loop.Frames();
+
+    const Rx2LoopCreator& creator = m_loop.Creator();
+    m_creatorName      = RexStringToWide(creator.name);
+    m_creatorCopyright = RexStringToWide(creator.copyright);
+    m_creatorURL       = RexStringToWide(creator.url);
+    m_creatorEmail     = RexStringToWide(creator.email);
+    m_creatorFreeText  = RexStringToWide(creator.freeText);
+
+    // Integer storage is served natively unless float output is forced.
+    const Rx2SampleFormat storageFormat = m_loop.StorageFormat();
+    if (storageFormat == Rx2SampleFormat::Float32 || Rx2GetSettings().pcmNativeOutput)
+        m_outputFormat = storageFormat;
     else
-    {
-        // WAIT_TIMEOUT or WAIT_FAILED: REXCreate hung inside the DLL
-        TerminateThread(thread, 1);
-        CloseHandle(thread);
-        CloseHandle(ctx.doneEvent);
-
-        m_lastError = REX::kREXError_FileCorrupt;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
-    }
-    
+        m_outputFormat = Rx2SampleFormat::Float32;
 
-    // Hard failure if handle is null
-    if (!m_rexHandle)
-    {
-        m_lastError = (err != REX::kREXError_NoError)
-                        ? err
-                        : REX::kREXError_Undefined;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
-    }
-    
+    m_isValid     = true;
+    m_lastUseTick = GetTickCount64();
 
-    // If err is non-zero but handle is valid, treat as non-fatal warning.
-    if (err != REX::kREXError_NoError)
-    {
-        // Loop length not set must be fatal.
-        if (err == REX::kREXError_FileHasZeroLoopLength)
-        {
-            m_lastError = err;
-            m_hasError  = true;
-            m_isValid   = false;
-
-            if (m_rexHandle)
-            {
-                REX::REXDelete(&m_rexHandle);
-                m_rexHandle = nullptr;
-            }
-            return;
-        }
+    Rx2MemoryBudgetRegister(this);
+    Rx2MemoryBudgetCharge(this, m_loop.Pcm().ResidentBytes());
+}
 
-        m_lastError = err;
-        m_hasError  = true;
-    }
-        
+// Reads the whole stream into m_fileData / m_fileSize.
+bool Rx2Decoder::ReadWholeStream()
+{
+    RX2_TRACE_SCOPE("Rx2Decoder::ReadWholeStream");
 
-    // 3) get info
-    REX::REXInfo info{};
-    err = REX::REXGetInfo(
-        m_rexHandle,
-        static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)),
-        &info);
+    delete[] m_fileData;
+    m_fileData = nullptr;
+    m_fileSize = 0;
 
-    // Detect missing loop length to surface the correct error code.
-    if (info.fPPQLength <= 0)
-    {
-        m_lastError = REX::kREXError_FileHasZeroLoopLength;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
-    }
+    m_stream->Seek(0, AIMP_STREAM_SEEKMODE_FROM_BEGINNING);
+    const INT64 totalSize = m_stream->GetSize();
+    if (totalSize <= 0)
+        return false;
 
-    m_channels         = info.fChannels;
-    m_sourceSampleRate = info.fSampleRate;
+    m_fileData = new (std::nothrow) std::uint8_t[static_cast<size_t>(totalSize)];
+    if (!m_fileData)
+        return false;
 
-    // 3.5) optional creator metadata
+    while (m_fileSize < totalSize)
     {
-        REX::REXCreatorInfo creator{};
-        REX::REXError cErr = REX::REXGetCreatorInfo(
-            m_rexHandle,
-            static_cast<REX::REX_int32_t>(sizeof(REX::REXCreatorInfo)),
-            &creator);
-
-        if (cErr == REX::kREXError_NoError)
-        {
-            m_creatorName      = RexStringToWide(creator.fName);
-            m_creatorCopyright = RexStringToWide(creator.fCopyright);
-            m_creatorURL       = RexStringToWide(creator.fURL);
-            m_creatorEmail     = RexStringToWide(creator.fEmail);
-            m_creatorFreeText  = RexStringToWide(creator.fFreeText);
-        }
+        INT64 remaining = totalSize - m_fileSize;
+        int toRead = static_cast<int>(remaining > 64 * 1024 ? 64 * 1024 : remaining);
+        int r = RX2_TRACE_CALL("IAIMPStream::Read", m_stream->Read(m_fileData + m_fileSize, toRead));
+        if (r <= 0)
+            break;
+        m_fileSize += r;
     }
 
-    // Use original file sample rate for playback; fallback to 44100 if missing
-    if (m_sourceSampleRate > 0)
-        m_sampleRate = m_sourceSampleRate;
-    else
-        m_sampleRate = 44100;
+    Rx2MetricAdd(Rx2Counter::BytesIngested, static_cast<std::uint64_t>(m_fileSize));
+    return m_fileSize > 0;
+}
 
-    // Missing both tempo fields implies Bars/Beats not set.
-    if (info.fTempo <= 0 && info.fOriginalTempo <= 0)
-    {
-        m_lastError = REX::kREXError_FileHasZeroLoopLength;
-        m_hasError  = true;
-        m_isValid   = false;
+// Feeds the core's last render into the metrics.
+void Rx2Decoder::RecordRender() const
+{
+    if (m_loop.LastRenderUs() < 0)
         return;
-    }
-
-    // choose tempo: prefer exported tempo, then original tempo
-    REX::REX_int32_t tempo = 0;
-    bool hasTempo = false;
-
-    if (info.fTempo > 0)
-    {
-        tempo    = info.fTempo;
-        hasTempo = true;
-    }
-    else if (info.fOriginalTempo > 0)
-    {
-        tempo    = info.fOriginalTempo;
-        hasTempo = true;
-    }
-    else
-    {
-        tempo    = 120000; // 120.000 BPM
-        hasTempo = false;
-    }
-        
-    m_previewTempo     = tempo;
-    m_hasTempoFromFile = hasTempo;
-
-    // 4) set sample rate & compute length (same as PreviewRenderInTempo)
-    REX::REXSetOutputSampleRate(
-        m_rexHandle,
-        static_cast<REX::REX_int32_t>(m_sampleRate));
-
-    double tmp = static_cast<double>(m_sampleRate);
-    tmp *= 1000.0;
-    tmp *= static_cast<double>(info.fPPQLength);
-
-    // Convert tempo to quarter-note BPM depending on time signature denominator.
-    double tempoForLength = static_cast<double>(m_previewTempo);
-    int    denom          = info.fTimeSignDenom;
 
-    if (denom > 0 && denom != 4)
-    {
-        tempoForLength = tempoForLength * 4.0 / static_cast<double>(denom);
-    }
-
-    tmp /= (tempoForLength * 256.0);
-
-    if (tmp < 0.0)
-        tmp = 0.0;
-      
-    REX::REX_int32_t lengthFrames = static_cast<REX::REX_int32_t>(tmp);
+    Rx2MetricRecordUs(Rx2Histogram::RenderUs, m_loop.LastRenderUs());
+    if (m_loop.LastRenderFrames() > 0)
+        Rx2MetricAdd(Rx2Counter::FramesRendered, static_cast<std::uint64_t>(m_loop.LastRenderFrames()));
+}
 
-    if (lengthFrames <= 0 || m_sampleRate <= 0 || m_channels <= 0)
-    {
-        m_lastError = REX::kREXError_FileCorrupt;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
-    }
-    
+// Brings evicted PCM back by re-reading the stream and rendering the loop
+// again with the parameters established by the constructor.
+bool Rx2Decoder::EnsureResident()
+{
+    if (!m_pcmEvicted)
+        return true;
 
-    // initial guess; we'll overwrite with actual framesRendered later
-    m_loopFrames      = static_cast<INT64>(lengthFrames);
-    m_totalSamples    = m_loopFrames;
-    m_positionSamples = 0;
+    RX2_TRACE_SCOPE("Rx2Decoder::EnsureResident");
+    Rx2MetricAdd(Rx2Counter::Rerenders);
 
-    // sanity bound ~1 hour
-    {
-        double durationSec = static_cast<double>(m_loopFrames)
-                           / static_cast<double>(m_sampleRate);
-        const double kMaxDurationSec = 60.0 * 60.0;
+    if (!m_stream || !ReadWholeStream())
+        return false;
 
-        if (durationSec <= 0.0 || durationSec > kMaxDurationSec)
-        {
-            m_lastError = REX::kREXError_FileCorrupt;
-            m_hasError  = true;
-            m_isValid   = false;
-            return;
-        }
-    }
+    const bool rendered = m_loop.Rerender(m_fileData, m_fileSize);
+    m_fileData = nullptr;
 
-    // 5) render preview into channel-separated buffers
-    std::vector<float> renderSamples;
-    try
-    {
-        renderSamples.resize(static_cast<size_t>(info.fChannels)
-                             * static_cast<size_t>(lengthFrames));
-    }
-    catch (...)
-    {
-        m_lastError = REX::kREXError_OutOfMemory;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
-    }
+    RecordRender();
 
-    float* buffers[2] = { nullptr, nullptr };
-    buffers[0] = renderSamples.data();
-    if (info.fChannels == 2)
-        buffers[1] = renderSamples.data() + lengthFrames;
-    else
-        buffers[1] = nullptr;
+    if (!rendered)
+        return false;
 
-    // Set tempo (already using m_previewTempo from above)
-    err = REX::REXSetPreviewTempo(m_rexHandle, m_previewTempo);
-    if (err != REX::kREXError_NoError)
-    {
-        m_lastError = err;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
-    }
+    m_pcmEvicted = false;
+    Rx2MemoryBudgetCharge(this, m_loop.Pcm().ResidentBytes());
+    return true;
+}
 
-    err = REX::REXStartPreview(m_rexHandle);
-    if (err != REX::kREXError_NoError)
-    {
-        m_lastError = err;
-        m_hasError  = true;
-        m_isValid   = false;
+// Restores evicted PCM on a pool thread, started by a seek or by the first
+// Read() that finds it missing, so the audio thread never renders. Queueing
+// the work item allocates, which the audio thread only pays once per
+// eviction.
+void Rx2Decoder::RequestRestore()
+{
+    if (m_restorePending.exchange(true))
         return;
-    }
-
-    REX::REX_int32_t framesRendered = 0;
-
-    while (framesRendered != lengthFrames)
-    {
-        REX::REX_int32_t remaining = lengthFrames - framesRendered;
-        REX::REX_int32_t todo      = remaining > 64 ? 64 : remaining;
-
-        float* tmpBuf[2] = { nullptr, nullptr };
-        tmpBuf[0] = buffers[0] + framesRendered;
-        if (buffers[1])
-            tmpBuf[1] = buffers[1] + framesRendered;
-
-        err = REX::REXRenderPreviewBatch(m_rexHandle, todo, tmpBuf);
-        if (err != REX::kREXError_NoError)
-        {
-            m_lastError = err;
-            m_hasError  = true;
-            m_isValid   = false;
-            break;
-        }
-
-        framesRendered += todo;
-    }
-
-    REX::REXStopPreview(m_rexHandle);
-
-    // SDK does a small extra batch after StopPreview.
-    {
-        float left[64];
-        float right[64];
-        float* tmpRenderBuffers[2];
-
-        tmpRenderBuffers[0] = &left[0];
-        tmpRenderBuffers[1] = (m_channels > 1) ? &right[0] : nullptr;
-
-        (void)REX::REXRenderPreviewBatch(m_rexHandle, 64, tmpRenderBuffers);
-    }
-
-    // 6) copy to interleaved m_pcmData
-    const int   ch   = m_channels;
-    const INT64 nFrm = framesRendered;
 
-    try
+    RX2_RT_NOTE(Rx2RtViolation::Allocation, "Rx2Decoder::RequestRestore");
+    AddRef();   // released by RestoreProc
+    if (!QueueUserWorkItem(RestoreProc, this, WT_EXECUTELONGFUNCTION))
     {
-        m_pcmData.resize(static_cast<size_t>(nFrm) * ch);
-    }
-    catch (...)
-    {
-        m_lastError = REX::kREXError_OutOfMemory;
-        m_hasError  = true;
-        m_isValid   = false;
-        return;
+        m_restorePending = false;
+        Release();
     }
+}
 
-    const float* left  = buffers[0];
-    const float* right = buffers[1];
+DWORD WINAPI Rx2Decoder::RestoreProc(LPVOID param)
+{
+    Rx2Decoder* self = static_cast<Rx2Decoder*>(param);
 
-    for (INT64 f = 0; f < nFrm; ++f)
-    {
-        float l = left[f];
-        float r = (ch > 1 && right) ? right[f] : l;
+    Rx2LockExclusive(&self->m_pcmLock, Rx2SyncSite::DecoderPcm);
+    if (!self->EnsureResident())
+        self->m_restoreFailed = true;
+    ReleaseSRWLockExclusive(&self->m_pcmLock);
 
-        size_t base = static_cast<size_t>(f) * ch;
-        m_pcmData[base + 0] = ClampSampleFloat(l);
-        if (ch > 1)
-            m_pcmData[base + 1] = ClampSampleFloat(r);
-    }
+    self->m_restorePending = false;
+    self->Release();
+    return 0;
+}
 
-    m_totalSamples = nFrm;
-    m_loopFrames   = nFrm;
+std::size_t Rx2Decoder::ResidentBytes()
+{
+    Rx2LockExclusive(&m_pcmLock, Rx2SyncSite::DecoderPcm);
+    const std::size_t bytes = m_loop.Pcm().ResidentBytes();
+    ReleaseSRWLockExclusive(&m_pcmLock);
+    return bytes;
+}
 
-    // Detect files that render as complete silence (e.g., all slices muted).
-    {
-        const float kSilenceThreshold = 1e-7f;
-        bool hasActiveSamples = false;
+void Rx2Decoder::SetPinned(bool pinned)
+{
+    if (!pinned)
+        m_lastUseTick.store(GetTickCount64(), std::memory_order_relaxed);
+    m_pinned.store(pinned, std::memory_order_release);
+}
 
-        for (float sample : m_pcmData)
-        {
-            if (sample < -kSilenceThreshold || sample > kSilenceThreshold)
-            {
-                hasActiveSamples = true;
-                break;
-            }
-        }
+std::size_t Rx2Decoder::EvictMemory()
+{
+    if (m_pinned.load(std::memory_order_acquire) || g_playing.load(std::memory_order_relaxed) == this)
+        return 0;
 
-        if (!hasActiveSamples || nFrm <= 0)
-        {
-            m_lastError = kRexError_NoActiveSlices;
-            m_hasError  = true;
-            m_isValid   = false;
-            return;
-        }
-    }
+    // Never wait: if Read() holds the lock, this decoder is in use anyway.
+    if (!TryAcquireSRWLockExclusive(&m_pcmLock))
+        return 0;
 
-    if (m_rexHandle)
+    std::size_t released = 0;
+    if (m_isValid && !m_pcmEvicted)
     {
-        REX::REXDelete(&m_rexHandle);
-        m_rexHandle = nullptr;
+        released = m_loop.Pcm().ResidentBytes();
+        m_loop.ReleasePcm();
+        m_pcmEvicted = true;
     }
 
-    m_isValid = true;
+    ReleaseSRWLockExclusive(&m_pcmLock);
+    return released;
 }
 
 
 Rx2Decoder::~Rx2Decoder()
 {
-    if (m_rexHandle)
-    {
-        REX::REXDelete(&m_rexHandle);
-        m_rexHandle = nullptr;
-    }
+    if (m_callLogId)
+        Rx2CallLogRecord(kRx2CallDestroy, m_callLogId, 0, 0, Rx2CallLogNowUs());
+
+    Rx2MemoryBudgetUnregister(this);
+
+    const Rx2Decoder* self = this;
+    g_playing.compare_exchange_strong(self, nullptr, std::memory_order_relaxed);
 
     delete[] m_fileData;
     m_fileData = nullptr;
@@ -652,6 +349,13 @@ HRESULT WINAPI Rx2Decoder::QueryInterface(REFIID riid, void **ppv)
         return S_OK;
     }
 
+    if (riid == IID_IRx2Waveform)
+    {
+        *ppv = static_cast<IRx2Waveform*>(this);
+        AddRef();
+        return S_OK;
+    }
+
     *ppv = nullptr;
     return E_NOINTERFACE;
 }
@@ -673,12 +377,15 @@ ULONG WINAPI Rx2Decoder::Release()
 
 BOOL WINAPI Rx2Decoder::GetFileInfo(IAIMPFileInfo *FileInfo)
 {
+    RX2_TRACE_SCOPE("Rx2Decoder::GetFileInfo");
+    Rx2LoggedCall call(kRx2CallGetFileInfo, m_callLogId);
+
     if (!m_isValid || !FileInfo)
-        return FALSE;
+        return call.Result(FALSE);
 
     double durationSec = 0.0;
-    if (m_loopFrames > 0 && m_sampleRate > 0)
-        durationSec = static_cast<double>(m_loopFrames) / m_sampleRate;
+    if (m_totalSamples > 0 && m_sampleRate > 0)
+        durationSec = static_cast<double>(m_totalSamples) / m_sampleRate;
 
     FileInfo->BeginUpdate();
 
@@ -687,13 +394,22 @@ BOOL WINAPI Rx2Decoder::GetFileInfo(IAIMPFileInfo *FileInfo)
                               static_cast<float>(durationSec));
 
     // show original samplerate from file header (fallback to playback SR)
-    int displayRate = (m_sourceSampleRate > 0) ? m_sourceSampleRate : m_sampleRate;
+    int displayRate = (m_loop.SourceSampleRate() > 0) ? m_loop.SourceSampleRate() : m_sampleRate;
     if (displayRate > 0)
         FileInfo->SetValueAsInt32(AIMP_FILEINFO_PROPID_SAMPLERATE, displayRate);
 
     if (m_channels > 0)
         FileInfo->SetValueAsInt32(AIMP_FILEINFO_PROPID_CHANNELS, m_channels);
 
+    // ReplayGain from the loudness measured while rendering; spares AIMP's
+    // scanner a second decode.
+    const Rx2Loudness& loudness = m_loop.Loudness();
+    if (loudness.HasResult())
+    {
+        FileInfo->SetValueAsFloat(AIMP_FILEINFO_PROPID_TRACKGAIN, loudness.TrackGainDb());
+        FileInfo->SetValueAsFloat(AIMP_FILEINFO_PROPID_TRACKPEAK, loudness.TruePeak());
+    }
+
     // Creator metadata from REXCreatorInfo, if present
     auto setWideStringProp = [&](int propId, const std::wstring& value)
     {
@@ -749,21 +465,24 @@ BOOL WINAPI Rx2Decoder::GetFileInfo(IAIMPFileInfo *FileInfo)
     }
 
     // BPM from header tempo
-    if (m_hasTempoFromFile && m_previewTempo > 0)
+    if (m_loop.HasTempoFromFile() && m_loop.Tempo() > 0)
     {
-        int bpm = static_cast<int>(m_previewTempo / 1000); // 1/1000 BPM
+        int bpm = static_cast<int>(m_loop.Tempo() / 1000); // 1/1000 BPM
         if (bpm > 0)
             FileInfo->SetValueAsInt32(AIMP_FILEINFO_PROPID_BPM, bpm);
     }
 
     FileInfo->EndUpdate();
-    return TRUE;
+    return call.Result(TRUE);
 }
 
 BOOL WINAPI Rx2Decoder::GetStreamInfo(int *SampleRate, int *Channels, int *SampleFormat)
 {
+    RX2_TRACE_SCOPE("Rx2Decoder::GetStreamInfo");
+    Rx2LoggedCall call(kRx2CallGetStreamInfo, m_callLogId);
+
     if (!m_isValid)
-        return FALSE;
+        return call.Result(FALSE);
 
     if (SampleRate)
         *SampleRate = m_sampleRate;   // playback SR = original SR now
@@ -772,59 +491,77 @@ BOOL WINAPI Rx2Decoder::GetStreamInfo(int *SampleRate, int *Channels, int *Sampl
         *Channels = m_channels;
 
     if (SampleFormat)
-        *SampleFormat = AIMP_DECODER_SAMPLEFORMAT_32BITFLOAT;
+        *SampleFormat = AimpSampleFormat(m_outputFormat);
 
-    return TRUE;
+    return call.Result(TRUE);
 }
 
 BOOL WINAPI Rx2Decoder::IsSeekable()
 {
-    return m_isValid ? TRUE : FALSE;
+    Rx2LoggedCall call(kRx2CallIsSeekable, m_callLogId);
+
+    return call.Result(m_isValid ? TRUE : FALSE);
 }
 
 BOOL WINAPI Rx2Decoder::IsRealTimeStream()
 {
-    return FALSE;
+    Rx2LoggedCall call(kRx2CallIsRealTimeStream, m_callLogId);
+
+    return call.Result(FALSE);
 }
 
 INT64 WINAPI Rx2Decoder::GetAvailableData()
 {
+    RX2_RT_SCOPE();
+    RX2_TRACE_SCOPE("Rx2Decoder::GetAvailableData");
+    Rx2LoggedCall call(kRx2CallGetAvailableData, m_callLogId);
+
     if (!m_isValid || m_channels <= 0)
-        return 0;
+        return call.Result(0);
 
-    const int bytesPerSample = 4;
+    const int bytesPerSample = Rx2BytesPerSample(m_outputFormat);
     const INT64 framesLeft   = m_totalSamples - m_positionSamples;
     if (framesLeft <= 0)
-        return 0;
+        return call.Result(0);
 
-    return FramesToBytes(framesLeft, m_channels, bytesPerSample);
+    return call.Result(FramesToBytes(framesLeft, m_channels, bytesPerSample));
 }
 
 INT64 WINAPI Rx2Decoder::GetSize()
 {
+    RX2_TRACE_SCOPE("Rx2Decoder::GetSize");
+    Rx2LoggedCall call(kRx2CallGetSize, m_callLogId);
+
     if (!m_isValid || m_channels <= 0)
-        return 0;
+        return call.Result(0);
 
-    const int bytesPerSample = 4;
-    return FramesToBytes(m_totalSamples, m_channels, bytesPerSample);
+    const int bytesPerSample = Rx2BytesPerSample(m_outputFormat);
+    return call.Result(FramesToBytes(m_totalSamples, m_channels, bytesPerSample));
 }
 
 INT64 WINAPI Rx2Decoder::GetPosition()
 {
+    RX2_TRACE_SCOPE("Rx2Decoder::GetPosition");
+    Rx2LoggedCall call(kRx2CallGetPosition, m_callLogId);
+
     if (!m_isValid || m_channels <= 0)
-        return 0;
+        return call.Result(0);
 
-    const int bytesPerSample = 4;
-    return FramesToBytes(m_positionSamples, m_channels, bytesPerSample);
+    const int bytesPerSample = Rx2BytesPerSample(m_outputFormat);
+    return call.Result(FramesToBytes(m_positionSamples, m_channels, bytesPerSample));
 }
 
 BOOL WINAPI Rx2Decoder::SetPosition(const INT64 Value)
 {
+    RX2_RT_SCOPE();
+    RX2_TRACE_SCOPE("Rx2Decoder::SetPosition");
+    Rx2LoggedCall call(kRx2CallSetPosition, m_callLogId, Value);
+
     if (!m_isValid || m_totalSamples <= 0 || m_channels <= 0)
-        return FALSE;
+        return call.Result(FALSE);
 
     const int  channels       = m_channels;
-    const int  bytesPerSample = 4;
+    const int  bytesPerSample = Rx2BytesPerSample(m_outputFormat);
 
     INT64 targetFrame = BytesToFrames(Value, channels, bytesPerSample);
     if (targetFrame < 0)
@@ -833,43 +570,86 @@ BOOL WINAPI Rx2Decoder::SetPosition(const INT64 Value)
         targetFrame = m_totalSamples;
 
     m_positionSamples = targetFrame;
-    return TRUE;
+
+    // Start bringing evicted PCM back now rather than at the next Read().
+    // A failed try-lock means an evictor or restore holds it; Read() will
+    // look again.
+    if (TryAcquireSRWLockExclusive(&m_pcmLock))
+    {
+        const bool evicted = m_pcmEvicted;
+        ReleaseSRWLockExclusive(&m_pcmLock);
+
+        if (evicted)
+            RequestRestore();
+    }
+
+    return call.Result(m_restoreFailed ? FALSE : TRUE);
 }
 
 int WINAPI Rx2Decoder::Read(void *Buffer, int Count)
 {
+    RX2_RT_SCOPE();
+    RX2_TRACE_SCOPE("Rx2Decoder::Read");
+    Rx2LoggedCall call(kRx2CallRead, m_callLogId, Count);
+
     if (!Buffer || !m_isValid || m_totalSamples <= 0 || m_channels <= 0)
-        return 0;
+        return call.Result(0);
 
-    const int bytesPerSample = 4;
+    const int bytesPerSample = Rx2BytesPerSample(m_outputFormat);
     const int channels       = m_channels;
     const int frameSize      = channels * bytesPerSample;
 
     int requestedFrames = Count / frameSize;
     if (requestedFrames <= 0)
-        return 0;
+        return call.Result(0);
 
     INT64 framesLeft = m_totalSamples - m_positionSamples;
     if (framesLeft <= 0)
-        return 0;
+        return call.Result(0);
 
     if (requestedFrames > framesLeft)
         requestedFrames = static_cast<int>(framesLeft);
 
-    float *out = static_cast<float*>(Buffer);
+    m_lastUseTick.store(GetTickCount64(), std::memory_order_relaxed);
+    if (g_playing.load(std::memory_order_relaxed) != this)
+        g_playing.store(this, std::memory_order_relaxed);
 
-    const float *src = m_pcmData.data()
-                     + static_cast<size_t>(m_positionSamples) * channels;
+    if (m_restoreFailed)
+        return call.Result(0);
 
-    size_t samplesToCopy = static_cast<size_t>(requestedFrames) * channels;
-    for (size_t i = 0; i < samplesToCopy; ++i)
-        out[i] = src[i];
+    // Never wait here. The playing decoder is not evicted, so the lock is
+    // only held elsewhere, or the PCM missing, when playback moves to a
+    // decoder evicted while it sat idle. Then start the restore on a pool
+    // thread and serve silence without advancing, so the audio carries on
+    // where it left off once the restore lands.
+    const int bytesRequested = requestedFrames * frameSize;
+    if (!TryAcquireSRWLockExclusive(&m_pcmLock))
+    {
+        RX2_RT_NOTE(Rx2RtViolation::Contention, "Rx2Decoder::Read");
+        memset(Buffer, 0, static_cast<size_t>(bytesRequested));
+        return call.Result(bytesRequested);
+    }
+
+    if (m_pcmEvicted)
+    {
+        ReleaseSRWLockExclusive(&m_pcmLock);
+        RequestRestore();
+        memset(Buffer, 0, static_cast<size_t>(bytesRequested));
+        return call.Result(bytesRequested);
+    }
+
+    RX2_TRACE_CALL("Rx2PcmStore::Read", m_loop.Pcm().Read(m_positionSamples, requestedFrames, Buffer, m_outputFormat));
+    ReleaseSRWLockExclusive(&m_pcmLock);
 
     m_positionSamples += requestedFrames;
+    m_bytesServed     += bytesRequested;
 
-    const int bytesReturned = requestedFrames * frameSize;
-    if (bytesReturned > 0)
-        m_bytesServed += bytesReturned;
+    return call.Result(bytesRequested);
+}
+
+// ---------------- IRx2Waveform ----------------
 
-    return bytesReturned;
+int WINAPI Rx2Decoder::GetPeaks(INT64 FirstFrame, INT64 Frames, int Buckets, Rx2Peak* Peaks)
+{
+    return Peaks ? m_loop.Peaks().Query(FirstFrame, Frames, Buckets, Peaks) : 0;
 }
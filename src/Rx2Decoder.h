@@ -5,19 +5,27 @@
 #include "apiFileManager.h"
 #include "apiObjects.h"
 #include "RexSdk.h"
+#include "Rx2Loop.h"
+#include "Rx2MemoryBudget.h"
+#include "Rx2Waveform.h"
 
+#include <windows.h>
+
+#include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
 
-// Custom sentinel error codes not provided by the REX SDK.
-static constexpr REX::REXError kRexError_NoActiveSlices =
-    static_cast<REX::REXError>(10000);
-
-class Rx2Decoder : public IAIMPAudioDecoder
+// AIMP adapter over the decoder core (Rx2Loop): reads the stream, hands
+// the bytes to the core and serves its PCM through IAIMPAudioDecoder, with
+// eviction and restore under the memory budget. Its peaks are offered to
+// other plugins through IRx2Waveform.
+class Rx2Decoder : public IAIMPAudioDecoder, public IRx2Waveform, public Rx2MemoryClient
 {
 public:
-    Rx2Decoder(IAIMPCore* core, IAIMPStream* stream, bool skipPreflight = false);
+    // sliceIndex >= 0 renders just that slice (REXRenderSlice) instead of
+    // the whole loop.
+    Rx2Decoder(IAIMPCore* core, IAIMPStream* stream, bool skipPreflight = false, int sliceIndex = -1);
     virtual ~Rx2Decoder();
 
     // IUnknown
@@ -26,6 +34,17 @@ public:
     ULONG   WINAPI Release() override;
 
     // IAIMPAudioDecoder
+    //
+    // Read, SetPosition and GetAvailableData run on AIMP's audio thread and
+    // are real-time safe: they do not allocate, make blocking calls or wait
+    // on a lock (m_pcmLock is only try-acquired), and the resident PCM is
+    // prefaulted after every render. The decoder read last is never
+    // evicted, so pausing and resuming it always finds its PCM. One evicted
+    // while it sat idle is restored on a pool thread, started by SetPosition
+    // or the first Read (the one allocation, to queue the work item); Read
+    // serves silence without advancing until it lands. Spilled stores map
+    // their file views on demand. RX2_RT_AUDIT builds count every violation
+    // (see Rx2RtAudit.h).
     BOOL    WINAPI GetFileInfo(IAIMPFileInfo *FileInfo) override;
     BOOL    WINAPI GetStreamInfo(int *SampleRate, int *Channels, int *SampleFormat) override;
     BOOL    WINAPI IsSeekable() override;
@@ -36,12 +55,39 @@ public:
     BOOL    WINAPI SetPosition(const INT64 Value) override;
     int     WINAPI Read(void *Buffer, int Count) override;
 
+    // IRx2Waveform (the peak index is immutable, so any thread may call it)
+    int     WINAPI GetChannels() override { return m_channels; }
+    INT64   WINAPI GetFrames() override { return m_loop.Peaks().Frames(); }
+    int     WINAPI GetPeaks(INT64 FirstFrame, INT64 Frames, int Buckets, Rx2Peak* Peaks) override;
+
     // Helpers for extension
     bool          IsValid()     const { return m_isValid; }
-    bool          HasError()    const { return m_hasError; }
-    REX::REXError GetLastError() const { return m_lastError; }
+    bool          HasError()    const { return m_loop.HasError(); }
+    REX::REXError GetLastError() const { return m_loop.LastError(); }
+    std::uint32_t CallLogId()    const { return m_callLogId; }
+    std::size_t   ResidentBytes();
+
+    // While pinned the memory budget never evicts the PCM (a prefetched
+    // decoder waiting to be adopted). Unpinning counts as a use, so the new
+    // owner gets the usual grace period before it can be evicted.
+    void          SetPinned(bool pinned);
+
+    // Analysis done during the first render; finished once the constructor
+    // succeeds and never touched again.
+    const Rx2PeakIndex& Peaks()    const { return m_loop.Peaks(); }
+    const Rx2Loudness&  Loudness() const { return m_loop.Loudness(); }
+
+    // Rx2MemoryClient
+    std::size_t   EvictMemory() override;
+    std::uint64_t LastUseTick() const override { return m_lastUseTick.load(std::memory_order_relaxed); }
 
 private:
+    bool          ReadWholeStream();
+    void          RecordRender() const;
+    bool          EnsureResident();   // m_pcmLock held
+    void          RequestRestore();
+    static DWORD WINAPI RestoreProc(LPVOID param);
+
     LONG         m_refCount;
     IAIMPCore   *m_core;
     IAIMPStream *m_stream;
@@ -49,31 +95,37 @@ private:
     std::uint8_t *m_fileData;
     std::int64_t  m_fileSize;
 
+    Rx2Loop      m_loop;
+
+    // Copied from m_loop once it has rendered, for the audio-thread calls.
     int    m_sampleRate;
     int    m_channels;
-    int    m_sourceSampleRate; // original rate from REX (info.fSampleRate)
 
     std::int64_t  m_totalSamples;      // frames
     std::int64_t  m_positionSamples;   // frames
-    std::int64_t  m_loopFrames;        // frames
     std::int64_t  m_bytesServed;       // bytes returned via Read()
 
-    REX::REX_int32_t m_previewTempo;      // 1/1000 BPM
-    bool             m_hasTempoFromFile;
-
-    // Creator metadata (from REXCreatorInfo). Empty strings mean "not available".
+    // Creator metadata (m_loop.Creator() as UTF-16). Empty strings mean "not available".
     std::wstring m_creatorName;
     std::wstring m_creatorCopyright;
     std::wstring m_creatorURL;
     std::wstring m_creatorEmail;
     std::wstring m_creatorFreeText;
 
-    REX::REXHandle   m_rexHandle;
     bool             m_isValid;
     bool             m_skipPreflight;
-
-    REX::REXError    m_lastError;
-    bool             m_hasError;
-
-    std::vector<float> m_pcmData;
+    int              m_sliceIndex;     // -1 = whole loop
+    std::uint32_t    m_callLogId;      // Rx2CallLog decoder id, 0 = not recorded
+
+    Rx2SampleFormat  m_outputFormat;   // format handed to AIMP by Read()
+
+    // Guards m_loop's PCM against eviction by the memory budget while Read()
+    // runs. m_pcmEvicted means it was dropped and must be re-rendered from
+    // m_stream by RestoreProc before it is served.
+    SRWLOCK                    m_pcmLock;
+    bool                       m_pcmEvicted;
+    std::atomic<std::uint64_t> m_lastUseTick;
+    std::atomic<bool>          m_pinned;          // SetPinned
+    std::atomic<bool>          m_restorePending;  // RestoreProc queued
+    std::atomic<bool>          m_restoreFailed;   // re-render failed; Read() ends
 };
@@ -1,5 +1,16 @@
 #include "Rx2DecoderExtension.h"
+#include "Rx2AnalysisCache.h"
+#include "Rx2CallLog.h"
 #include "Rx2Decoder.h"
+#include "Rx2LibraryIndex.h"
+#include "Rx2Metrics.h"
+#include "Rx2NegativeCache.h"
+#include "Rx2Prefetcher.h"
+#include "Rx2RexLibrary.h"
+#include "Rx2RexShim.h"
+#include "Rx2Settings.h"
+#include "Rx2SliceTrack.h"
+#include "Rx2Trace.h"
 #include "apiObjects.h"
 #include "RexSdk.h"
 #include <windows.h>
@@ -89,6 +100,9 @@ static const wchar_t* GetRexErrorMessageShort(REX::REXError err,
     case kRexError_NoActiveSlices:
         return L"This ReCycle file does not contain any active slices.";
 
+    case kRexError_CreateTimedOut:
+        return L"The REX library took too long to open this file. It may be damaged.";
+
     case REX::kREXError_OutOfMemory:
         return L"Not enough memory to load this REX file.";
 
@@ -193,6 +207,8 @@ static bool PreflightStream(IAIMPCore* core,
                             IAIMPErrorInfo* errorInfo,
                             REX::REXError& outErr)
 {
+    RX2_TRACE_SCOPE("PreflightStream");
+
     outErr = REX::kREXError_NoError;
 
     if (!stream)
@@ -207,7 +223,7 @@ static bool PreflightStream(IAIMPCore* core,
     if (size >= 12)
     {
         BYTE hdr[12] = {0};
-        int r = stream->Read(hdr, static_cast<int>(sizeof(hdr)));
+        int r = RX2_TRACE_CALL("IAIMPStream::Read", stream->Read(hdr, static_cast<int>(sizeof(hdr))));
         stream->Seek(0, AIMP_STREAM_SEEKMODE_FROM_BEGINNING);
         if (r == sizeof(hdr)
             && memcmp(hdr, "RIFF", 4) == 0
@@ -217,6 +233,14 @@ static bool PreflightStream(IAIMPCore* core,
         }
     }
 
+    // First REX file of the session: load the REX Shared Library now.
+    REX::REXError libErr = RX2_TRACE_CALL("Rx2EnsureRexLibrary", Rx2EnsureRexLibrary());
+    if (libErr != REX::kREXError_NoError)
+    {
+        outErr = libErr;
+        return false;
+    }
+
     // Read up to 1 MB for fast header validation; fall back to full file on doubt.
     const INT64 kMaxPreflight = 1024 * 1024;
     INT64 toRead = size;
@@ -239,7 +263,7 @@ static bool PreflightStream(IAIMPCore* core,
     {
         INT64 remaining = toRead - readBytes;
         int chunk = static_cast<int>(remaining > 64 * 1024 ? 64 * 1024 : remaining);
-        int r = stream->Read(data.data() + readBytes, chunk);
+        int r = RX2_TRACE_CALL("IAIMPStream::Read", stream->Read(data.data() + readBytes, chunk));
         if (r <= 0)
             break;
         readBytes += r;
@@ -251,11 +275,11 @@ static bool PreflightStream(IAIMPCore* core,
         return false;
 
     REX::REXInfo preInfo{};
-    REX::REXError preErr = REX::REXGetInfoFromBuffer(
+    REX::REXError preErr = RX2_TRACE_CALL("REXGetInfoFromBuffer", Rx2RexApi::REXGetInfoFromBuffer(
         static_cast<REX::REX_int32_t>(readBytes),
         reinterpret_cast<const char*>(data.data()),
         static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)),
-        &preInfo);
+        &preInfo));
 
     // If the truncated read reports FileCorrupt, retry with the full file to avoid false positives.
     if (preErr == REX::kREXError_FileCorrupt && toRead < size)
@@ -277,7 +301,7 @@ static bool PreflightStream(IAIMPCore* core,
         {
             INT64 remaining = size - readBytes;
             int chunk = static_cast<int>(remaining > 64 * 1024 ? 64 * 1024 : remaining);
-            int r = stream->Read(data.data() + readBytes, chunk);
+            int r = RX2_TRACE_CALL("IAIMPStream::Read", stream->Read(data.data() + readBytes, chunk));
             if (r <= 0)
                 break;
             readBytes += r;
@@ -288,60 +312,51 @@ static bool PreflightStream(IAIMPCore* core,
         if (readBytes <= 0)
             return false;
 
-        preErr = REX::REXGetInfoFromBuffer(
+        preErr = RX2_TRACE_CALL("REXGetInfoFromBuffer", Rx2RexApi::REXGetInfoFromBuffer(
             static_cast<REX::REX_int32_t>(readBytes),
             reinterpret_cast<const char*>(data.data()),
             static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)),
-            &preInfo);
+            &preInfo));
     }
 
     outErr = preErr;
 
     if (preErr == REX::kREXError_NoError)
     {
-        bool headerOk = true;
-        REX::REXError finalErr = preErr;
-
-        if (preInfo.fPPQLength <= 0)
-        {
-            headerOk = false;
-            finalErr = REX::kREXError_FileHasZeroLoopLength;
-        }
-
-        // Bars/Beats not set -> both tempo fields zero.
-        if (preInfo.fTempo <= 0 && preInfo.fOriginalTempo <= 0)
-        {
-            headerOk = false;
-            finalErr = REX::kREXError_FileHasZeroLoopLength;
-        }
-
-        if (preInfo.fChannels <= 0 || preInfo.fChannels > 2)
-        {
-            headerOk = false;
-            finalErr = REX::kREXError_FileCorrupt;
-        }
+        outErr = Rx2PreflightHeaderError(preInfo);
+        return outErr == REX::kREXError_NoError;
+    }
 
-        if (preInfo.fSampleRate <= 0 || preInfo.fSampleRate > 192000)
-        {
-            headerOk = false;
-            finalErr = REX::kREXError_FileCorrupt;
-        }
+    return false;
+}
 
-        if (!headerOk)
-        {
-            outErr = finalErr;
-            return false;
-        }
+// Bookkeeping shared by every exit of CreateDecoder: the metrics and, when
+// recording, the call log.
+struct OpenCall
+{
+    std::int64_t started;      // Rx2MetricNow()
+    std::int64_t logStartUs;   // Rx2CallLogNowUs()
+    std::int64_t logArg;       // Rx2CallOpenArg()
+};
 
-        outErr = REX::kREXError_NoError;
-        return true;
-    }
+static HRESULT CountRejected(const OpenCall& call, REX::REXError err)
+{
+    Rx2MetricReject(err);
+    Rx2MetricRecordUs(Rx2Histogram::RejectUs, Rx2MetricElapsedUs(call.started));
+    Rx2CallLogRecord(kRx2CallCreateDecoder, 0, call.logArg, E_FAIL, call.logStartUs);
+    return E_FAIL;
+}
 
-    return false;
+static HRESULT CountOpened(const OpenCall& call, const Rx2Decoder* decoder)
+{
+    Rx2MetricAdd(Rx2Counter::Opens);
+    Rx2MetricRecordUs(Rx2Histogram::OpenUs, Rx2MetricElapsedUs(call.started));
+    Rx2CallLogRecord(kRx2CallCreateDecoder, decoder->CallLogId(), call.logArg, S_OK, call.logStartUs);
+    return S_OK;
 }
 
 HRESULT WINAPI Rx2DecoderExtension::CreateDecoder(IAIMPStream* Stream,
-                                                  LongWord /*Flags*/,
+                                                  LongWord Flags,
                                                   IAIMPErrorInfo* ErrorInfo,
                                                   IAIMPAudioDecoder** Decoder)
 {
@@ -350,41 +365,128 @@ HRESULT WINAPI Rx2DecoderExtension::CreateDecoder(IAIMPStream* Stream,
 
     *Decoder = nullptr;
 
+    RX2_TRACE_SCOPE("Rx2DecoderExtension::CreateDecoder");
+
+    OpenCall call = { Rx2MetricNow(), Rx2CallLogNowUs(), 0 };
+    Rx2MetricAdd(Rx2Counter::OpenAttempts);
+
+    // Streams opened for a slice sub-track carry the slice to render.
+    int sliceIndex = -1;
+    {
+        IRx2SliceSource* slice = nullptr;
+        if (SUCCEEDED(Stream->QueryInterface(IID_IRx2SliceSource, (void**)&slice)) && slice)
+        {
+            sliceIndex = slice->GetSliceIndex();
+            slice->Release();
+        }
+    }
+
+    Rx2FileKey fileKey;
+    const bool haveKey = RX2_TRACE_CALL("Rx2MakeFileKey", Rx2MakeFileKey(Stream, &fileKey));
+    if (Rx2CallLogEnabled())
+        call.logArg = Rx2CallOpenArg(Rx2CallLogFileId(fileKey.path), sliceIndex, Flags);
+
+    // Files that already failed validation fail again without any REX work.
+    REX::REXError cachedErr = REX::kREXError_NoError;
+    if (haveKey && Rx2NegativeCacheLookup(fileKey, &cachedErr))
+    {
+        Rx2MetricAdd(Rx2Counter::NegativeCacheHits);
+        SetErrorInfoFromRexError(m_core, ErrorInfo, cachedErr);
+        return CountRejected(call, cachedErr);
+    }
+    if (haveKey)
+        Rx2MetricAdd(Rx2Counter::NegativeCacheMisses);
+
+    // Files the library index has seen: bad ones fail without any REX work
+    // (the index holds the same verdict a full open would reach), good ones
+    // skip the preflight.
+    bool indexed = false;
+    Rx2IndexEntry indexEntry;
+    if (haveKey && Rx2LibraryIndexLookup(fileKey, &indexEntry))
+    {
+        if (indexEntry.status == kRx2IndexNotRex)
+            return CountRejected(call, REX::kREXError_NoError);
+
+        if (indexEntry.status != kRx2IndexOk)
+        {
+            const REX::REXError err = static_cast<REX::REXError>(indexEntry.rexError);
+            SetErrorInfoFromRexError(m_core, ErrorInfo, err);
+            return CountRejected(call, err);
+        }
+        indexed = true;
+    }
+
+    // Already rendered in the background while the previous track played.
+    if (haveKey && sliceIndex < 0)
+    {
+        if (Rx2Decoder* prefetched = Rx2PrefetchAdopt(fileKey))
+        {
+            Rx2MetricAdd(Rx2Counter::PrefetchHits);
+            *Decoder = prefetched;
+            return CountOpened(call, prefetched);
+        }
+        if (Rx2GetSettings().prefetchNext)
+            Rx2MetricAdd(Rx2Counter::PrefetchMisses);
+    }
+
     // Preflight before constructing decoder to block obvious non-REX files.
+    // Indexed files only need the REX library, which it would have loaded.
     REX::REXError preErr = REX::kREXError_NoError;
-    if (!PreflightStream(m_core, Stream, ErrorInfo, preErr))
+    if (indexed)
+    {
+        const REX::REXError libErr = RX2_TRACE_CALL("Rx2EnsureRexLibrary", Rx2EnsureRexLibrary());
+        if (libErr != REX::kREXError_NoError)
+        {
+            SetErrorInfoFromRexError(m_core, ErrorInfo, libErr);
+            return CountRejected(call, libErr);
+        }
+    }
+    else if (!PreflightStream(m_core, Stream, ErrorInfo, preErr))
     {
         if (preErr != REX::kREXError_NoError)
         {
             // REX headers are present but invalid.
+            if (haveKey)
+                Rx2NegativeCacheStore(fileKey, preErr);
+
             SetErrorInfoFromRexError(m_core, ErrorInfo, preErr);
-            return E_FAIL;
+            return CountRejected(call, preErr);
         }
 
-        return E_FAIL;
+        return CountRejected(call, REX::kREXError_NoError);
     }
 
-    Rx2Decoder* d = new Rx2Decoder(m_core, Stream, false /*skipPreflight*/);
+    Rx2Decoder* d = new Rx2Decoder(m_core, Stream, indexed /*skipPreflight*/, sliceIndex);
 
     if (!d->IsValid() || d->HasError())
     {
+        const REX::REXError err = d->HasError() ? d->GetLastError()
+                                                : REX::kREXError_FileCorrupt;
+        // A bad slice says nothing about the rest of the file.
+        if (haveKey && sliceIndex < 0)
+            Rx2NegativeCacheStore(fileKey, err);
+
         if (ErrorInfo && m_core)
         {
-            if (d->HasError())
-                SetErrorInfoFromRexError(m_core, ErrorInfo, d->GetLastError());
-            else
-                SetErrorInfoFromRexError(m_core, ErrorInfo, REX::kREXError_FileCorrupt);
+            SetErrorInfoFromRexError(m_core, ErrorInfo, err);
 
             d->Release();
             *Decoder = nullptr;
-            return E_FAIL;
+            return CountRejected(call, err);
         }
 
         d->Release();
         *Decoder = nullptr;
-        return E_FAIL;
+        return CountRejected(call, err);
+    }
+
+    // Analysis is per file; a slice's would overwrite the loop's.
+    if (haveKey && sliceIndex < 0)
+    {
+        Rx2StoreCachedPeaks(fileKey, d->Peaks());
+        Rx2StoreCachedLoudness(fileKey, d->Loudness());
     }
 
     *Decoder = d;
-    return S_OK;
+    return CountOpened(call, d);
 }
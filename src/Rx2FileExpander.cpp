@@ -0,0 +1,269 @@
+#include "Rx2FileExpander.h"
+#include "Rx2AnalysisCache.h"
+#include "Rx2FileKey.h"
+#include "Rx2Loudness.h"
+#include "Rx2RexLibrary.h"
+#include "Rx2RexShim.h"
+#include "Rx2SliceTrack.h"
+#include "apiObjects.h"
+#include "RexSdk.h"
+
+#include <cwchar>
+#include <new>
+#include <string>
+#include <windows.h>
+
+// ---------------- helpers ----------------
+
+static bool HasRexExtension(const std::wstring& path)
+{
+    const size_t dot = path.find_last_of(L'.');
+    if (dot == std::wstring::npos)
+        return false;
+
+    const wchar_t* ext = path.c_str() + dot;
+    return _wcsicmp(ext, L".rx2") == 0
+        || _wcsicmp(ext, L".rex") == 0
+        || _wcsicmp(ext, L".rcy") == 0;
+}
+
+// Reads the whole file through AIMP's file streaming service into a new[]
+// buffer, as Rx2CreateRexHandle takes it. `*haveKey` says whether `key`
+// (the analysis cache's identity of the file) could be built.
+static bool ReadWholeFile(IAIMPCore* core, IAIMPString* fileName, std::uint8_t** data, std::int64_t* dataSize,
+                          Rx2FileKey* key, bool* haveKey)
+{
+    *data     = nullptr;
+    *dataSize = 0;
+    *haveKey  = false;
+
+    IAIMPServiceFileStreaming* streaming = nullptr;
+    if (FAILED(core->QueryInterface(IID_IAIMPServiceFileStreaming, (void**)&streaming)) || !streaming)
+        return false;
+
+    IAIMPStream* stream = nullptr;
+    if (FAILED(streaming->CreateStreamForFile(fileName, AIMP_SERVICE_FILESTREAMING_FLAG_READ,
+                                              -1, -1, &stream)))
+        stream = nullptr;
+    streaming->Release();
+
+    if (!stream)
+        return false;
+
+    *haveKey = Rx2MakeFileKey(stream, key);
+
+    bool ok = false;
+    const INT64 size = stream->GetSize();
+    std::uint8_t* buffer = (size > 0 && size < 0x7FFFFFFF)
+        ? new (std::nothrow) std::uint8_t[static_cast<size_t>(size)]
+        : nullptr;
+    if (buffer)
+    {
+        INT64 got = 0;
+        while (got < size)
+        {
+            const INT64 remaining = size - got;
+            const int   toRead    = static_cast<int>(remaining > 64 * 1024 ? 64 * 1024 : remaining);
+            const int   r         = stream->Read(buffer + got, toRead);
+            if (r <= 0)
+                break;
+            got += r;
+        }
+        ok = (got == size);
+    }
+
+    stream->Release();
+
+    if (!ok)
+    {
+        delete[] buffer;
+        return false;
+    }
+
+    *data     = buffer;
+    *dataSize = size;
+    return true;
+}
+
+// Creates one virtual file entry and appends it to `list`. `loudness`, if
+// given, is reported as the entry's ReplayGain.
+static bool AddEntry(IAIMPCore* core, IAIMPObjectList* list, const std::wstring& path,
+                     int sliceIndex, int sampleRate, int channels, std::int64_t frames,
+                     const Rx2Loudness* loudness = nullptr)
+{
+    IAIMPVirtualFile* inner = nullptr;
+    if (FAILED(core->CreateObject(IID_IAIMPVirtualFile, (void**)&inner)) || !inner)
+        return false;
+
+    // "<file>:0" is the whole loop, "<file>:N" slice N (1-based).
+    wchar_t suffix[16];
+    _snwprintf_s(suffix, _countof(suffix), _TRUNCATE, L":%d", sliceIndex + 1);
+    const std::wstring uri = path + suffix;
+
+    IAIMPString* uriStr  = nullptr;
+    IAIMPString* pathStr = nullptr;
+    if (SUCCEEDED(core->CreateObject(IID_IAIMPString, (void**)&uriStr)) &&
+        SUCCEEDED(core->CreateObject(IID_IAIMPString, (void**)&pathStr)))
+    {
+        uriStr->SetData(const_cast<wchar_t*>(uri.c_str()), static_cast<int>(uri.length()));
+        pathStr->SetData(const_cast<wchar_t*>(path.c_str()), static_cast<int>(path.length()));
+
+        inner->SetValueAsObject(AIMP_VIRTUALFILE_PROPID_FILEURI, uriStr);
+        inner->SetValueAsObject(AIMP_VIRTUALFILE_PROPID_AUDIOSOURCEFILE, pathStr);
+        inner->SetValueAsInt32(AIMP_VIRTUALFILE_PROPID_INDEXINSET, sliceIndex + 1);
+    }
+    if (uriStr)
+        uriStr->Release();
+    if (pathStr)
+        pathStr->Release();
+
+    Rx2SliceFile* entry = new Rx2SliceFile(core, inner, path, sliceIndex, sampleRate, channels, frames);
+    inner->Release();
+
+    if (loudness && loudness->HasResult())
+        entry->SetReplayGain(loudness->TrackGainDb(), loudness->TruePeak());
+
+    const bool added = SUCCEEDED(list->Add(static_cast<IAIMPVirtualFile*>(entry)));
+    entry->Release();
+    return added;
+}
+
+// ---------------- Rx2FileExpander ----------------
+
+Rx2FileExpander::Rx2FileExpander(IAIMPCore* core)
+    : m_refCount(1)
+    , m_core(core)
+{
+    if (m_core)
+        m_core->AddRef();
+}
+
+Rx2FileExpander::~Rx2FileExpander()
+{
+    if (m_core)
+        m_core->Release();
+}
+
+// IUnknown
+
+HRESULT WINAPI Rx2FileExpander::QueryInterface(REFIID riid, void **ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IAIMPExtensionFileExpander)
+    {
+        *ppv = static_cast<IAIMPExtensionFileExpander*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2FileExpander::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2FileExpander::Release()
+{
+    ULONG r = InterlockedDecrement(&m_refCount);
+    if (r == 0)
+        delete this;
+    return r;
+}
+
+// IAIMPExtensionFileExpander
+
+HRESULT WINAPI Rx2FileExpander::Expand(IAIMPString *FileName, IAIMPObjectList **List,
+                                       IAIMPProgressCallback *ProgressCallback)
+{
+    if (!FileName || !List)
+        return E_POINTER;
+    *List = nullptr;
+
+    if (!m_core)
+        return E_FAIL;
+
+    const std::wstring path(FileName->GetData(), static_cast<size_t>(FileName->GetLength()));
+    if (!HasRexExtension(path))
+        return E_FAIL;
+
+    if (Rx2EnsureRexLibrary() != REX::kREXError_NoError)
+        return E_FAIL;
+
+    std::uint8_t* data     = nullptr;
+    std::int64_t  dataSize = 0;
+    Rx2FileKey    fileKey;
+    bool          haveKey  = false;
+    if (!ReadWholeFile(m_core, FileName, &data, &dataSize, &fileKey, &haveKey))
+        return E_FAIL;
+
+    REX::REXHandle handle = nullptr;
+    REX::REXError  err    = REX::kREXError_NoError;
+    const bool created = Rx2CreateRexHandle(data, dataSize, &handle, &err);
+
+    if (!created || !handle)
+        return E_FAIL;
+
+    REX::REXInfo info{};
+    err = Rx2RexApi::REXGetInfo(handle, static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)), &info);
+
+    // Nothing to split: let AIMP add the file as a single track.
+    if (err != REX::kREXError_NoError || info.fSliceCount <= 1)
+    {
+        Rx2RexApi::REXDelete(&handle);
+        return E_FAIL;
+    }
+
+    // Same rate the decoder plays at, so slice lengths match what it renders.
+    const int sampleRate = (info.fSampleRate > 0) ? info.fSampleRate : 44100;
+    Rx2RexApi::REXSetOutputSampleRate(handle, static_cast<REX::REX_int32_t>(sampleRate));
+
+    IAIMPObjectList* list = nullptr;
+    if (FAILED(m_core->CreateObject(IID_IAIMPObjectList, (void**)&list)) || !list)
+    {
+        Rx2RexApi::REXDelete(&handle);
+        return E_FAIL;
+    }
+
+    // The whole-loop entry carries the loudness measured when the loop was
+    // last played (slices have none of their own), so a playlist shows
+    // ReplayGain without rendering anything.
+    Rx2Loudness loudness;
+    const bool  haveLoudness = haveKey && Rx2LoadCachedLoudness(fileKey, &loudness);
+    AddEntry(m_core, list, path, -1, sampleRate, info.fChannels, 0,
+             haveLoudness ? &loudness : nullptr);
+
+    for (REX::REX_int32_t i = 0; i < info.fSliceCount; ++i)
+    {
+        REX::REXSliceInfo slice{};
+        if (Rx2RexApi::REXGetSliceInfo(handle, i, static_cast<REX::REX_int32_t>(sizeof(REX::REXSliceInfo)),
+                                       &slice) == REX::kREXError_NoError
+            && slice.fSampleLength > 0)
+        {
+            AddEntry(m_core, list, path, i, sampleRate, info.fChannels, slice.fSampleLength);
+        }
+
+        if (ProgressCallback && (i & 15) == 15)
+        {
+            BOOL abort = FALSE;
+            ProgressCallback->Process(static_cast<float>(i + 1) / info.fSliceCount, &abort);
+            if (abort)
+                break;
+        }
+    }
+
+    Rx2RexApi::REXDelete(&handle);
+
+    if (list->GetCount() <= 1)
+    {
+        list->Release();
+        return E_FAIL;
+    }
+
+    *List = list;
+    return S_OK;
+}
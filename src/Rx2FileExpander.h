@@ -0,0 +1,28 @@
+#pragma once
+
+#include "apiFileManager.h"
+#include "apiCore.h"
+
+// Optional slice mode: expands a REX file into virtual tracks, the whole
+// loop first and then one per slice reported by REXGetSliceInfo, much like
+// a CUE sheet. Expanding parses the file but renders nothing; a slice
+// track renders only its own slice when it is opened.
+class Rx2FileExpander : public IAIMPExtensionFileExpander
+{
+public:
+    explicit Rx2FileExpander(IAIMPCore* core);
+    virtual ~Rx2FileExpander();
+
+    // IUnknown
+    HRESULT WINAPI QueryInterface(REFIID riid, void **ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    // IAIMPExtensionFileExpander
+    HRESULT WINAPI Expand(IAIMPString *FileName, IAIMPObjectList **List,
+                          IAIMPProgressCallback *ProgressCallback) override;
+
+private:
+    LONG       m_refCount;
+    IAIMPCore* m_core;
+};
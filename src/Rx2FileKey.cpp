@@ -0,0 +1,58 @@
+#include "Rx2FileKey.h"
+#include "apiFileManager.h"
+
+#include <windows.h>
+
+bool Rx2MakeFileKey(IAIMPStream* stream, Rx2FileKey* key)
+{
+    if (!stream || !key)
+        return false;
+
+    IAIMPFileStream* fileStream = nullptr;
+    if (FAILED(stream->QueryInterface(IID_IAIMPFileStream, (void**)&fileStream)) || !fileStream)
+        return false;
+
+    IAIMPString* name = nullptr;
+    HRESULT hr = fileStream->GetFileName(&name);
+    fileStream->Release();
+    if (FAILED(hr) || !name)
+        return false;
+
+    key->path.assign(name->GetData(), static_cast<size_t>(name->GetLength()));
+    name->Release();
+    if (key->path.empty())
+        return false;
+
+    WIN32_FILE_ATTRIBUTE_DATA attr{};
+    if (!GetFileAttributesExW(key->path.c_str(), GetFileExInfoStandard, &attr))
+        return false;
+
+    key->mtime = (static_cast<std::uint64_t>(attr.ftLastWriteTime.dwHighDateTime) << 32)
+               | attr.ftLastWriteTime.dwLowDateTime;
+    key->size  = stream->GetSize();
+
+    BYTE header[4096];
+    stream->Seek(0, AIMP_STREAM_SEEKMODE_FROM_BEGINNING);
+    int r = stream->Read(header, static_cast<int>(sizeof(header)));
+    stream->Seek(0, AIMP_STREAM_SEEKMODE_FROM_BEGINNING);
+    if (r < 0)
+        r = 0;
+
+    std::uint32_t hash = 2166136261u;
+    for (int i = 0; i < r; ++i)
+    {
+        hash ^= header[i];
+        hash *= 16777619u;
+    }
+    key->headerHash = hash;
+
+    return true;
+}
+
+bool Rx2IsSameFile(const Rx2FileKey& a, const Rx2FileKey& b)
+{
+    return a.size == b.size
+        && a.mtime == b.mtime
+        && a.headerHash == b.headerHash
+        && _wcsicmp(a.path.c_str(), b.path.c_str()) == 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "apiObjects.h"
+
+#include <cstdint>
+#include <string>
+
+// Identity of a file as seen by CreateDecoder. A file that is edited in
+// place changes size, mtime or header bytes and so no longer matches.
+struct Rx2FileKey
+{
+    std::wstring  path;
+    std::int64_t  size;
+    std::uint64_t mtime;        // FILETIME of the last write
+    std::uint32_t headerHash;   // FNV-1a of the first 4 KB
+};
+
+// Builds the key for a stream, reading its first 4 KB and rewinding it.
+// Returns false for streams that are not backed by a named file.
+bool Rx2MakeFileKey(IAIMPStream* stream, Rx2FileKey* key);
+
+// Same path (case-insensitive) and same size, mtime and header.
+bool Rx2IsSameFile(const Rx2FileKey& a, const Rx2FileKey& b);
@@ -0,0 +1,367 @@
+#include "Rx2IndexFormat.h"
+#include "Rx2RexBackend.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// ---------------- helpers ----------------
+
+static char16_t FoldAscii(char16_t c)
+{
+    return (c >= u'A' && c <= u'Z') ? static_cast<char16_t>(c - u'A' + u'a') : c;
+}
+
+std::uint64_t Rx2IndexPathHash(const char16_t* path, std::size_t units)
+{
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < units; ++i)
+    {
+        const std::uint32_t c = FoldAscii(path[i]);
+        hash ^= c & 0xFF;
+        hash *= 1099511628211ull;
+        hash ^= c >> 8;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static bool InBounds(std::uint64_t offset, std::uint64_t bytes, std::uint64_t size)
+{
+    return offset <= size && bytes <= size - offset;
+}
+
+// Size and last-write FILETIME, as Rx2MakeFileKey sees them.
+static bool StatFile(const std::filesystem::path& file, std::int64_t* size, std::uint64_t* mtime)
+{
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA attr{};
+    if (!GetFileAttributesExW(file.c_str(), GetFileExInfoStandard, &attr))
+        return false;
+
+    *mtime = (static_cast<std::uint64_t>(attr.ftLastWriteTime.dwHighDateTime) << 32)
+           | attr.ftLastWriteTime.dwLowDateTime;
+    *size  = (static_cast<std::int64_t>(attr.nFileSizeHigh) << 32) | attr.nFileSizeLow;
+#else
+    struct stat st;
+    if (stat(file.c_str(), &st) != 0)
+        return false;
+
+    // FILETIME counts 100 ns intervals from 1601-01-01.
+    const std::uint64_t kEpochDelta = 116444736000000000ull;
+    *mtime = kEpochDelta
+           + static_cast<std::uint64_t>(st.st_mtim.tv_sec) * 10000000u
+           + static_cast<std::uint64_t>(st.st_mtim.tv_nsec) / 100u;
+    *size  = static_cast<std::int64_t>(st.st_size);
+#endif
+    return true;
+}
+
+static FILE* OpenFile(const std::filesystem::path& file, bool write)
+{
+#ifdef _WIN32
+    return _wfopen(file.c_str(), write ? L"wb" : L"rb");
+#else
+    return fopen(file.c_str(), write ? "wb" : "rb");
+#endif
+}
+
+// ---------------- Rx2IndexView ----------------
+
+bool Rx2IndexView::Attach(const void* data, std::size_t size)
+{
+    m_base    = nullptr;
+    m_size    = 0;
+    m_header  = nullptr;
+    m_entries = nullptr;
+
+    if (!data || size < sizeof(Rx2IndexHeader) || (reinterpret_cast<std::uintptr_t>(data) & 7) != 0)
+        return false;
+
+    const Rx2IndexHeader* header = static_cast<const Rx2IndexHeader*>(data);
+    if (memcmp(header->magic, kRx2IndexMagic, sizeof(header->magic)) != 0
+        || header->version != kRx2IndexVersion
+        || header->entrySize != sizeof(Rx2IndexEntry)
+        || (header->entriesOffset & 7) != 0
+        || !InBounds(header->entriesOffset,
+                     static_cast<std::uint64_t>(header->entryCount) * sizeof(Rx2IndexEntry), size)
+        || !InBounds(header->stringsOffset, header->stringsBytes, size))
+    {
+        return false;
+    }
+
+    m_base    = static_cast<const std::uint8_t*>(data);
+    m_size    = size;
+    m_header  = header;
+    m_entries = reinterpret_cast<const Rx2IndexEntry*>(m_base + header->entriesOffset);
+    return true;
+}
+
+const Rx2IndexEntry* Rx2IndexView::Find(const char16_t* path, std::size_t units, std::int64_t size,
+                                        std::uint64_t mtime, std::uint32_t headerHash) const
+{
+    if (!m_header || !path)
+        return nullptr;
+
+    const std::uint64_t  hash  = Rx2IndexPathHash(path, units);
+    const Rx2IndexEntry* begin = m_entries;
+    const Rx2IndexEntry* end   = m_entries + m_header->entryCount;
+    const Rx2IndexEntry* it    = std::lower_bound(begin, end, hash,
+        [](const Rx2IndexEntry& e, std::uint64_t h) { return e.pathHash < h; });
+
+    for (; it != end && it->pathHash == hash; ++it)
+    {
+        if (it->size != size || it->mtime != mtime || it->headerHash != headerHash)
+            continue;
+        if (it->path.bytes != units * sizeof(char16_t)
+            || !InBounds(it->path.offset, it->path.bytes, m_header->stringsBytes))
+            continue;
+
+        const std::uint8_t* stored = m_base + m_header->stringsOffset + it->path.offset;
+        bool same = true;
+        for (std::size_t i = 0; i < units && same; ++i)
+        {
+            const char16_t c = static_cast<char16_t>(stored[2 * i] | (stored[2 * i + 1] << 8));
+            same = FoldAscii(c) == FoldAscii(path[i]);
+        }
+        if (same)
+            return it;
+    }
+    return nullptr;
+}
+
+std::u16string Rx2IndexView::Utf16(const Rx2IndexString& s) const
+{
+    std::u16string out;
+    if (!m_header || (s.bytes & 1) != 0 || !InBounds(s.offset, s.bytes, m_header->stringsBytes))
+        return out;
+
+    const std::uint8_t* p = m_base + m_header->stringsOffset + s.offset;
+    out.resize(s.bytes / 2);
+    for (std::size_t i = 0; i < out.size(); ++i)
+        out[i] = static_cast<char16_t>(p[2 * i] | (p[2 * i + 1] << 8));
+    return out;
+}
+
+std::string Rx2IndexView::Utf8(const Rx2IndexString& s) const
+{
+    if (!m_header || !InBounds(s.offset, s.bytes, m_header->stringsBytes))
+        return std::string();
+
+    const char* p = reinterpret_cast<const char*>(m_base + m_header->stringsOffset + s.offset);
+    return std::string(p, s.bytes);
+}
+
+// ---------------- scanning ----------------
+
+static void SetStatus(Rx2IndexRecord* record, Rx2IndexStatus status, REX::REXError err)
+{
+    record->entry.status   = status;
+    record->entry.rexError = static_cast<std::int32_t>(err);
+}
+
+bool Rx2IndexScanFile(const std::filesystem::path& file, Rx2IndexRecord* record, REX::REXError* err)
+{
+    *err    = REX::kREXError_NoError;
+    *record = Rx2IndexRecord();
+    Rx2IndexEntry& e = record->entry;
+
+    if (!StatFile(file, &e.size, &e.mtime) || e.size < 0 || e.size > INT32_MAX)
+        return false;
+
+    // The whole file, in a new[] buffer that Rx2Loop::Open() can take. Scans
+    // run on worker threads, so a file too large for memory is left out
+    // rather than ending the run with bad_alloc.
+    std::uint8_t* data = new (std::nothrow) std::uint8_t[static_cast<std::size_t>(e.size) + 1];
+    if (!data)
+    {
+        *err = REX::kREXError_OutOfMemory;
+        return false;
+    }
+
+    FILE* f = OpenFile(file, false);
+    const std::size_t got = f ? fread(data, 1, static_cast<std::size_t>(e.size), f) : 0;
+    if (f)
+        fclose(f);
+    if (!f || got != static_cast<std::size_t>(e.size))
+    {
+        delete[] data;
+        return false;
+    }
+
+    std::uint32_t headerHash = 2166136261u;
+    for (std::size_t i = 0; i < got && i < 4096; ++i)
+    {
+        headerHash ^= data[i];
+        headerHash *= 16777619u;
+    }
+    std::uint64_t contentHash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < got; ++i)
+    {
+        contentHash ^= data[i];
+        contentHash *= 1099511628211ull;
+    }
+    e.headerHash  = headerHash;
+    e.contentHash = contentHash;
+
+    // PreflightStream: empty streams and WAV files are not REX files.
+    if (e.size == 0 || (e.size >= 12 && memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "WAVE", 4) == 0))
+    {
+        delete[] data;
+        SetStatus(record, kRx2IndexNotRex, REX::kREXError_NoError);
+        return true;
+    }
+
+    REX::REXInfo info{};
+    REX::REXError result = Rx2RexBackend::GetInfoFromBuffer(
+        static_cast<REX::REX_int32_t>(e.size),
+        reinterpret_cast<const char*>(data),
+        static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)),
+        &info);
+
+    if (result == REX::kREXError_NoError)
+    {
+        e.channels      = info.fChannels;
+        e.sampleRate    = info.fSampleRate;
+        e.bitDepth      = info.fBitDepth;
+        e.sliceCount    = info.fSliceCount;
+        e.tempo         = info.fTempo;
+        e.originalTempo = info.fOriginalTempo;
+        e.ppqLength     = info.fPPQLength;
+        e.timeSignNom   = info.fTimeSignNom;
+        e.timeSignDenom = info.fTimeSignDenom;
+        e.loopFrames    = Rx2LoopLengthFrames(info, info.fSampleRate > 0 ? info.fSampleRate : 44100,
+                                              info.fTempo > 0 ? info.fTempo : info.fOriginalTempo);
+        result = Rx2PreflightHeaderError(info);
+    }
+
+    if (result != REX::kREXError_NoError)
+    {
+        delete[] data;
+        *err = result;
+        if (Rx2IsTransientRexError(result))
+            return false;
+        SetStatus(record, kRx2IndexBad, result);
+        return true;
+    }
+
+    // Then what Rx2Decoder does with it, rendering included: only the
+    // render finds loops with no active slices. Storage is kept small.
+    Rx2LoopOptions options;
+    options.pcmStorageBits      = 16;
+    options.pcmMinStorageBits   = 16;
+    options.pcmCompression      = false;
+    options.pcmSpillThresholdMB = 256;
+    options.sliceIndex          = -1;
+    options.skipPreflight       = false;
+    options.sampleRate          = 0;
+    options.tempo               = 0;
+
+    Rx2Loop loop;
+    loop.Open(data, e.size, options);
+
+    if (!loop.IsValid() || loop.HasError())
+    {
+        result = loop.HasError() ? loop.LastError() : REX::kREXError_FileCorrupt;
+        *err   = result;
+        if (Rx2IsTransientRexError(result))
+            return false;
+        SetStatus(record, kRx2IndexBad, result);
+        return true;
+    }
+
+    record->creator = loop.Creator();
+    SetStatus(record, kRx2IndexOk, REX::kREXError_NoError);
+    return true;
+}
+
+// ---------------- writing ----------------
+
+static Rx2IndexString AddString(std::vector<std::uint8_t>& pool, const void* data, std::size_t bytes)
+{
+    Rx2IndexString s;
+    s.offset = static_cast<std::uint32_t>(pool.size());
+    s.bytes  = static_cast<std::uint32_t>(bytes);
+    pool.insert(pool.end(), static_cast<const std::uint8_t*>(data),
+                static_cast<const std::uint8_t*>(data) + bytes);
+    return s;
+}
+
+bool Rx2IndexWrite(const std::filesystem::path& path, std::vector<Rx2IndexRecord>& records)
+{
+    std::vector<Rx2IndexEntry> entries;
+    std::vector<std::uint8_t>  pool;
+    entries.reserve(records.size());
+
+    for (Rx2IndexRecord& record : records)
+    {
+        Rx2IndexEntry e = record.entry;
+        e.pathHash = Rx2IndexPathHash(record.path.data(), record.path.size());
+
+        std::vector<std::uint8_t> units;
+        for (char16_t c : record.path)
+        {
+            units.push_back(static_cast<std::uint8_t>(c & 0xFF));
+            units.push_back(static_cast<std::uint8_t>(c >> 8));
+        }
+        e.path = AddString(pool, units.data(), units.size());
+
+        const std::string* creator[kRx2IndexCreatorFields] =
+        {
+            &record.creator.name, &record.creator.copyright, &record.creator.url,
+            &record.creator.email, &record.creator.freeText
+        };
+        for (int i = 0; i < kRx2IndexCreatorFields; ++i)
+            e.creator[i] = AddString(pool, creator[i]->data(), creator[i]->size());
+
+        entries.push_back(e);
+    }
+
+    if (pool.size() > UINT32_MAX)
+        return false;
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const Rx2IndexEntry& a, const Rx2IndexEntry& b) { return a.pathHash < b.pathHash; });
+
+    Rx2IndexHeader header{};
+    memcpy(header.magic, kRx2IndexMagic, sizeof(header.magic));
+    header.version       = kRx2IndexVersion;
+    header.entrySize     = sizeof(Rx2IndexEntry);
+    header.entryCount    = static_cast<std::uint32_t>(entries.size());
+    header.entriesOffset = sizeof(Rx2IndexHeader);
+    header.stringsOffset = header.entriesOffset + entries.size() * sizeof(Rx2IndexEntry);
+    header.stringsBytes  = pool.size();
+
+    std::filesystem::path temp = path;
+    temp += ".tmp";
+
+    FILE* f = OpenFile(temp, true);
+    if (!f)
+        return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    if (ok && !entries.empty())
+        ok = fwrite(entries.data(), sizeof(Rx2IndexEntry), entries.size(), f) == entries.size();
+    if (ok && !pool.empty())
+        ok = fwrite(pool.data(), 1, pool.size(), f) == pool.size();
+    if (fclose(f) != 0)
+        ok = false;
+
+    std::error_code ec;
+    if (ok)
+    {
+        std::filesystem::rename(temp, path, ec);
+        ok = !ec;
+    }
+    if (!ok)
+        std::filesystem::remove(temp, ec);
+    return ok;
+}
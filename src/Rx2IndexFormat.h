@@ -0,0 +1,146 @@
+#pragma once
+
+// Library index: what the decoder would make of every REX file in a
+// library, worked out ahead of time by rx2_index (tools/Rx2Index.cpp) and
+// consulted by the plugin on open (Rx2LibraryIndex.h).
+//
+// Layout: an Rx2IndexHeader, a table of fixed-size Rx2IndexEntry records
+// sorted by path hash, and a pool of strings. Everything is little-endian
+// and naturally aligned, so a reader maps the file and uses it in place;
+// nothing is parsed up front and a lookup is a binary search. A file is
+// identified the way Rx2FileKey identifies it (path, size, last-write
+// FILETIME, hash of the first 4 KB), so an entry for a file edited since
+// the index was built no longer matches.
+
+#include "Rx2Loop.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static const char          kRx2IndexMagic[8] = { 'R', 'X', '2', 'I', 'N', 'D', 'E', 'X' };
+static const std::uint32_t kRx2IndexVersion  = 1;
+
+struct Rx2IndexHeader
+{
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t entrySize;       // sizeof(Rx2IndexEntry)
+    std::uint32_t entryCount;
+    std::uint32_t reserved;
+    std::uint64_t entriesOffset;   // from the start of the file
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsBytes;
+};
+
+// A string in the pool: byte offset from stringsOffset and length in bytes.
+struct Rx2IndexString
+{
+    std::uint32_t offset;
+    std::uint32_t bytes;
+};
+
+enum Rx2IndexStatus : std::uint32_t
+{
+    kRx2IndexOk     = 0,   // the decoder opens and renders it
+    kRx2IndexNotRex = 1,   // empty or a WAV file; turned away before REX sees it
+    kRx2IndexBad    = 2,   // rejected with rexError
+};
+
+enum Rx2IndexCreatorField
+{
+    kRx2IndexCreatorName,
+    kRx2IndexCreatorCopyright,
+    kRx2IndexCreatorUrl,
+    kRx2IndexCreatorEmail,
+    kRx2IndexCreatorFreeText,
+    kRx2IndexCreatorFields
+};
+
+struct Rx2IndexEntry
+{
+    std::uint64_t  pathHash;       // Rx2IndexPathHash() of the path
+    std::int64_t   size;
+    std::uint64_t  mtime;          // FILETIME of the last write
+    std::uint32_t  headerHash;     // FNV-1a of the first 4 KB
+    std::uint32_t  status;         // Rx2IndexStatus
+    std::uint64_t  contentHash;    // FNV-1a 64 of the whole file
+    std::int32_t   rexError;       // why a kRx2IndexBad file was rejected
+
+    // The header as REXGetInfoFromBuffer reports it; zero if it did not.
+    std::int32_t   channels;
+    std::int32_t   sampleRate;
+    std::int32_t   bitDepth;
+    std::int32_t   sliceCount;
+    std::int32_t   tempo;          // 1/1000 BPM
+    std::int32_t   originalTempo;
+    std::int32_t   ppqLength;
+    std::int32_t   timeSignNom;
+    std::int32_t   timeSignDenom;
+    std::int64_t   loopFrames;     // Rx2LoopLengthFrames() at the file's rate and tempo
+
+    Rx2IndexString path;                              // UTF-16LE, as the host names the file
+    Rx2IndexString creator[kRx2IndexCreatorFields];   // UTF-8
+};
+
+static_assert(sizeof(Rx2IndexHeader) == 48, "Rx2IndexHeader layout");
+static_assert(sizeof(Rx2IndexEntry) == 136, "Rx2IndexEntry layout");
+
+// FNV-1a 64 over the UTF-16 code units of `path`, low byte first, with
+// ASCII letters folded to lower case (paths compare case-insensitively).
+std::uint64_t Rx2IndexPathHash(const char16_t* path, std::size_t units);
+
+// ---------------- reading ----------------
+
+// A mapped (or loaded) index, used in place. Does not own the bytes.
+class Rx2IndexView
+{
+public:
+    Rx2IndexView() : m_base(nullptr), m_size(0), m_header(nullptr), m_entries(nullptr) {}
+
+    // Checks the header and that the entry table and string pool lie
+    // inside the `size` bytes at `data`, which must be 8-byte aligned.
+    bool Attach(const void* data, std::size_t size);
+
+    std::uint32_t        Count() const { return m_header ? m_header->entryCount : 0; }
+    const Rx2IndexEntry& Entry(std::uint32_t i) const { return m_entries[i]; }
+
+    // The entry for the file at `path` (case-insensitive) if it still has
+    // this size, mtime and header hash; null otherwise.
+    const Rx2IndexEntry* Find(const char16_t* path, std::size_t units, std::int64_t size,
+                              std::uint64_t mtime, std::uint32_t headerHash) const;
+
+    // Pool strings; empty if the reference is out of bounds.
+    std::u16string Utf16(const Rx2IndexString& s) const;
+    std::string    Utf8(const Rx2IndexString& s) const;
+
+private:
+    const std::uint8_t*   m_base;
+    std::size_t           m_size;
+    const Rx2IndexHeader* m_header;
+    const Rx2IndexEntry*  m_entries;
+};
+
+// ---------------- building ----------------
+
+// One file's entry with its strings, before they are pooled.
+struct Rx2IndexRecord
+{
+    Rx2IndexEntry  entry;
+    std::u16string path;
+    Rx2LoopCreator creator;
+};
+
+// Validates the file as CreateDecoder does: the WAV signature check, the
+// preflight header rules, then a full open and render through Rx2Loop.
+// Fills everything but the path, which is the caller's (the name the host
+// will open the file by). Returns false if the file could not be read or
+// failed for a reason that says nothing about it (Rx2IsTransientRexError);
+// *err then holds the REX error, or kREXError_NoError for a read failure.
+bool Rx2IndexScanFile(const std::filesystem::path& file, Rx2IndexRecord* record, REX::REXError* err);
+
+// Writes the records as an index file (beside `path`, then renamed over
+// it). Sorts `records` by path hash.
+bool Rx2IndexWrite(const std::filesystem::path& path, std::vector<Rx2IndexRecord>& records);
@@ -0,0 +1,116 @@
+#include "Rx2LibraryIndex.h"
+#include "Rx2Contention.h"
+#include "Rx2Metrics.h"
+#include "Rx2Settings.h"
+
+#include <cstdint>
+#include <string>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+static SRWLOCK      g_lock    = SRWLOCK_INIT;
+static HANDLE       g_file    = INVALID_HANDLE_VALUE;
+static HANDLE       g_mapping = nullptr;
+static const void*  g_view    = nullptr;
+static Rx2IndexView g_index;
+
+// ---------------- helpers ----------------
+
+// Called with g_lock held exclusively.
+static void Unmap()
+{
+    g_index = Rx2IndexView();
+
+    if (g_view)
+        UnmapViewOfFile(g_view);
+    if (g_mapping)
+        CloseHandle(g_mapping);
+    if (g_file != INVALID_HANDLE_VALUE)
+        CloseHandle(g_file);
+
+    g_view    = nullptr;
+    g_mapping = nullptr;
+    g_file    = INVALID_HANDLE_VALUE;
+}
+
+// ---------------- public API ----------------
+
+void Rx2LibraryIndexStart(IAIMPCore* core)
+{
+    if (!core || !Rx2GetSettings().libraryIndex)
+        return;
+
+    const std::wstring dir = Rx2ProfileDir(core);
+    if (!dir.empty())
+        Rx2LibraryIndexOpen((dir + L"Library.rx2index").c_str());
+}
+
+void Rx2LibraryIndexStop()
+{
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::LibraryIndex);
+    Unmap();
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+bool Rx2LibraryIndexOpen(const wchar_t* path)
+{
+    HANDLE file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size{};
+    HANDLE        mapping = nullptr;
+    const void*   view    = nullptr;
+    Rx2IndexView  index;
+
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0
+        && static_cast<std::uint64_t>(size.QuadPart) <= static_cast<std::uint64_t>(SIZE_MAX))
+    {
+        mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+
+    if (!view || !index.Attach(view, static_cast<size_t>(size.QuadPart)))
+    {
+        if (view)
+            UnmapViewOfFile(view);
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::LibraryIndex);
+    Unmap();
+    g_file    = file;
+    g_mapping = mapping;
+    g_view    = view;
+    g_index   = index;
+    ReleaseSRWLockExclusive(&g_lock);
+    return true;
+}
+
+bool Rx2LibraryIndexLookup(const Rx2FileKey& key, Rx2IndexEntry* entry)
+{
+    // The index stores UTF-16; wchar_t is UTF-16 on Windows and a code
+    // point elsewhere (the bench tools), where paths are BMP-only.
+    const std::u16string path(key.path.begin(), key.path.end());
+
+    Rx2LockShared(&g_lock, Rx2SyncSite::LibraryIndex);
+
+    const bool mapped = g_view != nullptr;
+    const Rx2IndexEntry* found = mapped
+        ? g_index.Find(path.data(), path.size(), key.size, key.mtime, key.headerHash)
+        : nullptr;
+    if (found && entry)
+        *entry = *found;
+
+    ReleaseSRWLockShared(&g_lock);
+
+    if (mapped)
+        Rx2MetricAdd(found ? Rx2Counter::LibraryIndexHits : Rx2Counter::LibraryIndexMisses);
+    return found != nullptr;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// The library index (Rx2IndexFormat.h) as the plugin uses it: mapped
+// read-only for the session and looked up by CreateDecoder before any
+// other work, so files the index knows to be bad are turned away without
+// touching REX and good ones skip the header preflight. Off unless
+// RX2Decoder\LibraryIndex is set; the plugin then maps
+// <AIMP profile>\RX2Decoder\Library.rx2index, written by rx2_index.
+
+#include "apiCore.h"
+#include "Rx2FileKey.h"
+#include "Rx2IndexFormat.h"
+
+void Rx2LibraryIndexStart(IAIMPCore* core);
+void Rx2LibraryIndexStop();
+
+// Maps the index at `path`, replacing the current one (the bench tools
+// use this directly). False if it cannot be mapped or is not an index.
+bool Rx2LibraryIndexOpen(const wchar_t* path);
+
+// Copies the entry for the file into *entry if the index has a current one.
+// Counts a hit or a miss while an index is mapped.
+bool Rx2LibraryIndexLookup(const Rx2FileKey& key, Rx2IndexEntry* entry);
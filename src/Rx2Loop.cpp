@@ -0,0 +1,664 @@
+#include "Rx2Loop.h"
+#include "Rx2CoreHooks.h"
+#include "Rx2RenderPipeline.h"
+#include "Rx2RexBackend.h"
+
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <vector>
+
+// ---------------- helpers ----------------
+
+// Deletes the REX handle on every way out of Open() / Rerender().
+struct RexHandleGuard
+{
+    REX::REXHandle handle = nullptr;
+
+    ~RexHandleGuard()
+    {
+        if (handle)
+            Rx2RexBackend::Delete(&handle);
+    }
+};
+
+static std::int64_t NowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Pick the resident PCM format from the options and the file's source bit depth.
+static Rx2SampleFormat ChooseStorageFormat(const Rx2LoopOptions& options, int sourceBitDepth)
+{
+    int bits = options.pcmStorageBits;
+    if (bits == 0)
+    {
+        if (sourceBitDepth > 0 && sourceBitDepth <= 16)
+            bits = 16;
+        else if (sourceBitDepth > 0 && sourceBitDepth <= 24)
+            bits = 24;
+        else
+            bits = 32;
+    }
+
+    if (bits < options.pcmMinStorageBits)
+        bits = options.pcmMinStorageBits;
+
+    if (bits <= 16)
+        return Rx2SampleFormat::Int16;
+    if (bits <= 24)
+        return Rx2SampleFormat::Int24;
+    return Rx2SampleFormat::Float32;
+}
+
+// ---------------- header ----------------
+
+const char* Rx2RexErrorName(REX::REXError err)
+{
+    switch (err)
+    {
+    case REX::kREXError_NoError:                 return "ok";
+    case REX::kREXError_OperationAbortedByUser:  return "aborted";
+    case REX::kREXError_NotEnoughMemoryForDLL:   return "dll_out_of_memory";
+    case REX::kREXError_UnableToLoadDLL:         return "dll_unable_to_load";
+    case REX::kREXError_DLLTooOld:               return "dll_too_old";
+    case REX::kREXError_DLLNotFound:             return "dll_not_found";
+    case REX::kREXError_APITooOld:               return "api_too_old";
+    case REX::kREXError_OutOfMemory:             return "out_of_memory";
+    case REX::kREXError_FileCorrupt:             return "file_corrupt";
+    case REX::kREXError_REX2FileTooNew:          return "file_too_new";
+    case REX::kREXError_FileHasZeroLoopLength:   return "zero_loop_length";
+    case REX::kREXError_OSVersionNotSupported:   return "os_not_supported";
+    case REX::kREXImplError_DLLNotInitialized:   return "dll_not_initialized";
+    case REX::kREXImplError_InvalidHandle:       return "invalid_handle";
+    case REX::kREXImplError_InvalidSize:         return "invalid_size";
+    case REX::kREXImplError_InvalidArgument:     return "invalid_argument";
+    case REX::kREXImplError_InvalidSlice:        return "invalid_slice";
+    case REX::kREXImplError_InvalidSampleRate:   return "invalid_sample_rate";
+    case REX::kREXImplError_BufferTooSmall:      return "buffer_too_small";
+    case REX::kREXImplError_InvalidTempo:        return "invalid_tempo";
+    case REX::kREXError_Undefined:               return "undefined";
+    case kRexError_NoActiveSlices:               return "no_active_slices";
+    case kRexError_CreateTimedOut:               return "create_timed_out";
+    default:                                     return "other";
+    }
+}
+
+REX::REXError Rx2PreflightHeaderError(const REX::REXInfo& info)
+{
+    REX::REXError err = REX::kREXError_NoError;
+
+    if (info.fPPQLength <= 0)
+        err = REX::kREXError_FileHasZeroLoopLength;
+
+    // Bars/Beats not set -> both tempo fields zero.
+    if (info.fTempo <= 0 && info.fOriginalTempo <= 0)
+        err = REX::kREXError_FileHasZeroLoopLength;
+
+    if (info.fChannels <= 0 || info.fChannels > 2)
+        err = REX::kREXError_FileCorrupt;
+
+    if (info.fSampleRate <= 0 || info.fSampleRate > 192000)
+        err = REX::kREXError_FileCorrupt;
+
+    return err;
+}
+
+bool Rx2IsTransientRexError(REX::REXError err)
+{
+    switch (err)
+    {
+    case REX::kREXError_NoError:
+    case REX::kREXError_OutOfMemory:
+    case REX::kREXError_OperationAbortedByUser:
+    case REX::kREXImplError_DLLNotInitialized:
+    case kRexError_CreateTimedOut:
+#if REX_DLL_LOADER
+    case REX::kREXError_NotEnoughMemoryForDLL:
+    case REX::kREXError_UnableToLoadDLL:
+    case REX::kREXError_DLLTooOld:
+    case REX::kREXError_DLLNotFound:
+    case REX::kREXError_APITooOld:
+    case REX::kREXError_OSVersionNotSupported:
+#endif
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool Rx2CheckRexHeader(const REX::REXInfo& info)
+{
+    // Channels must be 1 or 2 for our decoder
+    if (info.fChannels <= 0 || info.fChannels > 2)
+        return false;
+
+    // Sample rate must be sane
+    if (info.fSampleRate <= 0 || info.fSampleRate > 192000)
+        return false;
+
+    // PPQ length must be positive and not absurdly large
+    if (info.fPPQLength <= 0 || info.fPPQLength > 100000000)
+        return false;
+
+    // Bars/Beats not set -> both tempo fields zero.
+    if (info.fTempo <= 0 && info.fOriginalTempo <= 0)
+        return false;
+
+    // Time signature denominator should be common musical values
+    return info.fTimeSignDenom == 1 ||
+           info.fTimeSignDenom == 2 ||
+           info.fTimeSignDenom == 4 ||
+           info.fTimeSignDenom == 8 ||
+           info.fTimeSignDenom == 16;
+}
+
+std::int64_t Rx2LoopLengthFrames(const REX::REXInfo& info, int sampleRate, REX::REX_int32_t tempo)
+{
+    if (sampleRate <= 0 || tempo <= 0)
+        return 0;
+
+    double tmp = static_cast<double>(sampleRate);
+    tmp *= 1000.0;
+    tmp *= static_cast<double>(info.fPPQLength);
+
+    // Convert tempo to quarter-note BPM depending on time signature denominator.
+    double tempoForLength = static_cast<double>(tempo);
+    int    denom          = info.fTimeSignDenom;
+
+    if (denom > 0 && denom != 4)
+    {
+        tempoForLength = tempoForLength * 4.0 / static_cast<double>(denom);
+    }
+
+    tmp /= (tempoForLength * 256.0);
+
+    if (tmp < 0.0 || tmp > static_cast<double>(INT32_MAX))
+        return 0;
+
+    return static_cast<std::int64_t>(tmp);
+}
+
+// ---------------- Rx2Loop ----------------
+
+Rx2Loop::Rx2Loop()
+    : m_options()
+    , m_channels(2)
+    , m_sampleRate(44100)
+    , m_sourceSampleRate(0)
+    , m_frames(0)
+    , m_tempo(0)
+    , m_hasTempoFromFile(false)
+    , m_creator()
+    , m_isValid(false)
+    , m_hasError(false)
+    , m_lastError(REX::kREXError_NoError)
+    , m_storageFormat(Rx2SampleFormat::Float32)
+    , m_renderUs(-1)
+    , m_renderFrames(0)
+{
+}
+
+Rx2Loop::~Rx2Loop()
+{
+}
+
+bool Rx2Loop::Fail(REX::REXError err)
+{
+    m_lastError = err;
+    m_hasError  = true;
+    m_isValid   = false;
+    return false;
+}
+
+bool Rx2Loop::Open(std::uint8_t* data, std::int64_t size, const Rx2LoopOptions& options)
+{
+    RX2_TRACE_SCOPE("Rx2Loop::Open");
+
+    m_options      = options;
+    m_renderUs     = -1;
+    m_renderFrames = 0;
+
+    if (!data || size <= 0)
+    {
+        delete[] data;
+        return false;
+    }
+
+    // 1) Preflight: skip here if already performed by caller/extension
+    if (!options.skipPreflight)
+    {
+        REX::REXInfo preInfo{};
+        REX::REXError preErr = RX2_TRACE_CALL("REXGetInfoFromBuffer", Rx2RexBackend::GetInfoFromBuffer(
+            static_cast<REX::REX_int32_t>(size),
+            reinterpret_cast<const char*>(data),
+            static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)),
+            &preInfo));
+
+        if (preErr != REX::kREXError_NoError)
+        {
+            delete[] data;
+            return Fail(preErr);
+        }
+
+        // The plugin's preflight verdict first, so the core reports the same
+        // error for a file as the plugin does; then the stricter sanity rules.
+        preErr = Rx2PreflightHeaderError(preInfo);
+        if (preErr == REX::kREXError_NoError && !Rx2CheckRexHeader(preInfo))
+            preErr = REX::kREXError_FileCorrupt;
+
+        if (preErr != REX::kREXError_NoError)
+        {
+            delete[] data;
+            return Fail(preErr);
+        }
+    }
+
+    // 2) create REX handle; the backend owns the bytes from here (REX keeps
+    // its own copy of the file)
+    RexHandleGuard handle;
+    REX::REXError  err = REX::kREXError_NoError;
+
+    if (!Rx2RexBackend::Create(data, size, &handle.handle, &err))
+        return Fail(err);
+
+    // Hard failure if handle is null
+    if (!handle.handle)
+        return Fail(err != REX::kREXError_NoError ? err : REX::kREXError_Undefined);
+
+    // If err is non-zero but handle is valid, treat as non-fatal warning.
+    if (err != REX::kREXError_NoError)
+    {
+        // Loop length not set must be fatal.
+        if (err == REX::kREXError_FileHasZeroLoopLength)
+            return Fail(err);
+
+        m_lastError = err;
+        m_hasError  = true;
+    }
+
+    // 3) get info
+    REX::REXInfo info{};
+    err = RX2_TRACE_CALL("REXGetInfo", Rx2RexBackend::GetInfo(
+        handle.handle,
+        static_cast<REX::REX_int32_t>(sizeof(REX::REXInfo)),
+        &info));
+
+    // Detect missing loop length to surface the correct error code.
+    if (info.fPPQLength <= 0)
+        return Fail(REX::kREXError_FileHasZeroLoopLength);
+
+    m_channels         = info.fChannels;
+    m_sourceSampleRate = info.fSampleRate;
+
+    // 3.5) optional creator metadata
+    {
+        REX::REXCreatorInfo creator{};
+        REX::REXError cErr = RX2_TRACE_CALL("REXGetCreatorInfo", Rx2RexBackend::GetCreatorInfo(
+            handle.handle,
+            static_cast<REX::REX_int32_t>(sizeof(REX::REXCreatorInfo)),
+            &creator));
+
+        if (cErr == REX::kREXError_NoError)
+        {
+            m_creator.name      = creator.fName;
+            m_creator.copyright = creator.fCopyright;
+            m_creator.url       = creator.fURL;
+            m_creator.email     = creator.fEmail;
+            m_creator.freeText  = creator.fFreeText;
+        }
+    }
+
+    // Use original file sample rate for playback unless the host asks for
+    // another; fallback to 44100 if missing
+    if (options.sampleRate > 0)
+        m_sampleRate = options.sampleRate;
+    else if (m_sourceSampleRate > 0)
+        m_sampleRate = m_sourceSampleRate;
+    else
+        m_sampleRate = 44100;
+
+    // Missing both tempo fields implies Bars/Beats not set.
+    if (info.fTempo <= 0 && info.fOriginalTempo <= 0)
+        return Fail(REX::kREXError_FileHasZeroLoopLength);
+
+    // choose tempo: the host's, else exported tempo, then original tempo
+    m_hasTempoFromFile = options.tempo <= 0;
+    if (!m_hasTempoFromFile)
+        m_tempo = options.tempo;
+    else
+        m_tempo = (info.fTempo > 0) ? info.fTempo : info.fOriginalTempo;
+
+    // 4) set sample rate & compute length (same as PreviewRenderInTempo).
+    // Only a rate the host asked for has to be accepted.
+    err = Rx2RexBackend::SetOutputSampleRate(
+        handle.handle,
+        static_cast<REX::REX_int32_t>(m_sampleRate));
+
+    if (options.sampleRate > 0 && err != REX::kREXError_NoError)
+        return Fail(err);
+
+    REX::REX_int32_t lengthFrames =
+        static_cast<REX::REX_int32_t>(Rx2LoopLengthFrames(info, m_sampleRate, m_tempo));
+
+    if (lengthFrames <= 0 || m_channels <= 0)
+        return Fail(REX::kREXError_FileCorrupt);
+
+    // Slice sub-track: only this slice's frames are rendered and kept.
+    if (options.sliceIndex >= 0)
+    {
+        REX::REXSliceInfo slice{};
+        if (options.sliceIndex >= info.fSliceCount ||
+            Rx2RexBackend::GetSliceInfo(handle.handle,
+                                        static_cast<REX::REX_int32_t>(options.sliceIndex),
+                                        static_cast<REX::REX_int32_t>(sizeof(REX::REXSliceInfo)),
+                                        &slice) != REX::kREXError_NoError ||
+            slice.fSampleLength <= 0)
+        {
+            return Fail(REX::kREXImplError_InvalidSlice);
+        }
+
+        lengthFrames = slice.fSampleLength;
+    }
+
+    // sanity bound ~1 hour
+    {
+        double durationSec = static_cast<double>(lengthFrames)
+                           / static_cast<double>(m_sampleRate);
+        const double kMaxDurationSec = 60.0 * 60.0;
+
+        if (durationSec <= 0.0 || durationSec > kMaxDurationSec)
+            return Fail(REX::kREXError_FileCorrupt);
+    }
+
+    // 5) render the loop into the PCM store
+    m_storageFormat = ChooseStorageFormat(options, info.fBitDepth);
+
+    std::int64_t nFrm = 0;
+    err = RenderPcm(handle.handle, lengthFrames, &nFrm);
+
+    if (err == REX::kREXError_OutOfMemory || (err != REX::kREXError_NoError && nFrm <= 0))
+        return Fail(err);
+
+    // A batch failing mid-loop keeps what was rendered so far.
+    if (err != REX::kREXError_NoError)
+    {
+        m_lastError = err;
+        m_hasError  = true;
+    }
+
+    m_frames = nFrm;
+
+    // Detect files that render as complete silence (e.g., all slices muted).
+    // The store answers from its extent map and tracked peak, no rescan.
+    {
+        const float kSilenceThreshold = 1e-7f;
+
+        if (!m_pcm.HasSignalAbove(kSilenceThreshold) || nFrm <= 0)
+            return Fail(kRexError_NoActiveSlices);
+    }
+
+    m_pcm.Prefault();
+
+    m_isValid = true;
+    return true;
+}
+
+bool Rx2Loop::Rerender(std::uint8_t* data, std::int64_t size)
+{
+    RX2_TRACE_SCOPE("Rx2Loop::Rerender");
+
+    m_renderUs     = -1;
+    m_renderFrames = 0;
+
+    RexHandleGuard handle;
+    REX::REXError  err = REX::kREXError_NoError;
+
+    if (!Rx2RexBackend::Create(data, size, &handle.handle, &err) || !handle.handle)
+        return false;
+
+    Rx2RexBackend::SetOutputSampleRate(handle.handle, static_cast<REX::REX_int32_t>(m_sampleRate));
+
+    std::int64_t frames = 0;
+    err = RenderPcm(handle.handle, static_cast<REX::REX_int32_t>(m_frames), &frames);
+
+    if (err != REX::kREXError_NoError || frames != m_frames)
+    {
+        m_pcm.Clear();
+        return false;
+    }
+
+    m_pcm.Prefault();
+    return true;
+}
+
+// ---------------- render ----------------
+
+// Renders `lengthFrames` frames of the loop at m_tempo into m_pcm in
+// m_storageFormat. Loops over the spill threshold go to a temp file right
+// away; a heap render that runs out of memory is retried spilled. Returns
+// the first REX error (with the frames committed before it in
+// *framesRendered), or kREXError_OutOfMemory if the store could not grow.
+// Slice decoders render through RenderSlice() instead.
+REX::REXError Rx2Loop::RenderPcm(REX::REXHandle handle,
+                                 REX::REX_int32_t lengthFrames,
+                                 std::int64_t* framesRendered)
+{
+    RX2_TRACE_SCOPE("Rx2Loop::RenderPcm");
+
+    const std::int64_t started = NowUs();
+
+    REX::REXError err;
+    if (m_options.sliceIndex >= 0)
+    {
+        err = RenderSlice(handle, lengthFrames, framesRendered);
+    }
+    else
+    {
+        const std::uint64_t spillThreshold =
+            static_cast<std::uint64_t>(m_options.pcmSpillThresholdMB) * 1024 * 1024;
+        const std::uint64_t estimatedBytes =
+            static_cast<std::uint64_t>(lengthFrames) * m_channels * Rx2BytesPerSample(m_storageFormat);
+
+        const bool spill = spillThreshold > 0 && estimatedBytes > spillThreshold;
+
+        err = RenderPcmPass(handle, lengthFrames, spill, framesRendered);
+        if (err == REX::kREXError_OutOfMemory && !spill && spillThreshold > 0)
+            err = RenderPcmPass(handle, lengthFrames, true, framesRendered);
+    }
+
+    m_renderUs     = NowUs() - started;
+    m_renderFrames = *framesRendered;
+    return err;
+}
+
+// Consumer stage of the render pipeline, on its worker thread: store
+// append (clamp/quantize/compress) and the per-file analysis.
+struct Rx2RenderTarget
+{
+    Rx2Loop* loop;
+    bool     analyze;
+};
+
+bool Rx2Loop::ConsumeRenderedBlock(void* context, const float* left, const float* right, int frames)
+{
+    Rx2RenderTarget* target = static_cast<Rx2RenderTarget*>(context);
+    Rx2Loop*         self   = target->loop;
+
+    if (!RX2_TRACE_CALL("Rx2PcmStore::Append", self->m_pcm.Append(left, right, frames)))
+        return false;
+
+    if (target->analyze)
+    {
+        RX2_TRACE_SCOPE("Rx2Loop::Analyze");
+        self->m_peaks.Add(left, right, frames);
+        self->m_loudness.Add(left, right, frames);
+    }
+    return true;
+}
+
+// One render attempt. This thread drives the DLL in 64-frame preview
+// batches and fills pipeline blocks; the pipeline worker appends them to
+// the chunked store meanwhile, so no loop-sized buffer is needed.
+REX::REXError Rx2Loop::RenderPcmPass(REX::REXHandle handle,
+                                     REX::REX_int32_t lengthFrames,
+                                     bool spill,
+                                     std::int64_t* framesRendered)
+{
+    *framesRendered = 0;
+
+    if (!m_pcm.Reset(m_channels, lengthFrames, m_storageFormat,
+                     m_options.pcmCompression, spill))
+        return REX::kREXError_OutOfMemory;
+
+    // Waveform and loudness only depend on the loop, so a re-render after
+    // eviction keeps the results of the first pass.
+    Rx2RenderTarget target = { this, !m_peaks.IsFinished() };
+    if (target.analyze)
+    {
+        m_peaks.Reset(m_channels);
+        m_loudness.Reset(m_sampleRate, m_channels);
+    }
+
+    REX::REXError err = Rx2RexBackend::SetPreviewTempo(handle, m_tempo);
+    if (err != REX::kREXError_NoError)
+        return err;
+
+    err = Rx2RexBackend::StartPreview(handle);
+    if (err != REX::kREXError_NoError)
+        return err;
+
+    // A couple of blocks are not worth a thread.
+    Rx2RenderPipeline pipeline;
+    pipeline.Start(m_channels, &Rx2Loop::ConsumeRenderedBlock, &target,
+                   lengthFrames > 2 * Rx2RenderPipeline::kBlockFrames);
+
+    REX::REX_int32_t rendered = 0;
+
+    while (rendered != lengthFrames && pipeline.IsHealthy())
+    {
+        float* blockLeft  = nullptr;
+        float* blockRight = nullptr;
+        RX2_TRACE_CALL("Rx2RenderPipeline::BeginBlock", pipeline.BeginBlock(&blockLeft, &blockRight));
+
+        // One trace event per block; per batch would flood the buffer.
+        int filled = 0;
+        {
+            RX2_TRACE_SCOPE("REXRenderPreviewBatch (block)");
+
+            while (filled < Rx2RenderPipeline::kBlockFrames && rendered != lengthFrames)
+            {
+                REX::REX_int32_t remaining = lengthFrames - rendered;
+                REX::REX_int32_t todo      = remaining > 64 ? 64 : remaining;
+
+                float* tmpBuf[2] = { blockLeft + filled, blockRight ? blockRight + filled : nullptr };
+
+                err = Rx2RexBackend::RenderPreviewBatch(handle, todo, tmpBuf);
+                if (err != REX::kREXError_NoError)
+                    break;
+
+                filled   += todo;
+                rendered += todo;
+            }
+        }
+
+        if (filled > 0)
+            pipeline.CommitBlock(filled);
+
+        if (err != REX::kREXError_NoError)
+            break;
+    }
+
+    Rx2RexBackend::StopPreview(handle);
+
+    // SDK does a small extra batch after StopPreview.
+    {
+        float left[64];
+        float right[64];
+        float* tmpRenderBuffers[2];
+
+        tmpRenderBuffers[0] = &left[0];
+        tmpRenderBuffers[1] = (m_channels > 1) ? &right[0] : nullptr;
+
+        (void)Rx2RexBackend::RenderPreviewBatch(handle, 64, tmpRenderBuffers);
+    }
+
+    const bool consumed = pipeline.Finish();
+
+    // Commit the trailing block.
+    if (!consumed || !m_pcm.Finish())
+    {
+        m_pcm.Clear();
+        if (target.analyze)
+        {
+            m_peaks.Clear();
+            m_loudness.Clear();
+        }
+        return REX::kREXError_OutOfMemory;
+    }
+
+    if (target.analyze)
+    {
+        m_peaks.Finish();
+        m_loudness.Finish();
+    }
+
+    *framesRendered = rendered;
+    return err;
+}
+
+// Renders one slice with REXRenderSlice. Slices are short, so the whole
+// slice is rendered into scratch buffers and appended in one go.
+REX::REXError Rx2Loop::RenderSlice(REX::REXHandle handle,
+                                   REX::REX_int32_t lengthFrames,
+                                   std::int64_t* framesRendered)
+{
+    *framesRendered = 0;
+
+    std::vector<float> left;
+    std::vector<float> right;
+    try
+    {
+        left.resize(static_cast<size_t>(lengthFrames));
+        if (m_channels > 1)
+            right.resize(static_cast<size_t>(lengthFrames));
+    }
+    catch (...)
+    {
+        return REX::kREXError_OutOfMemory;
+    }
+
+    float* buffers[2] = { left.data(), (m_channels > 1) ? right.data() : nullptr };
+
+    REX::REXError err = RX2_TRACE_CALL("REXRenderSlice",
+                                       Rx2RexBackend::RenderSlice(handle,
+                                                                  static_cast<REX::REX_int32_t>(m_options.sliceIndex),
+                                                                  lengthFrames,
+                                                                  buffers));
+    if (err != REX::kREXError_NoError)
+        return err;
+
+    if (!m_pcm.Reset(m_channels, lengthFrames, m_storageFormat,
+                     m_options.pcmCompression, false) ||
+        !m_pcm.Append(buffers[0], buffers[1], lengthFrames) ||
+        !m_pcm.Finish())
+    {
+        m_pcm.Clear();
+        return REX::kREXError_OutOfMemory;
+    }
+
+    if (!m_peaks.IsFinished())
+    {
+        m_peaks.Reset(m_channels);
+        m_peaks.Add(buffers[0], buffers[1], lengthFrames);
+        m_peaks.Finish();
+
+        m_loudness.Reset(m_sampleRate, m_channels);
+        m_loudness.Add(buffers[0], buffers[1], lengthFrames);
+        m_loudness.Finish();
+    }
+
+    *framesRendered = lengthFrames;
+    return REX::kREXError_NoError;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+// Decoder core: one REX loop (or slice) rendered to PCM.
+//
+// Takes the raw file bytes, validates the header, creates a REX handle,
+// works out the loop's format, tempo and length, and renders it through
+// the render pipeline into an Rx2PcmStore, measuring the waveform and
+// loudness on the way. Nothing here depends on Win32 or the AIMP SDK:
+// REX is called through Rx2RexBackend (Rx2RexBackend.h), host settings
+// come in as Rx2LoopOptions, and Rx2Decoder adapts the result to AIMP.
+// Built with RX2_CORE_STANDALONE, the core compiles on its own (target
+// rx2_core) against any provider of the REX API.
+
+#include "RexSdk.h"
+#include "Rx2Loudness.h"
+#include "Rx2PcmStore.h"
+#include "Rx2PeakIndex.h"
+
+#include <cstdint>
+#include <string>
+
+// Custom sentinel error codes not provided by the REX SDK.
+static constexpr REX::REXError kRexError_NoActiveSlices =
+    static_cast<REX::REXError>(10000);
+// REXCreate did not finish within the sandbox timeout. Transient: a valid
+// file can be slow on a loaded machine.
+static constexpr REX::REXError kRexError_CreateTimedOut =
+    static_cast<REX::REXError>(10001);
+
+// What the core needs from the host's configuration (see Rx2Settings.h
+// for the meaning of each field in the plugin).
+struct Rx2LoopOptions
+{
+    int  pcmStorageBits;       // 0 = follow the file, 16, 24 or 32
+    int  pcmMinStorageBits;
+    bool pcmCompression;
+    int  pcmSpillThresholdMB;  // 0 = never spill
+    int  sliceIndex;           // >= 0 renders that slice only
+    bool skipPreflight;        // the caller has validated the header
+    int  sampleRate;           // output rate; 0 = the file's (the plugin's choice)
+    int  tempo;                // render tempo in 1/1000 BPM; 0 = the file's, likewise
+};
+
+// REXCreatorInfo, UTF-8. Empty strings mean "not available".
+struct Rx2LoopCreator
+{
+    std::string name;
+    std::string copyright;
+    std::string url;
+    std::string email;
+    std::string freeText;
+};
+
+// Short snake_case name for a REX error ("file_corrupt"), or "other".
+const char* Rx2RexErrorName(REX::REXError err);
+
+// PreflightStream's verdict on a header REXGetInfoFromBuffer accepted:
+// kREXError_NoError, FileHasZeroLoopLength (no PPQ length or tempo) or
+// FileCorrupt (channels or sample rate out of range).
+REX::REXError Rx2PreflightHeaderError(const REX::REXInfo& info);
+
+// Errors that depend on the machine state (memory, the REX library) rather
+// than on the file, and so say nothing about the file.
+bool Rx2IsTransientRexError(REX::REXError err);
+
+// The decoder's header sanity rules: 1-2 channels, 1..192000 Hz, a PPQ
+// length in 1..1e8, a tempo, and a power-of-two time signature
+// denominator up to 16.
+bool Rx2CheckRexHeader(const REX::REXInfo& info);
+
+// Frames one pass of the loop lasts at `sampleRate` and `tempo` (1/1000
+// BPM), as the SDK's PreviewRenderInTempo computes it. 0 if nonsensical.
+std::int64_t Rx2LoopLengthFrames(const REX::REXInfo& info, int sampleRate, REX::REX_int32_t tempo);
+
+class Rx2Loop
+{
+public:
+    Rx2Loop();
+    ~Rx2Loop();
+
+    Rx2Loop(const Rx2Loop&)            = delete;
+    Rx2Loop& operator=(const Rx2Loop&) = delete;
+
+    // Validates and renders the file in `data`, which must come from new[];
+    // ownership passes to the core (the REXCreate sandbox may outlive the
+    // call). Returns IsValid(); LastError() then says why not, or holds a
+    // non-fatal warning when HasError() is set on a valid loop.
+    bool Open(std::uint8_t* data, std::int64_t size, const Rx2LoopOptions& options);
+
+    // Renders the PCM again after ReleasePcm(), from the same file and with
+    // the format and length Open() established. Same ownership rule.
+    bool Rerender(std::uint8_t* data, std::int64_t size);
+    void ReleasePcm() { m_pcm.Clear(); }
+
+    bool             IsValid()          const { return m_isValid; }
+    bool             HasError()         const { return m_hasError; }
+    REX::REXError    LastError()        const { return m_lastError; }
+
+    int              Channels()         const { return m_channels; }
+    int              SampleRate()       const { return m_sampleRate; }
+    int              SourceSampleRate() const { return m_sourceSampleRate; }
+    std::int64_t     Frames()           const { return m_frames; }
+    REX::REX_int32_t Tempo()            const { return m_tempo; }   // 1/1000 BPM
+    bool             HasTempoFromFile() const { return m_hasTempoFromFile; }
+    const Rx2LoopCreator& Creator()     const { return m_creator; }
+
+    Rx2PcmStore&        Pcm()                 { return m_pcm; }
+    const Rx2PcmStore&  Pcm()           const { return m_pcm; }
+    Rx2SampleFormat     StorageFormat() const { return m_storageFormat; }
+
+    // Analysis done during the first render; kept across ReleasePcm().
+    const Rx2PeakIndex& Peaks()    const { return m_peaks; }
+    const Rx2Loudness&  Loudness() const { return m_loudness; }
+
+    // Wall time (-1 = nothing was rendered) and frames of the render in the
+    // last Open() or Rerender(), for the host's metrics.
+    std::int64_t LastRenderUs()     const { return m_renderUs; }
+    std::int64_t LastRenderFrames() const { return m_renderFrames; }
+
+private:
+    bool          Fail(REX::REXError err);
+    REX::REXError RenderPcm(REX::REXHandle handle, REX::REX_int32_t lengthFrames, std::int64_t* framesRendered);
+    REX::REXError RenderPcmPass(REX::REXHandle handle, REX::REX_int32_t lengthFrames, bool spill,
+                                std::int64_t* framesRendered);
+    REX::REXError RenderSlice(REX::REXHandle handle, REX::REX_int32_t lengthFrames, std::int64_t* framesRendered);
+    static bool   ConsumeRenderedBlock(void* context, const float* left, const float* right, int frames);
+
+    Rx2LoopOptions   m_options;
+
+    int              m_channels;
+    int              m_sampleRate;        // output rate: the host's, the file's, or 44100
+    int              m_sourceSampleRate;  // info.fSampleRate
+    std::int64_t     m_frames;
+    REX::REX_int32_t m_tempo;
+    bool             m_hasTempoFromFile;
+    Rx2LoopCreator   m_creator;
+
+    bool             m_isValid;
+    bool             m_hasError;
+    REX::REXError    m_lastError;
+
+    Rx2PcmStore      m_pcm;           // interleaved, in m_storageFormat
+    Rx2SampleFormat  m_storageFormat;
+    Rx2PeakIndex     m_peaks;         // min/max waveform
+    Rx2Loudness      m_loudness;      // R128 loudness / true peak
+
+    std::int64_t     m_renderUs;
+    std::int64_t     m_renderFrames;
+};
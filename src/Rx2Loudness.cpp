@@ -0,0 +1,325 @@
+#include "Rx2Loudness.h"
+
+#include <cmath>
+#include <cstring>
+
+// ---------------- helpers ----------------
+
+static const std::uint32_t kLoudnessMagic   = 0x4C325852u;   // "RX2L"
+static const std::uint32_t kLoudnessVersion = 1;
+
+static const double kPi               = 3.14159265358979323846;
+static const double kAbsoluteGateLufs = -70.0;
+static const double kRelativeGateLu   = -10.0;
+
+static double EnergyToLufs(double energy)
+{
+    return -0.691 + 10.0 * std::log10(energy);
+}
+
+static double LufsToEnergy(double lufs)
+{
+    return std::pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+// ---------------- Rx2Loudness ----------------
+
+Rx2Loudness::Rx2Loudness()
+{
+    Clear();
+}
+
+void Rx2Loudness::Clear()
+{
+    m_sampleRate    = 0;
+    m_channels      = 0;
+    m_finished      = false;
+    m_hasLoudness   = false;
+    m_segmentFrames = 0;
+    m_segmentFill   = 0;
+    m_segmentEnergy = 0.0;
+    m_totalEnergy   = 0.0;
+    m_totalFrames   = 0;
+    m_integrated    = 0.0;
+    m_truePeak      = 0.0;
+    memset(m_stage, 0, sizeof(m_stage));
+    memset(m_fir, 0, sizeof(m_fir));
+    memset(m_state, 0, sizeof(m_state));
+    std::vector<double>().swap(m_segments);
+}
+
+void Rx2Loudness::Reset(int sampleRate, int channels)
+{
+    Clear();
+
+    if (sampleRate <= 0)
+        return;
+
+    m_sampleRate    = sampleRate;
+    m_channels      = (channels == 2) ? 2 : 1;
+    m_segmentFrames = (sampleRate + 5) / 10;
+
+    InitFilters();
+}
+
+// BS.1770 K-weighting, re-derived for the actual rate (the published
+// coefficients are for 48 kHz only), plus the 4x interpolation filter.
+void Rx2Loudness::InitFilters()
+{
+    const double fs = static_cast<double>(m_sampleRate);
+
+    {
+        const double f0 = 1681.974450955533;
+        const double g  = 3.999843853973347;
+        const double q  = 0.7071752369554196;
+
+        const double k  = std::tan(kPi * f0 / fs);
+        const double vh = std::pow(10.0, g / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        m_stage[0].b0 = (vh + vb * k / q + k * k) / a0;
+        m_stage[0].b1 = 2.0 * (k * k - vh) / a0;
+        m_stage[0].b2 = (vh - vb * k / q + k * k) / a0;
+        m_stage[0].a1 = 2.0 * (k * k - 1.0) / a0;
+        m_stage[0].a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double f0 = 38.13547087602444;
+        const double q  = 0.5003270373238773;
+
+        const double k  = std::tan(kPi * f0 / fs);
+        const double a0 = 1.0 + k / q + k * k;
+
+        m_stage[1].b0 = 1.0;
+        m_stage[1].b1 = -2.0;
+        m_stage[1].b2 = 1.0;
+        m_stage[1].a1 = 2.0 * (k * k - 1.0) / a0;
+        m_stage[1].a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    // Hann-windowed sinc; phase p interpolates at (kTruePeakTaps/2 - p/4)
+    // samples behind the newest input. Phase 0 is the plain sample.
+    const double half = kTruePeakTaps / 2.0;
+    for (int p = 0; p < kTruePeakPhases; ++p)
+    {
+        for (int j = 0; j < kTruePeakTaps; ++j)
+        {
+            const double x    = j - half + static_cast<double>(p) / kTruePeakPhases;
+            const double sinc = (x == 0.0) ? 1.0 : std::sin(kPi * x) / (kPi * x);
+            const double win  = 0.5 * (1.0 + std::cos(kPi * x / half));
+            m_fir[p][j] = static_cast<float>(sinc * win);
+        }
+    }
+}
+
+double Rx2Loudness::Weight(ChannelState& ch, double x) const
+{
+    for (int s = 0; s < 2; ++s)
+    {
+        const Biquad& f = m_stage[s];
+        const double  w = x - f.a1 * ch.z1[s] - f.a2 * ch.z2[s];
+        x = f.b0 * w + f.b1 * ch.z1[s] + f.b2 * ch.z2[s];
+        ch.z2[s] = ch.z1[s];
+        ch.z1[s] = w;
+    }
+    return x;
+}
+
+float Rx2Loudness::OversampledPeak(ChannelState& ch, float x)
+{
+    // Newest sample at history[pos]; the mirror keeps 12 taps contiguous.
+    ch.historyPos = (ch.historyPos == 0) ? kTruePeakTaps - 1 : ch.historyPos - 1;
+    ch.history[ch.historyPos]                 = x;
+    ch.history[ch.historyPos + kTruePeakTaps] = x;
+
+    const float* h = &ch.history[ch.historyPos];
+
+    float peak = std::fabs(x);
+    for (int p = 1; p < kTruePeakPhases; ++p)
+    {
+        float acc = 0.0f;
+        for (int j = 0; j < kTruePeakTaps; ++j)
+            acc += h[j] * m_fir[p][j];
+
+        const float a = std::fabs(acc);
+        if (a > peak)
+            peak = a;
+    }
+    return peak;
+}
+
+void Rx2Loudness::CloseSegment()
+{
+    try
+    {
+        m_segments.push_back(m_segmentEnergy / static_cast<double>(m_segmentFrames));
+    }
+    catch (...)
+    {
+        // Losing a segment only shifts the gate slightly.
+    }
+
+    m_segmentEnergy = 0.0;
+    m_segmentFill   = 0;
+}
+
+void Rx2Loudness::Add(const float* left, const float* right, int frames)
+{
+    if (m_finished || m_sampleRate <= 0 || !left || frames <= 0)
+        return;
+
+    if (!right)
+        right = left;
+
+    double peak = m_truePeak;
+
+    for (int i = 0; i < frames; ++i)
+    {
+        double energy = 0.0;
+
+        const double l = Weight(m_state[0], left[i]);
+        energy += l * l;
+        const float pl = OversampledPeak(m_state[0], left[i]);
+        if (pl > peak) peak = pl;
+
+        if (m_channels > 1)
+        {
+            const double r = Weight(m_state[1], right[i]);
+            energy += r * r;
+            const float pr = OversampledPeak(m_state[1], right[i]);
+            if (pr > peak) peak = pr;
+        }
+
+        m_segmentEnergy += energy;
+        m_totalEnergy   += energy;
+
+        if (++m_segmentFill == m_segmentFrames)
+            CloseSegment();
+    }
+
+    m_totalFrames += frames;
+    m_truePeak     = peak;
+}
+
+void Rx2Loudness::Finish()
+{
+    if (m_finished)
+        return;
+
+    m_finished = true;
+
+    if (m_sampleRate <= 0 || m_totalFrames <= 0)
+        return;
+
+    // Gating blocks are 4 consecutive segments (400 ms, 100 ms hop).
+    std::vector<double> blocks;
+    try
+    {
+        for (std::size_t i = 3; i < m_segments.size(); ++i)
+            blocks.push_back((m_segments[i - 3] + m_segments[i - 2] +
+                              m_segments[i - 1] + m_segments[i]) / 4.0);
+    }
+    catch (...)
+    {
+        blocks.clear();
+    }
+
+    // Loops shorter than one block: measure the whole signal ungated.
+    if (blocks.empty())
+    {
+        const double energy = m_totalEnergy / static_cast<double>(m_totalFrames);
+        if (energy > 0.0 && EnergyToLufs(energy) > kAbsoluteGateLufs)
+        {
+            m_integrated  = EnergyToLufs(energy);
+            m_hasLoudness = true;
+        }
+        std::vector<double>().swap(m_segments);
+        return;
+    }
+
+    const double absoluteGate = LufsToEnergy(kAbsoluteGateLufs);
+
+    double sum   = 0.0;
+    size_t count = 0;
+    for (double b : blocks)
+    {
+        if (b > absoluteGate)
+        {
+            sum += b;
+            ++count;
+        }
+    }
+
+    if (count > 0)
+    {
+        const double relativeGate = LufsToEnergy(EnergyToLufs(sum / count) + kRelativeGateLu);
+
+        double gatedSum   = 0.0;
+        size_t gatedCount = 0;
+        for (double b : blocks)
+        {
+            if (b > absoluteGate && b > relativeGate)
+            {
+                gatedSum += b;
+                ++gatedCount;
+            }
+        }
+
+        if (gatedCount > 0)
+        {
+            m_integrated  = EnergyToLufs(gatedSum / gatedCount);
+            m_hasLoudness = true;
+        }
+    }
+
+    std::vector<double>().swap(m_segments);
+}
+
+bool Rx2Loudness::Serialize(std::vector<std::uint8_t>& out) const
+{
+    if (!m_finished)
+        return false;
+
+    const std::uint32_t header[3] = { kLoudnessMagic, kLoudnessVersion, m_hasLoudness ? 1u : 0u };
+    const double        values[2] = { m_integrated, m_truePeak };
+
+    try
+    {
+        out.resize(sizeof(header) + sizeof(values));
+        memcpy(out.data(), header, sizeof(header));
+        memcpy(out.data() + sizeof(header), values, sizeof(values));
+    }
+    catch (...)
+    {
+        out.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool Rx2Loudness::Deserialize(const std::uint8_t* data, std::size_t size)
+{
+    Clear();
+
+    std::uint32_t header[3];
+    double        values[2];
+
+    if (!data || size != sizeof(header) + sizeof(values))
+        return false;
+
+    memcpy(header, data, sizeof(header));
+    memcpy(values, data + sizeof(header), sizeof(values));
+
+    if (header[0] != kLoudnessMagic || header[1] != kLoudnessVersion || header[2] > 1
+        || !std::isfinite(values[0]) || !std::isfinite(values[1]) || values[1] < 0.0)
+        return false;
+
+    m_hasLoudness = header[2] != 0;
+    m_integrated  = values[0];
+    m_truePeak    = values[1];
+    m_finished    = true;
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Incremental ITU-R BS.1770 / EBU R128 meter fed from the render loop, so
+// ReplayGain values come out of the render that playback needs anyway.
+//
+// Integrated loudness uses K-weighting and the standard gating (400 ms
+// blocks with 75% overlap, -70 LUFS absolute and -10 LU relative gates).
+// True peak is estimated with 4x polyphase oversampling.
+class Rx2Loudness
+{
+public:
+    // ReplayGain 2.0 reference level.
+    static constexpr double kReferenceLufs = -18.0;
+
+    Rx2Loudness();
+
+    void Reset(int sampleRate, int channels);
+    void Clear();
+
+    // Same contract as Rx2PcmStore::Append(): `right` may be null.
+    void Add(const float* left, const float* right, int frames);
+
+    void Finish();
+
+    bool   IsFinished()   const { return m_finished; }
+    bool   HasResult()    const { return m_finished && m_hasLoudness; }
+    double IntegratedLufs() const { return m_integrated; }
+    double TruePeak()     const { return m_truePeak; }   // linear, 1.0 = full scale
+
+    // Gain that brings the track to kReferenceLufs, in dB.
+    double TrackGainDb()  const { return kReferenceLufs - m_integrated; }
+
+    bool Serialize(std::vector<std::uint8_t>& out) const;
+    bool Deserialize(const std::uint8_t* data, std::size_t size);
+
+private:
+    static const int kTruePeakTaps   = 12;   // per phase
+    static const int kTruePeakPhases = 4;
+
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    struct ChannelState
+    {
+        double z1[2];                      // direct form II state, per stage
+        double z2[2];
+        float  history[kTruePeakTaps * 2]; // mirrored ring for the oversampler
+        int    historyPos;
+    };
+
+    void   InitFilters();
+    double Weight(ChannelState& ch, double x) const;
+    float  OversampledPeak(ChannelState& ch, float x);
+    void   CloseSegment();
+
+    int          m_sampleRate;
+    int          m_channels;
+    bool         m_finished;
+    bool         m_hasLoudness;
+
+    Biquad       m_stage[2];   // high shelf, then high pass
+    float        m_fir[kTruePeakPhases][kTruePeakTaps];
+    ChannelState m_state[2];
+
+    std::int64_t m_segmentFrames;   // 100 ms
+    std::int64_t m_segmentFill;
+    double       m_segmentEnergy;   // sum over channels of squared weighted samples
+    double       m_totalEnergy;     // whole-signal fallback for very short loops
+    std::int64_t m_totalFrames;
+
+    std::vector<double> m_segments;   // mean-square energy per 100 ms
+    double       m_integrated;
+    double       m_truePeak;
+};
@@ -0,0 +1,210 @@
+#include "Rx2MemoryBudget.h"
+#include "Rx2Contention.h"
+#include "Rx2Metrics.h"
+
+#include <algorithm>
+#include <vector>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+struct BudgetEntry
+{
+    Rx2MemoryClient* client;
+    std::size_t      bytes;
+};
+
+static SRWLOCK                  g_lock        = SRWLOCK_INIT;
+static std::vector<BudgetEntry> g_entries;
+static std::size_t              g_totalBytes  = 0;
+static std::size_t              g_budgetBytes = 0;
+
+static HANDLE g_watchThread = nullptr;
+static HANDLE g_stopEvent   = nullptr;
+static HANDLE g_lowMemory   = nullptr;
+
+// ---------------- eviction ----------------
+
+// Evicts idle clients, oldest first, until the total drops to `target`.
+// `keep` is never evicted (the client currently charging). Called with
+// g_lock held; clients only try-lock themselves, so this cannot deadlock
+// against a decoder that is waiting to charge.
+static void EvictIdleLocked(std::size_t target, const Rx2MemoryClient* keep)
+{
+    if (g_totalBytes <= target)
+        return;
+
+    const std::uint64_t now = GetTickCount64();
+
+    std::vector<BudgetEntry*> candidates;
+    candidates.reserve(g_entries.size());
+
+    for (BudgetEntry& entry : g_entries)
+    {
+        if (entry.client == keep || entry.bytes == 0)
+            continue;
+        if (now - entry.client->LastUseTick() < kRx2ActiveWindowMs)
+            continue;
+        candidates.push_back(&entry);
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const BudgetEntry* a, const BudgetEntry* b)
+              {
+                  return a->client->LastUseTick() < b->client->LastUseTick();
+              });
+
+    for (BudgetEntry* entry : candidates)
+    {
+        if (g_totalBytes <= target)
+            break;
+
+        if (entry->client->EvictMemory() == 0)
+            continue;   // busy in Read(); try the next one
+
+        g_totalBytes -= entry->bytes;
+        entry->bytes  = 0;
+    }
+
+    Rx2MetricSetGauge(Rx2Gauge::PcmResidentBytes, g_totalBytes);
+}
+
+static DWORD WINAPI LowMemoryWatchProc(LPVOID /*param*/)
+{
+    HANDLE handles[2] = { g_stopEvent, g_lowMemory };
+
+    for (;;)
+    {
+        DWORD res = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        if (res != WAIT_OBJECT_0 + 1)
+            break;
+
+        Rx2LockExclusive(&g_lock, Rx2SyncSite::MemoryBudget);
+        EvictIdleLocked(0, nullptr);
+        ReleaseSRWLockExclusive(&g_lock);
+
+        // The notification stays signaled while memory is low; back off
+        // instead of spinning on it.
+        if (WaitForSingleObject(g_stopEvent, 5000) == WAIT_OBJECT_0)
+            break;
+    }
+
+    return 0;
+}
+
+// ---------------- public API ----------------
+
+void Rx2MemoryBudgetStart(std::size_t budgetBytes)
+{
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::MemoryBudget);
+    g_budgetBytes = budgetBytes;
+    ReleaseSRWLockExclusive(&g_lock);
+
+    if (g_watchThread)
+        return;
+
+    g_lowMemory = CreateMemoryResourceNotification(LowMemoryResourceNotification);
+    if (!g_lowMemory)
+        return;
+
+    g_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!g_stopEvent)
+    {
+        CloseHandle(g_lowMemory);
+        g_lowMemory = nullptr;
+        return;
+    }
+
+    g_watchThread = CreateThread(nullptr, 0, LowMemoryWatchProc, nullptr, 0, nullptr);
+    if (!g_watchThread)
+    {
+        CloseHandle(g_stopEvent);
+        CloseHandle(g_lowMemory);
+        g_stopEvent = nullptr;
+        g_lowMemory = nullptr;
+    }
+}
+
+void Rx2MemoryBudgetStop()
+{
+    if (g_watchThread)
+    {
+        SetEvent(g_stopEvent);
+        WaitForSingleObject(g_watchThread, INFINITE);
+        CloseHandle(g_watchThread);
+        g_watchThread = nullptr;
+    }
+
+    if (g_stopEvent)
+    {
+        CloseHandle(g_stopEvent);
+        g_stopEvent = nullptr;
+    }
+
+    if (g_lowMemory)
+    {
+        CloseHandle(g_lowMemory);
+        g_lowMemory = nullptr;
+    }
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::MemoryBudget);
+    g_budgetBytes = 0;
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+void Rx2MemoryBudgetRegister(Rx2MemoryClient* client)
+{
+    if (!client)
+        return;
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::MemoryBudget);
+    g_entries.push_back(BudgetEntry{ client, 0 });
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+void Rx2MemoryBudgetUnregister(Rx2MemoryClient* client)
+{
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::MemoryBudget);
+    for (size_t i = 0; i < g_entries.size(); ++i)
+    {
+        if (g_entries[i].client == client)
+        {
+            g_totalBytes -= g_entries[i].bytes;
+            g_entries[i]  = g_entries.back();
+            g_entries.pop_back();
+            break;
+        }
+    }
+    Rx2MetricSetGauge(Rx2Gauge::PcmResidentBytes, g_totalBytes);
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+void Rx2MemoryBudgetCharge(Rx2MemoryClient* client, std::size_t bytes)
+{
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::MemoryBudget);
+
+    for (BudgetEntry& entry : g_entries)
+    {
+        if (entry.client == client)
+        {
+            g_totalBytes -= entry.bytes;
+            g_totalBytes += bytes;
+            entry.bytes   = bytes;
+            break;
+        }
+    }
+    Rx2MetricSetGauge(Rx2Gauge::PcmResidentBytes, g_totalBytes);
+
+    if (g_budgetBytes > 0)
+        EvictIdleLocked(g_budgetBytes, client);
+
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+std::size_t Rx2MemoryBudgetTotalBytes()
+{
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::MemoryBudget);
+    const std::size_t total = g_totalBytes;
+    ReleaseSRWLockExclusive(&g_lock);
+    return total;
+}
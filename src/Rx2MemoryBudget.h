@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Something that holds evictable memory on behalf of the plugin (a decoder's
+// resident PCM). Implementations must be safe to call from any thread.
+class Rx2MemoryClient
+{
+public:
+    // Drops the evictable memory unless the client is busy right now.
+    // Returns the number of bytes released (0 when busy or already empty).
+    virtual std::size_t EvictMemory() = 0;
+
+    // GetTickCount64() of the last Read(); used for LRU ordering.
+    virtual std::uint64_t LastUseTick() const = 0;
+
+protected:
+    ~Rx2MemoryClient() {}
+};
+
+// Plugin-wide accountant for PCM held by live decoders.
+//
+// Clients report their resident bytes after every (re)render. When the total
+// exceeds the configured budget, the least recently read clients are asked to
+// evict until the total fits again. Clients read within the last
+// kRx2ActiveWindowMs are never evicted, so the budget is a soft limit while
+// several tracks are actually playing. A watcher thread also evicts every
+// idle client when Windows signals low physical memory.
+static const std::uint64_t kRx2ActiveWindowMs = 2000;
+
+// budgetBytes == 0 disables the budget (the low-memory watcher still runs).
+void Rx2MemoryBudgetStart(std::size_t budgetBytes);
+void Rx2MemoryBudgetStop();
+
+void Rx2MemoryBudgetRegister(Rx2MemoryClient* client);
+void Rx2MemoryBudgetUnregister(Rx2MemoryClient* client);   // first thing in the dtor
+
+// Records the client's current resident size and enforces the budget
+// against all other clients.
+void Rx2MemoryBudgetCharge(Rx2MemoryClient* client, std::size_t bytes);
+
+std::size_t Rx2MemoryBudgetTotalBytes();
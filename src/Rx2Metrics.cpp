@@ -0,0 +1,474 @@
+#include "Rx2Metrics.h"
+#include "Rx2Decoder.h"
+#include "Rx2RexShim.h"
+#include "Rx2Settings.h"
+
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+static const int kCounters   = static_cast<int>(Rx2Counter::Count);
+static const int kGauges     = static_cast<int>(Rx2Gauge::Count);
+static const int kHistograms = static_cast<int>(Rx2Histogram::Count);
+
+// Bucket 0 holds 0 us; bucket b > 0 holds [2^(b-1), 2^b) us. The last
+// bucket also takes everything longer (2^38 us is over three days).
+static const int kBuckets = 40;
+
+struct GaugeValue
+{
+    std::atomic<std::uint64_t> current;
+    std::atomic<std::uint64_t> peak;
+};
+
+struct HistogramData
+{
+    std::atomic<std::uint64_t> buckets[kBuckets];
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::int64_t>  sumUs;
+    std::atomic<std::int64_t>  maxUs;
+};
+
+// Rejects by the error reported to AIMP. Unlisted codes count as "other".
+struct RejectCode
+{
+    REX::REXError code;
+    const char*   name;
+};
+
+static const RejectCode kRejectCodes[] =
+{
+    { REX::kREXError_NoError,                  "not_rex" },
+    { REX::kREXError_OperationAbortedByUser,   "aborted" },
+    { REX::kREXError_NotEnoughMemoryForDLL,    "dll_out_of_memory" },
+    { REX::kREXError_UnableToLoadDLL,          "dll_unable_to_load" },
+    { REX::kREXError_DLLTooOld,                "dll_too_old" },
+    { REX::kREXError_DLLNotFound,              "dll_not_found" },
+    { REX::kREXError_APITooOld,                "api_too_old" },
+    { REX::kREXError_OutOfMemory,              "out_of_memory" },
+    { REX::kREXError_FileCorrupt,              "file_corrupt" },
+    { REX::kREXError_REX2FileTooNew,           "file_too_new" },
+    { REX::kREXError_FileHasZeroLoopLength,    "zero_loop_length" },
+    { REX::kREXError_OSVersionNotSupported,    "os_not_supported" },
+    { REX::kREXImplError_DLLNotInitialized,    "dll_not_initialized" },
+    { REX::kREXImplError_InvalidHandle,        "invalid_handle" },
+    { REX::kREXImplError_InvalidSize,          "invalid_size" },
+    { REX::kREXImplError_InvalidArgument,      "invalid_argument" },
+    { REX::kREXImplError_InvalidSlice,         "invalid_slice" },
+    { REX::kREXImplError_InvalidSampleRate,    "invalid_sample_rate" },
+    { REX::kREXImplError_BufferTooSmall,       "buffer_too_small" },
+    { REX::kREXImplError_InvalidTempo,         "invalid_tempo" },
+    { REX::kREXError_Undefined,                "undefined" },
+    { kRexError_NoActiveSlices,                "no_active_slices" },
+    { kRexError_CreateTimedOut,                "create_timed_out" },
+};
+
+static const int kRejectSlots = _countof(kRejectCodes) + 1;   // + "other"
+
+struct RexCallData
+{
+    HistogramData              time;
+    std::atomic<std::uint64_t> failed;      // returned an error, injected or not
+    std::atomic<std::uint64_t> injected;    // faults from the shim's script
+};
+
+static std::atomic<std::uint64_t> g_counters[kCounters];
+static GaugeValue                 g_gauges[kGauges];
+static HistogramData              g_histograms[kHistograms];
+static std::atomic<std::uint64_t> g_rejects[kRejectSlots];
+static RexCallData                g_rexCalls[kRx2RexEntryCount];
+static std::atomic<std::int64_t>  g_startTicks(0);
+
+static std::wstring g_dumpPath;              // set between Start and Stop
+static HANDLE       g_dumpEvent = nullptr;
+static HANDLE       g_dumpWait  = nullptr;
+
+static const char* const kCounterNames[kCounters] =
+{
+    "open_attempts", "opens", "rejects", "rex_create_timeouts", "bytes_ingested",
+    "frames_rendered", "rerenders", "negative_cache_hits", "negative_cache_misses",
+    "prefetch_hits", "prefetch_misses", "analysis_cache_hits", "analysis_cache_misses",
+    "library_index_hits", "library_index_misses",
+};
+
+static const char* const kGaugeNames[kGauges] = { "pcm_resident_bytes" };
+
+static const char* const kHistogramNames[kHistograms] =
+{
+    "open_us", "reject_us", "rex_create_us", "render_us", "initialize_us", "rex_library_load_us",
+};
+
+// ---------------- helpers ----------------
+
+static int BucketOf(std::int64_t us)
+{
+    int bucket = 0;
+    for (std::uint64_t v = us > 0 ? static_cast<std::uint64_t>(us) : 0; v; v >>= 1)
+        ++bucket;
+    return bucket < kBuckets ? bucket : kBuckets - 1;
+}
+
+static std::int64_t BucketUpperUs(int bucket)
+{
+    return bucket == 0 ? 0 : (std::int64_t(1) << bucket) - 1;
+}
+
+static void AtomicMax(std::atomic<std::int64_t>& target, std::int64_t value)
+{
+    std::int64_t prev = target.load(std::memory_order_relaxed);
+    while (value > prev && !target.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+// Upper bound of the bucket that holds the pct-th percentile, capped at the
+// largest value seen.
+static std::int64_t EstimatePercentileUs(const std::uint64_t* buckets, std::uint64_t count,
+                                         std::int64_t maxUs, double pct)
+{
+    if (!count)
+        return 0;
+
+    std::uint64_t rank = static_cast<std::uint64_t>(pct / 100.0 * count + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    std::uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b)
+    {
+        seen += buckets[b];
+        if (seen >= rank)
+            return BucketUpperUs(b) < maxUs ? BucketUpperUs(b) : maxUs;
+    }
+    return maxUs;
+}
+
+static void Record(HistogramData& d, std::int64_t us)
+{
+    d.buckets[BucketOf(us)].fetch_add(1, std::memory_order_relaxed);
+    d.count.fetch_add(1, std::memory_order_relaxed);
+    d.sumUs.fetch_add(us, std::memory_order_relaxed);
+    AtomicMax(d.maxUs, us);
+}
+
+static void Clear(HistogramData& d)
+{
+    for (std::atomic<std::uint64_t>& b : d.buckets)
+        b = 0;
+    d.count = 0;
+    d.sumUs = 0;
+    d.maxUs = 0;
+}
+
+// `"name": { "count": ..., <extra>"sum_us": ..., "buckets": [...] }`.
+// Buckets as [upper bound in us, count], empty ones left out.
+static void AppendHistogram(std::string& out, const char* name, const HistogramData& d,
+                            const std::string& extra)
+{
+    std::uint64_t buckets[kBuckets];
+    for (int b = 0; b < kBuckets; ++b)
+        buckets[b] = d.buckets[b].load(std::memory_order_relaxed);
+    const std::uint64_t count = d.count.load(std::memory_order_relaxed);
+    const std::int64_t  maxUs = d.maxUs.load(std::memory_order_relaxed);
+
+    Rx2AppendF(out, "\n    \"%s\": { \"count\": %llu, ", name, static_cast<unsigned long long>(count));
+    out += extra;
+    Rx2AppendF(out, "\"sum_us\": %lld, \"max_us\": %lld, "
+                    "\"p50_us\": %lld, \"p95_us\": %lld, \"p99_us\": %lld,\n      \"buckets\": [",
+               static_cast<long long>(d.sumUs.load(std::memory_order_relaxed)),
+               static_cast<long long>(maxUs),
+               static_cast<long long>(EstimatePercentileUs(buckets, count, maxUs, 50)),
+               static_cast<long long>(EstimatePercentileUs(buckets, count, maxUs, 95)),
+               static_cast<long long>(EstimatePercentileUs(buckets, count, maxUs, 99)));
+
+    bool firstBucket = true;
+    for (int b = 0; b < kBuckets; ++b)
+    {
+        if (!buckets[b])
+            continue;
+        Rx2AppendF(out, "%s[%lld, %llu]", firstBucket ? "" : ", ",
+                   static_cast<long long>(BucketUpperUs(b)), static_cast<unsigned long long>(buckets[b]));
+        firstBucket = false;
+    }
+    out += "] }";
+}
+
+static void CALLBACK DumpRequested(PVOID /*context*/, BOOLEAN /*timedOut*/)
+{
+    Rx2MetricsWriteJson(g_dumpPath.c_str());
+}
+
+// ---------------- recording ----------------
+
+void Rx2MetricAdd(Rx2Counter counter, std::uint64_t amount)
+{
+    const int c = static_cast<int>(counter);
+    if (c >= 0 && c < kCounters)
+        g_counters[c].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Rx2MetricSetGauge(Rx2Gauge gauge, std::uint64_t value)
+{
+    const int g = static_cast<int>(gauge);
+    if (g < 0 || g >= kGauges)
+        return;
+
+    GaugeValue& v = g_gauges[g];
+    v.current.store(value, std::memory_order_relaxed);
+
+    std::uint64_t prev = v.peak.load(std::memory_order_relaxed);
+    while (value > prev && !v.peak.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void Rx2MetricRecordUs(Rx2Histogram histogram, std::int64_t us)
+{
+    const int h = static_cast<int>(histogram);
+    if (h < 0 || h >= kHistograms)
+        return;
+
+    Record(g_histograms[h], us);
+}
+
+void Rx2MetricReject(REX::REXError err)
+{
+    Rx2MetricAdd(Rx2Counter::Rejects);
+
+    int slot = kRejectSlots - 1;
+    for (int i = 0; i < kRejectSlots - 1; ++i)
+    {
+        if (kRejectCodes[i].code == err)
+        {
+            slot = i;
+            break;
+        }
+    }
+    g_rejects[slot].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Rx2MetricRexCall(int entry, std::int64_t us, bool failed, bool injected)
+{
+    if (entry < 0 || entry >= kRx2RexEntryCount)
+        return;
+
+    RexCallData& d = g_rexCalls[entry];
+    Record(d.time, us);
+    if (failed)
+        d.failed.fetch_add(1, std::memory_order_relaxed);
+    if (injected)
+        d.injected.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::int64_t Rx2TicksPerSecond()
+{
+    static const std::int64_t freq = []()
+    {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        return static_cast<std::int64_t>(f.QuadPart);
+    }();
+    return freq;
+}
+
+void Rx2AppendF(std::string& out, const char* format, ...)
+{
+    char buf[256];
+    va_list args;
+    va_start(args, format);
+    const int n = vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    if (n > 0)
+        out.append(buf, static_cast<size_t>(n) < sizeof(buf) ? static_cast<size_t>(n) : sizeof(buf) - 1);
+}
+
+std::int64_t Rx2MetricNow()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    // The first reading of the process also marks the start of uptime.
+    std::int64_t expected = 0;
+    g_startTicks.compare_exchange_strong(expected, now.QuadPart, std::memory_order_relaxed);
+    return now.QuadPart;
+}
+
+std::int64_t Rx2MetricElapsedUs(std::int64_t since)
+{
+    return static_cast<std::int64_t>((Rx2MetricNow() - since) * 1e6 / Rx2TicksPerSecond());
+}
+
+// ---------------- dump ----------------
+
+std::string Rx2MetricsJson()
+{
+    std::string out;
+    out.reserve(4096);
+
+    const std::int64_t start = g_startTicks.load(std::memory_order_relaxed);
+    Rx2AppendF(out, "{\n  \"schema\": 1,\n  \"uptime_s\": %.1f,\n",
+               start ? (Rx2MetricNow() - start) / static_cast<double>(Rx2TicksPerSecond()) : 0.0);
+
+    out += "  \"counters\": {";
+    for (int c = 0; c < kCounters; ++c)
+    {
+        Rx2AppendF(out, "%s\n    \"%s\": %llu", c ? "," : "", kCounterNames[c],
+                   static_cast<unsigned long long>(g_counters[c].load(std::memory_order_relaxed)));
+    }
+    out += "\n  },\n";
+
+    out += "  \"gauges\": {";
+    for (int g = 0; g < kGauges; ++g)
+    {
+        Rx2AppendF(out, "%s\n    \"%s\": { \"current\": %llu, \"peak\": %llu }", g ? "," : "", kGaugeNames[g],
+                   static_cast<unsigned long long>(g_gauges[g].current.load(std::memory_order_relaxed)),
+                   static_cast<unsigned long long>(g_gauges[g].peak.load(std::memory_order_relaxed)));
+    }
+    out += "\n  },\n";
+
+    // Only the errors that occurred.
+    out += "  \"rejects\": {";
+    bool first = true;
+    for (int i = 0; i < kRejectSlots; ++i)
+    {
+        const std::uint64_t n = g_rejects[i].load(std::memory_order_relaxed);
+        if (!n)
+            continue;
+        Rx2AppendF(out, "%s\n    \"%s\": %llu", first ? "" : ",",
+                   i < kRejectSlots - 1 ? kRejectCodes[i].name : "other",
+                   static_cast<unsigned long long>(n));
+        first = false;
+    }
+    out += first ? "},\n" : "\n  },\n";
+
+    out += "  \"histograms\": {";
+    for (int h = 0; h < kHistograms; ++h)
+    {
+        if (h)
+            out += ",";
+        AppendHistogram(out, kHistogramNames[h], g_histograms[h], std::string());
+    }
+    out += "\n  },\n";
+
+    // Per REX function, only those called through the shim.
+    out += "  \"rex_api\": {";
+    first = true;
+    for (int e = 0; e < kRx2RexEntryCount; ++e)
+    {
+        const RexCallData& d = g_rexCalls[e];
+        if (!d.time.count.load(std::memory_order_relaxed))
+            continue;
+
+        std::string extra;
+        Rx2AppendF(extra, "\"failed\": %llu, \"injected\": %llu, ",
+                   static_cast<unsigned long long>(d.failed.load(std::memory_order_relaxed)),
+                   static_cast<unsigned long long>(d.injected.load(std::memory_order_relaxed)));
+        if (!first)
+            out += ",";
+        AppendHistogram(out, Rx2RexEntryName(e), d.time, extra);
+        first = false;
+    }
+    out += first ? "}\n}\n" : "\n  }\n}\n";
+    return out;
+}
+
+bool Rx2MetricsWriteJson(const wchar_t* path)
+{
+    if (!path || !*path)
+        return false;
+
+    const std::string  json = Rx2MetricsJson();
+    const std::wstring target(path);
+
+    // Write beside the file and rename, so a reader never sees half a dump.
+    wchar_t suffix[24];
+    _snwprintf_s(suffix, _countof(suffix), _TRUNCATE, L".%lu.tmp", GetCurrentThreadId());
+    const std::wstring temp = target + suffix;
+
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, json.data(), static_cast<DWORD>(json.size()), &written, nullptr)
+           && written == json.size();
+    CloseHandle(file);
+
+    if (ok)
+        ok = MoveFileExW(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+    if (!ok)
+        DeleteFileW(temp.c_str());
+    return ok;
+}
+
+void Rx2MetricsReset()
+{
+    for (std::atomic<std::uint64_t>& c : g_counters)
+        c = 0;
+    for (GaugeValue& g : g_gauges)
+    {
+        g.current = 0;
+        g.peak    = 0;
+    }
+    for (HistogramData& d : g_histograms)
+        Clear(d);
+    for (RexCallData& d : g_rexCalls)
+    {
+        Clear(d.time);
+        d.failed   = 0;
+        d.injected = 0;
+    }
+    for (std::atomic<std::uint64_t>& r : g_rejects)
+        r = 0;
+    g_startTicks = 0;
+}
+
+// ---------------- dump triggers ----------------
+
+void Rx2MetricsStart(IAIMPCore* core)
+{
+    Rx2MetricNow();
+
+    if (!core || !Rx2GetSettings().stats || g_dumpEvent)
+        return;
+
+    const std::wstring dir = Rx2ProfileDir(core);
+    if (dir.empty())
+        return;
+
+    g_dumpPath = dir + L"Stats.json";
+
+    // Auto-reset, so each SetEvent from outside produces one dump.
+    g_dumpEvent = CreateEventW(nullptr, FALSE, FALSE, L"Local\\AIMP-RX2Decoder-DumpStats");
+    if (g_dumpEvent
+        && !RegisterWaitForSingleObject(&g_dumpWait, g_dumpEvent, DumpRequested, nullptr,
+                                        INFINITE, WT_EXECUTEDEFAULT))
+    {
+        g_dumpWait = nullptr;
+    }
+}
+
+void Rx2MetricsStop()
+{
+    if (g_dumpWait)
+    {
+        // Waits for a dump in progress.
+        UnregisterWaitEx(g_dumpWait, INVALID_HANDLE_VALUE);
+        g_dumpWait = nullptr;
+    }
+    if (g_dumpEvent)
+    {
+        CloseHandle(g_dumpEvent);
+        g_dumpEvent = nullptr;
+    }
+
+    if (!g_dumpPath.empty())
+    {
+        Rx2MetricsWriteJson(g_dumpPath.c_str());
+        g_dumpPath.clear();
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+// Process-wide performance counters and latency histograms.
+//
+// Always on: an update is a relaxed atomic add or two, so they are safe on
+// every path except the audio thread's, which records nothing. Counters are
+// running totals; gauges hold a current value and its peak; histograms
+// bucket durations in microseconds by powers of two. Rx2MetricsWriteJson()
+// dumps everything, with per-function REX timings when the REX API shim
+// is on. Between Rx2MetricsStart() and Rx2MetricsStop() the
+// plugin writes <AIMP profile>\RX2Decoder\Stats.json whenever the named
+// event "Local\AIMP-RX2Decoder-DumpStats" is signaled, and once more at stop.
+
+#include "apiCore.h"
+#include "RexSdk.h"
+
+#include <cstdint>
+#include <string>
+
+enum class Rx2Counter
+{
+    OpenAttempts,          // CreateDecoder calls
+    Opens,                 // ... that returned a decoder
+    Rejects,               // ... that failed; split by REXError in the dump
+    RexCreateTimeouts,     // sandboxed REXCreate calls given up on
+    BytesIngested,         // file bytes read to hand to REXCreate
+    FramesRendered,        // PCM frames rendered, re-renders included
+    Rerenders,             // evicted PCM brought back
+    NegativeCacheHits,
+    NegativeCacheMisses,
+    PrefetchHits,          // opens served by the pre-rendered next track
+    PrefetchMisses,
+    AnalysisCacheHits,
+    AnalysisCacheMisses,
+    LibraryIndexHits,      // opens the library index answered for
+    LibraryIndexMisses,
+    Count
+};
+
+enum class Rx2Gauge
+{
+    PcmResidentBytes,      // PCM held by all live decoders
+    Count
+};
+
+enum class Rx2Histogram
+{
+    OpenUs,                // CreateDecoder that returned a decoder
+    RejectUs,              // CreateDecoder that failed
+    RexCreateUs,           // sandboxed REXCreate, thread start included
+    RenderUs,              // one loop or slice render into the PCM store
+    InitializeUs,          // Rx2Plugin::Initialize, once per session
+    RexLibraryLoadUs,      // first-use load of the REX library, found or not
+    Count
+};
+
+void Rx2MetricAdd(Rx2Counter counter, std::uint64_t amount = 1);
+void Rx2MetricSetGauge(Rx2Gauge gauge, std::uint64_t value);
+void Rx2MetricRecordUs(Rx2Histogram histogram, std::int64_t us);
+
+// A failed open: counts Rejects and the per-error total. kREXError_NoError
+// stands for "not a REX file at all" (WAV, empty stream).
+void Rx2MetricReject(REX::REXError err);
+
+// One call through the REX API shim (Rx2RexShim.h); `entry` is an
+// Rx2RexEntry. Only recorded while the shim is on.
+void Rx2MetricRexCall(int entry, std::int64_t us, bool failed, bool injected);
+
+// QueryPerformanceCounter ticks, and the microseconds since such a reading.
+std::int64_t Rx2MetricNow();
+std::int64_t Rx2MetricElapsedUs(std::int64_t since);
+std::int64_t Rx2TicksPerSecond();
+
+// printf into `out`, for the JSON writers (stats, trace); one call writes
+// at most 255 characters.
+void Rx2AppendF(std::string& out, const char* format, ...);
+
+std::string Rx2MetricsJson();
+bool        Rx2MetricsWriteJson(const wchar_t* path);
+void        Rx2MetricsReset();
+
+// Dump-on-request and at shutdown; no-ops unless RX2Decoder\Stats is set.
+void Rx2MetricsStart(IAIMPCore* core);
+void Rx2MetricsStop();
@@ -0,0 +1,113 @@
+#include "Rx2NegativeCache.h"
+#include "Rx2Contention.h"
+#include "Rx2Loop.h"
+
+#include <cwctype>
+#include <unordered_map>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+struct NegativeEntry
+{
+    Rx2FileKey    key;
+    REX::REXError err;
+    std::uint64_t stamp;   // insertion order, for trimming
+};
+
+static const size_t kMaxEntries = 256;
+
+static SRWLOCK                                        g_lock  = SRWLOCK_INIT;
+static std::unordered_map<std::wstring, NegativeEntry> g_entries;   // by MapKey()
+static std::uint64_t                                  g_stamp = 0;
+
+// ---------------- helpers ----------------
+
+// Paths compare case-insensitively (Rx2IsSameFile), so the map is keyed by
+// the lower-cased path: "Loop.rx2" and "loop.rx2" share one entry.
+static std::wstring MapKey(const std::wstring& path)
+{
+    std::wstring folded(path);
+    for (wchar_t& ch : folded)
+        ch = static_cast<wchar_t>(towlower(ch));
+    return folded;
+}
+
+// ---------------- public API ----------------
+
+bool Rx2NegativeCacheLookup(const Rx2FileKey& key, REX::REXError* err)
+{
+    std::wstring mapKey;
+    try
+    {
+        mapKey = MapKey(key.path);
+    }
+    catch (...)
+    {
+        return false;   // a miss only costs a full validation
+    }
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::NegativeCache);
+
+    bool hit = false;
+    auto it = g_entries.find(mapKey);
+    if (it != g_entries.end())
+    {
+        if (Rx2IsSameFile(it->second.key, key))
+        {
+            if (err)
+                *err = it->second.err;
+            hit = true;
+        }
+        else
+        {
+            g_entries.erase(it);   // file changed since it failed
+        }
+    }
+
+    ReleaseSRWLockExclusive(&g_lock);
+    return hit;
+}
+
+void Rx2NegativeCacheStore(const Rx2FileKey& key, REX::REXError err)
+{
+    if (Rx2IsTransientRexError(err))
+        return;
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::NegativeCache);
+
+    try
+    {
+        const std::wstring mapKey = MapKey(key.path);
+
+        if (g_entries.size() >= kMaxEntries && g_entries.find(mapKey) == g_entries.end())
+        {
+            auto oldest = g_entries.begin();
+            for (auto it = g_entries.begin(); it != g_entries.end(); ++it)
+            {
+                if (it->second.stamp < oldest->second.stamp)
+                    oldest = it;
+            }
+            g_entries.erase(oldest);
+        }
+
+        NegativeEntry& entry = g_entries[mapKey];
+        entry.key   = key;
+        entry.err   = err;
+        entry.stamp = ++g_stamp;
+    }
+    catch (...)
+    {
+        // Caching is best effort.
+    }
+
+    ReleaseSRWLockExclusive(&g_lock);
+}
+
+void Rx2NegativeCacheClear()
+{
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::NegativeCache);
+    g_entries.clear();
+    g_stamp = 0;
+    ReleaseSRWLockExclusive(&g_lock);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Rx2FileKey.h"
+#include "RexSdk.h"
+
+// Remembers why a file failed validation so that AIMP's repeated open
+// attempts (playlist refreshes, retries) fail immediately with the same
+// error instead of re-running preflight and a sandboxed REXCreate.
+// Transient failures (out of memory, DLL problems) are never cached.
+bool Rx2NegativeCacheLookup(const Rx2FileKey& key, REX::REXError* err);
+void Rx2NegativeCacheStore(const Rx2FileKey& key, REX::REXError err);
+void Rx2NegativeCacheClear();
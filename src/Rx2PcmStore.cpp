@@ -0,0 +1,992 @@
+#include "Rx2PcmStore.h"
+#include "Rx2RtAudit.h"
+
+#include <cmath>
+#include <cstring>
+#include <new>
+
+// ---------------- sample helpers ----------------
+
+static float ClampSampleFloat(float v)
+{
+    if (v < -1.0f) return -1.0f;
+    if (v >  1.0f) return  1.0f;
+    return v;
+}
+
+static float FullScale(Rx2SampleFormat format)
+{
+    switch (format)
+    {
+    case Rx2SampleFormat::Int16: return 32768.0f;
+    case Rx2SampleFormat::Int24: return 8388608.0f;
+    default:                     return 1.0f;
+    }
+}
+
+static std::int32_t LoadInt24(const std::uint8_t* p)
+{
+    std::int32_t v = static_cast<std::int32_t>(p[0])
+                   | (static_cast<std::int32_t>(p[1]) << 8)
+                   | (static_cast<std::int32_t>(p[2]) << 16);
+    return (v ^ 0x800000) - 0x800000; // sign-extend
+}
+
+static std::int32_t LoadInt16(const std::uint8_t* p)
+{
+    std::int16_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void StoreInt16(std::uint8_t* p, std::int32_t v)
+{
+    std::int16_t s = static_cast<std::int16_t>(v);
+    memcpy(p, &s, sizeof(s));
+}
+
+static void StoreInt24(std::uint8_t* p, std::int32_t v)
+{
+    p[0] = static_cast<std::uint8_t>(v & 0xFF);
+    p[1] = static_cast<std::uint8_t>((v >> 8) & 0xFF);
+    p[2] = static_cast<std::uint8_t>((v >> 16) & 0xFF);
+}
+
+static float LoadSampleAsFloat(const std::uint8_t* p, Rx2SampleFormat format)
+{
+    switch (format)
+    {
+    case Rx2SampleFormat::Int16:
+        return static_cast<float>(LoadInt16(p)) * (1.0f / 32768.0f);
+    case Rx2SampleFormat::Int24:
+        return static_cast<float>(LoadInt24(p)) * (1.0f / 8388608.0f);
+    default:
+    {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    }
+}
+
+// Stores an already clamped sample; `dither` is in LSBs and ignored for float.
+static void StoreSampleFromFloat(std::uint8_t* p, Rx2SampleFormat format, float v, float dither)
+{
+    if (format == Rx2SampleFormat::Float32)
+    {
+        memcpy(p, &v, sizeof(v));
+        return;
+    }
+
+    const float scale  = FullScale(format);
+    const float maxPos = scale - 1.0f;
+
+    float q = std::floor(v * scale + dither + 0.5f);
+    if (q < -scale) q = -scale;
+    if (q > maxPos) q = maxPos;
+
+    if (format == Rx2SampleFormat::Int16)
+        StoreInt16(p, static_cast<std::int32_t>(q));
+    else
+        StoreInt24(p, static_cast<std::int32_t>(q));
+}
+
+// Copies `samples` interleaved samples out in the storage format, or
+// widens them to float (the only two output formats Read() serves).
+static void ConvertSamples(const std::uint8_t* src, Rx2SampleFormat srcFormat,
+                           size_t samples,
+                           std::uint8_t* dst, Rx2SampleFormat dstFormat)
+{
+    const int srcBps = Rx2BytesPerSample(srcFormat);
+
+    if (dstFormat == srcFormat)
+    {
+        memcpy(dst, src, samples * srcBps);
+        return;
+    }
+
+    float* out = reinterpret_cast<float*>(dst);
+    for (size_t i = 0; i < samples; ++i)
+        out[i] = LoadSampleAsFloat(src + i * srcBps, srcFormat);
+}
+
+// ---------------- lossless block codec ----------------
+//
+// A compressed block is one bitstream: a flag bit (channel 1 coded as the
+// side signal ch1 - ch0), then per channel a 2-bit fixed predictor order and,
+// per partition of kPartitionSamples residuals, a 5-bit Rice parameter
+// followed by the zigzag-mapped residuals. The first `order` samples of a
+// channel use the lower orders, so every block decodes on its own.
+
+static const int kPartitionSamples = 256;
+static const int kRiceEscape       = 32;  // unary run that flags a raw 32-bit value
+static const int kMaxOrder         = 3;
+
+class BitWriter
+{
+public:
+    explicit BitWriter(std::vector<std::uint8_t>& out)
+        : m_out(out), m_acc(0), m_bits(0) {}
+
+    void Put(std::uint32_t value, int n) // n <= 32
+    {
+        m_acc   = (m_acc << n) | (value & ((std::uint64_t(1) << n) - 1));
+        m_bits += n;
+        while (m_bits >= 8)
+        {
+            m_bits -= 8;
+            m_out.push_back(static_cast<std::uint8_t>(m_acc >> m_bits));
+        }
+    }
+
+    void PutOnes(int count)
+    {
+        while (count >= 16)
+        {
+            Put(0xFFFF, 16);
+            count -= 16;
+        }
+        if (count > 0)
+            Put((1u << count) - 1, count);
+    }
+
+    void PutRice(std::uint32_t u, int k)
+    {
+        const std::uint32_t q = u >> k;
+        if (q >= static_cast<std::uint32_t>(kRiceEscape))
+        {
+            PutOnes(kRiceEscape);
+            Put(u, 32);
+            return;
+        }
+        PutOnes(static_cast<int>(q));
+        Put(0, 1);
+        Put(u, k);
+    }
+
+    void Flush()
+    {
+        if (m_bits > 0)
+            m_out.push_back(static_cast<std::uint8_t>(m_acc << (8 - m_bits)));
+        m_bits = 0;
+    }
+
+private:
+    std::vector<std::uint8_t>& m_out;
+    std::uint64_t              m_acc;
+    int                        m_bits;
+};
+
+class BitReader
+{
+public:
+    BitReader(const std::uint8_t* data, size_t size)
+        : m_p(data), m_end(data + size), m_acc(0), m_bits(0) {}
+
+    std::uint32_t Get(int n) // n <= 32
+    {
+        while (m_bits < n)
+        {
+            m_acc   = (m_acc << 8) | (m_p < m_end ? *m_p++ : 0);
+            m_bits += 8;
+        }
+        m_bits -= n;
+        return static_cast<std::uint32_t>((m_acc >> m_bits) & ((std::uint64_t(1) << n) - 1));
+    }
+
+    std::uint32_t GetRice(int k)
+    {
+        std::uint32_t q = 0;
+        while (q < static_cast<std::uint32_t>(kRiceEscape) && Get(1))
+            ++q;
+        if (q == static_cast<std::uint32_t>(kRiceEscape))
+            return Get(32);
+        return (q << k) | Get(k);
+    }
+
+private:
+    const std::uint8_t* m_p;
+    const std::uint8_t* m_end;
+    std::uint64_t       m_acc;
+    int                 m_bits;
+};
+
+static std::uint32_t Zigzag(std::int32_t v)
+{
+    return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+}
+
+static std::int32_t Unzigzag(std::uint32_t u)
+{
+    return static_cast<std::int32_t>(u >> 1) ^ -static_cast<std::int32_t>(u & 1);
+}
+
+static std::int32_t Predict(const std::int32_t* x, int n, int order)
+{
+    switch (n < order ? n : order)
+    {
+    case 0:  return 0;
+    case 1:  return x[n - 1];
+    case 2:  return 2 * x[n - 1] - x[n - 2];
+    default: return 3 * x[n - 1] - 3 * x[n - 2] + x[n - 3];
+    }
+}
+
+static std::uint64_t ResidualCost(const std::int32_t* x, int n, int order)
+{
+    std::uint64_t sum = 0;
+    for (int i = 0; i < n; ++i)
+        sum += Zigzag(x[i] - Predict(x, i, order));
+    return sum;
+}
+
+static int BestOrder(const std::int32_t* x, int n, std::uint64_t* costOut)
+{
+    int           best     = 0;
+    std::uint64_t bestCost = ResidualCost(x, n, 0);
+    for (int order = 1; order <= kMaxOrder; ++order)
+    {
+        std::uint64_t cost = ResidualCost(x, n, order);
+        if (cost < bestCost)
+        {
+            best     = order;
+            bestCost = cost;
+        }
+    }
+    if (costOut)
+        *costOut = bestCost;
+    return best;
+}
+
+// Rice parameter whose 2^k is close to the mean zigzag residual.
+static int RiceParameter(std::uint64_t sum, int count)
+{
+    int k = 0;
+    while (k < 30 && (static_cast<std::uint64_t>(count) << (k + 1)) <= sum)
+        ++k;
+    return k;
+}
+
+static void EncodeChannel(BitWriter& bw, const std::int32_t* x, int n, int order)
+{
+    bw.Put(static_cast<std::uint32_t>(order), 2);
+
+    for (int start = 0; start < n; start += kPartitionSamples)
+    {
+        const int end = (start + kPartitionSamples < n) ? start + kPartitionSamples : n;
+
+        std::uint64_t sum = 0;
+        for (int i = start; i < end; ++i)
+            sum += Zigzag(x[i] - Predict(x, i, order));
+
+        const int k = RiceParameter(sum, end - start);
+        bw.Put(static_cast<std::uint32_t>(k), 5);
+
+        for (int i = start; i < end; ++i)
+            bw.PutRice(Zigzag(x[i] - Predict(x, i, order)), k);
+    }
+}
+
+static void DecodeChannel(BitReader& br, std::int32_t* x, int n)
+{
+    const int order = static_cast<int>(br.Get(2));
+
+    for (int start = 0; start < n; start += kPartitionSamples)
+    {
+        const int end = (start + kPartitionSamples < n) ? start + kPartitionSamples : n;
+        const int k   = static_cast<int>(br.Get(5));
+
+        for (int i = start; i < end; ++i)
+            x[i] = Unzigzag(br.GetRice(k)) + Predict(x, i, order);
+    }
+}
+
+// ---------------- chunk memory ----------------
+
+static std::uint8_t* AllocateChunkMemory(size_t bytes)
+{
+    return static_cast<std::uint8_t*>(
+        ::operator new(bytes, std::align_val_t(Rx2PcmStore::kChunkAlign), std::nothrow));
+}
+
+static void FreeChunkMemory(std::uint8_t* p)
+{
+    ::operator delete(p, std::align_val_t(Rx2PcmStore::kChunkAlign));
+}
+
+int Rx2BytesPerSample(Rx2SampleFormat format)
+{
+    switch (format)
+    {
+    case Rx2SampleFormat::Int16: return 2;
+    case Rx2SampleFormat::Int24: return 3;
+    default:                     return 4;
+    }
+}
+
+// ---------------- Rx2PcmStore ----------------
+
+Rx2PcmStore::~Rx2PcmStore()
+{
+    Clear();
+}
+
+Rx2PcmStore::Rx2PcmStore()
+    : m_channels(0)
+    , m_frames(0)
+    , m_format(Rx2SampleFormat::Float32)
+    , m_bytesPerSample(4)
+    , m_compress(false)
+    , m_peak(0.0f)
+    , m_ditherState(0x9E3779B9u)
+    , m_silentFrames(0)
+    , m_stagingFrames(0)
+    , m_cacheClock(0)
+    , m_viewClock(0)
+    , m_readAhead(false)
+{
+    for (CacheSlot& slot : m_cache)
+    {
+        slot.block   = -1;
+        slot.lastUse = 0;
+    }
+    for (ViewSlot& view : m_views)
+    {
+        view.chunk   = -1;
+        view.lastUse = 0;
+    }
+}
+
+bool Rx2PcmStore::Reset(int channels, std::int64_t frames, Rx2SampleFormat format,
+                        bool compress, bool spill)
+{
+    Clear();
+
+    if (channels <= 0 || channels > 2 || frames < 0)
+        return false;
+
+    m_channels       = channels;
+    m_format         = format;
+    m_bytesPerSample = Rx2BytesPerSample(format);
+    m_compress       = compress && format != Rx2SampleFormat::Float32;
+
+    const size_t blockBytes = static_cast<size_t>(kBlockFrames) * channels * m_bytesPerSample;
+    const size_t blockCount = static_cast<size_t>((frames + kBlockFrames - 1) / kBlockFrames);
+
+    try
+    {
+        m_staging.resize(blockBytes);
+        m_blocks.reserve(blockCount);
+        m_extents.reserve(16);
+
+        m_chunks.reserve(blockCount * blockBytes / kChunkBytes + 1);
+
+        if (m_compress)
+        {
+            // One spare plane for the side-channel trial.
+            m_work.resize(static_cast<size_t>(kBlockFrames) * (channels + 1));
+            m_encoded.reserve(blockBytes + 64);
+            for (CacheSlot& slot : m_cache)
+                slot.samples.resize(blockBytes);
+        }
+    }
+    catch (...)
+    {
+        Clear();
+        return false;
+    }
+
+    if (spill)
+    {
+        // Size the file for raw blocks packed with worst-case tail waste per
+        // chunk; compressed blocks are only kept when smaller than raw.
+        const std::uint64_t alignedBlock = (blockBytes + kChunkAlign - 1) & ~static_cast<size_t>(kChunkAlign - 1);
+        const std::uint64_t usable       = kChunkBytes - alignedBlock;
+        const std::uint64_t chunks       = (blockCount * alignedBlock + usable - 1) / usable + 1;
+
+        if (!m_spill.Create(chunks * kChunkBytes))
+        {
+            Clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Rx2PcmStore::Clear()
+{
+    UnmapChunks();
+    std::vector<Block>().swap(m_blocks);
+    std::vector<Rx2PcmExtent>().swap(m_extents);
+    if (!m_spill.IsOpen())
+    {
+        for (Chunk& chunk : m_chunks)
+            FreeChunkMemory(chunk.data);
+    }
+    std::vector<Chunk>().swap(m_chunks);
+    m_spill.Close();
+    std::vector<std::uint8_t>().swap(m_staging);
+    std::vector<std::int32_t>().swap(m_work);
+    std::vector<std::uint8_t>().swap(m_encoded);
+    for (CacheSlot& slot : m_cache)
+    {
+        std::vector<std::uint8_t>().swap(slot.samples);
+        slot.block   = -1;
+        slot.lastUse = 0;
+    }
+
+    m_channels      = 0;
+    m_frames        = 0;
+    m_compress      = false;
+    m_peak          = 0.0f;
+    m_ditherState   = 0x9E3779B9u;
+    m_stagingFrames = 0;
+    m_silentFrames  = 0;
+    m_cacheClock    = 0;
+    m_readAhead     = false;
+}
+
+size_t Rx2PcmStore::ResidentBytes() const
+{
+    size_t bytes = m_chunks.capacity() * sizeof(Chunk)
+                 + m_staging.capacity()
+                 + m_encoded.capacity()
+                 + m_work.capacity() * sizeof(std::int32_t)
+                 + m_blocks.capacity() * sizeof(Block)
+                 + m_extents.capacity() * sizeof(Rx2PcmExtent);
+    if (!m_spill.IsOpen())
+    {
+        for (const Chunk& chunk : m_chunks)
+            bytes += chunk.capacity;
+    }
+    for (const CacheSlot& slot : m_cache)
+        bytes += slot.samples.capacity();
+    return bytes;
+}
+
+// TPDF dither: difference of two uniform variates, +/-1 LSB triangular.
+float Rx2PcmStore::NextDither()
+{
+    auto next = [this]() -> float
+    {
+        std::uint32_t x = m_ditherState;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        m_ditherState = x;
+        return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+    };
+
+    const float a = next();
+    const float b = next();
+    return a - b;
+}
+
+bool Rx2PcmStore::Append(const float* left, const float* right, int frames)
+{
+    if (frames <= 0)
+        return true;
+    if (!left || m_channels <= 0 || m_staging.empty())
+        return false;
+
+    const bool dither     = (m_format != Rx2SampleFormat::Float32);
+    const int  frameBytes = m_channels * m_bytesPerSample;
+    float      peak       = m_peak;
+
+    for (int f = 0; f < frames; ++f)
+    {
+        float in[2];
+        in[0] = ClampSampleFloat(left[f]);
+        in[1] = ClampSampleFloat((m_channels > 1 && right) ? right[f] : left[f]);
+
+        std::uint8_t* dst = m_staging.data() + static_cast<size_t>(m_stagingFrames) * frameBytes;
+        float prevDither = 0.0f;
+        for (int c = 0; c < m_channels; ++c)
+        {
+            const float v   = in[c];
+            const float mag = std::fabs(v);
+            if (mag > peak)
+                peak = mag;
+
+            // Digital silence stays exactly silent, and identical channels
+            // share one dither value so dual-mono survives quantization.
+            float d = 0.0f;
+            if (dither && v != 0.0f)
+                d = (c > 0 && v == in[0]) ? prevDither : NextDither();
+            prevDither = d;
+
+            StoreSampleFromFloat(dst, m_format, v, d);
+            dst += m_bytesPerSample;
+        }
+
+        ++m_stagingFrames;
+        ++m_frames;
+
+        if (m_stagingFrames == kBlockFrames && !CommitStaging())
+        {
+            m_peak = peak;
+            return false;
+        }
+    }
+
+    m_peak = peak;
+    return true;
+}
+
+bool Rx2PcmStore::Finish()
+{
+    if (m_stagingFrames > 0 && !CommitStaging())
+        return false;
+
+    // Encoder scratch and the staging block are only needed while appending.
+    std::vector<std::uint8_t>().swap(m_staging);
+    std::vector<std::int32_t>().swap(m_work);
+    std::vector<std::uint8_t>().swap(m_encoded);
+
+    // From here on reads map the chunk after the one being played.
+    m_readAhead = true;
+
+    // Trim the last chunk so short loops do not pin a whole chunk.
+    if (!m_chunks.empty() && !m_spill.IsOpen())
+    {
+        Chunk& last = m_chunks.back();
+        const std::uint32_t trimmed = (last.used + kChunkAlign - 1) & ~(kChunkAlign - 1);
+        if (trimmed < last.capacity)
+        {
+            std::uint8_t* data = AllocateChunkMemory(trimmed > 0 ? trimmed : kChunkAlign);
+            if (data)
+            {
+                memcpy(data, last.data, last.used);
+                FreeChunkMemory(last.data);
+                last.data     = data;
+                last.capacity = trimmed > 0 ? trimmed : kChunkAlign;
+            }
+        }
+    }
+
+    return true;
+}
+
+std::uint8_t* Rx2PcmStore::AllocatePayload(std::uint32_t bytes, Block& block)
+{
+    const bool spilled = m_spill.IsOpen();
+
+    if (m_chunks.empty() || m_chunks.back().capacity - m_chunks.back().used < bytes)
+    {
+        Chunk chunk{};
+        if (spilled)
+        {
+            // Mapped below; only check that the file has room for it.
+            if ((static_cast<std::uint64_t>(m_chunks.size()) + 1) * kChunkBytes > m_spill.Capacity())
+                return nullptr;
+        }
+        else
+        {
+            chunk.data = AllocateChunkMemory(kChunkBytes);
+            if (!chunk.data)
+                return nullptr;
+        }
+        chunk.capacity = kChunkBytes;
+        chunk.used     = 0;
+
+        try
+        {
+            m_chunks.push_back(chunk);
+        }
+        catch (...)
+        {
+            if (!spilled)
+                FreeChunkMemory(chunk.data);
+            return nullptr;
+        }
+    }
+
+    const std::uint32_t index = static_cast<std::uint32_t>(m_chunks.size() - 1);
+    std::uint8_t*       base  = spilled ? MapChunk(index) : m_chunks.back().data;
+    if (!base)
+        return nullptr;
+
+    Chunk& chunk = m_chunks.back();
+    block.chunk  = index;
+    block.offset = chunk.used;
+
+    // Keep payloads cache-line aligned inside the chunk.
+    chunk.used += (bytes + kChunkAlign - 1) & ~(kChunkAlign - 1);
+    if (chunk.used > chunk.capacity)
+        chunk.used = chunk.capacity;
+
+    return base + block.offset;
+}
+
+void Rx2PcmStore::Prefault()
+{
+    if (m_spill.IsOpen())
+        return;
+
+    for (const Chunk& chunk : m_chunks)
+        Rx2SpillFile::Prefetch(chunk.data, chunk.used);
+
+    for (const CacheSlot& slot : m_cache)
+        Rx2SpillFile::Prefetch(slot.samples.data(), slot.samples.size());
+}
+
+// Spill mode: returns the view of chunk `index`, mapping it in place of the
+// least recently used view if needed. Null if the view cannot be mapped.
+std::uint8_t* Rx2PcmStore::MapChunk(std::uint32_t index)
+{
+    Chunk& chunk = m_chunks[index];
+
+    ViewSlot* victim = &m_views[0];
+    for (ViewSlot& view : m_views)
+    {
+        if (view.chunk == index && chunk.data)
+        {
+            view.lastUse = ++m_viewClock;
+            return chunk.data;
+        }
+        if (view.lastUse < victim->lastUse)
+            victim = &view;
+    }
+
+    RX2_RT_NOTE(Rx2RtViolation::Blocking, "Rx2PcmStore::MapChunk");
+
+    if (victim->chunk >= 0)
+    {
+        Chunk& old = m_chunks[static_cast<size_t>(victim->chunk)];
+        Rx2SpillFile::UnmapView(old.data);
+        old.data = nullptr;
+    }
+
+    chunk.data      = m_spill.MapView(static_cast<std::uint64_t>(index) * kChunkBytes, kChunkBytes);
+    victim->chunk   = chunk.data ? index : -1;
+    victim->lastUse = chunk.data ? ++m_viewClock : 0;
+    return chunk.data;
+}
+
+void Rx2PcmStore::UnmapChunks()
+{
+    for (ViewSlot& view : m_views)
+    {
+        if (view.chunk >= 0)
+        {
+            Chunk& chunk = m_chunks[static_cast<size_t>(view.chunk)];
+            Rx2SpillFile::UnmapView(chunk.data);
+            chunk.data = nullptr;
+        }
+        view.chunk   = -1;
+        view.lastUse = 0;
+    }
+    m_viewClock = 0;
+}
+
+const std::uint8_t* Rx2PcmStore::Payload(const Block& block)
+{
+    if (!m_spill.IsOpen())
+        return m_chunks[block.chunk].data + block.offset;
+
+    std::uint8_t* base = MapChunk(block.chunk);
+    if (!base)
+        return nullptr;
+
+    // Read-ahead: map the next chunk now and let the memory manager page it
+    // in while this one is consumed. The current view is the most recently
+    // used, so this never unmaps it.
+    const std::uint32_t next = block.chunk + 1;
+    if (m_readAhead && next < m_chunks.size() && !m_chunks[next].data)
+        Rx2SpillFile::Prefetch(MapChunk(next), kChunkBytes);
+
+    return base + block.offset;
+}
+
+bool Rx2PcmStore::CommitStaging()
+{
+    const int    frames      = m_stagingFrames;
+    const size_t sampleCount = static_cast<size_t>(frames) * m_channels;
+    std::uint8_t* staging    = m_staging.data();
+
+    Block block{};
+    block.chunk    = 0;
+    block.offset   = 0;
+    block.bytes    = 0;
+    block.kind     = kBlockSilent;
+    block.channels = 0;
+
+    // Exact digital silence is kept as an extent only. Float -0.0 counts
+    // as silence (it reads back as +0.0); integer zero is all zero bytes.
+    bool silent = true;
+    if (m_format == Rx2SampleFormat::Float32)
+    {
+        for (size_t i = 0; i < sampleCount && silent; ++i)
+        {
+            std::uint32_t bits;
+            memcpy(&bits, staging + i * sizeof(bits), sizeof(bits));
+            silent = (bits & 0x7FFFFFFFu) == 0;
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < sampleCount * m_bytesPerSample && silent; ++i)
+            silent = staging[i] == 0;
+    }
+
+    if (!silent)
+    {
+        block.kind     = kBlockRaw;
+        block.channels = static_cast<std::uint8_t>(m_channels);
+
+        // Identical channels collapse to one stored channel.
+        if (m_channels == 2)
+        {
+            const int bps  = m_bytesPerSample;
+            bool      mono = true;
+            for (int f = 0; f < frames && mono; ++f)
+                mono = memcmp(staging + f * 2 * bps, staging + f * 2 * bps + bps, bps) == 0;
+
+            if (mono)
+            {
+                for (int f = 1; f < frames; ++f)
+                    memmove(staging + f * bps, staging + f * 2 * bps, bps);
+                block.channels = 1;
+            }
+        }
+
+        const size_t rawBytes = static_cast<size_t>(frames) * block.channels * m_bytesPerSample;
+        const std::uint8_t* payload = staging;
+        size_t              bytes   = rawBytes;
+
+        if (m_compress && EncodeStaging(frames, block.channels) && m_encoded.size() < rawBytes)
+        {
+            payload    = m_encoded.data();
+            bytes      = m_encoded.size();
+            block.kind = kBlockCompressed;
+        }
+
+        block.bytes = static_cast<std::uint32_t>(bytes);
+
+        std::uint8_t* dst = AllocatePayload(block.bytes, block);
+        if (!dst)
+            return false;
+        memcpy(dst, payload, bytes);
+    }
+
+    const Rx2PcmExtentKind kind =
+        block.kind == kBlockSilent                    ? Rx2PcmExtentKind::Silent :
+        (block.channels == 1 && m_channels == 2)      ? Rx2PcmExtentKind::DualMono :
+                                                        Rx2PcmExtentKind::Full;
+    const std::int64_t firstFrame = static_cast<std::int64_t>(m_blocks.size()) * kBlockFrames;
+
+    try
+    {
+        m_blocks.push_back(block);
+
+        if (!m_extents.empty() && m_extents.back().kind == kind)
+            m_extents.back().frames += frames;
+        else
+            m_extents.push_back(Rx2PcmExtent{ firstFrame, frames, kind });
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    if (kind == Rx2PcmExtentKind::Silent)
+        m_silentFrames += frames;
+
+    m_stagingFrames = 0;
+    return true;
+}
+
+bool Rx2PcmStore::EncodeStaging(int frames, int channels)
+{
+    m_encoded.clear();
+
+    try
+    {
+        // Deinterleave into planar integers.
+        std::int32_t* planes[3] = { m_work.data(),
+                                    m_work.data() + kBlockFrames,
+                                    m_work.data() + 2 * static_cast<size_t>(kBlockFrames) };
+        const std::uint8_t* src = m_staging.data();
+        for (int f = 0; f < frames; ++f)
+        {
+            for (int c = 0; c < channels; ++c)
+            {
+                planes[c][f] = (m_format == Rx2SampleFormat::Int16) ? LoadInt16(src) : LoadInt24(src);
+                src += m_bytesPerSample;
+            }
+        }
+
+        BitWriter bw(m_encoded);
+
+        std::uint64_t costCh0 = 0;
+        const int orderCh0 = BestOrder(planes[0], frames, &costCh0);
+
+        if (channels == 1)
+        {
+            bw.Put(0, 1);
+            EncodeChannel(bw, planes[0], frames, orderCh0);
+        }
+        else
+        {
+            for (int f = 0; f < frames; ++f)
+                planes[2][f] = planes[1][f] - planes[0][f];
+
+            std::uint64_t costCh1  = 0;
+            std::uint64_t costSide = 0;
+            const int orderCh1  = BestOrder(planes[1], frames, &costCh1);
+            const int orderSide = BestOrder(planes[2], frames, &costSide);
+            const bool useSide  = costSide < costCh1;
+
+            bw.Put(useSide ? 1 : 0, 1);
+            EncodeChannel(bw, planes[0], frames, orderCh0);
+            if (useSide)
+                EncodeChannel(bw, planes[2], frames, orderSide);
+            else
+                EncodeChannel(bw, planes[1], frames, orderCh1);
+        }
+
+        bw.Flush();
+    }
+    catch (...)
+    {
+        m_encoded.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void Rx2PcmStore::DecodeBlock(const Block& block, int frames, std::uint8_t* dst)
+{
+    // Planar decode scratch on the stack keeps Read() free of allocations.
+    std::int32_t plane[2][kBlockFrames];
+
+    const std::uint8_t* payload = Payload(block);
+    if (!payload)
+    {
+        // Spill view could not be mapped: play silence rather than crash.
+        memset(dst, 0, static_cast<size_t>(frames) * m_channels * m_bytesPerSample);
+        return;
+    }
+
+    BitReader br(payload, block.bytes);
+    const bool side = br.Get(1) != 0;
+
+    DecodeChannel(br, plane[0], frames);
+    if (block.channels > 1)
+    {
+        DecodeChannel(br, plane[1], frames);
+        if (side)
+        {
+            for (int f = 0; f < frames; ++f)
+                plane[1][f] += plane[0][f];
+        }
+    }
+
+    // Dual-mono blocks are expanded here so cached blocks are always full.
+    for (int f = 0; f < frames; ++f)
+    {
+        for (int c = 0; c < m_channels; ++c)
+        {
+            const std::int32_t v = plane[c < block.channels ? c : 0][f];
+            if (m_format == Rx2SampleFormat::Int16)
+                StoreInt16(dst, v);
+            else
+                StoreInt24(dst, v);
+            dst += m_bytesPerSample;
+        }
+    }
+}
+
+const std::uint8_t* Rx2PcmStore::BlockSamples(std::int64_t index, int* storedChannels)
+{
+    *storedChannels = m_channels;
+
+    // Trailing block still being filled.
+    if (index >= static_cast<std::int64_t>(m_blocks.size()))
+        return m_staging.data();
+
+    const Block& block = m_blocks[static_cast<size_t>(index)];
+    if (block.kind == kBlockSilent)
+    {
+        *storedChannels = 0;
+        return nullptr;
+    }
+    if (block.kind == kBlockRaw)
+    {
+        const std::uint8_t* payload = Payload(block);
+        *storedChannels = payload ? block.channels : 0;
+        return payload;
+    }
+
+    CacheSlot* victim = &m_cache[0];
+    for (CacheSlot& slot : m_cache)
+    {
+        if (slot.block == index)
+        {
+            slot.lastUse = ++m_cacheClock;
+            return slot.samples.data();
+        }
+        if (slot.lastUse < victim->lastUse)
+            victim = &slot;
+    }
+
+    std::int64_t remaining = m_frames - index * kBlockFrames;
+    const int frames = static_cast<int>(remaining < kBlockFrames ? remaining : kBlockFrames);
+
+    DecodeBlock(block, frames, victim->samples.data());
+    victim->block   = index;
+    victim->lastUse = ++m_cacheClock;
+    return victim->samples.data();
+}
+
+void Rx2PcmStore::Read(std::int64_t frame, int frames, void* dst, Rx2SampleFormat outFormat)
+{
+    if (!dst || frames <= 0 || frame < 0 || frame + frames > m_frames)
+        return;
+    if (outFormat != m_format)
+        outFormat = Rx2SampleFormat::Float32;
+
+    const int     outBps        = Rx2BytesPerSample(outFormat);
+    const size_t  outFrameBytes = static_cast<size_t>(m_channels) * outBps;
+    std::uint8_t* out           = static_cast<std::uint8_t*>(dst);
+
+    while (frames > 0)
+    {
+        const std::int64_t index   = frame / kBlockFrames;
+        const int          inBlock = static_cast<int>(frame - index * kBlockFrames);
+        const int          n       = (frames < kBlockFrames - inBlock) ? frames : kBlockFrames - inBlock;
+
+        int                 stored = 0;
+        const std::uint8_t* block  = BlockSamples(index, &stored);
+
+        if (stored == 0)
+        {
+            // Zero bytes are silence in every output format.
+            memset(out, 0, static_cast<size_t>(n) * outFrameBytes);
+        }
+        else if (stored == m_channels)
+        {
+            const std::uint8_t* src = block + static_cast<size_t>(inBlock) * stored * m_bytesPerSample;
+            ConvertSamples(src, m_format, static_cast<size_t>(n) * m_channels, out, outFormat);
+        }
+        else
+        {
+            // Dual-mono: convert each stored sample once, then duplicate it.
+            const std::uint8_t* src = block + static_cast<size_t>(inBlock) * m_bytesPerSample;
+            std::uint8_t*       o   = out;
+            for (int f = 0; f < n; ++f)
+            {
+                ConvertSamples(src, m_format, 1, o, outFormat);
+                memcpy(o + outBps, o, outBps);
+                src += m_bytesPerSample;
+                o   += outFrameBytes;
+            }
+        }
+
+        out    += static_cast<size_t>(n) * outFrameBytes;
+        frame  += n;
+        frames -= n;
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Rx2SpillFile.h"
+
+// Sample representations used for resident PCM and for Read() output.
+enum class Rx2SampleFormat
+{
+    Float32,
+    Int16,
+    Int24    // packed little-endian, 3 bytes per sample
+};
+
+int Rx2BytesPerSample(Rx2SampleFormat format);
+
+enum class Rx2PcmExtentKind
+{
+    Silent,     // exact digital silence, nothing stored
+    DualMono,   // stereo with identical channels, one channel stored
+    Full
+};
+
+// A run of consecutive frames sharing one storage layout.
+struct Rx2PcmExtent
+{
+    std::int64_t     firstFrame;
+    std::int64_t     frames;
+    Rx2PcmExtentKind kind;
+};
+
+// Interleaved PCM rendered from a REX loop.
+//
+// Planar float batches from the renderer are clamped and, for integer
+// formats, quantized with TPDF dither as they are appended. Samples are kept
+// in fixed-size blocks of kBlockFrames frames whose payloads are packed into
+// cache-aligned chunks of kChunkBytes, so no single allocation grows with
+// the loop length. Silent blocks store nothing
+// and dual-mono stereo blocks store one channel; both are recorded in an
+// extent map and expanded by Read(). With compression enabled, integer
+// blocks are coded losslessly (fixed linear predictor + Rice codes) and
+// decoded on demand into a small cache. Read() serves the storage format
+// as a straight copy, or float.
+//
+// In spill mode the chunks live in a temporary memory-mapped file instead of
+// the heap; only kMappedChunks views are mapped at a time, and reads map and
+// prefetch the following chunk ahead of the playback position.
+class Rx2PcmStore
+{
+public:
+    static const int           kBlockFrames = 4096;
+    static const int           kCacheBlocks = 4;
+    static const std::uint32_t kChunkBytes  = 256 * 1024;
+    static const std::uint32_t kChunkAlign  = 64;
+    static const int           kMappedChunks = 4;
+
+    Rx2PcmStore();
+    ~Rx2PcmStore();
+
+    Rx2PcmStore(const Rx2PcmStore&)            = delete;
+    Rx2PcmStore& operator=(const Rx2PcmStore&) = delete;
+
+    // Drops previous content and prepares for `frames` frames. Compression
+    // only applies to integer formats; `spill` backs the chunks with a temp
+    // file. Returns false on allocation (or temp file) failure.
+    bool Reset(int channels, std::int64_t frames, Rx2SampleFormat format,
+               bool compress = false, bool spill = false);
+    void Clear();
+
+    // Appends planar float frames. `right` is ignored for mono and may be
+    // null for stereo (left is duplicated). Returns false on allocation failure.
+    bool Append(const float* left, const float* right, int frames);
+
+    // Commits the trailing partial block; call once after the last Append().
+    bool Finish();
+
+    // Writes `frames` interleaved frames starting at `frame` into `dst`, in
+    // the storage format (a straight copy) or as Float32; any other
+    // `outFormat` is served as Float32. The caller keeps the range inside
+    // [0, Frames()).
+    void Read(std::int64_t frame, int frames, void* dst, Rx2SampleFormat outFormat);
+
+    // Asks the memory manager to bring the heap chunks and the decode cache
+    // into the working set, so Read() does not page-fault on first touch.
+    // Spilled stores are left alone; their views are mapped on demand.
+    void Prefault();
+
+    // Answered from the extent map and the input peak tracked by Append();
+    // the samples themselves are not rescanned.
+    bool HasSignalAbove(float threshold) const
+    {
+        return m_silentFrames < m_frames && m_peak > threshold;
+    }
+
+    // Storage layout runs covering all committed frames (after Finish()).
+    const std::vector<Rx2PcmExtent>& Extents() const { return m_extents; }
+
+    int             Channels()      const { return m_channels; }
+    std::int64_t    Frames()        const { return m_frames; }
+    Rx2SampleFormat Format()        const { return m_format; }
+    bool            IsSpilled()     const { return m_spill.IsOpen(); }
+    std::size_t     ResidentBytes() const;   // heap only; spilled chunks excluded
+
+private:
+    enum BlockKind : std::uint8_t
+    {
+        kBlockSilent,
+        kBlockRaw,
+        kBlockCompressed
+    };
+
+    struct Chunk
+    {
+        std::uint8_t* data;      // heap block, or mapped view (null if unmapped)
+        std::uint32_t capacity;
+        std::uint32_t used;
+    };
+
+    struct Block
+    {
+        std::uint32_t chunk;     // index into m_chunks
+        std::uint32_t offset;    // within the chunk
+        std::uint32_t bytes;
+        BlockKind     kind;
+        std::uint8_t  channels;  // stored channels: 0 silent, 1 mono/dual-mono, 2
+    };
+
+    struct CacheSlot
+    {
+        std::int64_t              block;
+        std::uint64_t             lastUse;
+        std::vector<std::uint8_t> samples;   // raw block in storage format
+    };
+
+    struct ViewSlot
+    {
+        std::int64_t  chunk;     // -1 when free
+        std::uint64_t lastUse;
+    };
+
+    float               NextDither();
+    bool                CommitStaging();
+    std::uint8_t*       AllocatePayload(std::uint32_t bytes, Block& block);
+    std::uint8_t*       MapChunk(std::uint32_t index);
+    void                UnmapChunks();
+    const std::uint8_t* Payload(const Block& block);
+    bool                EncodeStaging(int frames, int channels);
+    void                DecodeBlock(const Block& block, int frames, std::uint8_t* dst);
+    const std::uint8_t* BlockSamples(std::int64_t index, int* storedChannels);
+
+    int                       m_channels;
+    std::int64_t              m_frames;        // committed + staged
+    Rx2SampleFormat           m_format;
+    int                       m_bytesPerSample;
+    bool                      m_compress;
+    float                     m_peak;
+    std::uint32_t             m_ditherState;
+
+    std::vector<Block>        m_blocks;
+    std::vector<Rx2PcmExtent> m_extents;
+    std::int64_t              m_silentFrames;
+    std::vector<Chunk>        m_chunks;        // block payloads
+    std::vector<std::uint8_t> m_staging;       // block being filled
+    int                       m_stagingFrames;
+
+    // Compression scratch and decoded-block cache (sized in Reset()).
+    std::vector<std::int32_t> m_work;
+    std::vector<std::uint8_t> m_encoded;
+    CacheSlot                 m_cache[kCacheBlocks];
+    std::uint64_t             m_cacheClock;
+
+    // Spill mode: backing file and the currently mapped chunk views.
+    Rx2SpillFile              m_spill;
+    ViewSlot                  m_views[kMappedChunks];
+    std::uint64_t             m_viewClock;
+    bool                      m_readAhead;     // set by Finish()
+};
@@ -0,0 +1,337 @@
+#include "Rx2PeakIndex.h"
+
+#include <cmath>
+#include <cstring>
+
+// ---------------- helpers ----------------
+
+static const std::uint32_t kPeakMagic   = 0x50325852u;   // "RX2P"
+static const std::uint32_t kPeakVersion = 1;
+
+static std::int16_t QuantizeDown(float v)
+{
+    if (v <= -1.0f)
+        return -32767;
+    if (v >= 1.0f)
+        return 32767;
+    return static_cast<std::int16_t>(std::floor(v * 32767.0f));
+}
+
+static std::int16_t QuantizeUp(float v)
+{
+    if (v <= -1.0f)
+        return -32767;
+    if (v >= 1.0f)
+        return 32767;
+    return static_cast<std::int16_t>(std::ceil(v * 32767.0f));
+}
+
+template <typename T>
+static void PutValue(std::vector<std::uint8_t>& out, T v)
+{
+    const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(&v);
+    out.insert(out.end(), p, p + sizeof(T));
+}
+
+template <typename T>
+static bool GetValue(const std::uint8_t*& p, const std::uint8_t* end, T* v)
+{
+    if (static_cast<std::size_t>(end - p) < sizeof(T))
+        return false;
+    memcpy(v, p, sizeof(T));
+    p += sizeof(T);
+    return true;
+}
+
+// ---------------- Rx2PeakIndex ----------------
+
+Rx2PeakIndex::Rx2PeakIndex()
+    : m_channels(0)
+    , m_frames(0)
+    , m_finished(false)
+{
+    for (Accumulator& acc : m_acc)
+        ResetAccumulator(acc);
+}
+
+void Rx2PeakIndex::Reset(int channels)
+{
+    Clear();
+    m_channels = (channels == 2) ? 2 : 1;
+}
+
+void Rx2PeakIndex::Clear()
+{
+    for (int level = 0; level < kLevels; ++level)
+    {
+        std::vector<Rx2Peak>().swap(m_levels[level]);
+        ResetAccumulator(m_acc[level]);
+    }
+
+    m_channels = 0;
+    m_frames   = 0;
+    m_finished = false;
+}
+
+void Rx2PeakIndex::ResetAccumulator(Accumulator& acc)
+{
+    acc.min[0] = acc.min[1] =  1.0f;
+    acc.max[0] = acc.max[1] = -1.0f;
+    acc.count  = 0;
+}
+
+void Rx2PeakIndex::Add(const float* left, const float* right, int frames)
+{
+    if (m_finished || m_channels <= 0 || !left || frames <= 0)
+        return;
+
+    if (!right)
+        right = left;
+
+    Accumulator& acc = m_acc[0];
+
+    for (int i = 0; i < frames; ++i)
+    {
+        const float l = left[i];
+        if (l < acc.min[0]) acc.min[0] = l;
+        if (l > acc.max[0]) acc.max[0] = l;
+
+        if (m_channels > 1)
+        {
+            const float r = right[i];
+            if (r < acc.min[1]) acc.min[1] = r;
+            if (r > acc.max[1]) acc.max[1] = r;
+        }
+
+        if (++acc.count == kBaseFrames)
+        {
+            Emit(0, acc.min, acc.max);
+            ResetAccumulator(acc);
+        }
+    }
+
+    m_frames += frames;
+}
+
+// Stores a finished bucket at `level` and folds it into the level above.
+void Rx2PeakIndex::Emit(int level, const float* mins, const float* maxs)
+{
+    try
+    {
+        for (int c = 0; c < m_channels; ++c)
+            m_levels[level].push_back(Rx2Peak{ QuantizeDown(mins[c]), QuantizeUp(maxs[c]) });
+    }
+    catch (...)
+    {
+        // A missing waveform is not worth failing playback over.
+        return;
+    }
+
+    if (level + 1 >= kLevels)
+        return;
+
+    Accumulator& up = m_acc[level + 1];
+    for (int c = 0; c < m_channels; ++c)
+    {
+        if (mins[c] < up.min[c]) up.min[c] = mins[c];
+        if (maxs[c] > up.max[c]) up.max[c] = maxs[c];
+    }
+
+    if (++up.count == kLevelFactor)
+    {
+        // Reset before recursing; the finished bucket is copied out first.
+        float upMin[2] = { up.min[0], up.min[1] };
+        float upMax[2] = { up.max[0], up.max[1] };
+        ResetAccumulator(up);
+        Emit(level + 1, upMin, upMax);
+    }
+}
+
+void Rx2PeakIndex::Finish()
+{
+    if (m_finished)
+        return;
+
+    // Bottom-up, so each partial bucket is folded into its parent before
+    // the parent itself is flushed.
+    for (int level = 0; level < kLevels; ++level)
+    {
+        Accumulator& acc = m_acc[level];
+        if (acc.count == 0)
+            continue;
+
+        float mins[2] = { acc.min[0], acc.min[1] };
+        float maxs[2] = { acc.max[0], acc.max[1] };
+        ResetAccumulator(acc);
+        Emit(level, mins, maxs);
+    }
+
+    for (int level = 0; level < kLevels; ++level)
+        m_levels[level].shrink_to_fit();
+
+    m_finished = true;
+}
+
+std::int64_t Rx2PeakIndex::FramesPerPeak(int level) const
+{
+    std::int64_t frames = kBaseFrames;
+    for (int i = 0; i < level; ++i)
+        frames *= kLevelFactor;
+    return frames;
+}
+
+std::int64_t Rx2PeakIndex::PeakCount(int level) const
+{
+    if (level < 0 || level >= kLevels || m_channels <= 0)
+        return 0;
+    return static_cast<std::int64_t>(m_levels[level].size()) / m_channels;
+}
+
+const Rx2Peak* Rx2PeakIndex::Peaks(int level) const
+{
+    if (level < 0 || level >= kLevels || m_levels[level].empty())
+        return nullptr;
+    return m_levels[level].data();
+}
+
+int Rx2PeakIndex::Query(std::int64_t firstFrame, std::int64_t frames, int buckets, Rx2Peak* out) const
+{
+    if (!m_finished || !out || buckets <= 0 || m_channels <= 0 || m_frames <= 0)
+        return 0;
+
+    if (firstFrame < 0)
+        firstFrame = 0;
+    if (firstFrame >= m_frames)
+        return 0;
+    if (frames <= 0 || firstFrame + frames > m_frames)
+        frames = m_frames - firstFrame;
+
+    // Coarsest level whose buckets are no wider than the requested ones.
+    const std::int64_t width = frames / buckets;
+    int level = 0;
+    while (level + 1 < kLevels && FramesPerPeak(level + 1) <= width && PeakCount(level + 1) > 0)
+        ++level;
+
+    const std::int64_t fpp   = FramesPerPeak(level);
+    const std::int64_t count = PeakCount(level);
+    const Rx2Peak*     peaks = m_levels[level].data();
+    if (count <= 0)
+        return 0;   // the level was lost to an allocation failure
+
+    for (int b = 0; b < buckets; ++b)
+    {
+        const std::int64_t start = firstFrame + frames * b / buckets;
+        std::int64_t       end   = firstFrame + frames * (b + 1) / buckets;
+        if (end <= start)
+            end = start + 1;
+
+        std::int64_t i0 = start / fpp;
+        std::int64_t i1 = (end - 1) / fpp;
+        if (i0 >= count) i0 = count - 1;
+        if (i1 >= count) i1 = count - 1;
+
+        for (int c = 0; c < m_channels; ++c)
+        {
+            Rx2Peak merged = peaks[i0 * m_channels + c];
+            for (std::int64_t i = i0 + 1; i <= i1; ++i)
+            {
+                const Rx2Peak& p = peaks[i * m_channels + c];
+                if (p.min < merged.min) merged.min = p.min;
+                if (p.max > merged.max) merged.max = p.max;
+            }
+            out[static_cast<std::size_t>(b) * m_channels + c] = merged;
+        }
+    }
+
+    return buckets;
+}
+
+bool Rx2PeakIndex::Serialize(std::vector<std::uint8_t>& out) const
+{
+    if (!m_finished)
+        return false;
+
+    try
+    {
+        out.clear();
+        PutValue<std::uint32_t>(out, kPeakMagic);
+        PutValue<std::uint32_t>(out, kPeakVersion);
+        PutValue<std::uint32_t>(out, static_cast<std::uint32_t>(m_channels));
+        PutValue<std::uint32_t>(out, kBaseFrames);
+        PutValue<std::uint32_t>(out, kLevelFactor);
+        PutValue<std::uint32_t>(out, kLevels);
+        PutValue<std::int64_t>(out, m_frames);
+
+        for (int level = 0; level < kLevels; ++level)
+        {
+            const std::vector<Rx2Peak>& peaks = m_levels[level];
+            PutValue<std::uint64_t>(out, peaks.size());
+            const std::uint8_t* p = reinterpret_cast<const std::uint8_t*>(peaks.data());
+            out.insert(out.end(), p, p + peaks.size() * sizeof(Rx2Peak));
+        }
+    }
+    catch (...)
+    {
+        out.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool Rx2PeakIndex::Deserialize(const std::uint8_t* data, std::size_t size)
+{
+    Clear();
+
+    const std::uint8_t* p   = data;
+    const std::uint8_t* end = data + size;
+
+    std::uint32_t magic = 0, version = 0, channels = 0, base = 0, factor = 0, levels = 0;
+    std::int64_t  frames = 0;
+
+    if (!data
+        || !GetValue(p, end, &magic)    || magic   != kPeakMagic
+        || !GetValue(p, end, &version)  || version != kPeakVersion
+        || !GetValue(p, end, &channels) || (channels != 1 && channels != 2)
+        || !GetValue(p, end, &base)     || base    != static_cast<std::uint32_t>(kBaseFrames)
+        || !GetValue(p, end, &factor)   || factor  != static_cast<std::uint32_t>(kLevelFactor)
+        || !GetValue(p, end, &levels)   || levels  != static_cast<std::uint32_t>(kLevels)
+        || !GetValue(p, end, &frames)   || frames  <  0)
+    {
+        return false;
+    }
+
+    m_channels = static_cast<int>(channels);
+    m_frames   = frames;
+
+    try
+    {
+        for (int level = 0; level < kLevels; ++level)
+        {
+            // Finish() leaves exactly one bucket per started FramesPerPeak().
+            const std::int64_t  fpp      = FramesPerPeak(level);
+            const std::uint64_t expected = static_cast<std::uint64_t>(frames / fpp + (frames % fpp != 0)) * channels;
+
+            std::uint64_t count = 0;
+            if (!GetValue(p, end, &count)
+                || count != expected
+                || count > static_cast<std::uint64_t>(end - p) / sizeof(Rx2Peak))
+            {
+                Clear();
+                return false;
+            }
+
+            m_levels[level].resize(static_cast<std::size_t>(count));
+            memcpy(m_levels[level].data(), p, static_cast<std::size_t>(count) * sizeof(Rx2Peak));
+            p += count * sizeof(Rx2Peak);
+        }
+    }
+    catch (...)
+    {
+        Clear();
+        return false;
+    }
+
+    m_finished = true;
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One waveform bucket: sample extremes quantized to 16 bits.
+struct Rx2Peak
+{
+    std::int16_t min;
+    std::int16_t max;
+};
+
+// Min/max waveform pyramid built from the same planar batches that feed
+// the PCM store, so drawing a REX waveform never needs a second decode.
+//
+// Level 0 holds one bucket per kBaseFrames frames; each further level
+// merges kLevelFactor buckets of the level below. Buckets are interleaved
+// by channel. Query() picks the coarsest level that still resolves the
+// requested bucket width, so any zoom costs at most a few thousand merges.
+class Rx2PeakIndex
+{
+public:
+    static const int kBaseFrames  = 256;
+    static const int kLevelFactor = 4;
+    static const int kLevels      = 5;   // 256 .. 65536 frames per bucket
+
+    Rx2PeakIndex();
+
+    void Reset(int channels);
+    void Clear();
+
+    // Same contract as Rx2PcmStore::Append(): `right` may be null.
+    void Add(const float* left, const float* right, int frames);
+
+    // Flushes partial buckets; the index is immutable afterwards.
+    void Finish();
+
+    bool         IsFinished() const { return m_finished; }
+    int          Channels()   const { return m_channels; }
+    std::int64_t Frames()     const { return m_frames; }
+
+    std::int64_t FramesPerPeak(int level) const;
+    std::int64_t PeakCount(int level) const;
+    const Rx2Peak* Peaks(int level) const;
+
+    // Reduces [firstFrame, firstFrame + frames) to `buckets` buckets per
+    // channel, written interleaved to `out` (buckets * Channels() entries).
+    // Returns the number of buckets written.
+    int Query(std::int64_t firstFrame, std::int64_t frames, int buckets, Rx2Peak* out) const;
+
+    // Flat little-endian image for the analysis cache.
+    bool Serialize(std::vector<std::uint8_t>& out) const;
+    bool Deserialize(const std::uint8_t* data, std::size_t size);
+
+private:
+    struct Accumulator
+    {
+        float min[2];
+        float max[2];
+        int   count;     // frames (level 0) or child buckets (levels > 0)
+    };
+
+    void Emit(int level, const float* mins, const float* maxs);
+    void ResetAccumulator(Accumulator& acc);
+
+    int                  m_channels;
+    std::int64_t         m_frames;
+    bool                 m_finished;
+    Accumulator          m_acc[kLevels];
+    std::vector<Rx2Peak> m_levels[kLevels];
+};
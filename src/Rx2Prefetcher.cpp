@@ -0,0 +1,336 @@
+#include "Rx2Prefetcher.h"
+#include "Rx2AnalysisCache.h"
+#include "Rx2Contention.h"
+#include "Rx2Decoder.h"
+#include "Rx2NegativeCache.h"
+#include "Rx2RexLibrary.h"
+#include "Rx2Settings.h"
+#include "apiFileManager.h"
+#include "apiMessages.h"
+#include "apiPlayer.h"
+#include "apiPlaylists.h"
+
+#include <string>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+class Rx2PrefetchHook;
+
+static SRWLOCK          g_lock        = SRWLOCK_INIT;
+static IAIMPCore*       g_core        = nullptr;
+static Rx2PrefetchHook* g_hook        = nullptr;
+static HANDLE           g_thread      = nullptr;
+static HANDLE           g_wakeEvent   = nullptr;
+static HANDLE           g_stopEvent   = nullptr;
+
+static std::wstring     g_pending;          // file to render next (guarded)
+static Rx2FileKey       g_slotKey;          // guarded
+static Rx2Decoder*      g_slotDecoder = nullptr;
+
+// ---------------- helpers ----------------
+
+static bool HasRexExtension(const std::wstring& path)
+{
+    const size_t dot = path.find_last_of(L'.');
+    if (dot == std::wstring::npos)
+        return false;
+
+    const wchar_t* ext = path.c_str() + dot;
+    return _wcsicmp(ext, L".rx2") == 0
+        || _wcsicmp(ext, L".rex") == 0
+        || _wcsicmp(ext, L".rcy") == 0;
+}
+
+static std::wstring NextQueuedFileName(IAIMPCore* core)
+{
+    std::wstring result;
+
+    IAIMPServicePlaybackQueue* queue = nullptr;
+    if (FAILED(core->QueryInterface(IID_IAIMPServicePlaybackQueue, (void**)&queue)) || !queue)
+        return result;
+
+    IAIMPPlaybackQueueItem* next = nullptr;
+    if (SUCCEEDED(queue->GetNextTrack(&next)) && next)
+    {
+        IAIMPPlaylistItem* item = nullptr;
+        if (SUCCEEDED(next->GetValueAsObject(AIMP_PLAYBACKQUEUEITEM_PROPID_PLAYLISTITEM,
+                                             IID_IAIMPPlaylistItem, (void**)&item)) && item)
+        {
+            IAIMPString* name = nullptr;
+            if (SUCCEEDED(item->GetValueAsObject(AIMP_PLAYLISTITEM_PROPID_FILENAME,
+                                                 IID_IAIMPString, (void**)&name)) && name)
+            {
+                result.assign(name->GetData(), static_cast<size_t>(name->GetLength()));
+                name->Release();
+            }
+            item->Release();
+        }
+        next->Release();
+    }
+
+    queue->Release();
+    return result;
+}
+
+static IAIMPStream* OpenFileStream(IAIMPCore* core, const std::wstring& path)
+{
+    IAIMPServiceFileStreaming* streaming = nullptr;
+    if (FAILED(core->QueryInterface(IID_IAIMPServiceFileStreaming, (void**)&streaming)) || !streaming)
+        return nullptr;
+
+    IAIMPStream* stream = nullptr;
+    IAIMPString* name   = nullptr;
+    if (SUCCEEDED(core->CreateObject(IID_IAIMPString, (void**)&name)))
+    {
+        name->SetData(const_cast<wchar_t*>(path.c_str()), static_cast<int>(path.length()));
+        if (FAILED(streaming->CreateStreamForFile(name, AIMP_SERVICE_FILESTREAMING_FLAG_READ,
+                                                  -1, -1, &stream)))
+            stream = nullptr;
+        name->Release();
+    }
+
+    streaming->Release();
+    return stream;
+}
+
+// Swaps `decoder` into the slot (null empties it); the previous occupant is
+// released outside the lock. The slot's decoder is pinned against the memory
+// budget until it is adopted: nothing reads it meanwhile, so it would
+// otherwise look idle and be evicted.
+static void FillSlot(const Rx2FileKey& key, Rx2Decoder* decoder)
+{
+    if (decoder)
+        decoder->SetPinned(true);
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::PrefetchSlot);
+    Rx2Decoder* old = g_slotDecoder;
+    g_slotDecoder   = decoder;
+    g_slotKey       = key;
+    ReleaseSRWLockExclusive(&g_lock);
+
+    if (old)
+        old->Release();
+}
+
+// Opens and fully renders one file on the worker thread.
+static void PrefetchFile(const std::wstring& path)
+{
+    IAIMPStream* stream = OpenFileStream(g_core, path);
+    if (!stream)
+        return;
+
+    Rx2FileKey key;
+    REX::REXError knownErr = REX::kREXError_NoError;
+    if (!Rx2MakeFileKey(stream, &key) || Rx2NegativeCacheLookup(key, &knownErr)
+        || Rx2EnsureRexLibrary() != REX::kREXError_NoError)
+    {
+        stream->Release();
+        return;
+    }
+
+    Rx2Decoder* d = new Rx2Decoder(g_core, stream, false /*skipPreflight*/);
+    stream->Release();   // the decoder holds its own reference
+
+    if (!d->IsValid() || d->HasError())
+    {
+        Rx2NegativeCacheStore(key, d->HasError() ? d->GetLastError() : REX::kREXError_FileCorrupt);
+        d->Release();
+        return;
+    }
+
+    // Worth keeping even when the PCM itself is too large to hold.
+    Rx2StoreCachedPeaks(key, d->Peaks());
+    Rx2StoreCachedLoudness(key, d->Loudness());
+
+    const std::size_t limit =
+        static_cast<std::size_t>(Rx2GetSettings().prefetchMaxMB) * 1024 * 1024;
+    if (d->ResidentBytes() > limit)
+    {
+        d->Release();
+        return;
+    }
+
+    FillSlot(key, d);
+}
+
+static DWORD WINAPI PrefetchThreadProc(LPVOID /*param*/)
+{
+    // Background mode lowers CPU, I/O and memory priority together, so the
+    // render never competes with the track that is playing.
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+    HANDLE handles[2] = { g_stopEvent, g_wakeEvent };
+
+    for (;;)
+    {
+        DWORD res = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        if (res != WAIT_OBJECT_0 + 1)
+            break;
+
+        Rx2LockExclusive(&g_lock, Rx2SyncSite::PrefetchSlot);
+        std::wstring path;
+        path.swap(g_pending);
+        const bool alreadyHeld = g_slotDecoder
+                              && _wcsicmp(g_slotKey.path.c_str(), path.c_str()) == 0;
+        ReleaseSRWLockExclusive(&g_lock);
+
+        if (!path.empty() && !alreadyHeld)
+            PrefetchFile(path);
+    }
+
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+    return 0;
+}
+
+static void RequestPrefetch(const std::wstring& path)
+{
+    if (path.empty() || !HasRexExtension(path))
+        return;
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::PrefetchSlot);
+    g_pending = path;
+    ReleaseSRWLockExclusive(&g_lock);
+
+    SetEvent(g_wakeEvent);
+}
+
+// ---------------- message hook ----------------
+
+class Rx2PrefetchHook : public IAIMPMessageHook
+{
+public:
+    Rx2PrefetchHook() : m_refCount(1) {}
+    virtual ~Rx2PrefetchHook() {}
+
+    // IUnknown
+    HRESULT WINAPI QueryInterface(REFIID riid, void **ppv) override
+    {
+        if (!ppv)
+            return E_POINTER;
+
+        if (riid == IID_IUnknown)
+        {
+            *ppv = static_cast<IAIMPMessageHook*>(this);
+            AddRef();
+            return S_OK;
+        }
+
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    ULONG WINAPI AddRef() override
+    {
+        return InterlockedIncrement(&m_refCount);
+    }
+
+    ULONG WINAPI Release() override
+    {
+        ULONG r = InterlockedDecrement(&m_refCount);
+        if (r == 0)
+            delete this;
+        return r;
+    }
+
+    // IAIMPMessageHook
+    void WINAPI CoreMessage(DWORD AMessage, int /*AParam1*/, void* /*AParam2*/, HRESULT* /*AResult*/) override
+    {
+        // A track just started: whatever follows it is the one to prepare.
+        if (AMessage == AIMP_MSG_EVENT_STREAM_START && g_core)
+            RequestPrefetch(NextQueuedFileName(g_core));
+    }
+
+private:
+    LONG m_refCount;
+};
+
+static void SetHooked(bool hooked)
+{
+    IAIMPServiceMessageDispatcher* dispatcher = nullptr;
+    if (FAILED(g_core->QueryInterface(IID_IAIMPServiceMessageDispatcher, (void**)&dispatcher)) || !dispatcher)
+        return;
+
+    if (hooked)
+        dispatcher->Hook(g_hook);
+    else
+        dispatcher->Unhook(g_hook);
+
+    dispatcher->Release();
+}
+
+// ---------------- public API ----------------
+
+void Rx2PrefetchStart(IAIMPCore* core)
+{
+    if (!core || g_core)
+        return;
+
+    g_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    g_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (g_wakeEvent && g_stopEvent)
+        g_thread = CreateThread(nullptr, 0, PrefetchThreadProc, nullptr, 0, nullptr);
+
+    if (!g_thread)
+    {
+        if (g_wakeEvent)
+            CloseHandle(g_wakeEvent);
+        if (g_stopEvent)
+            CloseHandle(g_stopEvent);
+        g_wakeEvent = nullptr;
+        g_stopEvent = nullptr;
+        return;
+    }
+
+    g_core = core;
+    g_core->AddRef();
+
+    g_hook = new Rx2PrefetchHook();
+    SetHooked(true);
+}
+
+void Rx2PrefetchStop()
+{
+    if (!g_core)
+        return;
+
+    SetHooked(false);
+    g_hook->Release();
+    g_hook = nullptr;
+
+    // A render in progress finishes first; REXCreate is already bounded by
+    // its own timeout.
+    SetEvent(g_stopEvent);
+    WaitForSingleObject(g_thread, INFINITE);
+    CloseHandle(g_thread);
+    CloseHandle(g_wakeEvent);
+    CloseHandle(g_stopEvent);
+    g_thread    = nullptr;
+    g_wakeEvent = nullptr;
+    g_stopEvent = nullptr;
+
+    FillSlot(Rx2FileKey(), nullptr);
+    g_pending.clear();
+
+    g_core->Release();
+    g_core = nullptr;
+}
+
+Rx2Decoder* Rx2PrefetchAdopt(const Rx2FileKey& key)
+{
+    Rx2Decoder* adopted = nullptr;
+
+    Rx2LockExclusive(&g_lock, Rx2SyncSite::PrefetchSlot);
+    if (g_slotDecoder && Rx2IsSameFile(g_slotKey, key))
+    {
+        adopted       = g_slotDecoder;
+        g_slotDecoder = nullptr;
+        g_slotKey     = Rx2FileKey();
+    }
+    ReleaseSRWLockExclusive(&g_lock);
+
+    if (adopted)
+        adopted->SetPinned(false);
+
+    return adopted;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "apiCore.h"
+#include "Rx2FileKey.h"
+
+class Rx2Decoder;
+
+// Speculative pre-render of the next REX track.
+//
+// A message hook listens for AIMP_MSG_EVENT_STREAM_START; when a track
+// starts, the playback queue is asked for the next one and, if it is a REX
+// file, a background-priority worker opens it and builds a complete
+// Rx2Decoder into a single slot. The next CreateDecoder for the same file
+// adopts that decoder instead of reading and rendering the file again, so
+// consecutive loops change over without a render gap. The slot holds at
+// most one decoder; a newer request replaces it, and a decoder larger than
+// the configured limit is not kept.
+void        Rx2PrefetchStart(IAIMPCore* core);
+void        Rx2PrefetchStop();
+
+// Hands over the prefetched decoder if it was built from this file, or
+// returns null. The caller receives the slot's reference.
+Rx2Decoder* Rx2PrefetchAdopt(const Rx2FileKey& key);
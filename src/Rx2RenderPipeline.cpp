@@ -0,0 +1,242 @@
+#include "Rx2RenderPipeline.h"
+#include "Rx2CoreHooks.h"
+
+#include <new>
+#include <system_error>
+
+// Times a side checks the ring again, yielding in between, before it parks.
+// A block takes far longer to produce or consume than a yield, so this only
+// saves the park and wake when the other side is about to finish one.
+static const int kSpinYields = 16;
+
+// ---------------- helpers ----------------
+
+struct Rx2PipelineWorker
+{
+    static void Run(Rx2RenderPipeline* self);
+};
+
+static bool Join(std::thread& thread)
+{
+    thread.join();
+    return true;
+}
+
+// ---------------- Rx2RenderPipeline ----------------
+
+Rx2RenderPipeline::Rx2RenderPipeline()
+    : m_channels(0)
+    , m_consume(nullptr)
+    , m_context(nullptr)
+    , m_threaded(false)
+    , m_finished(true)
+    , m_blocks(nullptr)
+    , m_writeIndex(0)
+    , m_readIndex(0)
+    , m_thread()
+    , m_failed(false)
+    , m_producerParked(false)
+    , m_workerParked(false)
+{
+}
+
+Rx2RenderPipeline::~Rx2RenderPipeline()
+{
+    Finish();
+}
+
+void Rx2RenderPipeline::Start(int channels, ConsumeFn consume, void* context, bool threaded)
+{
+    Finish();
+
+    m_channels   = channels;
+    m_consume    = consume;
+    m_context    = context;
+    m_finished   = false;
+    m_writeIndex.store(0, std::memory_order_relaxed);
+    m_readIndex.store(0, std::memory_order_relaxed);
+    m_producerParked.store(false, std::memory_order_relaxed);
+    m_workerParked.store(false, std::memory_order_relaxed);
+    m_failed.store(false, std::memory_order_relaxed);
+
+    if (threaded)
+    {
+        m_blocks = new (std::nothrow) Block[kSlots];
+
+        if (m_blocks)
+        {
+            try
+            {
+                m_thread = std::thread(Rx2PipelineWorker::Run, this);
+            }
+            catch (const std::system_error&)
+            {
+            }
+        }
+
+        if (!m_thread.joinable())
+        {
+            delete[] m_blocks;
+            m_blocks = nullptr;
+        }
+    }
+
+    m_threaded = m_thread.joinable();
+
+    // Inline: one block, consumed on commit.
+    if (!m_threaded)
+        m_blocks = new (std::nothrow) Block[1];
+
+    if (!m_blocks)
+        m_failed.store(true, std::memory_order_release);
+}
+
+void Rx2RenderPipeline::BeginBlock(float** left, float** right)
+{
+    if (m_threaded && !HasFreeSlot())
+        RX2_SYNC_WAIT(Rx2SyncSite::PipelineFreeSlot, WaitFreeSlot());
+
+    Block& block = m_blocks[m_threaded ? (m_writeIndex.load(std::memory_order_relaxed) % kSlots) : 0];
+    *left  = block.left;
+    *right = (m_channels > 1) ? block.right : nullptr;
+}
+
+void Rx2RenderPipeline::CommitBlock(int frames)
+{
+    if (!m_blocks)
+        return;
+
+    if (!m_threaded)
+    {
+        m_blocks[0].frames = frames;
+        Consume(m_blocks[0]);
+        return;
+    }
+
+    const std::uint32_t write = m_writeIndex.load(std::memory_order_relaxed);
+    m_blocks[write % kSlots].frames = frames;
+    m_writeIndex.store(write + 1);
+    Wake(m_workerParked, m_filledReady);
+}
+
+bool Rx2RenderPipeline::Finish()
+{
+    if (m_finished)
+        return !m_failed.load(std::memory_order_acquire);
+
+    m_finished = true;
+
+    if (m_threaded)
+    {
+        // End-of-stream marker.
+        float* left  = nullptr;
+        float* right = nullptr;
+        BeginBlock(&left, &right);
+        CommitBlock(0);
+
+        // The worker still drains the blocks in flight.
+        RX2_SYNC_WAIT(Rx2SyncSite::PipelineJoin, Join(m_thread));
+        m_threaded = false;
+    }
+
+    delete[] m_blocks;
+    m_blocks = nullptr;
+
+    return !m_failed.load(std::memory_order_acquire);
+}
+
+void Rx2RenderPipeline::Consume(const Block& block)
+{
+    if (m_failed.load(std::memory_order_relaxed))
+        return;
+
+    if (!m_consume(m_context, block.left, (m_channels > 1) ? block.right : nullptr, block.frames))
+        m_failed.store(true, std::memory_order_release);
+}
+
+// ---------------- ring ----------------
+
+// Index loads and stores default to sequentially consistent: a side's
+// store of its own index and its load of the other side's parked flag must
+// not be reordered, or a wake-up could be lost (see Wake()).
+
+bool Rx2RenderPipeline::HasFreeSlot() const
+{
+    return m_writeIndex.load(std::memory_order_relaxed) - m_readIndex.load() < kSlots;
+}
+
+bool Rx2RenderPipeline::HasFilledSlot() const
+{
+    return m_readIndex.load(std::memory_order_relaxed) != m_writeIndex.load();
+}
+
+bool Rx2RenderPipeline::WaitFreeSlot()
+{
+    for (int i = 0; i < kSpinYields; ++i)
+    {
+        if (HasFreeSlot())
+            return true;
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(m_parkMutex);
+    m_producerParked.store(true);
+    m_freeReady.wait(lock, [this]() { return HasFreeSlot(); });
+    m_producerParked.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+bool Rx2RenderPipeline::WaitFilledSlot()
+{
+    for (int i = 0; i < kSpinYields; ++i)
+    {
+        if (HasFilledSlot())
+            return true;
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(m_parkMutex);
+    m_workerParked.store(true);
+    m_filledReady.wait(lock, [this]() { return HasFilledSlot(); });
+    m_workerParked.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+// Called after publishing an index. A side parks by setting its flag and
+// then rechecking the ring, both under m_parkMutex; so either it sees the
+// new index, or this sees the flag and takes the mutex, which it cannot get
+// until the parked side is waiting on `ready`.
+void Rx2RenderPipeline::Wake(std::atomic<bool>& parked, std::condition_variable& ready)
+{
+    if (!parked.load())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+    }
+    ready.notify_one();
+}
+
+// ---------------- worker ----------------
+
+void Rx2PipelineWorker::Run(Rx2RenderPipeline* self)
+{
+    for (;;)
+    {
+        if (!self->HasFilledSlot())
+            RX2_SYNC_WAIT(Rx2SyncSite::PipelineFilledSlot, self->WaitFilledSlot());
+
+        const std::uint32_t read = self->m_readIndex.load(std::memory_order_relaxed);
+        const Rx2RenderPipeline::Block& block = self->m_blocks[read % Rx2RenderPipeline::kSlots];
+        const bool end = (block.frames == 0);
+
+        // The slot goes back to the producer only once the block is consumed.
+        if (!end)
+            self->Consume(block);
+        self->m_readIndex.store(read + 1);
+        self->Wake(self->m_producerParked, self->m_freeReady);
+
+        if (end)
+            break;
+    }
+}
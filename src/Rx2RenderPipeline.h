@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Two-stage render: the calling thread fills planar blocks (driving the REX
+// DLL), and a worker thread consumes them (store append, quantization,
+// analysis). The stages overlap, so a render takes about as long as the
+// slower of the two rather than their sum.
+//
+// Blocks travel through a single-producer/single-consumer ring, as in
+// Rx2CallLog: each side publishes its own running index with an atomic
+// store and reads the other's, so handing over a block takes no lock. A
+// side that finds the ring full (producer) or empty (worker) yields a few
+// times and then parks on a condition variable; the other side only takes
+// the mutex to wake it when its parked flag is set. If the worker cannot be
+// started the pipeline runs inline and consumes each block on commit. Only
+// the standard library is used, so the pipeline is part of the portable
+// core (Rx2Loop.h).
+class Rx2RenderPipeline
+{
+public:
+    static const int kBlockFrames = 4096;
+    static const int kSlots       = 8;
+
+    // Runs on the worker. Returning false stops further consumption; the
+    // remaining blocks are drained unconsumed.
+    typedef bool (*ConsumeFn)(void* context, const float* left, const float* right, int frames);
+
+    Rx2RenderPipeline();
+    ~Rx2RenderPipeline();
+
+    // threaded = false consumes inline (small renders are not worth a thread).
+    void Start(int channels, ConsumeFn consume, void* context, bool threaded);
+
+    // Producer side: the next free block's channel buffers (kBlockFrames
+    // each; right is null for mono). Blocks until a slot is free. Only
+    // valid while IsHealthy() after Start().
+    void BeginBlock(float** left, float** right);
+    void CommitBlock(int frames);
+
+    // False once the consumer has failed; the producer should stop early.
+    bool IsHealthy() const { return !m_failed.load(std::memory_order_acquire); }
+
+    // Flushes, joins the worker and returns whether every block was consumed.
+    bool Finish();
+
+private:
+    struct Block
+    {
+        int   frames;          // 0 = end of stream
+        float left[kBlockFrames];
+        float right[kBlockFrames];
+    };
+
+    friend struct Rx2PipelineWorker;
+
+    void Consume(const Block& block);
+
+    bool HasFreeSlot() const;
+    bool HasFilledSlot() const;
+    bool WaitFreeSlot();     // producer; returns true so RX2_SYNC_WAIT can time it
+    bool WaitFilledSlot();   // worker
+    void Wake(std::atomic<bool>& parked, std::condition_variable& ready);
+
+    int                   m_channels;
+    ConsumeFn             m_consume;
+    void*                 m_context;
+    bool                  m_threaded;
+    bool                  m_finished;
+
+    Block*                     m_blocks;        // kSlots, or 1 when inline
+    std::atomic<std::uint32_t> m_writeIndex;    // blocks committed; stored by the producer only
+    std::atomic<std::uint32_t> m_readIndex;     // blocks consumed; stored by the worker only
+    std::thread                m_thread;
+    std::atomic<bool>          m_failed;
+
+    // Parking for a side that has nothing to do.
+    std::mutex                 m_parkMutex;
+    std::condition_variable    m_freeReady;
+    std::condition_variable    m_filledReady;
+    std::atomic<bool>          m_producerParked;
+    std::atomic<bool>          m_workerParked;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+// The REX calls the decoder core (Rx2Loop) makes, as a class of static
+// members. The core is compiled against exactly one backend, picked here
+// at compile time, so a call costs what the call inside it costs.
+//
+// Rx2RexPluginBackend (default) is what the plugin and the bench host use:
+// calls go through the REX API shim (Rx2RexShim.h) and REXCreate runs in
+// the timeout sandbox (Rx2RexLibrary.h), both of which need Win32 and the
+// AIMP SDK. Rx2RexDirectBackend calls the REX API exactly as linked, with
+// nothing around it; standalone core builds (RX2_CORE_STANDALONE) use it
+// against whatever provides the REX:: functions, e.g. the bench's
+// stand-in on Linux. A backend must load the library itself if needed.
+//
+// Create() takes ownership of `data`, which must come from new[], and
+// returns false when REXCreate could not be run or was given up on (with
+// the error in *err); true when REXCreate returned, with its result in
+// *handle / *err.
+
+#include "RexSdk.h"
+
+#include <cstdint>
+
+struct Rx2RexDirectBackend
+{
+    static bool Create(std::uint8_t* data, std::int64_t size, REX::REXHandle* handle, REX::REXError* err)
+    {
+        *handle = nullptr;
+        *err    = REX::REXCreate(handle, reinterpret_cast<const char*>(data),
+                                 static_cast<REX::REX_int32_t>(size), nullptr, nullptr);
+        delete[] data;
+        return true;
+    }
+
+    static void Delete(REX::REXHandle* handle) { REX::REXDelete(handle); }
+
+    static REX::REXError GetInfoFromBuffer(REX::REX_int32_t bufferSize, const char buffer[],
+                                           REX::REX_int32_t infoSize, REX::REXInfo* info)
+    {
+        return REX::REXGetInfoFromBuffer(bufferSize, buffer, infoSize, info);
+    }
+
+    static REX::REXError GetInfo(REX::REXHandle handle, REX::REX_int32_t infoSize, REX::REXInfo* info)
+    {
+        return REX::REXGetInfo(handle, infoSize, info);
+    }
+
+    static REX::REXError GetCreatorInfo(REX::REXHandle handle, REX::REX_int32_t creatorInfoSize,
+                                        REX::REXCreatorInfo* creatorInfo)
+    {
+        return REX::REXGetCreatorInfo(handle, creatorInfoSize, creatorInfo);
+    }
+
+    static REX::REXError GetSliceInfo(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                      REX::REX_int32_t sliceInfoSize, REX::REXSliceInfo* sliceInfo)
+    {
+        return REX::REXGetSliceInfo(handle, sliceIndex, sliceInfoSize, sliceInfo);
+    }
+
+    static REX::REXError SetOutputSampleRate(REX::REXHandle handle, REX::REX_int32_t outputSampleRate)
+    {
+        return REX::REXSetOutputSampleRate(handle, outputSampleRate);
+    }
+
+    static REX::REXError RenderSlice(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                     REX::REX_int32_t bufferFrameLength, float* outputBuffers[2])
+    {
+        return REX::REXRenderSlice(handle, sliceIndex, bufferFrameLength, outputBuffers);
+    }
+
+    static REX::REXError StartPreview(REX::REXHandle handle) { return REX::REXStartPreview(handle); }
+    static REX::REXError StopPreview(REX::REXHandle handle)  { return REX::REXStopPreview(handle); }
+
+    static REX::REXError RenderPreviewBatch(REX::REXHandle handle, REX::REX_int32_t framesToRender,
+                                            float* outputBuffers[2])
+    {
+        return REX::REXRenderPreviewBatch(handle, framesToRender, outputBuffers);
+    }
+
+    static REX::REXError SetPreviewTempo(REX::REXHandle handle, REX::REX_int32_t tempo)
+    {
+        return REX::REXSetPreviewTempo(handle, tempo);
+    }
+};
+
+#if RX2_CORE_STANDALONE
+
+typedef Rx2RexDirectBackend Rx2RexBackend;
+
+#else
+
+#include "Rx2RexLibrary.h"
+#include "Rx2RexShim.h"
+
+struct Rx2RexPluginBackend
+{
+    static bool Create(std::uint8_t* data, std::int64_t size, REX::REXHandle* handle, REX::REXError* err)
+    {
+        return Rx2CreateRexHandle(data, size, handle, err);
+    }
+
+    static void Delete(REX::REXHandle* handle) { Rx2RexApi::REXDelete(handle); }
+
+    static REX::REXError GetInfoFromBuffer(REX::REX_int32_t bufferSize, const char buffer[],
+                                           REX::REX_int32_t infoSize, REX::REXInfo* info)
+    {
+        return Rx2RexApi::REXGetInfoFromBuffer(bufferSize, buffer, infoSize, info);
+    }
+
+    static REX::REXError GetInfo(REX::REXHandle handle, REX::REX_int32_t infoSize, REX::REXInfo* info)
+    {
+        return Rx2RexApi::REXGetInfo(handle, infoSize, info);
+    }
+
+    static REX::REXError GetCreatorInfo(REX::REXHandle handle, REX::REX_int32_t creatorInfoSize,
+                                        REX::REXCreatorInfo* creatorInfo)
+    {
+        return Rx2RexApi::REXGetCreatorInfo(handle, creatorInfoSize, creatorInfo);
+    }
+
+    static REX::REXError GetSliceInfo(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                      REX::REX_int32_t sliceInfoSize, REX::REXSliceInfo* sliceInfo)
+    {
+        return Rx2RexApi::REXGetSliceInfo(handle, sliceIndex, sliceInfoSize, sliceInfo);
+    }
+
+    static REX::REXError SetOutputSampleRate(REX::REXHandle handle, REX::REX_int32_t outputSampleRate)
+    {
+        return Rx2RexApi::REXSetOutputSampleRate(handle, outputSampleRate);
+    }
+
+    static REX::REXError RenderSlice(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                     REX::REX_int32_t bufferFrameLength, float* outputBuffers[2])
+    {
+        return Rx2RexApi::REXRenderSlice(handle, sliceIndex, bufferFrameLength, outputBuffers);
+    }
+
+    static REX::REXError StartPreview(REX::REXHandle handle) { return Rx2RexApi::REXStartPreview(handle); }
+    static REX::REXError StopPreview(REX::REXHandle handle)  { return Rx2RexApi::REXStopPreview(handle); }
+
+    static REX::REXError RenderPreviewBatch(REX::REXHandle handle, REX::REX_int32_t framesToRender,
+                                            float* outputBuffers[2])
+    {
+        return Rx2RexApi::REXRenderPreviewBatch(handle, framesToRender, outputBuffers);
+    }
+
+    static REX::REXError SetPreviewTempo(REX::REXHandle handle, REX::REX_int32_t tempo)
+    {
+        return Rx2RexApi::REXSetPreviewTempo(handle, tempo);
+    }
+};
+
+typedef Rx2RexPluginBackend Rx2RexBackend;
+
+#endif
@@ -0,0 +1,280 @@
+#include "Rx2RexLibrary.h"
+#include "Rx2Contention.h"
+#include "Rx2Loop.h"
+#include "Rx2Metrics.h"
+#include "Rx2RexShim.h"
+#include "Rx2Settings.h"
+#include "Rx2Trace.h"
+
+#include <windows.h>
+#include <shlwapi.h>
+
+#include <new>
+
+#pragma comment(lib, "Shlwapi.lib")
+
+// ---------------- state ----------------
+
+static INIT_ONCE     g_initOnce = INIT_ONCE_STATIC_INIT;
+static REX::REXError g_initErr  = REX::kREXError_NoError;
+static bool          g_loaded   = false;
+
+// ---------------- helpers ----------------
+
+static REX::REXError InitializeFromModuleFolder(HMODULE module)
+{
+    wchar_t dir[MAX_PATH] = {0};
+    if (GetModuleFileNameW(module, dir, MAX_PATH) == 0)
+        return REX::kREXError_DLLNotFound;
+
+    PathRemoveFileSpecW(dir);
+    return Rx2RexApi::REXInitializeDLL_DirPath(dir);
+}
+
+static BOOL CALLBACK LoadRexLibraryOnce(PINIT_ONCE /*initOnce*/, PVOID /*param*/, PVOID* /*context*/)
+{
+    const std::int64_t started = Rx2MetricNow();
+
+    REX::REXError err = REX::kREXError_DLLNotFound;
+
+    // Plugin DLL folder
+    HMODULE self = nullptr;
+    if (GetModuleHandleExW(
+            GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+            GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+            reinterpret_cast<LPCWSTR>(&Rx2EnsureRexLibrary),
+            &self))
+    {
+        err = InitializeFromModuleFolder(self);
+    }
+
+    // AIMP.exe folder (fallback). Keep the more specific error of the two:
+    // "not found" from one folder says less than "too old" from the other.
+    if (err != REX::kREXError_NoError)
+    {
+        REX::REXError exeErr = InitializeFromModuleFolder(nullptr);
+        if (exeErr == REX::kREXError_NoError || err == REX::kREXError_DLLNotFound)
+            err = exeErr;
+    }
+
+    g_initErr = err;
+    g_loaded  = (err == REX::kREXError_NoError);
+
+    Rx2MetricRecordUs(Rx2Histogram::RexLibraryLoadUs, Rx2MetricElapsedUs(started));
+
+    // Always "succeed" so the outcome, good or bad, is computed once.
+    return TRUE;
+}
+
+static REX::REXCallbackResult RexProgressCallback(REX::REX_int32_t /*percentFinished*/, void* /*ud*/)
+{
+    return REX::kREXCallback_Continue;
+}
+
+// Context for running REXCreate in a worker thread. Shared by the caller
+// and the worker and freed by whichever lets go last, so a worker that is
+// abandoned after a timeout still has its input, and cleans up after itself
+// if REXCreate ever returns.
+enum : LONG
+{
+    kCreateRunning,
+    kCreateDone,       // REXCreate returned before the caller gave up
+    kCreateAbandoned   // the caller timed out; the worker owns the result
+};
+
+struct REXCreateContext
+{
+    LONG             refCount;
+    LONG             state;
+    std::uint8_t*    data;        // owned
+    REX::REX_int32_t size;
+    REX::REXHandle   handle;
+    REX::REXError    err;
+    HANDLE           doneEvent;
+};
+
+static volatile LONG g_abandoned = 0;   // workers still running after a timeout
+
+// How long Finalize waits for abandoned workers before leaving the library
+// loaded for them.
+static const ULONGLONG kAbandonedWaitMs = 2000;
+
+static void ReleaseCreateContext(REXCreateContext* ctx)
+{
+    if (InterlockedDecrement(&ctx->refCount) != 0)
+        return;
+
+    // Still set only if the caller gave up before REXCreate returned.
+    if (ctx->handle)
+        Rx2RexApi::REXDelete(&ctx->handle);
+
+    delete[] ctx->data;
+    CloseHandle(ctx->doneEvent);
+    delete ctx;
+}
+
+// Worker thread: calls REXCreate and signals when done
+static DWORD WINAPI REXCreateThreadProc(LPVOID param)
+{
+    REXCreateContext* ctx = reinterpret_cast<REXCreateContext*>(param);
+
+    ctx->err = RX2_TRACE_CALL("REXCreate", Rx2RexApi::REXCreate(
+        &ctx->handle,
+        reinterpret_cast<const char*>(ctx->data),
+        ctx->size,
+        RexProgressCallback,
+        nullptr));
+
+    const bool abandoned =
+        InterlockedCompareExchange(&ctx->state, kCreateDone, kCreateRunning) == kCreateAbandoned;
+    if (!abandoned)
+        SetEvent(ctx->doneEvent);
+
+    // Counted until its REXDelete is done, so Finalize does not uninitialize
+    // the library under it.
+    ReleaseCreateContext(ctx);
+    if (abandoned)
+        InterlockedDecrement(&g_abandoned);
+    return 0;
+}
+
+// ---------------- public API ----------------
+
+REX::REXError Rx2EnsureRexLibrary()
+{
+    RX2_SYNC_WAIT(Rx2SyncSite::RexLibraryInit,
+                  InitOnceExecuteOnce(&g_initOnce, LoadRexLibraryOnce, nullptr, nullptr));
+    return g_initErr;
+}
+
+void Rx2ReleaseRexLibrary()
+{
+    // A worker abandoned after a timeout may still be inside REXCreate; it
+    // calls REXDelete and returns into this module when it gets out. Give
+    // such workers a bounded time, then leave the library loaded and pin
+    // the plugin so neither goes away under them. g_initOnce stays done, so
+    // a later Initialize reuses the library.
+    const ULONGLONG deadline = GetTickCount64() + kAbandonedWaitMs;
+    while (Rx2AbandonedRexCreates() > 0 && GetTickCount64() < deadline)
+        Sleep(10);
+
+    if (const long abandoned = Rx2AbandonedRexCreates())
+    {
+        HMODULE self = nullptr;
+        GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                           reinterpret_cast<LPCWSTR>(&REXCreateThreadProc), &self);
+
+        wchar_t msg[128];
+        _snwprintf_s(msg, _countof(msg), _TRUNCATE,
+                     L"RX2Decoder: %ld REXCreate workers still running; the REX library stays loaded\n",
+                     abandoned);
+        OutputDebugStringW(msg);
+        return;
+    }
+
+    if (g_loaded)
+    {
+        Rx2RexApi::REXUninitializeDLL();
+        g_loaded = false;
+    }
+
+    // Allow a later Initialize of the plugin to load the library again.
+    INIT_ONCE fresh = INIT_ONCE_STATIC_INIT;
+    g_initOnce = fresh;
+    g_initErr  = REX::kREXError_NoError;
+}
+
+bool Rx2CreateRexHandle(std::uint8_t*   data,
+                        std::int64_t    size,
+                        REX::REXHandle* handle,
+                        REX::REXError*  err)
+{
+    RX2_TRACE_SCOPE("Rx2CreateRexHandle");
+
+    *handle = nullptr;
+
+    const std::int64_t started = Rx2MetricNow();
+
+    REXCreateContext* ctx = new (std::nothrow) REXCreateContext{};
+    if (!ctx)
+    {
+        delete[] data;
+        *err = REX::kREXError_OutOfMemory;
+        return false;
+    }
+
+    ctx->refCount  = 1;
+    ctx->state     = kCreateRunning;
+    ctx->data      = data;
+    ctx->size      = static_cast<REX::REX_int32_t>(size);
+    ctx->handle    = nullptr;
+    ctx->err       = REX::kREXError_NoError;
+    ctx->doneEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+    if (!ctx->doneEvent)
+    {
+        ReleaseCreateContext(ctx);
+        *err = REX::kREXError_OutOfMemory;
+        return false;
+    }
+
+    // One reference for the worker, released when it returns.
+    InterlockedIncrement(&ctx->refCount);
+
+    HANDLE thread = CreateThread(
+        nullptr,
+        0,
+        REXCreateThreadProc,
+        ctx,
+        0,
+        nullptr);
+
+    if (!thread)
+    {
+        ctx->refCount = 1;
+        ReleaseCreateContext(ctx);
+        *err = REX::kREXError_OutOfMemory;
+        return false;
+    }
+
+    // The worker runs detached from here on; nothing below waits on it.
+    CloseHandle(thread);
+
+    // Wait for completion or timeout
+    const DWORD timeoutMs = static_cast<DWORD>(Rx2GetSettings().rexCreateTimeoutMs);
+    RX2_SYNC_WAIT(Rx2SyncSite::RexCreateSandbox, WaitForSingleObject(ctx->doneEvent, timeoutMs));
+    Rx2MetricRecordUs(Rx2Histogram::RexCreateUs, Rx2MetricElapsedUs(started));
+
+    if (InterlockedCompareExchange(&ctx->state, kCreateAbandoned, kCreateRunning) == kCreateRunning)
+    {
+        // REXCreate hung inside the DLL. Terminating the thread could leave
+        // the library's heap or locks inconsistent for every later call, so
+        // the worker is left to finish on its own; it frees the file bytes
+        // and deletes any handle it gets.
+        const LONG abandoned = InterlockedIncrement(&g_abandoned);
+        Rx2MetricAdd(Rx2Counter::RexCreateTimeouts);
+
+        wchar_t msg[128];
+        _snwprintf_s(msg, _countof(msg), _TRUNCATE,
+                     L"RX2Decoder: REXCreate timed out after %u ms (%ld abandoned)\n",
+                     static_cast<unsigned>(timeoutMs), static_cast<long>(abandoned));
+        OutputDebugStringW(msg);
+
+        ReleaseCreateContext(ctx);
+        *err = kRexError_CreateTimedOut;
+        return false;
+    }
+
+    // Completed normally (possibly just as the wait timed out)
+    *handle     = ctx->handle;
+    *err        = ctx->err;
+    ctx->handle = nullptr;
+
+    ReleaseCreateContext(ctx);
+    return true;
+}
+
+long Rx2AbandonedRexCreates()
+{
+    return InterlockedCompareExchange(&g_abandoned, 0, 0);
+}
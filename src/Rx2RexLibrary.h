@@ -0,0 +1,33 @@
+#pragma once
+
+#include "RexSdk.h"
+
+#include <cstdint>
+
+// Loads and initializes the REX Shared Library on first use instead of at
+// plugin startup. Thread-safe; the first caller performs the load (plugin
+// folder first, then the AIMP.exe folder) and every caller gets its result.
+// Returns kREXError_NoError once the library is usable.
+REX::REXError Rx2EnsureRexLibrary();
+
+// Uninitializes the library if it was loaded. Call from Finalize only, when
+// no decoder can be created or running anymore. Waits up to 2 s for
+// REXCreate workers abandoned after a timeout; if any are still running,
+// the library stays loaded and the plugin module is pinned in memory.
+void Rx2ReleaseRexLibrary();
+
+// Runs REXCreate on a worker thread and gives up after the configured
+// timeout (Rx2Settings::rexCreateTimeoutMs), since some damaged files hang
+// inside the DLL. Takes ownership of `data`, which must come from new[]: a
+// worker that is given up on keeps reading it and frees it when REXCreate
+// returns. Returns false when REXCreate could not be run or did not finish;
+// *err then holds the error to report (kRexError_CreateTimedOut for a
+// timeout, which is not remembered as a verdict on the file). Returns true when REXCreate
+// completed, with its result in *handle / *err.
+bool Rx2CreateRexHandle(std::uint8_t*   data,
+                        std::int64_t    size,
+                        REX::REXHandle* handle,
+                        REX::REXError*  err);
+
+// REXCreate workers still running after their caller timed out.
+long Rx2AbandonedRexCreates();
@@ -0,0 +1,346 @@
+#include "Rx2RexShim.h"
+#include "Rx2Metrics.h"
+#include "Rx2Settings.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+enum class FaultAction
+{
+    Delay,
+    Error,
+    Hang
+};
+
+struct FaultSpec
+{
+    int           entry;      // -1 = every entry
+    FaultAction   action;
+    DWORD         delayMs;
+    REX::REXError error;
+    std::uint64_t after;
+    std::uint64_t every;
+    std::uint64_t times;      // UINT64_MAX = unlimited
+};
+
+struct FaultRule
+{
+    FaultSpec                  spec;
+    std::atomic<std::uint64_t> seen;
+    std::atomic<std::uint64_t> fired;
+};
+
+static const int kMaxRules = 32;
+
+namespace Rx2RexShimDetail
+{
+    std::atomic<bool> active(false);
+}
+
+static FaultRule g_rules[kMaxRules];
+static int       g_ruleCount = 0;
+
+// Manual-reset; set by Stop to let hung calls go.
+static HANDLE    g_release   = nullptr;
+
+static const char* const kEntryNames[kRx2RexEntryCount] =
+{
+    "REXInitializeDLL_DirPath", "REXUninitializeDLL", "REXCreate", "REXDelete", "REXGetInfo",
+    "REXGetInfoFromBuffer", "REXGetCreatorInfo", "REXGetSliceInfo", "REXSetOutputSampleRate",
+    "REXRenderSlice", "REXStartPreview", "REXStopPreview", "REXRenderPreviewBatch",
+    "REXSetPreviewTempo"
+};
+
+// ---------------- script ----------------
+
+static bool ParseCount(const std::string& token, std::uint64_t* value)
+{
+    if (token.empty() || token[0] < '0' || token[0] > '9')
+        return false;
+
+    char* end = nullptr;
+    *value = strtoull(token.c_str(), &end, 10);
+    return end && *end == '\0';
+}
+
+static bool ParseRule(const std::string& line, FaultSpec* spec, std::string* error)
+{
+    std::istringstream in(line);
+    std::string entry, action, token;
+    in >> entry >> action;
+
+    spec->entry   = -1;
+    spec->delayMs = 0;
+    spec->error   = REX::kREXError_NoError;
+    spec->after   = 0;
+    spec->every   = 1;
+    spec->times   = UINT64_MAX;
+
+    if (entry != "*")
+    {
+        for (int e = 0; e < kRx2RexEntryCount && spec->entry < 0; ++e)
+        {
+            if (entry == kEntryNames[e])
+                spec->entry = e;
+        }
+        if (spec->entry < 0)
+        {
+            *error = "unknown REX function " + entry;
+            return false;
+        }
+    }
+
+    std::uint64_t value = 0;
+    if (action == "delay" || action == "error")
+    {
+        if (!(in >> token) || !ParseCount(token, &value))
+        {
+            *error = action + " needs a number";
+            return false;
+        }
+    }
+
+    if (action == "delay")
+    {
+        spec->action  = FaultAction::Delay;
+        spec->delayMs = static_cast<DWORD>(value);
+    }
+    else if (action == "error")
+    {
+        if (value == REX::kREXError_NoError)
+        {
+            *error = "error 1 is kREXError_NoError";
+            return false;
+        }
+        spec->action = FaultAction::Error;
+        spec->error  = static_cast<REX::REXError>(value);
+    }
+    else if (action == "hang")
+    {
+        spec->action = FaultAction::Hang;
+    }
+    else
+    {
+        *error = "unknown action " + action + " (delay, error or hang)";
+        return false;
+    }
+
+    while (in >> token)
+    {
+        std::string number;
+        if (!(in >> number) || !ParseCount(number, &value))
+        {
+            *error = token + " needs a number";
+            return false;
+        }
+
+        if      (token == "after") spec->after = value;
+        else if (token == "every") spec->every = value;
+        else if (token == "times") spec->times = value;
+        else
+        {
+            *error = "unknown option " + token + " (after, every or times)";
+            return false;
+        }
+    }
+
+    if (spec->every == 0)
+    {
+        *error = "every must be at least 1";
+        return false;
+    }
+    return true;
+}
+
+static bool ParseScript(const std::string& script, std::vector<FaultSpec>* specs, std::string* error)
+{
+    std::istringstream in(script);
+    std::string        line;
+    int                lineNo = 0;
+
+    while (std::getline(in, line))
+    {
+        ++lineNo;
+
+        const size_t hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        FaultSpec   spec;
+        std::string why;
+        if (!ParseRule(line, &spec, &why))
+        {
+            *error = "line " + std::to_string(lineNo) + ": " + why;
+            return false;
+        }
+        if (specs->size() == kMaxRules)
+        {
+            *error = "line " + std::to_string(lineNo) + ": more than 32 rules";
+            return false;
+        }
+        specs->push_back(spec);
+    }
+    return true;
+}
+
+// ---------------- interposition ----------------
+
+const char* Rx2RexEntryName(int entry)
+{
+    return (entry >= 0 && entry < kRx2RexEntryCount) ? kEntryNames[entry] : "?";
+}
+
+std::int64_t Rx2RexShimDetail::Enter(Rx2RexEntry entry, bool canFail, REX::REXError* injected)
+{
+    const std::int64_t start = Rx2MetricNow();
+
+    DWORD         delayMs = 0;
+    bool          hang    = false;
+    REX::REXError err     = REX::kREXError_NoError;
+
+    for (int i = 0; i < g_ruleCount; ++i)
+    {
+        FaultRule&       rule = g_rules[i];
+        const FaultSpec& spec = rule.spec;
+        if (spec.entry >= 0 && spec.entry != entry)
+            continue;
+        if (spec.action == FaultAction::Error && !canFail)
+            continue;
+
+        const std::uint64_t n = rule.seen.fetch_add(1, std::memory_order_relaxed);
+        if (n < spec.after || (n - spec.after) % spec.every != 0)
+            continue;
+        if (rule.fired.fetch_add(1, std::memory_order_relaxed) >= spec.times)
+            continue;
+
+        switch (spec.action)
+        {
+        case FaultAction::Delay:
+            delayMs += spec.delayMs;
+            break;
+        case FaultAction::Error:
+            if (err == REX::kREXError_NoError && !hang)
+                err = spec.error;
+            break;
+        case FaultAction::Hang:
+            if (err == REX::kREXError_NoError)
+                hang = true;
+            break;
+        }
+    }
+
+    if (delayMs)
+        Sleep(delayMs);
+    if (hang)
+    {
+        WaitForSingleObject(g_release, INFINITE);
+        err = REX::kREXError_OperationAbortedByUser;
+    }
+
+    *injected = err;
+    return start;
+}
+
+void Rx2RexShimDetail::Leave(Rx2RexEntry entry, std::int64_t start, REX::REXError result, bool injected)
+{
+    Rx2MetricRexCall(entry, Rx2MetricElapsedUs(start), result != REX::kREXError_NoError, injected);
+}
+
+// ---------------- control ----------------
+
+bool Rx2RexShimEnable(const std::string& script, std::string* error)
+{
+    std::vector<FaultSpec> specs;
+    std::string            why;
+    if (!ParseScript(script, &specs, &why))
+    {
+        if (error)
+            *error = why;
+        return false;
+    }
+
+    if (!g_release)
+    {
+        g_release = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (!g_release)
+        {
+            if (error)
+                *error = "cannot create the release event";
+            return false;
+        }
+    }
+    ResetEvent(g_release);
+
+    Rx2RexShimDetail::active.store(false, std::memory_order_relaxed);
+    for (size_t i = 0; i < specs.size(); ++i)
+    {
+        g_rules[i].spec = specs[i];
+        g_rules[i].seen.store(0, std::memory_order_relaxed);
+        g_rules[i].fired.store(0, std::memory_order_relaxed);
+    }
+    g_ruleCount = static_cast<int>(specs.size());
+    Rx2RexShimDetail::active.store(true, std::memory_order_release);
+    return true;
+}
+
+bool Rx2RexShimEnabled()
+{
+    return Rx2RexShimDetail::active.load(std::memory_order_relaxed);
+}
+
+static bool ReadTextFile(const std::wstring& path, std::string* text)
+{
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    char  chunk[4096];
+    DWORD read = 0;
+    while (ReadFile(file, chunk, sizeof(chunk), &read, nullptr) && read > 0)
+        text->append(chunk, read);
+    CloseHandle(file);
+    return true;
+}
+
+void Rx2RexShimStart(IAIMPCore* core)
+{
+    const int mode = Rx2GetSettings().rexShim;
+    if (!core || mode == 0)
+        return;
+
+    std::string script;
+    if (mode == 2)
+    {
+        const std::wstring dir = Rx2ProfileDir(core);
+        if (!dir.empty() && !ReadTextFile(dir + L"RexFaults.txt", &script))
+            OutputDebugStringW(L"RX2Decoder: no RexFaults.txt; timing REX calls only\n");
+    }
+
+    std::string error;
+    if (!Rx2RexShimEnable(script, &error))
+    {
+        wchar_t msg[256];
+        _snwprintf_s(msg, _countof(msg), _TRUNCATE, L"RX2Decoder: RexFaults.txt %hs; shim off\n",
+                     error.c_str());
+        OutputDebugStringW(msg);
+    }
+}
+
+void Rx2RexShimStop()
+{
+    if (!Rx2RexShimDetail::active.exchange(false))
+        return;
+
+    // Hung calls return kREXError_OperationAbortedByUser without touching
+    // the library. The event stays set, so a call still on its way in does
+    // not hang either.
+    SetEvent(g_release);
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+// Interposition layer over the REX Shared Library API.
+//
+// The plugin calls the library through Rx2RexApi::REXxxx(), which have the
+// same signatures as the REX:: functions and forward to them whichever
+// loader provides them (RexLegacyLoader.cpp on x86, the SDK's REX.c on
+// x64). While the shim is off a call costs one relaxed load and a branch.
+// While it is on, every call is counted and timed into the rex_api section
+// of Stats.json (Rx2Metrics.h), and a fault script can make chosen calls
+// slow, fail or hang.
+//
+// Fault script, one rule per line, '#' starts a comment:
+//
+//   <entry | *>  delay <ms> | error <REXError> | hang  [after <n>] [every <n>] [times <n>]
+//
+// `entry` is a REX function name as in Rx2RexEntryName(), e.g. REXCreate.
+// A rule sees every call to its entry; it skips the first `after` (0),
+// then fires on every `every`-th (1), at most `times` times (unlimited).
+// All matching delays are slept before the call; the first matching error
+// is returned instead of calling the library. A hang blocks the caller
+// until the shim is stopped and then returns kREXError_OperationAbortedByUser
+// without calling the library; outside the REXCreate sandbox it blocks
+// whichever AIMP thread made the call. The calls that return nothing
+// (REXDelete, REXUninitializeDLL) ignore errors, and a hang only delays
+// them: once released they still reach the library, so no handle leaks.
+// Timings include injected delays, since that is what the caller waited.
+//
+// The plugin turns the shim on when RX2Decoder\RexShim is 1 (timing) or 2
+// (timing and the rules in <AIMP profile>\RX2Decoder\RexFaults.txt).
+
+#include "apiCore.h"
+#include "RexSdk.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+enum Rx2RexEntry
+{
+    kRx2RexInitializeDLL,
+    kRx2RexUninitializeDLL,
+    kRx2RexCreate,
+    kRx2RexDelete,
+    kRx2RexGetInfo,
+    kRx2RexGetInfoFromBuffer,
+    kRx2RexGetCreatorInfo,
+    kRx2RexGetSliceInfo,
+    kRx2RexSetOutputSampleRate,
+    kRx2RexRenderSlice,
+    kRx2RexStartPreview,
+    kRx2RexStopPreview,
+    kRx2RexRenderPreviewBatch,
+    kRx2RexSetPreviewTempo,
+    kRx2RexEntryCount
+};
+
+// The REX function name, e.g. "REXCreate".
+const char* Rx2RexEntryName(int entry);
+
+// Turns the shim on with the given fault script (empty = timing only).
+// False, with the offending line in *error, if the script does not parse;
+// the shim is then left as it was. Rules are replaced only while no call
+// is in the shim, i.e. call it before REX files are opened.
+bool Rx2RexShimEnable(const std::string& script, std::string* error);
+bool Rx2RexShimEnabled();
+
+// Plugin lifetime: enables the shim per RX2Decoder\RexShim. Stop turns it
+// off and releases hung calls; call it before the library is unloaded.
+void Rx2RexShimStart(IAIMPCore* core);
+void Rx2RexShimStop();
+
+namespace Rx2RexShimDetail
+{
+    extern std::atomic<bool> active;
+
+    // Applies the script to one call and returns the start time to pass to
+    // Leave(); *injected is set to the error to return instead of calling
+    // the library, or kREXError_NoError. Error rules only apply if canFail.
+    std::int64_t Enter(Rx2RexEntry entry, bool canFail, REX::REXError* injected);
+    void         Leave(Rx2RexEntry entry, std::int64_t start, REX::REXError result, bool injected);
+
+    template <typename Call>
+    REX::REXError Run(Rx2RexEntry entry, Call call)
+    {
+        if (!active.load(std::memory_order_relaxed))
+            return call();
+
+        REX::REXError      err   = REX::kREXError_NoError;
+        const std::int64_t start = Enter(entry, true, &err);
+        const bool         fault = err != REX::kREXError_NoError;
+        if (!fault)
+            err = call();
+        Leave(entry, start, err, fault);
+        return err;
+    }
+
+    template <typename Call>
+    void RunVoid(Rx2RexEntry entry, Call call)
+    {
+        if (!active.load(std::memory_order_relaxed))
+        {
+            call();
+            return;
+        }
+
+        REX::REXError      err   = REX::kREXError_NoError;
+        const std::int64_t start = Enter(entry, false, &err);
+        const bool         hung  = err != REX::kREXError_NoError;
+        call();   // delayed, never skipped
+        Leave(entry, start, REX::kREXError_NoError, hung);
+    }
+}
+
+namespace Rx2RexApi
+{
+    inline REX::REXError REXInitializeDLL_DirPath(const wchar_t* dirPath)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexInitializeDLL,
+            [&]() { return REX::REXInitializeDLL_DirPath(dirPath); });
+    }
+
+    inline void REXUninitializeDLL()
+    {
+        Rx2RexShimDetail::RunVoid(kRx2RexUninitializeDLL, [&]() { REX::REXUninitializeDLL(); });
+    }
+
+    inline REX::REXError REXCreate(REX::REXHandle* handle, const char buffer[], REX::REX_int32_t size,
+                                   REX::REXCreateCallback callbackFunc, void* userData)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexCreate,
+            [&]() { return REX::REXCreate(handle, buffer, size, callbackFunc, userData); });
+    }
+
+    inline void REXDelete(REX::REXHandle* handle)
+    {
+        Rx2RexShimDetail::RunVoid(kRx2RexDelete, [&]() { REX::REXDelete(handle); });
+    }
+
+    inline REX::REXError REXGetInfo(REX::REXHandle handle, REX::REX_int32_t infoSize, REX::REXInfo* info)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexGetInfo,
+            [&]() { return REX::REXGetInfo(handle, infoSize, info); });
+    }
+
+    inline REX::REXError REXGetInfoFromBuffer(REX::REX_int32_t bufferSize, const char buffer[],
+                                              REX::REX_int32_t infoSize, REX::REXInfo* info)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexGetInfoFromBuffer,
+            [&]() { return REX::REXGetInfoFromBuffer(bufferSize, buffer, infoSize, info); });
+    }
+
+    inline REX::REXError REXGetCreatorInfo(REX::REXHandle handle, REX::REX_int32_t creatorInfoSize,
+                                           REX::REXCreatorInfo* creatorInfo)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexGetCreatorInfo,
+            [&]() { return REX::REXGetCreatorInfo(handle, creatorInfoSize, creatorInfo); });
+    }
+
+    inline REX::REXError REXGetSliceInfo(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                         REX::REX_int32_t sliceInfoSize, REX::REXSliceInfo* sliceInfo)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexGetSliceInfo,
+            [&]() { return REX::REXGetSliceInfo(handle, sliceIndex, sliceInfoSize, sliceInfo); });
+    }
+
+    inline REX::REXError REXSetOutputSampleRate(REX::REXHandle handle, REX::REX_int32_t outputSampleRate)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexSetOutputSampleRate,
+            [&]() { return REX::REXSetOutputSampleRate(handle, outputSampleRate); });
+    }
+
+    inline REX::REXError REXRenderSlice(REX::REXHandle handle, REX::REX_int32_t sliceIndex,
+                                        REX::REX_int32_t bufferFrameLength, float* outputBuffers[2])
+    {
+        return Rx2RexShimDetail::Run(kRx2RexRenderSlice,
+            [&]() { return REX::REXRenderSlice(handle, sliceIndex, bufferFrameLength, outputBuffers); });
+    }
+
+    inline REX::REXError REXStartPreview(REX::REXHandle handle)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexStartPreview,
+            [&]() { return REX::REXStartPreview(handle); });
+    }
+
+    inline REX::REXError REXStopPreview(REX::REXHandle handle)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexStopPreview,
+            [&]() { return REX::REXStopPreview(handle); });
+    }
+
+    inline REX::REXError REXRenderPreviewBatch(REX::REXHandle handle, REX::REX_int32_t framesToRender,
+                                               float* outputBuffers[2])
+    {
+        return Rx2RexShimDetail::Run(kRx2RexRenderPreviewBatch,
+            [&]() { return REX::REXRenderPreviewBatch(handle, framesToRender, outputBuffers); });
+    }
+
+    inline REX::REXError REXSetPreviewTempo(REX::REXHandle handle, REX::REX_int32_t tempo)
+    {
+        return Rx2RexShimDetail::Run(kRx2RexSetPreviewTempo,
+            [&]() { return REX::REXSetPreviewTempo(handle, tempo); });
+    }
+}
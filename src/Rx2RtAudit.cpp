@@ -0,0 +1,152 @@
+#include "Rx2RtAudit.h"
+
+#if RX2_RT_AUDIT
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+static const int kKinds = static_cast<int>(Rx2RtViolation::Count);
+
+static std::atomic<std::uint64_t> g_counts[kKinds];
+static std::atomic<bool>          g_logged[kKinds];
+static thread_local int           t_depth    = 0;
+static thread_local bool          t_noting   = false;   // no recursion via logging
+
+static const wchar_t* KindName(Rx2RtViolation kind)
+{
+    switch (kind)
+    {
+    case Rx2RtViolation::Allocation: return L"allocation";
+    case Rx2RtViolation::Lock:       return L"blocking lock";
+    case Rx2RtViolation::Blocking:   return L"blocking call";
+    case Rx2RtViolation::Contention: return L"lock contention";
+    default:                         return L"?";
+    }
+}
+
+// ---------------- public API ----------------
+
+Rx2RtScope::Rx2RtScope()
+{
+    ++t_depth;
+}
+
+Rx2RtScope::~Rx2RtScope()
+{
+    --t_depth;
+}
+
+bool Rx2RtInScope()
+{
+    return t_depth > 0 && !t_noting;
+}
+
+void Rx2RtNote(Rx2RtViolation kind, const char* site)
+{
+    const int k = static_cast<int>(kind);
+    if (k < 0 || k >= kKinds)
+        return;
+
+    g_counts[k].fetch_add(1, std::memory_order_relaxed);
+
+    if (g_logged[k].exchange(true, std::memory_order_relaxed))
+        return;
+
+    t_noting = true;
+    wchar_t msg[256];
+    _snwprintf_s(msg, _countof(msg), _TRUNCATE,
+                 L"RX2Decoder: RT audit: %ls on the audio thread in %hs\n",
+                 KindName(kind), site ? site : "?");
+    OutputDebugStringW(msg);
+    t_noting = false;
+}
+
+void Rx2RtAuditReport()
+{
+    wchar_t msg[256];
+    _snwprintf_s(msg, _countof(msg), _TRUNCATE,
+                 L"RX2Decoder: RT audit: %llu allocations, %llu blocking locks, "
+                 L"%llu blocking calls, %llu contended reads\n",
+                 static_cast<unsigned long long>(g_counts[0].load()),
+                 static_cast<unsigned long long>(g_counts[1].load()),
+                 static_cast<unsigned long long>(g_counts[2].load()),
+                 static_cast<unsigned long long>(g_counts[3].load()));
+    OutputDebugStringW(msg);
+}
+
+// ---------------- allocation hooks ----------------
+
+// Replacing the global operators only affects this module's allocations,
+// which is exactly the code under audit.
+
+void* operator new(std::size_t size)
+{
+    RX2_RT_NOTE(Rx2RtViolation::Allocation, "operator new");
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    RX2_RT_NOTE(Rx2RtViolation::Allocation, "operator new");
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+// Aligned forms (Rx2PcmStore's chunks, over-aligned types); _aligned_malloc
+// memory must go back through _aligned_free.
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    RX2_RT_NOTE(Rx2RtViolation::Allocation, "operator new");
+    if (void* p = _aligned_malloc(size ? size : 1, static_cast<std::size_t>(align)))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return operator new(size, align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    RX2_RT_NOTE(Rx2RtViolation::Allocation, "operator new");
+    return _aligned_malloc(size ? size : 1, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, align, tag);
+}
+
+void operator delete(void* p) noexcept                                   { std::free(p); }
+void operator delete[](void* p) noexcept                                 { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept                      { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept                    { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept            { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept          { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept                 { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept               { _aligned_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept    { _aligned_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept  { _aligned_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept   { _aligned_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { _aligned_free(p); }
+
+#endif
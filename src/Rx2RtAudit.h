@@ -0,0 +1,49 @@
+#pragma once
+
+// Audio-thread audit (RX2_RT_AUDIT builds only).
+//
+// Rx2Decoder::Read, SetPosition and GetAvailableData run on AIMP's audio
+// thread and must not allocate, wait on a lock or make blocking system
+// calls. RX2_RT_SCOPE() marks such a call; while one is active on the
+// current thread, heap allocations through operator new are counted
+// automatically, and code that can block reports itself with RX2_RT_NOTE.
+// The first violation of each kind is logged with OutputDebugString as it
+// happens, and Rx2RtAuditReport() logs the totals. Without RX2_RT_AUDIT
+// every macro compiles to nothing.
+
+enum class Rx2RtViolation
+{
+    Allocation,   // heap allocation
+    Lock,         // lock acquisition that can wait
+    Blocking,     // system call that can block or fault (I/O, mapping, render)
+    Contention,   // a try-lock failed and Read() served silence during an evict or restore
+    Count
+};
+
+#if RX2_RT_AUDIT
+
+class Rx2RtScope
+{
+public:
+    Rx2RtScope();
+    ~Rx2RtScope();
+
+    Rx2RtScope(const Rx2RtScope&) = delete;
+    Rx2RtScope& operator=(const Rx2RtScope&) = delete;
+};
+
+bool Rx2RtInScope();
+void Rx2RtNote(Rx2RtViolation kind, const char* site);
+void Rx2RtAuditReport();
+
+#define RX2_RT_SCOPE()           Rx2RtScope rx2RtScope_
+#define RX2_RT_NOTE(kind, site)  do { if (Rx2RtInScope()) Rx2RtNote(kind, site); } while (0)
+
+#else
+
+inline void Rx2RtAuditReport() {}
+
+#define RX2_RT_SCOPE()           ((void)0)
+#define RX2_RT_NOTE(kind, site)  ((void)0)
+
+#endif
@@ -0,0 +1,147 @@
+#include "Rx2Settings.h"
+#include "apiObjects.h"
+
+#include <cwchar>
+
+static Rx2Settings MakeDefaultSettings()
+{
+    Rx2Settings s{};
+    s.pcmStorageBits    = 0;
+    s.pcmMinStorageBits = 16;
+    s.pcmNativeOutput   = true;
+    s.pcmCompression    = false;
+    s.memoryBudgetMB    = 512;
+    s.prefetchNext      = true;
+    s.prefetchMaxMB     = 256;
+    s.analysisCache     = false;
+    s.libraryIndex      = false;
+    s.sliceTracks       = false;
+    s.rexCreateTimeoutMs = 2000;
+    s.stats             = true;
+    s.trace             = false;
+    s.recordCalls       = false;
+    s.rexShim           = 0;
+#if defined(_WIN64)
+    s.pcmSpillThresholdMB = 1024;
+#else
+    s.pcmSpillThresholdMB = 256;   // x86 address space fragments early
+#endif
+    return s;
+}
+
+static Rx2Settings g_settings = MakeDefaultSettings();
+
+// Read one integer key from the config service; returns fallback when absent.
+static int ReadConfigInt(IAIMPCore* core,
+                         IAIMPServiceConfig* config,
+                         const wchar_t* key,
+                         int fallback)
+{
+    IAIMPString* path = nullptr;
+    if (FAILED(core->CreateObject(IID_IAIMPString, (void**)&path)))
+        return fallback;
+
+    path->SetData(const_cast<wchar_t*>(key), static_cast<int>(wcslen(key)));
+
+    int value = fallback;
+    if (FAILED(config->GetValueAsInt32(path, &value)))
+        value = fallback;
+
+    path->Release();
+    return value;
+}
+
+static bool IsValidStorageBits(int bits, bool allowAuto)
+{
+    return (allowAuto && bits == 0) || bits == 16 || bits == 24 || bits == 32;
+}
+
+void Rx2LoadSettings(IAIMPCore* core)
+{
+    g_settings = MakeDefaultSettings();
+
+    if (!core)
+        return;
+
+    IAIMPServiceConfig* config = nullptr;
+    if (FAILED(core->QueryInterface(IID_IAIMPServiceConfig, (void**)&config)) || !config)
+        return;
+
+    Rx2Settings s = g_settings;
+
+    int storageBits = ReadConfigInt(core, config, L"RX2Decoder\\PcmStorageBits", s.pcmStorageBits);
+    if (IsValidStorageBits(storageBits, true))
+        s.pcmStorageBits = storageBits;
+
+    int minBits = ReadConfigInt(core, config, L"RX2Decoder\\PcmMinStorageBits", s.pcmMinStorageBits);
+    if (IsValidStorageBits(minBits, false))
+        s.pcmMinStorageBits = minBits;
+
+    s.pcmNativeOutput = ReadConfigInt(core, config, L"RX2Decoder\\PcmNativeOutput",
+                                      s.pcmNativeOutput ? 1 : 0) != 0;
+
+    s.pcmCompression = ReadConfigInt(core, config, L"RX2Decoder\\PcmCompression",
+                                     s.pcmCompression ? 1 : 0) != 0;
+
+    int budgetMB = ReadConfigInt(core, config, L"RX2Decoder\\MemoryBudgetMB", s.memoryBudgetMB);
+    if (budgetMB >= 0)
+        s.memoryBudgetMB = budgetMB;
+
+    int spillMB = ReadConfigInt(core, config, L"RX2Decoder\\PcmSpillThresholdMB", s.pcmSpillThresholdMB);
+    if (spillMB >= 0)
+        s.pcmSpillThresholdMB = spillMB;
+
+    s.prefetchNext = ReadConfigInt(core, config, L"RX2Decoder\\PrefetchNext",
+                                   s.prefetchNext ? 1 : 0) != 0;
+
+    int prefetchMB = ReadConfigInt(core, config, L"RX2Decoder\\PrefetchMaxMB", s.prefetchMaxMB);
+    if (prefetchMB > 0)
+        s.prefetchMaxMB = prefetchMB;
+
+    s.analysisCache = ReadConfigInt(core, config, L"RX2Decoder\\AnalysisCache",
+                                    s.analysisCache ? 1 : 0) != 0;
+
+    s.libraryIndex = ReadConfigInt(core, config, L"RX2Decoder\\LibraryIndex",
+                                   s.libraryIndex ? 1 : 0) != 0;
+
+    s.sliceTracks = ReadConfigInt(core, config, L"RX2Decoder\\SliceTracks",
+                                  s.sliceTracks ? 1 : 0) != 0;
+
+    int timeoutMs = ReadConfigInt(core, config, L"RX2Decoder\\RexCreateTimeoutMs", s.rexCreateTimeoutMs);
+    if (timeoutMs >= 100 && timeoutMs <= 60000)
+        s.rexCreateTimeoutMs = timeoutMs;
+
+    s.stats = ReadConfigInt(core, config, L"RX2Decoder\\Stats", s.stats ? 1 : 0) != 0;
+    s.trace = ReadConfigInt(core, config, L"RX2Decoder\\Trace", s.trace ? 1 : 0) != 0;
+    s.recordCalls = ReadConfigInt(core, config, L"RX2Decoder\\RecordCalls", s.recordCalls ? 1 : 0) != 0;
+
+    int rexShim = ReadConfigInt(core, config, L"RX2Decoder\\RexShim", s.rexShim);
+    if (rexShim >= 0 && rexShim <= 2)
+        s.rexShim = rexShim;
+
+    config->Release();
+    g_settings = s;
+}
+
+const Rx2Settings& Rx2GetSettings()
+{
+    return g_settings;
+}
+
+std::wstring Rx2ProfileDir(IAIMPCore* core)
+{
+    IAIMPString* profile = nullptr;
+    if (!core || FAILED(core->GetPath(AIMP_CORE_PATH_PROFILE, &profile)) || !profile)
+        return std::wstring();
+
+    std::wstring dir(profile->GetData(), static_cast<size_t>(profile->GetLength()));
+    profile->Release();
+
+    if (dir.empty())
+        return dir;
+    if (dir.back() != L'\\')
+        dir.push_back(L'\\');
+    dir.append(L"RX2Decoder\\");
+    CreateDirectoryW(dir.c_str(), nullptr);
+    return dir;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "apiCore.h"
+
+#include <string>
+
+// Plugin-wide tunables read from AIMP's configuration service at plugin
+// initialization. Missing or out-of-range keys fall back to the defaults.
+struct Rx2Settings
+{
+    // Resident PCM depth: 0 = follow the file's source bit depth,
+    // 16 or 24 = integer PCM, 32 = float (default).
+    int  pcmStorageBits;
+
+    // Quality floor for integer storage; never store below this depth.
+    int  pcmMinStorageBits;
+
+    // Hand integer PCM to AIMP in its native sample format. When disabled,
+    // Read() converts integer storage back to 32-bit float on the fly.
+    bool pcmNativeOutput;
+
+    // Keep integer PCM losslessly compressed in independently decodable
+    // blocks. Has no effect on float storage.
+    bool pcmCompression;
+
+    // Soft cap on PCM held by all open decoders, in MiB; 0 = unlimited.
+    // Idle decoders over the cap drop their PCM and re-render on next use.
+    int  memoryBudgetMB;
+
+    // Loops whose PCM would exceed this many MiB are rendered into a
+    // temporary memory-mapped file instead of the heap; a heap render that
+    // runs out of memory also retries this way. 0 disables spilling.
+    int  pcmSpillThresholdMB;
+
+    // Render the next queued REX track in the background while the current
+    // one plays, keeping at most prefetchMaxMB of PCM for it.
+    bool prefetchNext;
+    int  prefetchMaxMB;
+
+    // Persist per-file analysis (waveform peaks) under the AIMP profile
+    // folder so it survives restarts.
+    bool analysisCache;
+
+    // Consult the library index built by rx2_index on open
+    // (Rx2LibraryIndex.h).
+    bool libraryIndex;
+
+    // Expand REX files into the whole loop plus one virtual track per
+    // slice; a slice track renders only that slice.
+    bool sliceTracks;
+
+    // How long REXCreate may run before the open fails (kRexError_CreateTimedOut).
+    int  rexCreateTimeoutMs;
+
+    // Write the performance counters (Rx2Metrics) to the profile folder at
+    // shutdown and when asked through the dump event.
+    bool stats;
+
+    // Record the lifecycle trace (Rx2Trace) and write it at shutdown.
+    bool trace;
+
+    // Log every decoder call for replay (Rx2CallLog).
+    bool recordCalls;
+
+    // REX API shim (Rx2RexShim): 0 off, 1 time every library call, 2 also
+    // inject the faults scripted in the profile's RexFaults.txt.
+    int  rexShim;
+};
+
+void               Rx2LoadSettings(IAIMPCore* core);
+const Rx2Settings& Rx2GetSettings();
+
+// The plugin's folder in the AIMP profile, "<profile>\RX2Decoder\" with the
+// trailing backslash, created if missing; empty if AIMP has no profile path.
+// Stats, traces, call logs, fault scripts and caches live there.
+std::wstring       Rx2ProfileDir(IAIMPCore* core);
@@ -0,0 +1,351 @@
+#include "Rx2SliceTrack.h"
+
+#include <cwchar>
+
+// ---------------- helpers ----------------
+
+static IAIMPString* MakeString(IAIMPCore* core, const std::wstring& text)
+{
+    IAIMPString* s = nullptr;
+    if (!core || FAILED(core->CreateObject(IID_IAIMPString, (void**)&s)) || !s)
+        return nullptr;
+
+    s->SetData(const_cast<wchar_t*>(text.c_str()), static_cast<int>(text.length()));
+    return s;
+}
+
+static std::wstring FileTitle(const std::wstring& path)
+{
+    const size_t slash = path.find_last_of(L"\\/");
+    std::wstring name = (slash == std::wstring::npos) ? path : path.substr(slash + 1);
+
+    const size_t dot = name.find_last_of(L'.');
+    if (dot != std::wstring::npos && dot > 0)
+        name.erase(dot);
+    return name;
+}
+
+// ---------------- Rx2SliceStream ----------------
+
+Rx2SliceStream::Rx2SliceStream(IAIMPStream* inner, int sliceIndex)
+    : m_refCount(1)
+    , m_inner(inner)
+    , m_innerFile(nullptr)
+    , m_sliceIndex(sliceIndex)
+{
+    if (m_inner)
+    {
+        m_inner->AddRef();
+        if (FAILED(m_inner->QueryInterface(IID_IAIMPFileStream, (void**)&m_innerFile)))
+            m_innerFile = nullptr;
+    }
+}
+
+Rx2SliceStream::~Rx2SliceStream()
+{
+    if (m_innerFile)
+        m_innerFile->Release();
+    if (m_inner)
+        m_inner->Release();
+}
+
+HRESULT WINAPI Rx2SliceStream::QueryInterface(REFIID riid, void **ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IAIMPStream ||
+        (riid == IID_IAIMPFileStream && m_innerFile))
+    {
+        *ppv = static_cast<IAIMPFileStream*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    if (riid == IID_IRx2SliceSource)
+    {
+        *ppv = static_cast<IRx2SliceSource*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2SliceStream::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2SliceStream::Release()
+{
+    ULONG r = InterlockedDecrement(&m_refCount);
+    if (r == 0)
+        delete this;
+    return r;
+}
+
+INT64 WINAPI Rx2SliceStream::GetSize()
+{
+    return m_inner ? m_inner->GetSize() : 0;
+}
+
+HRESULT WINAPI Rx2SliceStream::SetSize(const INT64 /*Value*/)
+{
+    return E_NOTIMPL;   // read-only
+}
+
+INT64 WINAPI Rx2SliceStream::GetPosition()
+{
+    return m_inner ? m_inner->GetPosition() : 0;
+}
+
+HRESULT WINAPI Rx2SliceStream::Seek(const INT64 Offset, int Mode)
+{
+    return m_inner ? m_inner->Seek(Offset, Mode) : E_FAIL;
+}
+
+int WINAPI Rx2SliceStream::Read(unsigned char *Buffer, unsigned int Count)
+{
+    return m_inner ? m_inner->Read(Buffer, Count) : 0;
+}
+
+HRESULT WINAPI Rx2SliceStream::Write(unsigned char* /*Buffer*/, unsigned int /*Count*/, unsigned int *Written)
+{
+    if (Written)
+        *Written = 0;
+    return E_NOTIMPL;
+}
+
+HRESULT WINAPI Rx2SliceStream::GetClipping(INT64 *Offset, INT64 *Size)
+{
+    return m_innerFile ? m_innerFile->GetClipping(Offset, Size) : E_NOTIMPL;
+}
+
+HRESULT WINAPI Rx2SliceStream::GetFileName(IAIMPString **S)
+{
+    return m_innerFile ? m_innerFile->GetFileName(S) : E_NOTIMPL;
+}
+
+// ---------------- Rx2SliceFile ----------------
+
+Rx2SliceFile::Rx2SliceFile(IAIMPCore* core, IAIMPVirtualFile* inner, const std::wstring& path,
+                           int sliceIndex, int sampleRate, int channels, std::int64_t frames)
+    : m_refCount(1)
+    , m_core(core)
+    , m_inner(inner)
+    , m_path(path)
+    , m_sliceIndex(sliceIndex)
+    , m_sampleRate(sampleRate)
+    , m_channels(channels)
+    , m_frames(frames)
+    , m_hasReplayGain(false)
+    , m_trackGainDb(0.0)
+    , m_truePeak(0.0)
+{
+    if (m_core)
+        m_core->AddRef();
+    if (m_inner)
+        m_inner->AddRef();
+}
+
+void Rx2SliceFile::SetReplayGain(double trackGainDb, double truePeak)
+{
+    m_hasReplayGain = true;
+    m_trackGainDb   = trackGainDb;
+    m_truePeak      = truePeak;
+}
+
+Rx2SliceFile::~Rx2SliceFile()
+{
+    if (m_inner)
+        m_inner->Release();
+    if (m_core)
+        m_core->Release();
+}
+
+HRESULT WINAPI Rx2SliceFile::QueryInterface(REFIID riid, void **ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IAIMPPropertyList || riid == IID_IAIMPVirtualFile)
+    {
+        *ppv = static_cast<IAIMPVirtualFile*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2SliceFile::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2SliceFile::Release()
+{
+    ULONG r = InterlockedDecrement(&m_refCount);
+    if (r == 0)
+        delete this;
+    return r;
+}
+
+// IAIMPPropertyList: the core's virtual file keeps the properties.
+
+void WINAPI Rx2SliceFile::BeginUpdate()                     { m_inner->BeginUpdate(); }
+void WINAPI Rx2SliceFile::EndUpdate()                       { m_inner->EndUpdate(); }
+HRESULT WINAPI Rx2SliceFile::Reset()                        { return m_inner->Reset(); }
+
+HRESULT WINAPI Rx2SliceFile::GetValueAsFloat(int PropertyID, double *Value)
+{
+    return m_inner->GetValueAsFloat(PropertyID, Value);
+}
+
+HRESULT WINAPI Rx2SliceFile::GetValueAsInt32(int PropertyID, int *Value)
+{
+    return m_inner->GetValueAsInt32(PropertyID, Value);
+}
+
+HRESULT WINAPI Rx2SliceFile::GetValueAsInt64(int PropertyID, INT64 *Value)
+{
+    return m_inner->GetValueAsInt64(PropertyID, Value);
+}
+
+HRESULT WINAPI Rx2SliceFile::GetValueAsObject(int PropertyID, REFIID IID, void **Value)
+{
+    return m_inner->GetValueAsObject(PropertyID, IID, Value);
+}
+
+HRESULT WINAPI Rx2SliceFile::SetValueAsFloat(int PropertyID, const double Value)
+{
+    return m_inner->SetValueAsFloat(PropertyID, Value);
+}
+
+HRESULT WINAPI Rx2SliceFile::SetValueAsInt32(int PropertyID, int Value)
+{
+    return m_inner->SetValueAsInt32(PropertyID, Value);
+}
+
+HRESULT WINAPI Rx2SliceFile::SetValueAsInt64(int PropertyID, const INT64 Value)
+{
+    return m_inner->SetValueAsInt64(PropertyID, Value);
+}
+
+HRESULT WINAPI Rx2SliceFile::SetValueAsObject(int PropertyID, IUnknown *Value)
+{
+    return m_inner->SetValueAsObject(PropertyID, Value);
+}
+
+// IAIMPVirtualFile
+
+HRESULT WINAPI Rx2SliceFile::CreateStream(IAIMPStream **Stream)
+{
+    if (!Stream)
+        return E_POINTER;
+    *Stream = nullptr;
+
+    if (!m_core)
+        return E_FAIL;
+
+    IAIMPServiceFileStreaming* streaming = nullptr;
+    if (FAILED(m_core->QueryInterface(IID_IAIMPServiceFileStreaming, (void**)&streaming)) || !streaming)
+        return E_FAIL;
+
+    IAIMPStream* file = nullptr;
+    HRESULT      hr   = E_FAIL;
+
+    if (IAIMPString* name = MakeString(m_core, m_path))
+    {
+        hr = streaming->CreateStreamForFile(name, AIMP_SERVICE_FILESTREAMING_FLAG_READ, -1, -1, &file);
+        name->Release();
+    }
+    streaming->Release();
+
+    if (FAILED(hr) || !file)
+        return FAILED(hr) ? hr : E_FAIL;
+
+    // The whole-loop entry is an ordinary file stream.
+    if (m_sliceIndex < 0)
+    {
+        *Stream = file;
+        return S_OK;
+    }
+
+    *Stream = new Rx2SliceStream(file, m_sliceIndex);
+    file->Release();
+    return S_OK;
+}
+
+// Enough for the playlist without opening a decoder; slices report their
+// exact length, so listing a 200-slice file never renders anything.
+HRESULT WINAPI Rx2SliceFile::GetFileInfo(IAIMPFileInfo *Info)
+{
+    if (!Info)
+        return E_POINTER;
+
+    std::wstring title = FileTitle(m_path);
+    if (m_sliceIndex >= 0)
+    {
+        wchar_t suffix[32];
+        _snwprintf_s(suffix, _countof(suffix), _TRUNCATE, L" - Slice %d", m_sliceIndex + 1);
+        title.append(suffix);
+    }
+
+    Info->BeginUpdate();
+
+    if (IAIMPString* s = MakeString(m_core, title))
+    {
+        Info->SetValueAsObject(AIMP_FILEINFO_PROPID_TITLE, s);
+        s->Release();
+    }
+
+    if (m_sampleRate > 0)
+    {
+        Info->SetValueAsInt32(AIMP_FILEINFO_PROPID_SAMPLERATE, m_sampleRate);
+        if (m_frames > 0)
+            Info->SetValueAsFloat(AIMP_FILEINFO_PROPID_DURATION,
+                                  static_cast<double>(m_frames) / m_sampleRate);
+    }
+
+    if (m_channels > 0)
+        Info->SetValueAsInt32(AIMP_FILEINFO_PROPID_CHANNELS, m_channels);
+
+    if (m_hasReplayGain)
+    {
+        Info->SetValueAsFloat(AIMP_FILEINFO_PROPID_TRACKGAIN, m_trackGainDb);
+        Info->SetValueAsFloat(AIMP_FILEINFO_PROPID_TRACKPEAK, m_truePeak);
+    }
+
+    Info->EndUpdate();
+    return S_OK;
+}
+
+BOOL WINAPI Rx2SliceFile::IsExists()
+{
+    return GetFileAttributesW(m_path.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+HRESULT WINAPI Rx2SliceFile::IsInSameStream(IAIMPVirtualFile *VirtualFile)
+{
+    if (!VirtualFile)
+        return E_POINTER;
+
+    IAIMPString* source = nullptr;
+    if (FAILED(VirtualFile->GetValueAsObject(AIMP_VIRTUALFILE_PROPID_AUDIOSOURCEFILE,
+                                             IID_IAIMPString, (void**)&source)) || !source)
+        return S_FALSE;
+
+    const std::wstring other(source->GetData(), static_cast<size_t>(source->GetLength()));
+    source->Release();
+
+    return _wcsicmp(other.c_str(), m_path.c_str()) == 0 ? S_OK : S_FALSE;
+}
+
+HRESULT WINAPI Rx2SliceFile::Synchronize()
+{
+    return E_NOTIMPL;   // nothing to write back
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "apiCore.h"
+#include "apiFileManager.h"
+#include "apiObjects.h"
+
+#include <windows.h>
+
+#include <cstdint>
+#include <string>
+
+// Private interface carried by streams opened for a slice sub-track, so
+// CreateDecoder can tell which slice to render.
+// {5C1A7E0B-2F43-4D8E-9B61-3E2A90C4D7F1}
+static const GUID IID_IRx2SliceSource =
+    { 0x5c1a7e0b, 0x2f43, 0x4d8e, { 0x9b, 0x61, 0x3e, 0x2a, 0x90, 0xc4, 0xd7, 0xf1 } };
+
+class IRx2SliceSource : public IUnknown
+{
+public:
+    virtual int WINAPI GetSliceIndex() = 0;
+};
+
+// IAIMPFileStream over the REX file itself, tagged with a slice index.
+// Everything except IRx2SliceSource is forwarded to the real file stream.
+class Rx2SliceStream : public IAIMPFileStream, public IRx2SliceSource
+{
+public:
+    Rx2SliceStream(IAIMPStream* inner, int sliceIndex);
+    virtual ~Rx2SliceStream();
+
+    // IUnknown
+    HRESULT WINAPI QueryInterface(REFIID riid, void **ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    // IAIMPStream
+    INT64   WINAPI GetSize() override;
+    HRESULT WINAPI SetSize(const INT64 Value) override;
+    INT64   WINAPI GetPosition() override;
+    HRESULT WINAPI Seek(const INT64 Offset, int Mode) override;
+    int     WINAPI Read(unsigned char *Buffer, unsigned int Count) override;
+    HRESULT WINAPI Write(unsigned char *Buffer, unsigned int Count, unsigned int *Written) override;
+
+    // IAIMPFileStream
+    HRESULT WINAPI GetClipping(INT64 *Offset, INT64 *Size) override;
+    HRESULT WINAPI GetFileName(IAIMPString **S) override;
+
+    // IRx2SliceSource
+    int     WINAPI GetSliceIndex() override { return m_sliceIndex; }
+
+private:
+    LONG             m_refCount;
+    IAIMPStream*     m_inner;
+    IAIMPFileStream* m_innerFile;   // null if the inner stream is not file-backed
+    int              m_sliceIndex;
+};
+
+// One entry produced by Rx2FileExpander: the whole loop (sliceIndex -1) or
+// a single slice. Property storage is delegated to a core-created virtual
+// file; CreateStream opens the REX file and, for slices, tags the stream
+// so only that slice is rendered.
+class Rx2SliceFile : public IAIMPVirtualFile
+{
+public:
+    // `frames` is the slice length at `sampleRate`; 0 if unknown.
+    Rx2SliceFile(IAIMPCore* core, IAIMPVirtualFile* inner, const std::wstring& path,
+                 int sliceIndex, int sampleRate, int channels, std::int64_t frames);
+    virtual ~Rx2SliceFile();
+
+    // ReplayGain for the entry, from the analysis cache; reported by
+    // GetFileInfo like the decoder does after a render.
+    void SetReplayGain(double trackGainDb, double truePeak);
+
+    // IUnknown
+    HRESULT WINAPI QueryInterface(REFIID riid, void **ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    // IAIMPPropertyList
+    void    WINAPI BeginUpdate() override;
+    void    WINAPI EndUpdate() override;
+    HRESULT WINAPI Reset() override;
+    HRESULT WINAPI GetValueAsFloat(int PropertyID, double *Value) override;
+    HRESULT WINAPI GetValueAsInt32(int PropertyID, int *Value) override;
+    HRESULT WINAPI GetValueAsInt64(int PropertyID, INT64 *Value) override;
+    HRESULT WINAPI GetValueAsObject(int PropertyID, REFIID IID, void **Value) override;
+    HRESULT WINAPI SetValueAsFloat(int PropertyID, const double Value) override;
+    HRESULT WINAPI SetValueAsInt32(int PropertyID, int Value) override;
+    HRESULT WINAPI SetValueAsInt64(int PropertyID, const INT64 Value) override;
+    HRESULT WINAPI SetValueAsObject(int PropertyID, IUnknown *Value) override;
+
+    // IAIMPVirtualFile
+    HRESULT WINAPI CreateStream(IAIMPStream **Stream) override;
+    HRESULT WINAPI GetFileInfo(IAIMPFileInfo *Info) override;
+    BOOL    WINAPI IsExists() override;
+    HRESULT WINAPI IsInSameStream(IAIMPVirtualFile *VirtualFile) override;
+    HRESULT WINAPI Synchronize() override;
+
+private:
+    LONG              m_refCount;
+    IAIMPCore*        m_core;
+    IAIMPVirtualFile* m_inner;
+    std::wstring      m_path;
+    int               m_sliceIndex;
+    int               m_sampleRate;
+    int               m_channels;
+    std::int64_t      m_frames;
+    bool              m_hasReplayGain;
+    double            m_trackGainDb;
+    double            m_truePeak;
+};
@@ -0,0 +1,168 @@
+#include "Rx2SpillFile.h"
+
+#include <string>
+#include <windows.h>
+
+// ---------------- helpers ----------------
+
+typedef BOOL (WINAPI *PrefetchVirtualMemoryFn)(HANDLE, ULONG_PTR, WIN32_MEMORY_RANGE_ENTRY*, ULONG);
+
+// PrefetchVirtualMemory is Windows 8+; resolve it once at runtime.
+static PrefetchVirtualMemoryFn GetPrefetchVirtualMemory()
+{
+    static PrefetchVirtualMemoryFn fn = []() -> PrefetchVirtualMemoryFn
+    {
+        HMODULE kernel = GetModuleHandleW(L"kernel32.dll");
+        if (!kernel)
+            return nullptr;
+        return reinterpret_cast<PrefetchVirtualMemoryFn>(
+            GetProcAddress(kernel, "PrefetchVirtualMemory"));
+    }();
+    return fn;
+}
+
+// %TEMP%\AIMP-RX2\ (created on demand); empty on failure.
+static std::wstring SpillDirectory()
+{
+    wchar_t temp[MAX_PATH] = {0};
+    const DWORD len = GetTempPathW(MAX_PATH, temp);
+    if (len == 0 || len >= MAX_PATH)
+        return std::wstring();
+
+    std::wstring dir(temp, len);
+    if (!dir.empty() && dir.back() != L'\\')
+        dir.push_back(L'\\');
+    dir.append(L"AIMP-RX2\\");
+
+    CreateDirectoryW(dir.c_str(), nullptr);   // fails harmlessly if it exists
+    return dir;
+}
+
+// ---------------- Rx2SpillFile ----------------
+
+Rx2SpillFile::Rx2SpillFile()
+    : m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(nullptr)
+    , m_capacity(0)
+{
+}
+
+Rx2SpillFile::~Rx2SpillFile()
+{
+    Close();
+}
+
+bool Rx2SpillFile::Create(std::uint64_t capacity)
+{
+    Close();
+
+    if (capacity == 0)
+        return false;
+
+    const std::wstring dir = SpillDirectory();
+    if (dir.empty())
+        return false;
+
+    wchar_t path[MAX_PATH] = {0};
+    if (GetTempFileNameW(dir.c_str(), L"rx2", 0, path) == 0)
+        return false;
+
+    // No sharing: keeps CleanupStaleFiles() in other instances off live files.
+    m_file = CreateFileW(path,
+                         GENERIC_READ | GENERIC_WRITE,
+                         0,
+                         nullptr,
+                         CREATE_ALWAYS,
+                         FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                         nullptr);
+    if (m_file == INVALID_HANDLE_VALUE)
+    {
+        DeleteFileW(path);
+        return false;
+    }
+
+    m_mapping = CreateFileMappingW(m_file,
+                                   nullptr,
+                                   PAGE_READWRITE,
+                                   static_cast<DWORD>(capacity >> 32),
+                                   static_cast<DWORD>(capacity & 0xFFFFFFFFu),
+                                   nullptr);
+    if (!m_mapping)
+    {
+        Close();
+        return false;
+    }
+
+    m_capacity = capacity;
+    return true;
+}
+
+void Rx2SpillFile::Close()
+{
+    if (m_mapping)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+
+    // DELETE_ON_CLOSE removes the file here.
+    if (m_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_file);
+        m_file = INVALID_HANDLE_VALUE;
+    }
+
+    m_capacity = 0;
+}
+
+std::uint8_t* Rx2SpillFile::MapView(std::uint64_t offset, std::size_t bytes)
+{
+    if (!m_mapping || offset + bytes > m_capacity)
+        return nullptr;
+
+    return static_cast<std::uint8_t*>(
+        MapViewOfFile(m_mapping,
+                      FILE_MAP_WRITE,
+                      static_cast<DWORD>(offset >> 32),
+                      static_cast<DWORD>(offset & 0xFFFFFFFFu),
+                      bytes));
+}
+
+void Rx2SpillFile::UnmapView(std::uint8_t* view)
+{
+    if (view)
+        UnmapViewOfFile(view);
+}
+
+void Rx2SpillFile::Prefetch(const std::uint8_t* view, std::size_t bytes)
+{
+    PrefetchVirtualMemoryFn prefetch = GetPrefetchVirtualMemory();
+    if (!prefetch || !view || bytes == 0)
+        return;
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<std::uint8_t*>(view);
+    range.NumberOfBytes  = bytes;
+    prefetch(GetCurrentProcess(), 1, &range, 0);
+}
+
+void Rx2SpillFile::CleanupStaleFiles()
+{
+    const std::wstring dir = SpillDirectory();
+    if (dir.empty())
+        return;
+
+    WIN32_FIND_DATAW fd;
+    HANDLE find = FindFirstFileW((dir + L"rx2*.tmp").c_str(), &fd);
+    if (find == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            DeleteFileW((dir + fd.cFileName).c_str());
+    }
+    while (FindNextFileW(find, &fd));
+
+    FindClose(find);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Temporary, memory-mapped backing file for PCM that is too large to keep
+// resident. The file lives in %TEMP%\AIMP-RX2, is created with
+// FILE_ATTRIBUTE_TEMPORARY (so the cache manager avoids flushing it) and
+// FILE_FLAG_DELETE_ON_CLOSE, and is sized once up front. Views are mapped
+// read/write at offsets that must be multiples of the allocation
+// granularity (64 KiB). Off Windows (Rx2SpillFilePosix.cpp) it is an
+// unlinked file under $TMPDIR mapped with mmap.
+class Rx2SpillFile
+{
+public:
+    Rx2SpillFile();
+    ~Rx2SpillFile();
+
+    Rx2SpillFile(const Rx2SpillFile&)            = delete;
+    Rx2SpillFile& operator=(const Rx2SpillFile&) = delete;
+
+    bool Create(std::uint64_t capacity);
+    void Close();
+
+    bool          IsOpen()   const { return m_mapping != nullptr; }
+    std::uint64_t Capacity() const { return m_capacity; }
+
+    std::uint8_t* MapView(std::uint64_t offset, std::size_t bytes);
+    static void   UnmapView(std::uint8_t* view);
+
+    // Asks the memory manager to start reading the range in asynchronously.
+    // No-op where PrefetchVirtualMemory is unavailable (Windows 7).
+    static void   Prefetch(const std::uint8_t* view, std::size_t bytes);
+
+    // Deletes spill files left behind by a crashed session. Files still open
+    // in this or another AIMP instance are skipped (sharing violation).
+    static void   CleanupStaleFiles();
+
+private:
+    void*         m_file;      // HANDLE; kept opaque so the header stays free of windows.h
+    void*         m_mapping;
+    std::uint64_t m_capacity;
+};
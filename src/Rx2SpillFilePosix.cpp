@@ -0,0 +1,104 @@
+// POSIX implementation of Rx2SpillFile, for core builds off Windows: an
+// unlinked temp file under $TMPDIR mapped with mmap. Same contract as
+// Rx2SpillFile.cpp.
+
+#include "Rx2SpillFile.h"
+#include "Rx2PcmStore.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ---------------- Rx2SpillFile ----------------
+
+Rx2SpillFile::Rx2SpillFile()
+    : m_file(nullptr)
+    , m_mapping(nullptr)
+    , m_capacity(0)
+{
+}
+
+Rx2SpillFile::~Rx2SpillFile()
+{
+    Close();
+}
+
+bool Rx2SpillFile::Create(std::uint64_t capacity)
+{
+    Close();
+
+    if (capacity == 0)
+        return false;
+
+    const char* tmp = getenv("TMPDIR");
+    std::string path = std::string(tmp && *tmp ? tmp : "/tmp") + "/rx2XXXXXX";
+
+    const int fd = mkstemp(&path[0]);
+    if (fd < 0)
+        return false;
+
+    // Deleted on close, like FILE_FLAG_DELETE_ON_CLOSE.
+    unlink(path.c_str());
+
+    if (ftruncate(fd, static_cast<off_t>(capacity)) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The descriptor doubles as the "mapping"; +1 keeps fd 0 non-null.
+    m_file     = reinterpret_cast<void*>(static_cast<std::intptr_t>(fd) + 1);
+    m_mapping  = m_file;
+    m_capacity = capacity;
+    return true;
+}
+
+void Rx2SpillFile::Close()
+{
+    if (m_file)
+    {
+        close(static_cast<int>(reinterpret_cast<std::intptr_t>(m_file) - 1));
+        m_file = nullptr;
+    }
+
+    m_mapping  = nullptr;
+    m_capacity = 0;
+}
+
+std::uint8_t* Rx2SpillFile::MapView(std::uint64_t offset, std::size_t bytes)
+{
+    if (!m_mapping || offset + bytes > m_capacity)
+        return nullptr;
+
+    const int fd = static_cast<int>(reinterpret_cast<std::intptr_t>(m_mapping) - 1);
+    void* view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, static_cast<off_t>(offset));
+    return view == MAP_FAILED ? nullptr : static_cast<std::uint8_t*>(view);
+}
+
+// Chunk views are always kChunkBytes long; munmap needs the length.
+void Rx2SpillFile::UnmapView(std::uint8_t* view)
+{
+    if (view)
+        munmap(view, Rx2PcmStore::kChunkBytes);
+}
+
+void Rx2SpillFile::Prefetch(const std::uint8_t* view, std::size_t bytes)
+{
+    if (!view || bytes == 0)
+        return;
+
+    // Also called on heap memory by Rx2PcmStore::Prefault(); madvise wants
+    // a page-aligned start.
+    const std::uintptr_t page  = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(view) & ~(page - 1);
+    const std::uintptr_t end   = reinterpret_cast<std::uintptr_t>(view) + bytes;
+    madvise(reinterpret_cast<void*>(start), end - start, MADV_WILLNEED);
+}
+
+void Rx2SpillFile::CleanupStaleFiles()
+{
+    // Nothing to do: spill files are unlinked as soon as they are created.
+}
@@ -0,0 +1,207 @@
+#include "Rx2Trace.h"
+#include "Rx2Metrics.h"
+#include "Rx2Settings.h"
+
+#include <cstdio>
+#include <new>
+#include <unordered_map>
+#include <windows.h>
+
+// ---------------- state ----------------
+
+// 512K events x 32 bytes is 16 MB, held only while tracing is on.
+// Events of every thread share one array: an event claims its slot with one
+// atomic increment and is published by storing its name last, so recording
+// takes no lock and never allocates, and the threads that come and go with
+// each open (the REXCreate sandbox, the render pipeline worker) cost no
+// more than the events they record.
+static const std::uint32_t kMaxEvents = 1u << 19;
+
+struct TraceEvent
+{
+    std::atomic<const char*> name;       // null until the event is complete
+    std::int64_t             start;      // QueryPerformanceCounter ticks
+    std::int64_t             duration;
+    DWORD                    threadId;
+};
+
+namespace Rx2TraceDetail
+{
+    std::atomic<bool> enabled(false);
+}
+
+static std::atomic<TraceEvent*>   g_events(nullptr);
+static std::atomic<std::uint64_t> g_next(0);         // slots claimed; past kMaxEvents = dropped
+static std::atomic<int>           g_recording(0);    // Record() calls that may touch g_events
+static std::int64_t               g_originTicks = 0;
+
+static std::wstring g_tracePath;                     // set between Start and Stop
+
+static thread_local DWORD t_threadId = 0;
+
+// ---------------- recording ----------------
+
+std::int64_t Rx2TraceDetail::Now()
+{
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+void Rx2TraceDetail::Record(const char* name, std::int64_t start)
+{
+    const std::int64_t end = Now();
+
+    // A scope opened just before tracing stopped still lands here; the
+    // count keeps Rx2TraceDisable from freeing the pool under it.
+    g_recording.fetch_add(1);
+    TraceEvent* const events = g_events.load();
+    const std::uint64_t slot = events ? g_next.fetch_add(1, std::memory_order_relaxed) : kMaxEvents;
+    if (slot < kMaxEvents)
+    {
+        if (!t_threadId)
+            t_threadId = GetCurrentThreadId();
+
+        TraceEvent& event = events[slot];
+        event.start    = start;
+        event.duration = end - start;
+        event.threadId = t_threadId;
+        event.name.store(name, std::memory_order_release);
+    }
+    g_recording.fetch_sub(1, std::memory_order_release);
+}
+
+void Rx2TraceEnable()
+{
+    if (!g_events.load())
+    {
+        TraceEvent* events = new (std::nothrow) TraceEvent[kMaxEvents];
+        if (!events)
+            return;
+        for (std::uint32_t i = 0; i < kMaxEvents; ++i)
+            events[i].name.store(nullptr, std::memory_order_relaxed);
+
+        g_next.store(0, std::memory_order_relaxed);
+        g_originTicks = Rx2TraceDetail::Now();
+
+        TraceEvent* expected = nullptr;
+        if (!g_events.compare_exchange_strong(expected, events))
+            delete[] events;
+    }
+
+    Rx2TraceDetail::enabled.store(true, std::memory_order_relaxed);
+}
+
+void Rx2TraceDisable()
+{
+    Rx2TraceDetail::enabled.store(false, std::memory_order_relaxed);
+
+    TraceEvent* const events = g_events.exchange(nullptr);
+    if (!events)
+        return;
+
+    // Wait out the Record() calls that loaded the pool before it was taken.
+    while (g_recording.load(std::memory_order_acquire) != 0)
+        Sleep(0);
+    delete[] events;
+}
+
+bool Rx2TraceEnabled()
+{
+    return Rx2TraceDetail::enabled.load(std::memory_order_relaxed);
+}
+
+// ---------------- export ----------------
+
+std::string Rx2TraceJson()
+{
+    const DWORD         pid    = GetCurrentProcessId();
+    const double        usTick = 1e6 / static_cast<double>(Rx2TicksPerSecond());
+    TraceEvent* const   events = g_events.load();
+    const std::uint64_t next   = events ? g_next.load(std::memory_order_relaxed) : 0;
+    const std::uint32_t used   = next < kMaxEvents ? static_cast<std::uint32_t>(next) : kMaxEvents;
+
+    std::string out;
+    out.reserve(4096);
+    Rx2AppendF(out, "{\"displayTimeUnit\": \"ms\", \"otherData\": { \"dropped_events\": %llu },\n"
+                    "\"traceEvents\": [\n"
+                    "{\"ph\": \"M\", \"name\": \"process_name\", \"pid\": %lu, \"tid\": 0, "
+                    "\"args\": { \"name\": \"RX2Decoder\" }}",
+               static_cast<unsigned long long>(next - used), static_cast<unsigned long>(pid));
+
+    // Threads are listed in the order they first recorded an event.
+    std::unordered_map<DWORD, int> threads;
+
+    for (std::uint32_t e = 0; e < used; ++e)
+    {
+        const TraceEvent& event = events[e];
+        const char*       name  = event.name.load(std::memory_order_acquire);
+        if (!name)
+            continue;   // claimed but still being written
+
+        const auto inserted = threads.emplace(event.threadId, static_cast<int>(threads.size()));
+        if (inserted.second)
+        {
+            Rx2AppendF(out, ",\n{\"ph\": \"M\", \"name\": \"thread_sort_index\", \"pid\": %lu, \"tid\": %lu, "
+                            "\"args\": { \"sort_index\": %d }}",
+                       static_cast<unsigned long>(pid), static_cast<unsigned long>(event.threadId),
+                       inserted.first->second);
+        }
+
+        Rx2AppendF(out, ",\n{\"name\": \"%s\", \"cat\": \"rx2\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                        "\"pid\": %lu, \"tid\": %lu}",
+                   name, (event.start - g_originTicks) * usTick, event.duration * usTick,
+                   static_cast<unsigned long>(pid), static_cast<unsigned long>(event.threadId));
+    }
+
+    out += "\n]}\n";
+    return out;
+}
+
+bool Rx2TraceWriteJson(const wchar_t* path)
+{
+    if (!path || !*path)
+        return false;
+
+    const std::string json = Rx2TraceJson();
+
+    HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr,
+                              CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD written = 0;
+    const bool ok = WriteFile(file, json.data(), static_cast<DWORD>(json.size()), &written, nullptr)
+                 && written == json.size();
+    CloseHandle(file);
+    return ok;
+}
+
+// ---------------- plugin lifetime ----------------
+
+void Rx2TraceStart(IAIMPCore* core)
+{
+    if (!core || !Rx2GetSettings().trace)
+        return;
+
+    const std::wstring dir = Rx2ProfileDir(core);
+    if (dir.empty())
+        return;
+
+    g_tracePath = dir + L"Trace.json";
+    Rx2TraceEnable();
+}
+
+void Rx2TraceStop()
+{
+    if (g_tracePath.empty())
+        return;
+
+    Rx2TraceDetail::enabled.store(false, std::memory_order_relaxed);
+
+    if (!Rx2TraceWriteJson(g_tracePath.c_str()))
+        OutputDebugStringW(L"RX2Decoder: cannot write Trace.json\n");
+    g_tracePath.clear();
+
+    Rx2TraceDisable();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// Lifecycle tracer: timed scopes exported as Chrome trace-event JSON
+// (chrome://tracing, Perfetto).
+//
+// RX2_TRACE_SCOPE(name) times the rest of the enclosing block and
+// RX2_TRACE_CALL(name, call) times one call; `name` must be a string
+// literal. Complete ("X") events of every thread go into one array
+// allocated when tracing starts and freed when it stops, each claiming its
+// slot with an atomic increment, so recording takes no lock and never
+// allocates; this includes AIMP's audio thread. Once the array is full later
+// events are dropped, and the export says how many. While tracing is off a
+// scope is one relaxed load and a branch.
+//
+// The plugin traces when RX2Decoder\Trace is set and writes
+// <AIMP profile>\RX2Decoder\Trace.json at shutdown.
+
+#include "apiCore.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Rx2TraceDetail
+{
+    extern std::atomic<bool> enabled;
+
+    std::int64_t Now();
+    void         Record(const char* name, std::int64_t start);
+}
+
+class Rx2TraceScope
+{
+public:
+    explicit Rx2TraceScope(const char* name)
+        : m_name(Rx2TraceDetail::enabled.load(std::memory_order_relaxed) ? name : nullptr)
+        , m_start(m_name ? Rx2TraceDetail::Now() : 0)
+    {
+    }
+
+    ~Rx2TraceScope()
+    {
+        if (m_name)
+            Rx2TraceDetail::Record(m_name, m_start);
+    }
+
+    Rx2TraceScope(const Rx2TraceScope&) = delete;
+    Rx2TraceScope& operator=(const Rx2TraceScope&) = delete;
+
+private:
+    const char*  m_name;    // null while tracing is off
+    std::int64_t m_start;
+};
+
+// Starts recording into a new event pool. Disable stops recording and,
+// once the events still being recorded have landed, frees the pool with
+// everything in it, so export first.
+void        Rx2TraceEnable();
+void        Rx2TraceDisable();
+bool        Rx2TraceEnabled();
+
+std::string Rx2TraceJson();
+bool        Rx2TraceWriteJson(const wchar_t* path);
+
+// Plugin lifetime: enables tracing if RX2Decoder\Trace is set, and at stop
+// writes the trace to the profile folder.
+void        Rx2TraceStart(IAIMPCore* core);
+void        Rx2TraceStop();
+
+#define RX2_TRACE_CONCAT_(a, b)   a##b
+#define RX2_TRACE_CONCAT(a, b)    RX2_TRACE_CONCAT_(a, b)
+
+#define RX2_TRACE_SCOPE(name)     Rx2TraceScope RX2_TRACE_CONCAT(rx2TraceScope_, __LINE__)(name)
+#define RX2_TRACE_CALL(name, call) \
+    ([&]() -> decltype(auto) { Rx2TraceScope rx2TraceCall_(name); return call; }())
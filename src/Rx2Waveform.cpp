@@ -0,0 +1,188 @@
+#include "Rx2Waveform.h"
+#include "Rx2AnalysisCache.h"
+#include "Rx2Contention.h"
+#include "Rx2Decoder.h"
+#include "Rx2FileKey.h"
+#include "apiFileManager.h"
+
+// ---------------- helpers ----------------
+
+static IAIMPStream* OpenFileStream(IAIMPCore* core, IAIMPString* fileName)
+{
+    IAIMPServiceFileStreaming* streaming = nullptr;
+    if (FAILED(core->QueryInterface(IID_IAIMPServiceFileStreaming, (void**)&streaming)) || !streaming)
+        return nullptr;
+
+    IAIMPStream* stream = nullptr;
+    if (FAILED(streaming->CreateStreamForFile(fileName, AIMP_SERVICE_FILESTREAMING_FLAG_READ,
+                                              -1, -1, &stream)))
+        stream = nullptr;
+
+    streaming->Release();
+    return stream;
+}
+
+// ---------------- Rx2PeakWaveform ----------------
+
+Rx2PeakWaveform::Rx2PeakWaveform(const Rx2PeakIndex& peaks)
+    : m_refCount(1)
+    , m_peaks(peaks)
+{
+}
+
+HRESULT WINAPI Rx2PeakWaveform::QueryInterface(REFIID riid, void **ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IRx2Waveform)
+    {
+        *ppv = static_cast<IRx2Waveform*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2PeakWaveform::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2PeakWaveform::Release()
+{
+    ULONG r = InterlockedDecrement(&m_refCount);
+    if (r == 0)
+        delete this;
+    return r;
+}
+
+int WINAPI Rx2PeakWaveform::GetPeaks(INT64 FirstFrame, INT64 Frames, int Buckets, Rx2Peak* Peaks)
+{
+    return Peaks ? m_peaks.Query(FirstFrame, Frames, Buckets, Peaks) : 0;
+}
+
+// ---------------- Rx2WaveformService ----------------
+
+Rx2WaveformService::Rx2WaveformService(IAIMPCore* core, IAIMPExtensionAudioDecoder* decoders)
+    : m_refCount(1)
+    , m_core(core)
+    , m_decoders(decoders)
+{
+    InitializeSRWLock(&m_lock);
+    if (m_core)
+        m_core->AddRef();
+    if (m_decoders)
+        m_decoders->AddRef();
+}
+
+Rx2WaveformService::~Rx2WaveformService()
+{
+    Shutdown();
+}
+
+void Rx2WaveformService::Shutdown()
+{
+    Rx2LockExclusive(&m_lock, Rx2SyncSite::WaveformService);
+    IAIMPCore*                  core     = m_core;
+    IAIMPExtensionAudioDecoder* decoders = m_decoders;
+    m_core     = nullptr;
+    m_decoders = nullptr;
+    ReleaseSRWLockExclusive(&m_lock);
+
+    if (decoders)
+        decoders->Release();
+    if (core)
+        core->Release();
+}
+
+HRESULT WINAPI Rx2WaveformService::QueryInterface(REFIID riid, void **ppv)
+{
+    if (!ppv)
+        return E_POINTER;
+
+    if (riid == IID_IUnknown || riid == IID_IRx2ServiceWaveform)
+    {
+        *ppv = static_cast<IRx2ServiceWaveform*>(this);
+        AddRef();
+        return S_OK;
+    }
+
+    *ppv = nullptr;
+    return E_NOINTERFACE;
+}
+
+ULONG WINAPI Rx2WaveformService::AddRef()
+{
+    return InterlockedIncrement(&m_refCount);
+}
+
+ULONG WINAPI Rx2WaveformService::Release()
+{
+    ULONG r = InterlockedDecrement(&m_refCount);
+    if (r == 0)
+        delete this;
+    return r;
+}
+
+HRESULT WINAPI Rx2WaveformService::GetWaveform(IAIMPString* FileName, IRx2Waveform** Waveform)
+{
+    if (!FileName || !Waveform)
+        return E_POINTER;
+    *Waveform = nullptr;
+
+    Rx2LockShared(&m_lock, Rx2SyncSite::WaveformService);
+    IAIMPCore*                  core     = m_core;
+    IAIMPExtensionAudioDecoder* decoders = m_decoders;
+    if (core)
+        core->AddRef();
+    if (decoders)
+        decoders->AddRef();
+    ReleaseSRWLockShared(&m_lock);
+
+    if (!core || !decoders)
+    {
+        if (core)
+            core->Release();
+        if (decoders)
+            decoders->Release();
+        return E_UNEXPECTED;
+    }
+
+    HRESULT      hr     = E_FAIL;
+    IAIMPStream* stream = OpenFileStream(core, FileName);
+    if (stream)
+    {
+        // Drawn straight from the cache when the file was analysed before.
+        Rx2FileKey   key;
+        Rx2PeakIndex peaks;
+        if (Rx2MakeFileKey(stream, &key) && Rx2LoadCachedPeaks(key, &peaks))
+        {
+            *Waveform = new Rx2PeakWaveform(peaks);
+            hr = S_OK;
+        }
+        else
+        {
+            // Open it once; CreateDecoder also stores the analysis for next
+            // time. Only the peaks are kept, not the decoder and its PCM.
+            IAIMPAudioDecoder* decoder = nullptr;
+            hr = decoders->CreateDecoder(stream, 0, nullptr, &decoder);
+            if (SUCCEEDED(hr) && decoder)
+            {
+                *Waveform = new Rx2PeakWaveform(static_cast<Rx2Decoder*>(decoder)->Peaks());
+                decoder->Release();
+            }
+            else if (SUCCEEDED(hr))
+            {
+                hr = E_FAIL;
+            }
+        }
+        stream->Release();
+    }
+
+    decoders->Release();
+    core->Release();
+    return hr;
+}
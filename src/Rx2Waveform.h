@@ -0,0 +1,92 @@
+#pragma once
+
+#include "apiCore.h"
+#include "apiDecoders.h"
+#include "apiObjects.h"
+#include "Rx2PeakIndex.h"
+
+#include <windows.h>
+
+// Waveform API for other plugins (seekbars, visualizers): min/max peaks of
+// a REX file at any zoom, reduced from the pyramid built while the file was
+// rendered (Rx2PeakIndex), so drawing it never needs a second decode.
+//
+// Every decoder the plugin creates answers QueryInterface for IRx2Waveform.
+// Without a decoder at hand, IRx2ServiceWaveform (registered with the core,
+// so core->QueryInterface(IID_IRx2ServiceWaveform) finds it) serves any REX
+// file: from the analysis cache when it holds the file (AnalysisCache=1),
+// otherwise by opening the file once, which also fills the cache.
+
+// {92512255-BDD6-4587-A761-A89FBA53CAA2}
+static const GUID IID_IRx2Waveform =
+    { 0x92512255, 0xbdd6, 0x4587, { 0xa7, 0x61, 0xa8, 0x9f, 0xba, 0x53, 0xca, 0xa2 } };
+
+class IRx2Waveform : public IUnknown
+{
+public:
+    virtual int   WINAPI GetChannels() = 0;
+    virtual INT64 WINAPI GetFrames() = 0;   // at the rate the decoder plays at
+
+    // Reduces [FirstFrame, FirstFrame + Frames) to Buckets min/max pairs
+    // per channel, interleaved by channel (Buckets * GetChannels() entries).
+    // Returns the number of buckets written.
+    virtual int   WINAPI GetPeaks(INT64 FirstFrame, INT64 Frames, int Buckets, Rx2Peak* Peaks) = 0;
+};
+
+// {2A52600D-F5AA-4B7C-817A-15A3A6F8FE9A}
+static const GUID IID_IRx2ServiceWaveform =
+    { 0x2a52600d, 0xf5aa, 0x4b7c, { 0x81, 0x7a, 0x15, 0xa3, 0xa6, 0xf8, 0xfe, 0x9a } };
+
+class IRx2ServiceWaveform : public IUnknown
+{
+public:
+    virtual HRESULT WINAPI GetWaveform(IAIMPString* FileName, IRx2Waveform** Waveform) = 0;
+};
+
+// IRx2Waveform over a peak index of its own (loaded from the cache or
+// copied out of a decoder that was opened only for it).
+class Rx2PeakWaveform : public IRx2Waveform
+{
+public:
+    explicit Rx2PeakWaveform(const Rx2PeakIndex& peaks);
+    virtual ~Rx2PeakWaveform() {}
+
+    // IUnknown
+    HRESULT WINAPI QueryInterface(REFIID riid, void **ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    // IRx2Waveform
+    int     WINAPI GetChannels() override { return m_peaks.Channels(); }
+    INT64   WINAPI GetFrames() override { return m_peaks.Frames(); }
+    int     WINAPI GetPeaks(INT64 FirstFrame, INT64 Frames, int Buckets, Rx2Peak* Peaks) override;
+
+private:
+    LONG         m_refCount;
+    Rx2PeakIndex m_peaks;
+};
+
+class Rx2WaveformService : public IRx2ServiceWaveform
+{
+public:
+    // Falls back to `decoders` (the plugin's decoder extension) on a cache miss.
+    Rx2WaveformService(IAIMPCore* core, IAIMPExtensionAudioDecoder* decoders);
+    virtual ~Rx2WaveformService();
+
+    // The core may keep the service past Finalize; later calls then fail.
+    void Shutdown();
+
+    // IUnknown
+    HRESULT WINAPI QueryInterface(REFIID riid, void **ppv) override;
+    ULONG   WINAPI AddRef() override;
+    ULONG   WINAPI Release() override;
+
+    // IRx2ServiceWaveform
+    HRESULT WINAPI GetWaveform(IAIMPString* FileName, IRx2Waveform** Waveform) override;
+
+private:
+    LONG                        m_refCount;
+    SRWLOCK                     m_lock;
+    IAIMPCore*                  m_core;       // guarded by m_lock
+    IAIMPExtensionAudioDecoder* m_decoders;   // guarded by m_lock
+};
@@ -1,23 +1,32 @@
 #include <windows.h>
-#include <shlwapi.h>
 
 #include "apiPlugin.h"
 #include "apiCore.h"
 #include "apiFileManager.h"
 
-#include "RexSdk.h"
+#include "Rx2AnalysisCache.h"
+#include "Rx2CallLog.h"
+#include "Rx2Contention.h"
 #include "Rx2DecoderExtension.h"
+#include "Rx2FileExpander.h"
 #include "Rx2FileFormatExtension.h"
-
-#pragma comment(lib, "Shlwapi.lib")
+#include "Rx2LibraryIndex.h"
+#include "Rx2Settings.h"
+#include "Rx2MemoryBudget.h"
+#include "Rx2Metrics.h"
+#include "Rx2NegativeCache.h"
+#include "Rx2Prefetcher.h"
+#include "Rx2RexLibrary.h"
+#include "Rx2RexShim.h"
+#include "Rx2RtAudit.h"
+#include "Rx2SpillFile.h"
+#include "Rx2Trace.h"
+#include "Rx2Waveform.h"
 
 #ifndef AIMP_PLUGIN_INFO_VERSION
 #define AIMP_PLUGIN_INFO_VERSION 0x4
 #endif
 
-// Forward declaration so we can use its address in GetModuleHandleExW
-extern "C" HRESULT __declspec(dllexport) WINAPI AIMPPluginGetHeader(void **plugin);
-
 class Rx2Plugin : public IAIMPPlugin
 {
 public:
@@ -41,7 +50,8 @@ private:
     IAIMPCore              *m_core;
     Rx2DecoderExtension    *m_decoderExt;
     Rx2FileFormatExtension *m_fileFormatExt;
-    bool                    m_rexInitialized;
+    Rx2FileExpander        *m_fileExpander;    // slice mode only
+    Rx2WaveformService     *m_waveformService;
 };
 
 Rx2Plugin::Rx2Plugin()
@@ -49,7 +59,8 @@ Rx2Plugin::Rx2Plugin()
     , m_core(nullptr)
     , m_decoderExt(nullptr)
     , m_fileFormatExt(nullptr)
-    , m_rexInitialized(false)
+    , m_fileExpander(nullptr)
+    , m_waveformService(nullptr)
 {
 }
 
@@ -118,61 +129,26 @@ DWORD WINAPI Rx2Plugin::InfoGetCategories()
 
 HRESULT WINAPI Rx2Plugin::Initialize(IAIMPCore *core)
 {
+    const std::int64_t started = Rx2MetricNow();
+
     m_core = core;
     if (m_core)
         m_core->AddRef();
 
-    // --- 1) Initialize REX DLL (plugin folder first, then AIMP.exe folder) ---
+    Rx2LoadSettings(m_core);
 
-    if (!m_rexInitialized)
-    {
-        wchar_t dir[MAX_PATH] = {0};
-
-        // Plugin DLL folder
-        HMODULE hModule = nullptr;
-        if (GetModuleHandleExW(
-                GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
-                GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
-                reinterpret_cast<LPCWSTR>(&AIMPPluginGetHeader),
-                &hModule))
-        {
-            if (GetModuleFileNameW(hModule, dir, MAX_PATH) > 0)
-            {
-                PathRemoveFileSpecW(dir);
-
-                REX::REXError err = REX::REXInitializeDLL_DirPath(dir);
-                if (err == REX::kREXError_NoError)
-                {
-                    m_rexInitialized = true;
-                }
-            }
-        }
+    // The REX Shared Library is loaded on first use by CreateDecoder
+    // (Rx2EnsureRexLibrary), so sessions without REX files never pay for it.
 
-        // AIMP.exe folder (fallback)
-        if (!m_rexInitialized)
-        {
-            if (GetModuleFileNameW(nullptr, dir, MAX_PATH) > 0)
-            {
-                PathRemoveFileSpecW(dir);
-
-                REX::REXError err = REX::REXInitializeDLL_DirPath(dir);
-                if (err == REX::kREXError_NoError)
-                {
-                    m_rexInitialized = true;
-                }
-            }
-        }
-    }
+    // --- 1) Start the PCM memory budget ---
 
-    if (!m_rexInitialized)
-    {
-        if (m_core)
-        {
-            m_core->Release();
-            m_core = nullptr;
-        }
-        return E_FAIL;
-    }
+    Rx2MemoryBudgetStart(static_cast<size_t>(Rx2GetSettings().memoryBudgetMB) * 1024 * 1024);
+    Rx2AnalysisCacheStart(m_core);
+    Rx2LibraryIndexStart(m_core);
+    Rx2MetricsStart(m_core);
+    Rx2TraceStart(m_core);
+    Rx2CallLogStart(m_core);
+    Rx2RexShimStart(m_core);
 
     // --- 2) Register decoder and file format extensions ---
 
@@ -183,13 +159,41 @@ HRESULT WINAPI Rx2Plugin::Initialize(IAIMPCore *core)
     {
         m_core->RegisterExtension(IID_IAIMPServiceAudioDecoders, m_decoderExt);
         m_core->RegisterExtension(IID_IAIMPServiceFileFormats, m_fileFormatExt);
+
+        if (Rx2GetSettings().sliceTracks)
+        {
+            m_fileExpander = new Rx2FileExpander(m_core);
+            m_core->RegisterExtension(IID_IAIMPServiceFileExpanders, m_fileExpander);
+        }
+
+        // Peaks for other plugins; the core keeps its own reference.
+        m_waveformService = new Rx2WaveformService(m_core, m_decoderExt);
+        m_core->RegisterService(m_waveformService);
     }
 
+    // --- 3) Pre-render upcoming REX tracks ---
+
+    if (Rx2GetSettings().prefetchNext)
+        Rx2PrefetchStart(m_core);
+
+    Rx2MetricRecordUs(Rx2Histogram::InitializeUs, Rx2MetricElapsedUs(started));
+
     return S_OK;
 }
 
 HRESULT WINAPI Rx2Plugin::Finalize()
 {
+    Rx2PrefetchStop();
+
+    if (m_waveformService)
+    {
+        // Drops its references to the core and the decoder extension, so a
+        // reference the core still holds does not keep them alive.
+        m_waveformService->Shutdown();
+        m_waveformService->Release();
+        m_waveformService = nullptr;
+    }
+
     if (m_core)
     {
         if (m_decoderExt)
@@ -205,14 +209,35 @@ HRESULT WINAPI Rx2Plugin::Finalize()
             m_fileFormatExt->Release();
             m_fileFormatExt = nullptr;
         }
-    }
 
-    if (m_rexInitialized)
-    {
-        REX::REXUninitializeDLL();
-        m_rexInitialized = false;
+        if (m_fileExpander)
+        {
+            m_core->UnregisterExtension(m_fileExpander);
+            m_fileExpander->Release();
+            m_fileExpander = nullptr;
+        }
     }
 
+    Rx2MemoryBudgetStop();
+    Rx2AnalysisCacheStop();
+    Rx2LibraryIndexStop();
+
+    // Live spill files delete themselves on close; this catches leftovers
+    // from sessions that crashed.
+    Rx2SpillFile::CleanupStaleFiles();
+
+    Rx2NegativeCacheClear();
+
+    // Lets REX calls hung by the fault script return before the library goes.
+    Rx2RexShimStop();
+    Rx2ReleaseRexLibrary();
+
+    Rx2CallLogStop();
+    Rx2MetricsStop();
+    Rx2TraceStop();
+    Rx2RtAuditReport();
+    Rx2ContentionReport();
+
     if (m_core)
     {
         m_core->Release();
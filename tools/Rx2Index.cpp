@@ -0,0 +1,354 @@
+// Library index builder: scans directory trees of REX files on a pool of
+// worker threads, validates each file the way the plugin's CreateDecoder
+// does (Rx2IndexScanFile) and writes the result as a library index
+// (Rx2IndexFormat.h) for the plugin to consult on open. --dump prints an
+// existing index as JSON. See the "Library index" section of README.md.
+//
+// The REX library is called directly here, without the plugin's REXCreate
+// sandbox, so each file is scanned on a thread of its own and given up on
+// after --timeout-ms; a file that hangs the library is left out instead of
+// stalling the whole run.
+
+#include "Rx2IndexFormat.h"
+#include "Rx2ToolCommon.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// ---------------- options ----------------
+
+struct IndexOptions
+{
+    std::vector<std::string> dirs;
+    std::string              outPath;
+    int                      threads;    // 0 = one per hardware thread
+    int                      timeoutMs;  // per file; 0 = wait as long as it takes
+    std::string              dumpPath;   // print this index instead of building one
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: rx2_index [options] DIR...\n"
+            "       rx2_index --dump FILE\n"
+            "  Validates every .rx2, .rex and .rcy file under the DIRs as the plugin\n"
+            "  would and writes a library index of them.\n"
+            "  --out FILE       index to write (default Library.rx2index)\n"
+            "  --threads N      worker threads (default: one per hardware thread)\n"
+            "  --timeout-ms N   give up on a file after N ms and leave it out (default 2000, 0 = never)\n"
+            "  --dump FILE      print the entries of an index as JSON\n");
+}
+
+static bool ParseOptions(int argc, char** argv, IndexOptions* opt)
+{
+    opt->outPath   = "Library.rx2index";
+    opt->threads   = 0;
+    opt->timeoutMs = 2000;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            opt->dirs.push_back(arg);
+            continue;
+        }
+
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            fprintf(stderr, "rx2_index: missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if (arg == "--out")             opt->outPath   = value;
+        else if (arg == "--threads")    opt->threads   = atoi(value);
+        else if (arg == "--timeout-ms") opt->timeoutMs = atoi(value);
+        else if (arg == "--dump")       opt->dumpPath  = value;
+        else
+        {
+            fprintf(stderr, "rx2_index: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (opt->dumpPath.empty() && opt->dirs.empty())
+    {
+        fprintf(stderr, "rx2_index: no directory given\n");
+        return false;
+    }
+    if (opt->threads < 0 || opt->timeoutMs < 0)
+    {
+        fprintf(stderr, "rx2_index: --threads and --timeout-ms must not be negative\n");
+        return false;
+    }
+    return true;
+}
+
+// ---------------- scan ----------------
+
+static bool CollectFiles(const std::string& dir, std::vector<fs::path>* files)
+{
+    std::error_code ec;
+    fs::recursive_directory_iterator it(dir, fs::directory_options::skip_permission_denied, ec), end;
+    if (ec)
+    {
+        fprintf(stderr, "rx2_index: cannot read %s: %s\n", dir.c_str(), ec.message().c_str());
+        return false;
+    }
+
+    for (; it != end; it.increment(ec))
+    {
+        if (ec)
+        {
+            fprintf(stderr, "rx2_index: %s\n", ec.message().c_str());
+            ec.clear();
+            continue;
+        }
+        if (it->is_regular_file(ec) && Rx2ToolIsRexFile(it->path()))
+            files->push_back(it->path());
+    }
+    return true;
+}
+
+struct ScanResult
+{
+    Rx2IndexRecord record;
+    bool           indexed = false;   // false: unreadable or a transient failure
+    REX::REXError  err     = REX::kREXError_NoError;
+};
+
+// Scans `file`, giving up after `timeoutMs`: a scan still running then is
+// left out as create_timed_out, since the only call that can take that long
+// is REXCreate on a file that hangs it.
+static void ScanFile(const fs::path& file, ScanResult* out, int timeoutMs)
+{
+    const bool done = Rx2ToolRunTimed(timeoutMs, out, [file](ScanResult* r) {
+        r->indexed = Rx2IndexScanFile(file, &r->record, &r->err);
+    });
+    if (!done)
+    {
+        out->indexed = false;
+        out->err     = kRexError_CreateTimedOut;
+    }
+}
+
+static void ScanAll(const std::vector<fs::path>& files, std::vector<ScanResult>& results,
+                    int threads, int timeoutMs)
+{
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        for (;;)
+        {
+            const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= files.size())
+                break;
+
+            ScanResult& r = results[i];
+            ScanFile(files[i], &r, timeoutMs);
+
+            // The name the plugin will be handed: absolute, with the
+            // platform's separators.
+            std::error_code ec;
+            r.record.path = fs::absolute(files[i], ec).lexically_normal().u16string();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+}
+
+// ---------------- dump ----------------
+
+static const char* StatusName(std::uint32_t status)
+{
+    switch (status)
+    {
+    case kRx2IndexOk:     return "ok";
+    case kRx2IndexNotRex: return "not_rex";
+    case kRx2IndexBad:    return "bad";
+    default:              return "?";
+    }
+}
+
+static int Dump(const std::string& path)
+{
+    std::vector<std::uint8_t> bytes;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f)
+    {
+        char   chunk[65536];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+            bytes.insert(bytes.end(), chunk, chunk + n);
+        fclose(f);
+
+        // 8-byte aligned, as a mapping would be.
+        std::vector<std::uint64_t> data((bytes.size() + 7) / 8);
+        if (!bytes.empty())
+            memcpy(data.data(), bytes.data(), bytes.size());
+
+        Rx2IndexView index;
+        if (index.Attach(data.data(), bytes.size()))
+        {
+            static const char* const kCreatorKeys[kRx2IndexCreatorFields] =
+                { "name", "copyright", "url", "email", "free_text" };
+
+            std::string out = "[\n";
+            for (std::uint32_t i = 0; i < index.Count(); ++i)
+            {
+                const Rx2IndexEntry& e = index.Entry(i);
+                const std::u16string name = index.Utf16(e.path);
+
+                char line[512];
+                out += "  {\"path\": ";
+                Rx2ToolAppendJsonString(out, fs::path(name).u8string());
+                snprintf(line, sizeof(line),
+                         ", \"status\": \"%s\", \"error\": \"%s\", \"size\": %lld, \"mtime\": %llu, "
+                         "\"header_hash\": \"%08x\", \"content_hash\": \"%016llx\", \"channels\": %d, "
+                         "\"rate\": %d, \"bits\": %d, \"slices\": %d, \"tempo\": %d, \"original_tempo\": %d, "
+                         "\"ppq_length\": %d, \"time_sig\": \"%d/%d\", \"loop_frames\": %lld",
+                         StatusName(e.status), Rx2RexErrorName(static_cast<REX::REXError>(e.rexError)),
+                         static_cast<long long>(e.size), static_cast<unsigned long long>(e.mtime),
+                         static_cast<unsigned>(e.headerHash), static_cast<unsigned long long>(e.contentHash),
+                         e.channels, e.sampleRate, e.bitDepth, e.sliceCount, e.tempo, e.originalTempo,
+                         e.ppqLength, e.timeSignNom, e.timeSignDenom, static_cast<long long>(e.loopFrames));
+                out += line;
+
+                for (int c = 0; c < kRx2IndexCreatorFields; ++c)
+                {
+                    const std::string value = index.Utf8(e.creator[c]);
+                    if (value.empty())
+                        continue;
+                    out += std::string(", \"") + kCreatorKeys[c] + "\": ";
+                    Rx2ToolAppendJsonString(out, value);
+                }
+                out += (i + 1 < index.Count()) ? "},\n" : "}\n";
+            }
+            out += "]\n";
+            fputs(out.c_str(), stdout);
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "rx2_index: %s is not a version %u library index\n",
+            path.c_str(), static_cast<unsigned>(kRx2IndexVersion));
+    return 2;
+}
+
+// ---------------- main ----------------
+
+int main(int argc, char** argv)
+{
+    IndexOptions opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if (!opt.dumpPath.empty())
+        return Dump(opt.dumpPath);
+
+    std::vector<fs::path> files;
+    for (const std::string& dir : opt.dirs)
+    {
+        if (!CollectFiles(dir, &files))
+            return 2;
+    }
+
+    int threads = opt.threads;
+    if (threads == 0)
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(std::max<size_t>(files.size(), 1))));
+
+    // The REX Shared Library is expected next to the executable.
+#ifdef _WIN32
+    wchar_t exeDir[MAX_PATH];
+    if (!GetModuleFileNameW(nullptr, exeDir, MAX_PATH))
+        exeDir[0] = L'\0';
+    const std::wstring dllDir = fs::path(exeDir).parent_path().wstring();
+#else
+    const std::wstring dllDir = L".";
+#endif
+    const REX::REXError initErr = REX::REXInitializeDLL_DirPath(dllDir.c_str());
+    if (initErr != REX::kREXError_NoError)
+    {
+        fprintf(stderr, "rx2_index: cannot load the REX Shared Library: %s\n", Rx2RexErrorName(initErr));
+        return 2;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<ScanResult> results(files.size());
+    ScanAll(files, results, threads, opt.timeoutMs);
+
+    // Abandoned scans may still be inside the library; it stays loaded for
+    // them, and the process exits without waiting (see below).
+    const bool abandoned = Rx2ToolAbandonedJobs() > 0;
+    if (!abandoned)
+        REX::REXUninitializeDLL();
+
+    std::vector<Rx2IndexRecord> records;
+    size_t counts[3] = { 0, 0, 0 };
+    size_t skipped   = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (!results[i].indexed)
+        {
+            ++skipped;
+            fprintf(stderr, "rx2_index: %s: left out (%s)\n", files[i].u8string().c_str(),
+                    results[i].err == REX::kREXError_NoError ? "read_failed" : Rx2RexErrorName(results[i].err));
+            continue;
+        }
+        ++counts[std::min<std::uint32_t>(results[i].record.entry.status, 2)];
+        records.push_back(std::move(results[i].record));
+    }
+
+    int code = skipped ? 1 : 0;
+    if (Rx2IndexWrite(opt.outPath, records))
+    {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "rx2_index: %zu files: %zu ok, %zu bad, %zu not REX, %zu left out; %d threads, %.1f ms -> %s\n",
+                files.size(), counts[kRx2IndexOk], counts[kRx2IndexBad], counts[kRx2IndexNotRex], skipped,
+                threads, ms, opt.outPath.c_str());
+    }
+    else
+    {
+        fprintf(stderr, "rx2_index: cannot write %s\n", opt.outPath.c_str());
+        code = 2;
+    }
+
+    if (abandoned)
+    {
+        // Returning would run static destructors under the hung threads.
+        fflush(stdout);
+        fflush(stderr);
+        std::quick_exit(code);
+    }
+    return code;
+}
@@ -0,0 +1,563 @@
+// Batch renderer: walks a directory tree of REX files and renders each loop
+// to WAV or raw PCM on a pool of worker threads, through the same decoder
+// core the plugin uses (Rx2Loop.h) and with the same storage, tempo and
+// sample rate choices. Writes a per-file timing and error report as JSON.
+// See the "Batch rendering" section of README.md.
+//
+// As in rx2_index, the REX library is called without the plugin's sandbox,
+// so each file is opened on a thread of its own and given up on after
+// --timeout-ms (Rx2ToolRunTimed).
+
+#include "Rx2Loop.h"
+#include "Rx2ToolCommon.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// ---------------- options ----------------
+
+struct RenderOptions
+{
+    std::string srcDir;
+    std::string outDir;
+    int         threads;      // 0 = one per hardware thread
+    bool        raw;          // headerless interleaved PCM instead of WAV
+    int         bits;         // PcmStorageBits: 0 = follow the file, 16, 24 or 32
+    int         sampleRate;   // 0 = the file's
+    int         tempo;        // 1/1000 BPM; 0 = the file's
+    int         spillMB;      // PcmSpillThresholdMB; 0 = never spill
+    int         timeoutMs;    // reading and opening one file; 0 = no limit
+    std::string reportPath;   // empty = stdout
+};
+
+static void PrintUsage()
+{
+    fprintf(stderr,
+            "usage: rx2_render [options] SRC_DIR OUT_DIR\n"
+            "  Renders every .rx2, .rex and .rcy file under SRC_DIR to the same\n"
+            "  relative path under OUT_DIR.\n"
+            "  --threads N      worker threads (default: one per hardware thread)\n"
+            "  --format FMT     wav or raw (interleaved, little-endian; default wav)\n"
+            "  --bits N         0 = the file's bit depth, 16, 24 or 32 (float; default 0)\n"
+            "  --rate HZ        output sample rate (default: the file's)\n"
+            "  --tempo BPM      render tempo, e.g. 120 or 97.5 (default: the file's)\n"
+            "  --spill-mb N     back loops larger than N MB with a temp file; 0 = never\n"
+            "                   (default: the plugin's, 1024 or 256 on 32-bit builds)\n"
+            "  --timeout-ms N   give up on opening a file after N ms (default 10000, 0 = never)\n"
+            "  --report FILE    write the JSON report to FILE instead of stdout\n");
+}
+
+static bool ParseOptions(int argc, char** argv, RenderOptions* opt)
+{
+    opt->threads    = 0;
+    opt->raw        = false;
+    opt->bits       = 0;
+    opt->sampleRate = 0;
+    opt->tempo      = 0;
+    opt->spillMB    = sizeof(void*) < 8 ? 256 : 1024;   // the plugin's default
+    opt->timeoutMs  = 10000;
+
+    std::vector<std::string> dirs;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h")
+            return false;
+        if (arg.compare(0, 2, "--") != 0)
+        {
+            dirs.push_back(arg);
+            continue;
+        }
+
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            fprintf(stderr, "rx2_render: missing value for %s\n", arg.c_str());
+            return false;
+        }
+        ++i;
+
+        if (arg == "--threads")         opt->threads    = atoi(value);
+        else if (arg == "--bits")       opt->bits       = atoi(value);
+        else if (arg == "--rate")       opt->sampleRate = atoi(value);
+        else if (arg == "--tempo")      opt->tempo      = static_cast<int>(atof(value) * 1000.0 + 0.5);
+        else if (arg == "--spill-mb")   opt->spillMB    = atoi(value);
+        else if (arg == "--timeout-ms") opt->timeoutMs  = atoi(value);
+        else if (arg == "--report")     opt->reportPath = value;
+        else if (arg == "--format")
+        {
+            if (strcmp(value, "wav") != 0 && strcmp(value, "raw") != 0)
+            {
+                fprintf(stderr, "rx2_render: unknown format %s\n", value);
+                return false;
+            }
+            opt->raw = strcmp(value, "raw") == 0;
+        }
+        else
+        {
+            fprintf(stderr, "rx2_render: unknown option %s\n", arg.c_str());
+            return false;
+        }
+    }
+
+    if (dirs.size() != 2)
+    {
+        fprintf(stderr, "rx2_render: want a source and an output directory\n");
+        return false;
+    }
+    opt->srcDir = dirs[0];
+    opt->outDir = dirs[1];
+
+    if (opt->bits != 0 && opt->bits != 16 && opt->bits != 24 && opt->bits != 32)
+    {
+        fprintf(stderr, "rx2_render: --bits must be 0, 16, 24 or 32\n");
+        return false;
+    }
+    if (opt->threads < 0 || opt->sampleRate < 0 || opt->tempo < 0 || opt->spillMB < 0 || opt->timeoutMs < 0)
+    {
+        fprintf(stderr, "rx2_render: negative value\n");
+        return false;
+    }
+    return true;
+}
+
+// ---------------- files ----------------
+
+struct RenderJob
+{
+    fs::path src;
+    fs::path dst;
+    std::string relPath;     // UTF-8, for the report
+
+    // Results, written by the worker that took the job.
+    bool          ok          = false;
+    const char*   error       = "ok";
+    std::int64_t  frames      = 0;
+    int           sampleRate  = 0;
+    int           channels    = 0;
+    double        readMs      = 0.0;
+    double        openMs      = 0.0;   // header, REXCreate and render
+    double        renderMs    = 0.0;   // the render part of openMs
+    double        writeMs     = 0.0;
+    double        totalMs     = 0.0;
+};
+
+static bool CollectJobs(const RenderOptions& opt, std::vector<RenderJob>* jobs)
+{
+    const fs::path  src(opt.srcDir);
+    std::error_code ec;
+    fs::recursive_directory_iterator it(src, fs::directory_options::skip_permission_denied, ec), end;
+    if (ec)
+    {
+        fprintf(stderr, "rx2_render: cannot read %s: %s\n", opt.srcDir.c_str(), ec.message().c_str());
+        return false;
+    }
+
+    for (; it != end; it.increment(ec))
+    {
+        if (ec)
+        {
+            fprintf(stderr, "rx2_render: %s\n", ec.message().c_str());
+            ec.clear();
+            continue;
+        }
+        if (!it->is_regular_file(ec) || !Rx2ToolIsRexFile(it->path()))
+            continue;
+
+        RenderJob job;
+        job.src     = it->path();
+        const fs::path rel = it->path().lexically_relative(src);
+        job.relPath = rel.generic_u8string();
+        job.dst     = fs::path(opt.outDir) / rel;
+        job.dst.replace_extension(opt.raw ? ".raw" : ".wav");
+        jobs->push_back(std::move(job));
+    }
+
+    // Deterministic report order whatever the directory order.
+    std::sort(jobs->begin(), jobs->end(),
+              [](const RenderJob& a, const RenderJob& b) { return a.relPath < b.relPath; });
+    return true;
+}
+
+// Whole file into a new[] buffer, as the plugin hands it to the core. On
+// failure returns null with the report's error name in *error.
+static std::uint8_t* ReadWholeFile(const fs::path& path, std::int64_t* size, const char** error)
+{
+    *error = "read_failed";
+
+    std::error_code  ec;
+    const std::uintmax_t bytes = fs::file_size(path, ec);
+    if (!ec && bytes == 0)
+        *error = "empty_file";
+    if (ec || bytes == 0 || bytes > static_cast<std::uintmax_t>(INT32_MAX))
+        return nullptr;
+
+    FILE* f = nullptr;
+#ifdef _WIN32
+    f = _wfopen(path.c_str(), L"rb");
+#else
+    f = fopen(path.c_str(), "rb");
+#endif
+    if (!f)
+        return nullptr;
+
+    std::uint8_t* data = new (std::nothrow) std::uint8_t[static_cast<size_t>(bytes)];
+    if (!data)
+    {
+        fclose(f);
+        *error = Rx2RexErrorName(REX::kREXError_OutOfMemory);
+        return nullptr;
+    }
+
+    const size_t got = fread(data, 1, static_cast<size_t>(bytes), f);
+    fclose(f);
+
+    if (got != bytes)
+    {
+        delete[] data;
+        return nullptr;
+    }
+    *size = static_cast<std::int64_t>(bytes);
+    return data;
+}
+
+static void PutLE(std::uint8_t* p, std::uint32_t v, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        p[i] = static_cast<std::uint8_t>(v >> (8 * i));
+}
+
+// Canonical 44-byte RIFF header: format 1 for integer PCM, 3 for float.
+static void MakeWavHeader(std::uint8_t* h, const Rx2Loop& loop)
+{
+    const Rx2SampleFormat format     = loop.StorageFormat();
+    const int             bytes      = Rx2BytesPerSample(format);
+    const std::uint32_t   blockAlign = static_cast<std::uint32_t>(bytes * loop.Channels());
+    const std::uint64_t   dataBytes  = static_cast<std::uint64_t>(loop.Frames()) * blockAlign;
+    const std::uint32_t   dataSize   = dataBytes > 0xFFFFFFF0u ? 0xFFFFFFF0u
+                                                               : static_cast<std::uint32_t>(dataBytes);
+
+    memcpy(h + 0, "RIFF", 4);
+    PutLE(h + 4, 36 + dataSize, 4);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    PutLE(h + 16, 16, 4);
+    PutLE(h + 20, format == Rx2SampleFormat::Float32 ? 3 : 1, 2);
+    PutLE(h + 22, static_cast<std::uint32_t>(loop.Channels()), 2);
+    PutLE(h + 24, static_cast<std::uint32_t>(loop.SampleRate()), 4);
+    PutLE(h + 28, static_cast<std::uint32_t>(loop.SampleRate()) * blockAlign, 4);
+    PutLE(h + 32, blockAlign, 2);
+    PutLE(h + 34, static_cast<std::uint32_t>(bytes * 8), 2);
+    memcpy(h + 36, "data", 4);
+    PutLE(h + 40, dataSize, 4);
+}
+
+static bool WriteOutput(Rx2Loop& loop, const fs::path& path, bool raw)
+{
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    FILE* f = nullptr;
+#ifdef _WIN32
+    f = _wfopen(path.c_str(), L"wb");
+#else
+    f = fopen(path.c_str(), "wb");
+#endif
+    if (!f)
+        return false;
+
+    bool ok = true;
+    if (!raw)
+    {
+        std::uint8_t header[44];
+        MakeWavHeader(header, loop);
+        ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+    }
+
+    // Interleaved out of the store in the storage format, 16K frames at a time.
+    const Rx2SampleFormat format     = loop.StorageFormat();
+    const int             frameBytes = Rx2BytesPerSample(format) * loop.Channels();
+    const int             chunk      = 16384;
+    std::vector<std::uint8_t> buffer(static_cast<size_t>(chunk) * frameBytes);
+
+    for (std::int64_t frame = 0; ok && frame < loop.Frames(); frame += chunk)
+    {
+        const int n = static_cast<int>(std::min<std::int64_t>(chunk, loop.Frames() - frame));
+        loop.Pcm().Read(frame, n, buffer.data(), format);
+        ok = fwrite(buffer.data(), 1, static_cast<size_t>(n) * frameBytes, f)
+             == static_cast<size_t>(n) * frameBytes;
+    }
+
+    if (fclose(f) != 0)
+        ok = false;
+    if (!ok)
+        fs::remove(path, ec);
+    return ok;
+}
+
+// ---------------- render ----------------
+
+static double MsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// What reading and opening one file hands back to its worker.
+struct OpenedLoop
+{
+    std::unique_ptr<Rx2Loop> loop;           // null on failure
+    const char*              error  = "ok";
+    double                   readMs = 0.0;
+    double                   openMs = 0.0;   // header, REXCreate and render
+};
+
+static void OpenLoop(const RenderOptions& opt, const fs::path& src, OpenedLoop* out)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    std::int64_t  size = 0;
+    std::uint8_t* data = ReadWholeFile(src, &size, &out->error);
+    out->readMs = MsSince(start);
+    if (!data)
+        return;
+
+    std::unique_ptr<Rx2Loop> loop(new (std::nothrow) Rx2Loop());
+    if (!loop)
+    {
+        delete[] data;
+        out->error = Rx2RexErrorName(REX::kREXError_OutOfMemory);
+        return;
+    }
+
+    // The plugin's defaults (Rx2Settings.h) apart from what the command
+    // line sets.
+    Rx2LoopOptions options;
+    options.pcmStorageBits      = opt.bits;
+    options.pcmMinStorageBits   = 16;
+    options.pcmCompression      = false;
+    options.pcmSpillThresholdMB = opt.spillMB;
+    options.sliceIndex          = -1;
+    options.skipPreflight       = false;
+    options.sampleRate          = opt.sampleRate;
+    options.tempo               = opt.tempo;
+
+    const auto openStart = std::chrono::steady_clock::now();
+    loop->Open(data, size, options);   // takes the buffer
+    out->openMs = MsSince(openStart);
+    out->loop   = std::move(loop);
+}
+
+static void RenderOne(const RenderOptions& opt, RenderJob* job)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Bounded by --timeout-ms; a job given up on keeps its own copies.
+    OpenedLoop     opened;
+    const fs::path src = job->src;
+    if (!Rx2ToolRunTimed(opt.timeoutMs, &opened, [opt, src](OpenedLoop* r) { OpenLoop(opt, src, r); }))
+    {
+        job->error   = Rx2RexErrorName(kRexError_CreateTimedOut);
+        job->openMs  = MsSince(start);
+        job->totalMs = job->openMs;
+        return;
+    }
+
+    job->readMs = opened.readMs;
+    job->openMs = opened.openMs;
+    if (!opened.loop)
+    {
+        job->error   = opened.error;
+        job->totalMs = MsSince(start);
+        return;
+    }
+
+    Rx2Loop& loop = *opened.loop;
+    job->renderMs = loop.LastRenderUs() > 0 ? loop.LastRenderUs() / 1000.0 : 0.0;
+
+    // A loop that rendered only in part is an error here, as in the plugin.
+    if (!loop.IsValid() || loop.HasError())
+    {
+        job->error   = Rx2RexErrorName(loop.LastError());
+        job->totalMs = MsSince(start);
+        return;
+    }
+
+    job->frames     = loop.Frames();
+    job->sampleRate = loop.SampleRate();
+    job->channels   = loop.Channels();
+
+    const auto writeStart = std::chrono::steady_clock::now();
+    job->ok      = WriteOutput(loop, job->dst, opt.raw);
+    job->writeMs = MsSince(writeStart);
+    if (!job->ok)
+        job->error = "write_failed";
+    job->totalMs = MsSince(start);
+}
+
+static void RenderAll(const RenderOptions& opt, std::vector<RenderJob>& jobs, int threads)
+{
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        for (;;)
+        {
+            const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= jobs.size())
+                break;
+            RenderOne(opt, &jobs[i]);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool)
+        t.join();
+}
+
+// ---------------- report ----------------
+
+static std::string WriteReport(const RenderOptions& opt, const std::vector<RenderJob>& jobs,
+                               int threads, double wallMs)
+{
+    size_t       failed = 0;
+    std::int64_t frames = 0;
+    for (const RenderJob& job : jobs)
+    {
+        failed += job.ok ? 0 : 1;
+        frames += job.frames;
+    }
+
+    char        line[512];
+    std::string out = "{\n  \"tool\": \"rx2_render\",\n  \"config\": {";
+    snprintf(line, sizeof(line),
+             "\"threads\": %d, \"format\": \"%s\", \"bits\": %d, \"rate\": %d, \"tempo\": %d, \"spill_mb\": %d, "
+             "\"timeout_ms\": %d},\n",
+             threads, opt.raw ? "raw" : "wav", opt.bits, opt.sampleRate, opt.tempo, opt.spillMB, opt.timeoutMs);
+    out += line;
+    snprintf(line, sizeof(line),
+             "  \"summary\": {\"files\": %zu, \"failed\": %zu, \"frames\": %lld, \"wall_ms\": %.3f},\n",
+             jobs.size(), failed, static_cast<long long>(frames), wallMs);
+    out += line;
+    out += "  \"files\": [\n";
+
+    for (size_t i = 0; i < jobs.size(); ++i)
+    {
+        const RenderJob& job = jobs[i];
+        out += "    {\"path\": ";
+        Rx2ToolAppendJsonString(out, job.relPath);
+        snprintf(line, sizeof(line),
+                 ", \"ok\": %s, \"error\": \"%s\", \"frames\": %lld, \"rate\": %d, \"channels\": %d, "
+                 "\"read_ms\": %.3f, \"open_ms\": %.3f, \"render_ms\": %.3f, \"write_ms\": %.3f, \"total_ms\": %.3f}%s\n",
+                 job.ok ? "true" : "false", job.error, static_cast<long long>(job.frames),
+                 job.sampleRate, job.channels, job.readMs, job.openMs, job.renderMs, job.writeMs,
+                 job.totalMs, (i + 1 < jobs.size()) ? "," : "");
+        out += line;
+    }
+    out += "  ]\n}\n";
+    return out;
+}
+
+// ---------------- main ----------------
+
+int main(int argc, char** argv)
+{
+    RenderOptions opt;
+    if (!ParseOptions(argc, argv, &opt))
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    std::vector<RenderJob> jobs;
+    if (!CollectJobs(opt, &jobs))
+        return 2;
+
+    int threads = opt.threads;
+    if (threads == 0)
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = std::max(1, std::min<int>(threads, static_cast<int>(std::max<size_t>(jobs.size(), 1))));
+
+    // The REX Shared Library is expected next to the executable.
+#ifdef _WIN32
+    wchar_t exeDir[MAX_PATH];
+    if (!GetModuleFileNameW(nullptr, exeDir, MAX_PATH))
+        exeDir[0] = L'\0';
+    const std::wstring dllDir = fs::path(exeDir).parent_path().wstring();
+#else
+    const std::wstring dllDir = L".";
+#endif
+    const REX::REXError initErr = REX::REXInitializeDLL_DirPath(dllDir.c_str());
+    if (initErr != REX::kREXError_NoError)
+    {
+        fprintf(stderr, "rx2_render: cannot load the REX Shared Library: %s\n", Rx2RexErrorName(initErr));
+        return 2;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    RenderAll(opt, jobs, threads);
+    const double wallMs = MsSince(start);
+
+    // Abandoned opens may still be inside the library; it stays loaded for
+    // them, and the process exits without waiting (see below).
+    const bool abandoned = Rx2ToolAbandonedJobs() > 0;
+    if (!abandoned)
+        REX::REXUninitializeDLL();
+
+    size_t failed = 0;
+    for (const RenderJob& job : jobs)
+    {
+        if (!job.ok)
+        {
+            ++failed;
+            fprintf(stderr, "rx2_render: %s: %s\n", job.relPath.c_str(), job.error);
+        }
+    }
+    fprintf(stderr, "rx2_render: %zu files, %zu failed, %d threads, %.1f ms\n",
+            jobs.size(), failed, threads, wallMs);
+
+    int code = failed ? 1 : 0;
+    const std::string report = WriteReport(opt, jobs, threads, wallMs);
+    if (opt.reportPath.empty())
+    {
+        fputs(report.c_str(), stdout);
+    }
+    else
+    {
+        FILE* f = fopen(opt.reportPath.c_str(), "wb");
+        if (!f || fwrite(report.data(), 1, report.size(), f) != report.size())
+        {
+            fprintf(stderr, "rx2_render: cannot write %s\n", opt.reportPath.c_str());
+            code = 2;
+        }
+        if (f)
+            fclose(f);
+    }
+
+    if (abandoned)
+    {
+        // Returning would run static destructors under the hung threads.
+        fflush(stdout);
+        fflush(stderr);
+        std::quick_exit(code);
+    }
+    return code;
+}
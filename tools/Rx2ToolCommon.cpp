@@ -0,0 +1,50 @@
+#include "Rx2ToolCommon.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+
+static std::atomic<int> g_abandoned(0);
+
+bool Rx2ToolIsRexFile(const std::filesystem::path& path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return ext == ".rx2" || ext == ".rex" || ext == ".rcy";
+}
+
+void Rx2ToolAppendJsonString(std::string& out, const std::string& s)
+{
+    out += '"';
+    for (unsigned char c : s)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+            out += static_cast<char>(c);
+        }
+        else if (c < 0x20)
+        {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            out += esc;
+        }
+        else
+        {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+int Rx2ToolAbandonedJobs()
+{
+    return g_abandoned.load();
+}
+
+void Rx2ToolCountAbandoned(int delta)
+{
+    g_abandoned.fetch_add(delta);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Helpers shared by the command-line tools (rx2_render, rx2_index).
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+// .rx2, .rex or .rcy, in any case.
+bool Rx2ToolIsRexFile(const std::filesystem::path& path);
+
+// Appends `s` (UTF-8) as a quoted JSON string.
+void Rx2ToolAppendJsonString(std::string& out, const std::string& s);
+
+// Jobs Rx2ToolRunTimed gave up on that are still running. While any are,
+// the REX library must stay loaded and the tool should leave through
+// std::quick_exit, since returning would run static destructors under them.
+int  Rx2ToolAbandonedJobs();
+void Rx2ToolCountAbandoned(int delta);   // Rx2ToolRunTimed only
+
+// Runs fn(Result*) on a thread of its own and waits up to `timeoutMs`
+// (0 = on this thread, without a limit). Returns false when it is still
+// running then: the job is abandoned and finishes into a result of its own,
+// so `fn` must hold copies of whatever it uses. The tools call the REX
+// library without the plugin's REXCreate sandbox; this bounds a file that
+// hangs it.
+template <typename Result, typename Fn>
+bool Rx2ToolRunTimed(int timeoutMs, Result* out, Fn fn)
+{
+    struct Job
+    {
+        std::mutex              mutex;
+        std::condition_variable done;
+        bool                    finished  = false;
+        bool                    abandoned = false;
+        Result                  result;
+    };
+
+    if (timeoutMs <= 0)
+    {
+        fn(out);
+        return true;
+    }
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    try
+    {
+        std::thread([job, fn]() mutable {
+            Result r;
+            fn(&r);
+
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->result   = std::move(r);
+            job->finished = true;
+            if (job->abandoned)
+                Rx2ToolCountAbandoned(-1);
+            job->done.notify_one();
+        }).detach();
+    }
+    catch (const std::system_error&)
+    {
+        fn(out);
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    if (job->done.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&]() { return job->finished; }))
+    {
+        *out = std::move(job->result);
+        return true;
+    }
+
+    job->abandoned = true;
+    Rx2ToolCountAbandoned(1);
+    return false;
+}